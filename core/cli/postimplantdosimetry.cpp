@@ -0,0 +1,178 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   postimplantdosimetry.cpp
+//! \author Alex Robinson
+//! \brief  Main c++ command-line-interface for post-implant dosimetry.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#include <boost/chrono.hpp>
+#include <boost/program_options.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPostImplantDosimetry.hpp"
+#include "BrachytherapySeedHelpers.hpp"
+
+//! Main c++ command-line-interface for post-implant dosimetry
+int main( int argc, char** argv )
+{
+  // Time the execution of the entire program
+  boost::chrono::steady_clock::time_point start_clock = 
+    boost::chrono::steady_clock::now();
+
+  // Set the program options
+  boost::program_options::options_description generic( "Allowed options" );
+  generic.add_options()
+    ("help,h", "produce help message")
+    ("seed,s", 
+     boost::program_options::value<std::vector<std::string> >()->multitoken(),
+     "set the implanted seed and its air kerma strength "
+     "(arg = name strength)\n"
+     "default value: Amersham6711Seed 0.55\n")
+    ("prescribed_dose,d", 
+     boost::program_options::value<double>()->default_value(145.0),
+     "set the prescribed dose (Gy)\n"
+     "default value: 145.0 Gy\n")
+    ("threads", 
+     boost::program_options::value<unsigned>()->default_value(0u),
+     "set the number of threads (0 = all hardware threads)\n");
+
+  // Set the hidden program options (required args)
+  boost::program_options::options_description hidden( "Hidden options" );
+  hidden.add_options()
+    ("patient_file_name", 
+     boost::program_options::value<std::string>(),
+     "set the patient hdf5 file name (with path)")
+    ("implanted_seed_file_name", 
+     boost::program_options::value<std::string>(),
+     "set the implanted seed position file name (with path)");
+
+  boost::program_options::positional_options_description pd;
+  pd.add("patient_file_name", 1);
+  pd.add("implanted_seed_file_name", 1);
+
+  boost::program_options::options_description 
+    cmdline_options( "Allowed options" ); 
+  cmdline_options.add(generic).add(hidden);
+  
+  boost::program_options::variables_map vm;
+  boost::program_options::store(
+		       boost::program_options::command_line_parser(argc, argv).
+		       options(cmdline_options).positional(pd).run(), vm);
+  boost::program_options::notify( vm );
+
+  if( vm.count( "help" ) || 
+      !vm.count( "patient_file_name" ) ||
+      !vm.count( "implanted_seed_file_name" ) )
+  {
+    std::cout << "Usage: postimplantdosimetry [options] patient_file "
+	      << "implanted_seed_file" << std::endl
+	      << generic << std::endl;
+    return 1;
+  }
+
+  // Parse the implanted seed
+  TPOR::BrachytherapySeedType seed_type = TPOR::AMERSHAM_6711_SEED;
+  double seed_strength = 0.55;
+  
+  if( vm.count( "seed" ) )
+  {
+    std::vector<std::string> seed_args = 
+      vm["seed"].as<std::vector<std::string> >();
+
+    if( seed_args.size() != 2 )
+    {
+      std::cout << "The seed name and strength must be specified "
+		<< "(e.g. -s name strength)" << std::endl;
+      return 1;
+    }
+
+    std::istringstream iss( seed_args[1] );
+    iss >> seed_strength;
+
+    bool valid_seed = false;
+    
+    for( unsigned seed_id = TPOR::SEED_min; 
+	 seed_id <= TPOR::SEED_max; 
+	 ++seed_id )
+    {  
+      TPOR::BrachytherapySeedType test_seed_type =
+	TPOR::unsignedToBrachytherapySeedType( seed_id );
+      
+      if( seed_args[0].compare( 
+		     TPOR::brachytherapySeedName( test_seed_type ) ) == 0 )
+      {
+	seed_type = test_seed_type;
+	valid_seed = true;
+	break;
+      }
+    }
+
+    if( !valid_seed || iss.fail() || seed_strength <= 0.0 )
+    {
+      std::cout << "The seed " << seed_args[0] << " " << seed_args[1]
+		<< " is invalid." << std::endl;
+      return 1;
+    }
+  }
+
+  // Load the patient geometry (the organ weights are not used)
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> 
+    geometry( new TPOR::BrachytherapyPatientGeometry( 
+			    vm["patient_file_name"].as<std::string>(),
+			    vm["prescribed_dose"].as<double>()*100,
+			    1.0,
+			    1.0,
+			    1.0 ) );
+
+  // Load the implanted seeds
+  std::vector<TPOR::BrachytherapyImplantedSeed> seeds;
+
+  try{
+    TPOR::BrachytherapyPostImplantDosimetry::readImplantedSeeds( 
+			     vm["implanted_seed_file_name"].as<std::string>(),
+			     seeds );
+  }
+  catch( const std::exception &exception )
+  {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+  
+  // Evaluate the implant
+  TPOR::BrachytherapyPostImplantDosimetry dosimetry( geometry,
+						     seed_type,
+						     seed_strength );
+  
+  TPOR::BrachytherapyPlanMetrics metrics;
+  dosimetry.evaluateImplant( seeds, metrics, vm["threads"].as<unsigned>() );
+
+  std::cout.precision( 3 );
+  std::cout.setf( std::ios::fixed, std::ios::floatfield );
+  
+  std::cout << "Implanted Seeds:            " << seeds.size() << std::endl;
+  
+  TPOR::printBrachytherapyPlanMetrics( std::cout, metrics );
+
+  // Print the program execution time
+  boost::chrono::duration<double> seconds =
+    boost::chrono::steady_clock::now() - start_clock;
+  
+  std::cout << "Program Execution Time (s): " << seconds.count() << std::endl;
+
+  return 0;
+}
+
+//---------------------------------------------------------------------------//
+// end postimplantdosimetry.cpp
+//---------------------------------------------------------------------------//
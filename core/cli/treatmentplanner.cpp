@@ -10,15 +10,36 @@
 #include <time.h>
 #include <string>
 #include <vector>
+#include <iostream>
+#include <stdexcept>
 
 // Boost Includes
 #include <boost/shared_ptr.hpp>
 #include <boost/chrono.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 // TPOR Includes
 #include "BrachytherapyCommandLineProcessor.hpp"
+#include "BrachytherapyPatientGeometry.hpp"
 #include "BrachytherapyPatient.hpp"
 #include "BrachytherapyTreatmentPlannerFactory.hpp"
+#include "BrachytherapyTreatmentPlannerHelpers.hpp"
+#include "BrachytherapyPlanRobustnessAnalyzer.hpp"
+
+//! Export the patient data to vtk (the error message of a failure is stored)
+void exportPatientDataToVTK( 
+	    const boost::shared_ptr<const TPOR::BrachytherapyPatient> &patient,
+	    std::string &error_message )
+{
+  try{
+    patient->exportDataToVTK( true );
+  }
+  catch( const std::exception &exception )
+  {
+    error_message = exception.what();
+  }
+}
 
 //! Main c++ command-line-interface for creating a treatment plan
 int main( int argc, char** argv )
@@ -29,29 +50,91 @@ int main( int argc, char** argv )
   
   TPOR::BrachytherapyCommandLineProcessor user_args( argc, argv );
 
-  // Create the patient
+  // Load the patient geometry
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> 
+    geometry( new TPOR::BrachytherapyPatientGeometry( 
+				      user_args.getPatientFile(),
+				      user_args.getPrescribedDose(),
+				      user_args.getUrethraWeight(),
+				      user_args.getRectumWeight(),
+				      user_args.getMarginWeight(),
+				      user_args.getStructureWeights() ) );
+  
+  // Create the patient (treatment plan state)
   boost::shared_ptr<TPOR::BrachytherapyPatient> 
-    patient( new TPOR::BrachytherapyPatient( user_args.getPatientFile(),
-					     user_args.getPrescribedDose(),
-					     user_args.getUrethraWeight(),
-					     user_args.getRectumWeight(),
-					     user_args.getMarginWeight() ) );
+    patient( new TPOR::BrachytherapyPatient( geometry ) );
   
-  // Create the treatment planner factory
-  TPOR::BrachytherapyTreatmentPlannerFactory
-    planner_factory( patient, user_args.getSeeds() );
+  // Load an archived treatment plan (rebuild its dose from the seeds)
+  if( user_args.isPlanLoadRequested() )
+  {
+    std::cout << std::endl << "loading treatment plan " 
+	      << user_args.getLoadedPlanName() << "..." << std::endl;
+    
+    try{
+      patient->loadTreatmentPlanFromHDF5( user_args.getLoadedPlanName(),
+					  user_args.getSeeds(),
+					  user_args.getLoadedPlanFile() );
+    }
+    catch( const std::exception &exception )
+    {
+      std::cerr << "Error: the treatment plan could not be loaded: "
+		<< exception.what() << std::endl;
+      return 1;
+    }
+  }
+  else
+  {
+    // Create the treatment planner factory
+    TPOR::BrachytherapyTreatmentPlannerFactory
+      planner_factory( patient, 
+		       user_args.getSeeds(),
+		       user_args.isLazySetCoverEvaluationRequested(),
+		       user_args.getDoseMatrixSettings(),
+		       user_args.getNumberOfThreads(),
+		       user_args.isCoarseToFineRequested(),
+		       user_args.isCoarseToFineFallbackRequested(),
+		       user_args.isIIEMTrialSearchRequested(),
+		       user_args.getIIEMVerificationWindow() );
   
-  // Create the treatment planner
-  TPOR::BrachytherapyTreatmentPlannerFactory::BrachytherapyTreatmentPlannerPtr
-    planner = planner_factory.createTreatmentPlanner( 
-						  user_args.getPlannerType() );
+    // Create the treatment planner
+    TPOR::BrachytherapyTreatmentPlannerFactory::BrachytherapyTreatmentPlannerPtr
+      planner = planner_factory.createTreatmentPlanner( 
+						   user_args.getPlannerType() );
 					       
-  // Create the treatment plan
-  planner->calculateOptimumTreatmentPlan();
+    // Create the treatment plan
+    planner->calculateOptimumTreatmentPlan();
+  }
+
+  // Export the patient data to vtk in the background (the patient is only
+  // read from now on)
+  // Note: an error of the export is only reported once it has finished
+  boost::thread vtk_export_thread;
+
+  std::string vtk_export_error;
+  
+  if( user_args.isVTKExportRequested() )
+  {
+    vtk_export_thread = boost::thread( 
+			       boost::bind( &exportPatientDataToVTK,
+					    patient,
+					    boost::ref( vtk_export_error ) ) );
+  }
 
   // Print the treatment plan summary
   patient->printTreatmentPlanSummary( std::cout );
   
+  // Analyze the robustness of the treatment plan
+  if( user_args.getRobustnessScenarios() > 0 )
+  {
+    TPOR::BrachytherapyPlanRobustnessAnalyzer analyzer( 
+					  *patient,
+					  user_args.getPerturbationModel() );
+    analyzer.sampleScenarios( user_args.getRobustnessScenarios(),
+			      0u,
+			      user_args.getNumberOfThreads() );
+    analyzer.printRobustnessSummary( std::cout );
+  }
+  
   // Print the program execution time
   boost::chrono::duration<double> seconds =
     boost::chrono::steady_clock::now() - start_clock;
@@ -63,9 +146,36 @@ int main( int argc, char** argv )
 
   // Print the dose-volume-histogram
   patient->printDoseVolumeHistogramData( user_args.getDVHOutputStream() );
+
+  // Export the treatment plan results (the plan is named after the planner)
+  if( user_args.isResultsExportRequested() )
+  {
+    std::string plan_name = 
+      TPOR::brachytherapyTreatmentPlannerName( user_args.getPlannerType() );
+    
+    if( user_args.isCompactResultsRequested() )
+    {
+      patient->archiveTreatmentPlanToHDF5( plan_name,
+					   user_args.getResultsFile() );
+    }
+    else
+    {
+      patient->exportTreatmentPlanToHDF5( plan_name,
+					  user_args.getResultsFile() );
+    }
+  }
   
-  // Export the patient data to vtk
-  patient->exportDataToVTK();
+  // Wait for the vtk export to finish
+  if( vtk_export_thread.joinable() )
+    vtk_export_thread.join();
+
+  if( !vtk_export_error.empty() )
+  {
+    std::cerr << "Error: the vtk export failed: " << vtk_export_error 
+	      << std::endl;
+    
+    return 1;
+  }
 
   return 0;
  }
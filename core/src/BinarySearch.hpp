@@ -15,6 +15,11 @@ namespace TPOR{
 template<typename T>
 int binarySearch( const T* start, const T* end, const T value );
 
+//! Find the first successful trial of a monotone trial predicate
+template<typename Predicate>
+unsigned findFirstSuccessfulTrial( const unsigned number_of_trials,
+				   Predicate successful );
+
 } // end TPOR namespace
 
 //---------------------------------------------------------------------------//
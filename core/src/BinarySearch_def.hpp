@@ -46,6 +46,57 @@ int binarySearch( const T* start, const T* end, const T value )
   return start-start_copy;
 }
 
+// Find the first successful trial of a monotone trial predicate
+/*! \details The predicate is called with trial indices in [0, number of 
+ * trials) and returns true if the trial is successful. Every trial after a
+ * successful trial must also be successful. The first successful trial is
+ * bracketed by trials 0, 2, 6, 14, ... (the last trial closes the bracket)
+ * and is then found by bisection, so only a logarithmic number of trials is
+ * conducted and no trial is conducted twice. The number of trials is 
+ * returned if no trial is successful.
+ */
+template<typename Predicate>
+unsigned findFirstSuccessfulTrial( const unsigned number_of_trials,
+				   Predicate successful )
+{
+  // The trials before lower fail and trial upper is successful
+  unsigned lower = 0u;
+  unsigned upper = number_of_trials;
+
+  // Bracket the first successful trial
+  unsigned step = 1u;
+  
+  while( lower < number_of_trials )
+  {
+    unsigned trial = lower + step - 1u;
+
+    if( trial >= number_of_trials )
+      trial = number_of_trials - 1u;
+
+    if( successful( trial ) )
+    {
+      upper = trial;
+      break;
+    }
+
+    lower = trial + 1u;
+    step *= 2u;
+  }
+
+  // Bisect the bracket
+  while( lower < upper )
+  {
+    unsigned trial = lower + (upper - lower)/2u;
+
+    if( successful( trial ) )
+      upper = trial;
+    else
+      lower = trial + 1u;
+  }
+
+  return upper;
+}
+
 } // end TPOR namespace
 
 #endif // end BINARY_SEARCH_DEF_HPP
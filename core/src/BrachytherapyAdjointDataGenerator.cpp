@@ -8,6 +8,7 @@
 
 // Std Lib Includes
 #include <limits>
+#include <algorithm>
 
 // TPOR Includes
 #include "BrachytherapyAdjointDataGenerator.hpp"
@@ -42,21 +43,25 @@ void BrachytherapyAdjointDataGenerator::calculateAdjointDose(
 
   std::vector<int> seed_position( 3 );
 
-  for( int k = 0; k < mesh_z_dim; ++k )
+  unsigned organ_size = 
+    std::count( organ_mask.begin(), organ_mask.end(), true );
+
+  for( unsigned k = 0; k < mesh_z_dim; ++k )
   {
-    seed_position[2] = k;
+    seed_position[2] = static_cast<int>( k );
     
-    for( int j = 0; j < mesh_y_dim; ++j )
+    for( unsigned j = 0; j < mesh_y_dim; ++j )
     {
-      seed_position[1] = j;
+      seed_position[1] = static_cast<int>( j );
 	
-      for( int i = 0; i < mesh_x_dim; ++i )
+      for( unsigned i = 0; i < mesh_x_dim; ++i )
       {
-	seed_position[0] = i;
+	seed_position[0] = static_cast<int>( i );
 
 	organ_adjoint_data[i+j*mesh_x_dim+k*mesh_x_dim*mesh_y_dim] = 
 	  calculateAverageDoseToOrgan( seed_position,
 				       organ_mask,
+				       organ_size,
 				       mesh_x_dim,
 				       mesh_y_dim,
 				       mesh_z_dim );
@@ -83,23 +88,27 @@ void BrachytherapyAdjointDataGenerator::calculateCondensedAdjointDose(
 
   std::vector<int> seed_position( 3 );
 
-  for( int k = 0; k < mesh_z_dim; ++k )
+  unsigned organ_size = 
+    std::count( organ_mask.begin(), organ_mask.end(), true );
+
+  for( unsigned k = 0; k < mesh_z_dim; ++k )
   {
-    seed_position[2] = k;
+    seed_position[2] = static_cast<int>( k );
     
-    for( int j = 0; j < mesh_y_dim; ++j )
+    for( unsigned j = 0; j < mesh_y_dim; ++j )
     {
-      seed_position[1] = j;
+      seed_position[1] = static_cast<int>( j );
 	
-      for( int i = 0; i < mesh_x_dim; ++i )
+      for( unsigned i = 0; i < mesh_x_dim; ++i )
       {
-	seed_position[0] = i;
+	seed_position[0] = static_cast<int>( i );
 
 	if( prostate_mask[i+j*mesh_x_dim+k*mesh_x_dim*mesh_y_dim] )
 	{
 	  organ_adjoint_data[i+j*mesh_x_dim+k*mesh_x_dim*mesh_y_dim] = 
 	    calculateAverageDoseToOrgan( seed_position,
 					 organ_mask,
+					 organ_size,
 					 mesh_x_dim,
 					 mesh_y_dim,
 					 mesh_z_dim );
@@ -111,10 +120,89 @@ void BrachytherapyAdjointDataGenerator::calculateCondensedAdjointDose(
   }
 }
 
+// Calculate the adjoint dose of every structure in the prostate only
+/*! \details The structure labels store one bit per structure (bit s is set 
+ * if the mesh element belongs to structure s). The seed dose distribution is
+ * only traversed once for each prostate element, regardless of the number of
+ * structures, and the dose is only accumulated for the structures that 
+ * contain each element. The calculated adjoint dose will have units of 
+ * cGy/source.
+ */
+void BrachytherapyAdjointDataGenerator::calculateCondensedAdjointDose( 
+	       std::vector<std::vector<double> > &structure_adjoint_data,
+	       const std::vector<unsigned> &structure_labels,
+	       const std::vector<unsigned> &structure_sizes,
+	       const std::vector<bool> &prostate_mask,
+	       const unsigned mesh_x_dim,
+	       const unsigned mesh_y_dim,
+	       const unsigned mesh_z_dim )
+{
+  // Make sure that the dimensions passed and the size of the labels 
+  // are the same
+  testPrecondition( structure_labels.size() == 
+		    mesh_x_dim*mesh_y_dim*mesh_z_dim );
+  testPrecondition( prostate_mask.size() == structure_labels.size() );
+  // Make sure that there is a label bit for every structure
+  testPrecondition( structure_sizes.size() > 0 );
+  testPrecondition( structure_sizes.size() <= 
+		    std::numeric_limits<unsigned>::digits );
+
+  const unsigned number_of_structures = structure_sizes.size();
+
+  structure_adjoint_data.resize( number_of_structures );
+
+  for( unsigned s = 0; s < number_of_structures; ++s )
+    structure_adjoint_data[s].resize( structure_labels.size() );
+
+  std::vector<int> seed_position( 3 );
+
+  std::vector<double> structure_doses( number_of_structures );
+
+  for( unsigned k = 0; k < mesh_z_dim; ++k )
+  {
+    seed_position[2] = static_cast<int>( k );
+    
+    for( unsigned j = 0; j < mesh_y_dim; ++j )
+    {
+      seed_position[1] = static_cast<int>( j );
+	
+      for( unsigned i = 0; i < mesh_x_dim; ++i )
+      {
+	seed_position[0] = static_cast<int>( i );
+
+	unsigned index = i+j*mesh_x_dim+k*mesh_x_dim*mesh_y_dim;
+
+	if( prostate_mask[index] )
+	{
+	  calculateTotalDoseToStructures( seed_position,
+					  structure_labels,
+					  structure_doses,
+					  mesh_x_dim,
+					  mesh_y_dim,
+					  mesh_z_dim );
+
+	  // cGy/source
+	  for( unsigned s = 0; s < number_of_structures; ++s )
+	  {
+	    structure_adjoint_data[s][index] = 
+	      structure_doses[s]/structure_sizes[s];
+	  }
+	}
+	else
+	{
+	  for( unsigned s = 0; s < number_of_structures; ++s )
+	    structure_adjoint_data[s][index] = 0.0;
+	}
+      }
+    }
+  }
+}
+
 // Calculate the average dose to the organ at a seed location
 double BrachytherapyAdjointDataGenerator::calculateAverageDoseToOrgan(
 				         const std::vector<int> &seed_position,
 					 const std::vector<bool> &organ_mask,
+					 const unsigned organ_size,
 					 const unsigned mesh_x_dim,
 					 const unsigned mesh_y_dim,
 					 const unsigned mesh_z_dim )
@@ -126,28 +214,35 @@ double BrachytherapyAdjointDataGenerator::calculateAverageDoseToOrgan(
   testPrecondition( organ_mask.size() == mesh_x_dim*mesh_y_dim*mesh_z_dim );
 
   double dose = 0.0;
-  unsigned samples = 0;
 
-  for( int k = 0; k < mesh_z_dim; ++k )
+  // Only the organ elements that overlap the seed mesh receive dose
+  DoseDistributionOverlap overlap = 
+    d_seed->getDoseDistributionOverlap( seed_position[0],
+					seed_position[1],
+					seed_position[2],
+					mesh_x_dim,
+					mesh_y_dim,
+					mesh_z_dim );
+
+  for( int k = overlap.z_start; k < overlap.z_end; ++k )
   {
-    for( int j = 0; j < mesh_y_dim; ++j )
+    for( int j = overlap.y_start; j < overlap.y_end; ++j )
     {
-      for( int i = 0; i < mesh_x_dim; ++i )
+      const double* seed_dose_row = 
+	d_seed->getTotalDoseRow( overlap.x_start - seed_position[0],
+				 j - seed_position[1],
+				 k - seed_position[2] );
+      
+      for( int i = overlap.x_start; i < overlap.x_end; ++i )
       {
 	if( organ_mask[i+j*mesh_x_dim+k*mesh_x_dim*mesh_y_dim] )
-	{
-	  dose += d_seed->getTotalDose( i - seed_position[0],
-					j - seed_position[1],
-					k - seed_position[2] );
-	  
-	  ++samples;
-	}
+	  dose += seed_dose_row[i - overlap.x_start];
       }
     }
   }
 
   // cGy/source
-  double average_dose = dose/samples;
+  double average_dose = dose/organ_size;
   
   // Make sure that the average dose calculated is valid
   testPostcondition( average_dose == average_dose ); // Nan test
@@ -157,6 +252,59 @@ double BrachytherapyAdjointDataGenerator::calculateAverageDoseToOrgan(
   return average_dose;
 }
 
+// Calculate the total dose to every structure at a seed location
+void BrachytherapyAdjointDataGenerator::calculateTotalDoseToStructures(
+				const std::vector<int> &seed_position,
+				const std::vector<unsigned> &structure_labels,
+				std::vector<double> &structure_doses,
+				const unsigned mesh_x_dim,
+				const unsigned mesh_y_dim,
+				const unsigned mesh_z_dim )
+{
+  // Make sure that the seed position has only three dimensions
+  testPrecondition( seed_position.size() == 3 );
+  // Make sure that the dimensions passed and the size of the labels
+  // are the same
+  testPrecondition( structure_labels.size() == 
+		    mesh_x_dim*mesh_y_dim*mesh_z_dim );
+
+  std::fill( structure_doses.begin(), structure_doses.end(), 0.0 );
+
+  // Only the structure elements that overlap the seed mesh receive dose
+  DoseDistributionOverlap overlap = 
+    d_seed->getDoseDistributionOverlap( seed_position[0],
+					seed_position[1],
+					seed_position[2],
+					mesh_x_dim,
+					mesh_y_dim,
+					mesh_z_dim );
+
+  for( int k = overlap.z_start; k < overlap.z_end; ++k )
+  {
+    for( int j = overlap.y_start; j < overlap.y_end; ++j )
+    {
+      const double* seed_dose_row = 
+	d_seed->getTotalDoseRow( overlap.x_start - seed_position[0],
+				 j - seed_position[1],
+				 k - seed_position[2] );
+      
+      const unsigned* label_row = &structure_labels[j*mesh_x_dim+
+						    k*mesh_x_dim*mesh_y_dim];
+      
+      for( int i = overlap.x_start; i < overlap.x_end; ++i )
+      {
+	// Visit only the structures that contain the element
+	for( unsigned label = label_row[i], s = 0; label != 0u; 
+	     label >>= 1, ++s )
+	{
+	  if( label & 1u )
+	    structure_doses[s] += seed_dose_row[i - overlap.x_start];
+	}
+      }
+    }
+  }
+}
+
 } // end TPOR namespace
 
 //---------------------------------------------------------------------------//
@@ -49,16 +49,36 @@ public:
 				      const unsigned mesh_y_dim,
 				      const unsigned mesh_z_dim );
 
+  //! Calculate the adjoint dose of every structure in the prostate only
+  void calculateCondensedAdjointDose( 
+	       std::vector<std::vector<double> > &structure_adjoint_data,
+	       const std::vector<unsigned> &structure_labels,
+	       const std::vector<unsigned> &structure_sizes,
+	       const std::vector<bool> &prostate_mask,
+	       const unsigned mesh_x_dim,
+	       const unsigned mesh_y_dim,
+	       const unsigned mesh_z_dim );
+
 private:
 
   //! Calculate the average dose to the organ at a seed location
   double calculateAverageDoseToOrgan( 
 				    const std::vector<int> &seed_position,
 				    const std::vector<bool> &organ_mask,
+				    const unsigned organ_size,
 				    const unsigned mesh_x_dim,
 				    const unsigned mesh_y_dim,
 				    const unsigned mesh_z_dim );
 
+  //! Calculate the total dose to every structure at a seed location
+  void calculateTotalDoseToStructures(
+				const std::vector<int> &seed_position,
+				const std::vector<unsigned> &structure_labels,
+				std::vector<double> &structure_doses,
+				const unsigned mesh_x_dim,
+				const unsigned mesh_y_dim,
+				const unsigned mesh_z_dim );
+
   // Brachytherapy seed
   boost::shared_ptr<BrachytherapySeedProxy> d_seed;
 };
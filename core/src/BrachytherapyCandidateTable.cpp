@@ -0,0 +1,784 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyCandidateTable.cpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy candidate seed position table class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+// TPOR Includes
+#include "BrachytherapyCandidateTable.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+//! Base weight comparison functor (used to sort the candidate indices)
+struct BaseWeightLess
+{
+  BaseWeightLess( const std::vector<double> &weights )
+    : d_weights( weights )
+  { /* ... */ }
+
+  bool operator()( const unsigned a, const unsigned b ) const
+  { return d_weights[a] < d_weights[b]; }
+
+  const std::vector<double> &d_weights;
+};
+
+//! Reorder the elements of an array using a permutation
+template<typename T>
+void applyPermutation( std::vector<T> &array,
+		       const std::vector<unsigned> &permutation )
+{
+  std::vector<T> permuted_array( array.size() );
+
+  for( unsigned c = 0; c < permutation.size(); ++c )
+    permuted_array[c] = array[permutation[c]];
+
+  array.swap( permuted_array );
+}
+
+// Constructor
+BrachytherapyCandidateTable::BrachytherapyCandidateTable(
+						   const unsigned mesh_x_dim,
+						   const unsigned mesh_y_dim,
+						   const unsigned mesh_z_dim )
+  : d_mesh_x_dim( mesh_x_dim ),
+    d_mesh_y_dim( mesh_y_dim ),
+    d_mesh_z_dim( mesh_z_dim ),
+    d_seeds(),
+    d_x_indices(),
+    d_y_indices(),
+    d_z_indices(),
+    d_base_weights(),
+    d_dynamic_weights(),
+    d_seed_ids(),
+    d_alive(),
+    d_number_of_alive_candidates( 0u ),
+    d_dynamic_weight_queue_enabled( false ),
+    d_dynamic_weight_queue(),
+    d_column_offsets(),
+    d_column_candidates(),
+    d_position_ids(),
+    d_position_offsets(),
+    d_position_candidates()
+{
+  // Make sure that the mesh dimensions are valid
+  testPrecondition( mesh_x_dim > 0 );
+  testPrecondition( mesh_y_dim > 0 );
+  testPrecondition( mesh_z_dim > 0 );
+  // Make sure that the mesh indices can be packed
+  testPrecondition( mesh_x_dim <= std::numeric_limits<unsigned short>::max() );
+  testPrecondition( mesh_y_dim <= std::numeric_limits<unsigned short>::max() );
+  testPrecondition( mesh_z_dim <= std::numeric_limits<unsigned short>::max() );
+}
+
+// Return the mesh x dimension
+unsigned BrachytherapyCandidateTable::getMeshXDim() const
+{
+  return d_mesh_x_dim;
+}
+
+// Return the mesh y dimension
+unsigned BrachytherapyCandidateTable::getMeshYDim() const
+{
+  return d_mesh_y_dim;
+}
+
+// Return the mesh z dimension
+unsigned BrachytherapyCandidateTable::getMeshZDim() const
+{
+  return d_mesh_z_dim;
+}
+
+// Add a seed to the seed table and return the seed id
+unsigned BrachytherapyCandidateTable::addSeed(
+			 const boost::shared_ptr<BrachytherapySeedProxy> &seed )
+{
+  // Make sure that the seed is valid
+  testPrecondition( seed );
+  // Make sure that the seed id can be packed
+  testPrecondition( d_seeds.size() <
+		    std::numeric_limits<unsigned char>::max() );
+
+  d_seeds.push_back( seed );
+
+  return d_seeds.size() - 1u;
+}
+
+// Reserve storage for a number of candidates
+void BrachytherapyCandidateTable::reserve(
+				       const unsigned number_of_candidates )
+{
+  d_x_indices.reserve( number_of_candidates );
+  d_y_indices.reserve( number_of_candidates );
+  d_z_indices.reserve( number_of_candidates );
+  d_base_weights.reserve( number_of_candidates );
+  d_dynamic_weights.reserve( number_of_candidates );
+  d_seed_ids.reserve( number_of_candidates );
+  d_alive.reserve( number_of_candidates );
+}
+
+// Add a candidate seed position
+/*! \details The dynamic weight of the candidate is initialized to the base
+ * weight.
+ */
+void BrachytherapyCandidateTable::addCandidate( const unsigned x_index,
+						const unsigned y_index,
+						const unsigned z_index,
+						const double weight,
+						const unsigned seed_id )
+{
+  // Make sure that the indices are valid
+  testPrecondition( x_index < d_mesh_x_dim );
+  testPrecondition( y_index < d_mesh_y_dim );
+  testPrecondition( z_index < d_mesh_z_dim );
+  // Make sure that the weight is valid
+  testPrecondition( weight == weight ); // Nan test
+  testPrecondition( weight > 0.0 );
+  testPrecondition( weight != std::numeric_limits<double>::infinity() );
+  // Make sure that the seed id is valid
+  testPrecondition( seed_id < d_seeds.size() );
+  // Make sure that the dynamic weight queue has not been enabled
+  testPrecondition( !d_dynamic_weight_queue_enabled );
+  // Make sure that the position index has not been built
+  testPrecondition( !isPositionIndexBuilt() );
+
+  d_x_indices.push_back( static_cast<unsigned short>( x_index ) );
+  d_y_indices.push_back( static_cast<unsigned short>( y_index ) );
+  d_z_indices.push_back( static_cast<unsigned short>( z_index ) );
+  d_base_weights.push_back( weight );
+  d_dynamic_weights.push_back( weight );
+  d_seed_ids.push_back( static_cast<unsigned char>( seed_id ) );
+  d_alive.push_back( 1u );
+
+  ++d_number_of_alive_candidates;
+}
+
+// Return the number of candidates (alive and dead)
+unsigned BrachytherapyCandidateTable::getNumberOfCandidates() const
+{
+  return d_alive.size();
+}
+
+// Return the number of alive candidates
+unsigned BrachytherapyCandidateTable::getNumberOfAliveCandidates() const
+{
+  return d_number_of_alive_candidates;
+}
+
+// Test if a candidate is alive
+bool BrachytherapyCandidateTable::isAlive( const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_alive.size() );
+
+  return d_alive[candidate];
+}
+
+// Remove a candidate (flag it as dead)
+void BrachytherapyCandidateTable::removeCandidate( const unsigned candidate )
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_alive.size() );
+  // Make sure that the candidate is alive
+  testPrecondition( d_alive[candidate] );
+
+  d_alive[candidate] = 0u;
+
+  --d_number_of_alive_candidates;
+
+  if( d_dynamic_weight_queue_enabled )
+    d_dynamic_weight_queue.remove( candidate );
+}
+
+// Return the first alive candidate
+/*! \details If there are no alive candidates the number of candidates is
+ * returned (past-the-end candidate).
+ */
+unsigned BrachytherapyCandidateTable::getFirstAliveCandidate() const
+{
+  unsigned candidate = 0u;
+
+  while( candidate < d_alive.size() && !d_alive[candidate] )
+    ++candidate;
+
+  return candidate;
+}
+
+// Return the next alive candidate after a candidate
+/*! \details If there are no more alive candidates the number of candidates is
+ * returned (past-the-end candidate).
+ */
+unsigned BrachytherapyCandidateTable::getNextAliveCandidate(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_alive.size() );
+
+  unsigned next_candidate = candidate + 1u;
+
+  while( next_candidate < d_alive.size() && !d_alive[next_candidate] )
+    ++next_candidate;
+
+  return next_candidate;
+}
+
+// Return the x index of a candidate
+unsigned BrachytherapyCandidateTable::getXIndex(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_x_indices.size() );
+
+  return d_x_indices[candidate];
+}
+
+// Return the y index of a candidate
+unsigned BrachytherapyCandidateTable::getYIndex(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_y_indices.size() );
+
+  return d_y_indices[candidate];
+}
+
+// Return the z index of a candidate
+unsigned BrachytherapyCandidateTable::getZIndex(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_z_indices.size() );
+
+  return d_z_indices[candidate];
+}
+
+// Return the needle index of a candidate
+unsigned BrachytherapyCandidateTable::getNeedleIndex(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_x_indices.size() );
+
+  return d_x_indices[candidate] + d_y_indices[candidate]*d_mesh_x_dim;
+}
+
+// Return the mesh (position) index of a candidate
+unsigned BrachytherapyCandidateTable::getPositionIndex(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_x_indices.size() );
+
+  return d_x_indices[candidate] + d_y_indices[candidate]*d_mesh_x_dim +
+    d_z_indices[candidate]*d_mesh_x_dim*d_mesh_y_dim;
+}
+
+// Return the base weight of a candidate
+double BrachytherapyCandidateTable::getBaseWeight(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_base_weights.size() );
+
+  return d_base_weights[candidate];
+}
+
+// Return the dynamic weight of a candidate
+double BrachytherapyCandidateTable::getDynamicWeight(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_dynamic_weights.size() );
+
+  return d_dynamic_weights[candidate];
+}
+
+// Set the dynamic weight of a candidate
+void BrachytherapyCandidateTable::setDynamicWeight( const unsigned candidate,
+						    const double weight )
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_dynamic_weights.size() );
+  // Make sure that the weight is valid
+  testPrecondition( weight == weight ); // Nan test
+
+  // Only the candidates with a changed weight are moved in the queue
+  if( weight != d_dynamic_weights[candidate] )
+  {
+    d_dynamic_weights[candidate] = weight;
+
+    if( d_dynamic_weight_queue_enabled && d_alive[candidate] )
+      d_dynamic_weight_queue.update( candidate, weight );
+  }
+}
+
+// Multiply the dynamic weight of a candidate by a multiplier
+void BrachytherapyCandidateTable::multiplyDynamicWeight(
+						   const unsigned candidate,
+						   const double multiplier )
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_dynamic_weights.size() );
+
+  setDynamicWeight( candidate, d_dynamic_weights[candidate]*multiplier );
+}
+
+// Return the number of seeds in the seed table
+unsigned BrachytherapyCandidateTable::getNumberOfSeeds() const
+{
+  return d_seeds.size();
+}
+
+// Return the seed with a seed id
+const boost::shared_ptr<BrachytherapySeedProxy>&
+BrachytherapyCandidateTable::getSeedWithId( const unsigned seed_id ) const
+{
+  // Make sure that the seed id is valid
+  testPrecondition( seed_id < d_seeds.size() );
+
+  return d_seeds[seed_id];
+}
+
+// Return the seed id of a candidate
+unsigned BrachytherapyCandidateTable::getSeedId(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_seed_ids.size() );
+
+  return d_seed_ids[candidate];
+}
+
+// Return the seed of a candidate
+const boost::shared_ptr<BrachytherapySeedProxy>&
+BrachytherapyCandidateTable::getSeed( const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_seed_ids.size() );
+
+  return d_seeds[d_seed_ids[candidate]];
+}
+
+// Create the seed position of a candidate
+BrachytherapySeedPosition BrachytherapyCandidateTable::createSeedPosition(
+					       const unsigned candidate ) const
+{
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_seed_ids.size() );
+
+  return BrachytherapySeedPosition( d_x_indices[candidate],
+				    d_y_indices[candidate],
+				    d_z_indices[candidate],
+				    d_base_weights[candidate],
+				    d_seeds[d_seed_ids[candidate]] );
+}
+
+// Enable the dynamic weight queue
+/*! \details All alive candidates are added to the queue. The queue stays
+ * enabled for the lifetime of the table.
+ */
+void BrachytherapyCandidateTable::enableDynamicWeightQueue()
+{
+  if( d_dynamic_weight_queue_enabled )
+    return;
+
+  d_dynamic_weight_queue.reset( d_alive.size() );
+
+  for( unsigned c = 0; c < d_alive.size(); ++c )
+  {
+    if( d_alive[c] )
+      d_dynamic_weight_queue.push( c, d_dynamic_weights[c] );
+  }
+
+  d_dynamic_weight_queue_enabled = true;
+}
+
+// Test if the dynamic weight queue is enabled
+bool BrachytherapyCandidateTable::isDynamicWeightQueueEnabled() const
+{
+  return d_dynamic_weight_queue_enabled;
+}
+
+// Return the alive candidate with the smallest dynamic weight
+/*! \details If several candidates share the smallest dynamic weight the
+ * first one is returned (the queue breaks ties by candidate index). If there
+ * are no alive candidates the number of candidates is returned (past-the-end
+ * candidate).
+ */
+unsigned
+BrachytherapyCandidateTable::findMinimumDynamicWeightCandidate() const
+{
+  if( d_dynamic_weight_queue_enabled )
+  {
+    if( d_dynamic_weight_queue.empty() )
+      return d_alive.size();
+    else
+      return d_dynamic_weight_queue.top();
+  }
+  
+  unsigned min_candidate = d_alive.size();
+
+  for( unsigned c = 0; c < d_alive.size(); ++c )
+  {
+    if( d_alive[c] && (min_candidate == d_alive.size() ||
+		       d_dynamic_weights[c] < d_dynamic_weights[min_candidate]))
+      min_candidate = c;
+  }
+
+  return min_candidate;
+}
+
+// Sort the candidates by base weight (smallest to largest)
+/*! \details The sort is stable so that candidates with equal base weights
+ * keep their relative order. Candidate indices obtained before the sort are
+ * invalidated.
+ */
+void BrachytherapyCandidateTable::sortByBaseWeight()
+{
+  // Make sure that the dynamic weight queue has not been enabled
+  testPrecondition( !d_dynamic_weight_queue_enabled );
+  // Make sure that the position index has not been built
+  testPrecondition( !isPositionIndexBuilt() );
+  
+  std::vector<unsigned> permutation( d_alive.size() );
+
+  for( unsigned c = 0; c < permutation.size(); ++c )
+    permutation[c] = c;
+
+  std::stable_sort( permutation.begin(),
+		    permutation.end(),
+		    BaseWeightLess( d_base_weights ) );
+
+  applyPermutation( d_x_indices, permutation );
+  applyPermutation( d_y_indices, permutation );
+  applyPermutation( d_z_indices, permutation );
+  applyPermutation( d_base_weights, permutation );
+  applyPermutation( d_dynamic_weights, permutation );
+  applyPermutation( d_seed_ids, permutation );
+  applyPermutation( d_alive, permutation );
+}
+
+// Build the position index (the candidates of each needle column)
+/*! \details The candidates of each needle column are stored in increasing
+ * order. The candidates are also grouped by seed position. The position ids
+ * are assigned in the order of the first candidate at each position and the
+ * candidates of each position are stored in increasing order. No candidates
+ * can be added once the index has been built.
+ */
+void BrachytherapyCandidateTable::buildPositionIndex()
+{
+  if( isPositionIndexBuilt() )
+    return;
+  
+  unsigned number_of_columns = d_mesh_x_dim*d_mesh_y_dim;
+
+  d_column_offsets.assign( number_of_columns + 1u, 0u );
+
+  // Count the candidates in each column
+  for( unsigned c = 0; c < d_alive.size(); ++c )
+    ++d_column_offsets[getNeedleIndex( c ) + 1u];
+
+  for( unsigned n = 0; n < number_of_columns; ++n )
+    d_column_offsets[n+1u] += d_column_offsets[n];
+
+  // Fill the columns
+  std::vector<unsigned> column_sizes( number_of_columns, 0u );
+  
+  d_column_candidates.resize( d_alive.size() );
+
+  for( unsigned c = 0; c < d_alive.size(); ++c )
+  {
+    unsigned needle_index = getNeedleIndex( c );
+
+    d_column_candidates[d_column_offsets[needle_index] + 
+			column_sizes[needle_index]] = c;
+
+    ++column_sizes[needle_index];
+  }
+
+  // Assign the position ids
+  const unsigned no_position = std::numeric_limits<unsigned>::max();
+  
+  std::vector<unsigned> mesh_position_ids( 
+		    d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim, no_position );
+
+  d_position_ids.resize( d_alive.size() );
+  d_position_offsets.assign( 1u, 0u );
+
+  for( unsigned c = 0; c < d_alive.size(); ++c )
+  {
+    unsigned position_index = getPositionIndex( c );
+
+    if( mesh_position_ids[position_index] == no_position )
+    {
+      mesh_position_ids[position_index] = d_position_offsets.size() - 1u;
+      
+      d_position_offsets.push_back( 0u );
+    }
+
+    d_position_ids[c] = mesh_position_ids[position_index];
+
+    ++d_position_offsets[d_position_ids[c] + 1u];
+  }
+
+  for( unsigned p = 0; p < d_position_offsets.size() - 1u; ++p )
+    d_position_offsets[p+1u] += d_position_offsets[p];
+
+  // Fill the positions
+  std::vector<unsigned> position_sizes( d_position_offsets.size() - 1u, 0u );
+
+  d_position_candidates.resize( d_alive.size() );
+
+  for( unsigned c = 0; c < d_alive.size(); ++c )
+  {
+    unsigned position_id = d_position_ids[c];
+
+    d_position_candidates[d_position_offsets[position_id] + 
+			  position_sizes[position_id]] = c;
+
+    ++position_sizes[position_id];
+  }
+}
+
+// Test if the position index has been built
+bool BrachytherapyCandidateTable::isPositionIndexBuilt() const
+{
+  return d_column_offsets.size() > 0;
+}
+
+// Return the number of candidates in a needle column (alive and dead)
+unsigned BrachytherapyCandidateTable::getNumberOfColumnCandidates(
+					    const unsigned needle_index ) const
+{
+  // Make sure that the position index has been built
+  testPrecondition( isPositionIndexBuilt() );
+  // Make sure that the needle index is valid
+  testPrecondition( needle_index < d_mesh_x_dim*d_mesh_y_dim );
+
+  return d_column_offsets[needle_index+1u] - d_column_offsets[needle_index];
+}
+
+// Return a candidate in a needle column (in increasing candidate order)
+unsigned BrachytherapyCandidateTable::getColumnCandidate(
+					       const unsigned needle_index,
+					       const unsigned i ) const
+{
+  // Make sure that the candidate is in the column
+  testPrecondition( i < getNumberOfColumnCandidates( needle_index ) );
+
+  return d_column_candidates[d_column_offsets[needle_index] + i];
+}
+
+// Return the number of seed positions (the position index must be built)
+unsigned BrachytherapyCandidateTable::getNumberOfPositions() const
+{
+  // Make sure that the position index has been built
+  testPrecondition( isPositionIndexBuilt() );
+
+  return d_position_offsets.size() - 1u;
+}
+
+// Return the position id of a candidate
+/*! \details The candidates of the different seeds at a mesh element share
+ * a position id.
+ */
+unsigned BrachytherapyCandidateTable::getPositionId( 
+					       const unsigned candidate ) const
+{
+  // Make sure that the position index has been built
+  testPrecondition( isPositionIndexBuilt() );
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_alive.size() );
+
+  return d_position_ids[candidate];
+}
+
+// Return the number of candidates at a position (alive and dead)
+unsigned BrachytherapyCandidateTable::getNumberOfPositionCandidates(
+					     const unsigned position_id ) const
+{
+  // Make sure that the position id is valid
+  testPrecondition( position_id < getNumberOfPositions() );
+
+  return d_position_offsets[position_id+1u] - d_position_offsets[position_id];
+}
+
+// Return a candidate at a position (in increasing candidate order)
+unsigned BrachytherapyCandidateTable::getPositionCandidate(
+					       const unsigned position_id,
+					       const unsigned i ) const
+{
+  // Make sure that the candidate is at the position
+  testPrecondition( i < getNumberOfPositionCandidates( position_id ) );
+
+  return d_position_candidates[d_position_offsets[position_id] + i];
+}
+
+// Add the alive candidates in a box of mesh elements to an array
+void BrachytherapyCandidateTable::findAliveCandidatesInBox(
+				       const DoseDistributionOverlap &box,
+				       std::vector<unsigned> &candidates ) const
+{
+  for( unsigned seed_id = 0; seed_id < d_seeds.size(); ++seed_id )
+    findAliveCandidatesInBox( box, seed_id, candidates );
+}
+
+// Add the alive candidates of a seed in a box of mesh elements to an array
+void BrachytherapyCandidateTable::findAliveCandidatesInBox(
+				       const DoseDistributionOverlap &box,
+				       const unsigned seed_id,
+				       std::vector<unsigned> &candidates ) const
+{
+  // Make sure that the position index has been built
+  testPrecondition( isPositionIndexBuilt() );
+  // Make sure that the seed id is valid
+  testPrecondition( seed_id < d_seeds.size() );
+  // Make sure that the box is valid
+  testPrecondition( box.x_start >= 0 );
+  testPrecondition( box.x_end <= (int)d_mesh_x_dim );
+  testPrecondition( box.y_start >= 0 );
+  testPrecondition( box.y_end <= (int)d_mesh_y_dim );
+
+  for( int j = box.y_start; j < box.y_end; ++j )
+  {
+    for( int i = box.x_start; i < box.x_end; ++i )
+    {
+      unsigned needle_index = i + j*d_mesh_x_dim;
+      
+      for( unsigned n = d_column_offsets[needle_index];
+	   n < d_column_offsets[needle_index+1u];
+	   ++n )
+      {
+	unsigned c = d_column_candidates[n];
+
+	if( d_alive[c] && d_seed_ids[c] == seed_id &&
+	    (int)d_z_indices[c] >= box.z_start && 
+	    (int)d_z_indices[c] < box.z_end )
+	  candidates.push_back( c );
+      }
+    }
+  }
+}
+
+// Remove the occupied candidates in the order of a full update pass
+/*! \details The greedy planners originally updated their candidates with a
+ * single pass over a list: an occupied candidate was erased and the 
+ * candidate that followed it was skipped (erasing the last candidate 
+ * restarted the pass at the first candidate). This method removes the 
+ * occupied candidates that such a pass would erase without visiting the 
+ * free candidates. The occupied candidates that are skipped stay alive and
+ * are returned in the occupied candidates array. The candidates that the 
+ * pass skips and never visits are returned in the skipped candidates array
+ * (in increasing order).
+ */
+void BrachytherapyCandidateTable::removeOccupiedCandidates(
+				   std::vector<unsigned> &occupied_candidates,
+				   std::vector<unsigned> &skipped_candidates )
+{
+  std::sort( occupied_candidates.begin(), occupied_candidates.end() );
+
+  const unsigned end_candidate = d_alive.size();
+
+  std::vector<unsigned> pass_skipped_candidates, intersection;
+  bool first_pass = true;
+
+  unsigned candidate = getFirstAliveCandidate();
+
+  while( true )
+  {
+    // Find the next occupied candidate that the pass visits
+    std::vector<unsigned>::const_iterator occupied_candidate = 
+      std::lower_bound( occupied_candidates.begin(),
+			occupied_candidates.end(),
+			candidate );
+
+    while( occupied_candidate != occupied_candidates.end() &&
+	   !d_alive[*occupied_candidate] )
+      ++occupied_candidate;
+
+    bool pass_complete = (occupied_candidate == occupied_candidates.end());
+    
+    if( !pass_complete )
+    {
+      removeCandidate( *occupied_candidate );
+
+      candidate = getNextAliveCandidate( *occupied_candidate );
+
+      if( candidate != end_candidate )
+      {
+	pass_skipped_candidates.push_back( candidate );
+
+	candidate = getNextAliveCandidate( candidate );
+
+	continue;
+      }
+      
+      // Removing the last candidate restarts the pass
+      candidate = getFirstAliveCandidate();
+    }
+
+    // A candidate is only skipped if it is skipped in every pass
+    if( first_pass )
+      skipped_candidates.swap( pass_skipped_candidates );
+    else
+    {
+      intersection.clear();
+      
+      std::set_intersection( skipped_candidates.begin(),
+			     skipped_candidates.end(),
+			     pass_skipped_candidates.begin(),
+			     pass_skipped_candidates.end(),
+			     std::back_inserter( intersection ) );
+
+      skipped_candidates.swap( intersection );
+    }
+
+    pass_skipped_candidates.clear();
+    first_pass = false;
+
+    if( pass_complete )
+      break;
+  }
+
+  // Only the alive candidates are returned
+  unsigned number_of_skipped_candidates = 0u;
+
+  for( unsigned i = 0; i < skipped_candidates.size(); ++i )
+  {
+    if( d_alive[skipped_candidates[i]] )
+    {
+      skipped_candidates[number_of_skipped_candidates] = 
+	skipped_candidates[i];
+      ++number_of_skipped_candidates;
+    }
+  }
+
+  skipped_candidates.resize( number_of_skipped_candidates );
+
+  unsigned number_of_occupied_candidates = 0u;
+
+  for( unsigned i = 0; i < occupied_candidates.size(); ++i )
+  {
+    if( d_alive[occupied_candidates[i]] )
+    {
+      occupied_candidates[number_of_occupied_candidates] = 
+	occupied_candidates[i];
+      ++number_of_occupied_candidates;
+    }
+  }
+
+  occupied_candidates.resize( number_of_occupied_candidates );
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyCandidateTable.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,256 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyCandidateTable.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy candidate seed position table class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_CANDIDATE_TABLE_HPP
+#define BRACHYTHERAPY_CANDIDATE_TABLE_HPP
+
+// Std Lib Includes
+#include <vector>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+
+// TPOR Includes
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "IndexedMinHeap.hpp"
+
+namespace TPOR{
+
+/*! Brachytherapy candidate seed position table
+ *
+ * The candidate seed positions of a treatment planner are stored as a
+ * structure of arrays (packed mesh indices, base weights, dynamic weights,
+ * seed ids and alive flags) so that the planners can scan, sort and search
+ * the candidates without chasing list nodes. The seeds are stored once in a
+ * seed table and each candidate only stores the id of its seed.
+ *
+ * Candidates are never erased from the table. A removed candidate is flagged
+ * as dead and is skipped by the alive candidate iteration methods, so
+ * candidate indices remain valid for the lifetime of the table. The mesh
+ * indices are relative to the patient region of interest.
+ *
+ * The greedy planners can enable a dynamic weight queue (an indexed min heap
+ * of the alive candidates). The queue is kept up to date by the dynamic
+ * weight and removal methods so that the candidate with the smallest dynamic
+ * weight is found without scanning the table. A position index (the 
+ * candidates of each needle column) can also be built so that the candidates
+ * in a box of mesh elements are found without scanning the table. The 
+ * position index also groups the candidates by seed position: the 
+ * candidates of the different seeds at a mesh element share a position id,
+ * so a planner can evaluate every seed at a position together.
+ */
+class BrachytherapyCandidateTable
+{
+
+public:
+
+  //! Constructor
+  BrachytherapyCandidateTable( const unsigned mesh_x_dim,
+			       const unsigned mesh_y_dim,
+			       const unsigned mesh_z_dim );
+
+  //! Destructor
+  ~BrachytherapyCandidateTable()
+  { /* ... */ }
+
+  //! Return the mesh x dimension
+  unsigned getMeshXDim() const;
+
+  //! Return the mesh y dimension
+  unsigned getMeshYDim() const;
+
+  //! Return the mesh z dimension
+  unsigned getMeshZDim() const;
+
+  //! Add a seed to the seed table and return the seed id
+  unsigned addSeed( const boost::shared_ptr<BrachytherapySeedProxy> &seed );
+
+  //! Reserve storage for a number of candidates
+  void reserve( const unsigned number_of_candidates );
+
+  //! Add a candidate seed position
+  void addCandidate( const unsigned x_index,
+		     const unsigned y_index,
+		     const unsigned z_index,
+		     const double weight,
+		     const unsigned seed_id );
+
+  //! Return the number of candidates (alive and dead)
+  unsigned getNumberOfCandidates() const;
+
+  //! Return the number of alive candidates
+  unsigned getNumberOfAliveCandidates() const;
+
+  //! Test if a candidate is alive
+  bool isAlive( const unsigned candidate ) const;
+
+  //! Remove a candidate (flag it as dead)
+  void removeCandidate( const unsigned candidate );
+
+  //! Return the first alive candidate
+  unsigned getFirstAliveCandidate() const;
+
+  //! Return the next alive candidate after a candidate
+  unsigned getNextAliveCandidate( const unsigned candidate ) const;
+
+  //! Return the x index of a candidate
+  unsigned getXIndex( const unsigned candidate ) const;
+
+  //! Return the y index of a candidate
+  unsigned getYIndex( const unsigned candidate ) const;
+
+  //! Return the z index of a candidate
+  unsigned getZIndex( const unsigned candidate ) const;
+
+  //! Return the needle index of a candidate
+  unsigned getNeedleIndex( const unsigned candidate ) const;
+
+  //! Return the mesh (position) index of a candidate
+  unsigned getPositionIndex( const unsigned candidate ) const;
+
+  //! Return the base weight of a candidate
+  double getBaseWeight( const unsigned candidate ) const;
+
+  //! Return the dynamic weight of a candidate
+  double getDynamicWeight( const unsigned candidate ) const;
+
+  //! Set the dynamic weight of a candidate
+  void setDynamicWeight( const unsigned candidate, const double weight );
+
+  //! Multiply the dynamic weight of a candidate by a multiplier
+  void multiplyDynamicWeight( const unsigned candidate,
+			      const double multiplier );
+
+  //! Return the number of seeds in the seed table
+  unsigned getNumberOfSeeds() const;
+
+  //! Return the seed with a seed id
+  const boost::shared_ptr<BrachytherapySeedProxy>&
+  getSeedWithId( const unsigned seed_id ) const;
+
+  //! Return the seed id of a candidate
+  unsigned getSeedId( const unsigned candidate ) const;
+
+  //! Return the seed of a candidate
+  const boost::shared_ptr<BrachytherapySeedProxy>&
+  getSeed( const unsigned candidate ) const;
+
+  //! Create the seed position of a candidate
+  BrachytherapySeedPosition createSeedPosition(
+					    const unsigned candidate ) const;
+
+  //! Enable the dynamic weight queue
+  void enableDynamicWeightQueue();
+
+  //! Test if the dynamic weight queue is enabled
+  bool isDynamicWeightQueueEnabled() const;
+
+  //! Return the alive candidate with the smallest dynamic weight
+  unsigned findMinimumDynamicWeightCandidate() const;
+
+  //! Sort the candidates by base weight (smallest to largest)
+  void sortByBaseWeight();
+
+  //! Build the position index (the candidates of each needle column)
+  void buildPositionIndex();
+
+  //! Test if the position index has been built
+  bool isPositionIndexBuilt() const;
+
+  //! Return the number of candidates in a needle column (alive and dead)
+  unsigned getNumberOfColumnCandidates( const unsigned needle_index ) const;
+
+  //! Return a candidate in a needle column (in increasing candidate order)
+  unsigned getColumnCandidate( const unsigned needle_index,
+			       const unsigned i ) const;
+
+  //! Return the number of seed positions (the position index must be built)
+  unsigned getNumberOfPositions() const;
+
+  //! Return the position id of a candidate
+  unsigned getPositionId( const unsigned candidate ) const;
+
+  //! Return the number of candidates at a position (alive and dead)
+  unsigned getNumberOfPositionCandidates( const unsigned position_id ) const;
+
+  //! Return a candidate at a position (in increasing candidate order)
+  unsigned getPositionCandidate( const unsigned position_id,
+				 const unsigned i ) const;
+
+  //! Add the alive candidates in a box of mesh elements to an array
+  void findAliveCandidatesInBox( const DoseDistributionOverlap &box,
+				 std::vector<unsigned> &candidates ) const;
+
+  //! Add the alive candidates of a seed in a box of mesh elements to an array
+  void findAliveCandidatesInBox( const DoseDistributionOverlap &box,
+				 const unsigned seed_id,
+				 std::vector<unsigned> &candidates ) const;
+
+  //! Remove the occupied candidates in the order of a full update pass
+  void removeOccupiedCandidates( std::vector<unsigned> &occupied_candidates,
+				 std::vector<unsigned> &skipped_candidates );
+
+private:
+
+  // Mesh dimensions
+  unsigned d_mesh_x_dim;
+  unsigned d_mesh_y_dim;
+  unsigned d_mesh_z_dim;
+
+  // Seed table
+  std::vector<boost::shared_ptr<BrachytherapySeedProxy> > d_seeds;
+
+  // Candidate x indices
+  std::vector<unsigned short> d_x_indices;
+
+  // Candidate y indices
+  std::vector<unsigned short> d_y_indices;
+
+  // Candidate z indices
+  std::vector<unsigned short> d_z_indices;
+
+  // Candidate base weights
+  std::vector<double> d_base_weights;
+
+  // Candidate dynamic weights
+  std::vector<double> d_dynamic_weights;
+
+  // Candidate seed ids
+  std::vector<unsigned char> d_seed_ids;
+
+  // Candidate alive flags
+  std::vector<unsigned char> d_alive;
+
+  // Number of alive candidates
+  unsigned d_number_of_alive_candidates;
+
+  // Dynamic weight queue (alive candidates)
+  bool d_dynamic_weight_queue_enabled;
+  IndexedMinHeap d_dynamic_weight_queue;
+
+  // Position index (candidates of needle column n are stored in
+  // [d_column_offsets[n], d_column_offsets[n+1]) of d_column_candidates)
+  std::vector<unsigned> d_column_offsets;
+  std::vector<unsigned> d_column_candidates;
+
+  // Position groups (the candidates at position p are stored in
+  // [d_position_offsets[p], d_position_offsets[p+1]) of 
+  // d_position_candidates)
+  std::vector<unsigned> d_position_ids;
+  std::vector<unsigned> d_position_offsets;
+  std::vector<unsigned> d_position_candidates;
+};
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_CANDIDATE_TABLE_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyCandidateTable.hpp
+//---------------------------------------------------------------------------//
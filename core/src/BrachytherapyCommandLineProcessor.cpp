@@ -8,6 +8,8 @@
 
 // Std Lib Includes
 #include <stdlib.h>
+#include <sstream>
+#include <algorithm>
 
 // Boost Includes
 #include <boost/program_options/cmdline.hpp>
@@ -28,13 +30,29 @@ BrachytherapyCommandLineProcessor::BrachytherapyCommandLineProcessor(
 								  int argc,
 								  char** argv )
   : d_patient_file(),
+    d_lazy_set_cover_evaluation( true ),
+    d_coarse_to_fine( false ),
+    d_coarse_to_fine_fallback( false ),
+    d_iiem_trial_search( false ),
+    d_iiem_verification_window( 0u ),
     d_seeds(),
     d_prescribed_dose(),
     d_urethra_weight(),
     d_rectum_weight(),
     d_margin_weight(),
+    d_structure_weights(),
     d_treatment_plan_os(),
-    d_dvh_os()
+    d_dvh_os(),
+    d_export_vtk( false ),
+    d_export_results( false ),
+    d_results_file(),
+    d_compact_results( false ),
+    d_loaded_plan_name(),
+    d_loaded_plan_file(),
+    d_robustness_scenarios( 0u ),
+    d_perturbation_model(),
+    d_dose_matrix_settings(),
+    d_number_of_threads( 0u )
 { 
   // Create the treatment planner names
   std::string planner_msg = "set the treatment planner:\n";
@@ -87,6 +105,43 @@ BrachytherapyCommandLineProcessor::BrachytherapyCommandLineProcessor(
     ("treatment_planner,t", 
      boost::program_options::value<std::string>()->default_value(SCMTreatmentPlanner::name.c_str()), 
      planner_msg.c_str())
+    ("eager_set_cover",
+     "re-evaluate the candidates near each selected seed in the "
+     "SCMTreatmentPlanner (by default only the candidates that reach the "
+     "top of the candidate queue are re-evaluated)\n")
+    ("iiem_search",
+     "search the needle goals and the isodose constants of the "
+     "IIEMTreatmentPlanner by bracketing and bisection instead of "
+     "trying them in increasing order (the plan can differ from the "
+     "plan of the scan if the trial success is not monotone)\n")
+    ("iiem_verification_window",
+     boost::program_options::value<unsigned>()->default_value(0u),
+     "set the number of trials below an IIEMTreatmentPlanner search "
+     "result that are tried in increasing order\n"
+     "default value: 0\n")
+    ("coarse_to_fine",
+     "run the treatment planner on a mesh that is downsampled in-plane "
+     "by 2 first and then on the full mesh with the needle template "
+     "positions around the chosen needles (all of the positions are used "
+     "if the coarse plan does not meet the prostate coverage goal)\n")
+    ("coarse_to_fine_fallback",
+     "run the treatment planner again with all candidates if a "
+     "coarse-to-fine plan does not meet the prostate coverage goal (the "
+     "plan with the highest coverage is kept)\n")
+    ("dose_matrix_memory",
+     boost::program_options::value<double>()->default_value(0.0),
+     "set the memory budget of the candidate dose matrix used by the "
+     "IIEMTreatmentPlanner and the SCMTreatmentPlanner (MB)\n"
+     "default value: 0.0 MB (no dose matrix)\n")
+    ("dose_matrix_threshold",
+     boost::program_options::value<double>()->default_value(0.0),
+     "set the dose threshold of the candidate dose matrix (Gy)\n"
+     "default value: 0.0 Gy\n")
+    ("dose_matrix_precision",
+     boost::program_options::value<std::string>()->default_value("double"),
+     "set the precision of the candidate dose matrix (double, float or "
+     "16bit)\n"
+     "default value: double\n")
     ("seed,s", 
      boost::program_options::value<std::vector<std::string> >()->multitoken()->composing(),
      seed_msg.c_str())
@@ -106,10 +161,74 @@ BrachytherapyCommandLineProcessor::BrachytherapyCommandLineProcessor(
      boost::program_options::value<double>()->default_value(1.0),
      "set the importance (weight) of the margin relative to the prostate\n"
      "default value: 1.0\n")
+    ("structure_weight",
+     boost::program_options::value<std::vector<std::string> >()->composing(),
+     "set the importance (weight) of any structure in the patient "
+     "organ_masks group relative to the prostate (arg = name=weight)\n"
+     "default value: 1.0\n")
     ("plan_output_file", boost::program_options::value<std::string>(),
      "set the treatment plan output file (with path)\n")
     ("dvh_output_file", boost::program_options::value<std::string>(),
-     "set the dose-volume-histogram output file (with path)\n");
+     "set the dose-volume-histogram output file (with path)\n")
+    ("export_vtk",
+     "export the patient data and the treatment plan to a vtk file\n")
+    ("export_results",
+     "export the treatment plan results to the patient hdf5 file\n")
+    ("results_file", boost::program_options::value<std::string>(),
+     "export the treatment plan results to a separate hdf5 file (with "
+     "path)\n")
+    ("compact_results",
+     "only export the seeds, the plan metrics and a 16-bit dose "
+     "distribution\n")
+    ("load_plan", boost::program_options::value<std::string>(),
+     "load an archived treatment plan (arg = plan name) from the results "
+     "file (the patient file if no results file is given) instead of "
+     "running the treatment planner - the dose distribution is rebuilt "
+     "from the seeds, which must be given\n")
+    ("robustness_scenarios",
+     boost::program_options::value<unsigned>()->default_value(0u),
+     "set the number of perturbed seed placements used to analyze the "
+     "robustness of the treatment plan\n"
+     "default value: 0 (no robustness analysis)\n")
+    ("shift_distribution",
+     boost::program_options::value<std::string>()->default_value("normal"),
+     "set the distribution of the seed and needle shifts (normal or "
+     "uniform)\n"
+     "default value: normal\n")
+    ("seed_shift",
+     boost::program_options::value<double>()->default_value(0.1),
+     "set the width of the per-seed shifts along every axis (cm) - the "
+     "standard deviation of normal shifts or the half-width of uniform "
+     "shifts\n"
+     "default value: 0.1 cm\n")
+    ("seed_shift_x", boost::program_options::value<double>(),
+     "set the width of the per-seed shifts along the x axis (cm)\n"
+     "default value: the seed_shift width\n")
+    ("seed_shift_y", boost::program_options::value<double>(),
+     "set the width of the per-seed shifts along the y axis (cm)\n"
+     "default value: the seed_shift width\n")
+    ("seed_shift_z", boost::program_options::value<double>(),
+     "set the width of the per-seed shifts along the z axis (cm)\n"
+     "default value: the seed_shift width\n")
+    ("needle_shift",
+     boost::program_options::value<double>()->default_value(0.1),
+     "set the width of the per-needle shifts along every axis (cm)\n"
+     "default value: 0.1 cm\n")
+    ("needle_shift_x", boost::program_options::value<double>(),
+     "set the width of the per-needle shifts along the x axis (cm)\n"
+     "default value: the needle_shift width\n")
+    ("needle_shift_y", boost::program_options::value<double>(),
+     "set the width of the per-needle shifts along the y axis (cm)\n"
+     "default value: the needle_shift width\n")
+    ("needle_shift_z", boost::program_options::value<double>(),
+     "set the width of the per-needle shifts along the z axis (the needle "
+     "insertion depth error) (cm)\n"
+     "default value: the needle_shift width\n")
+    ("threads",
+     boost::program_options::value<unsigned>()->default_value(0u),
+     "set the number of threads used by the treatment planner and the "
+     "robustness analysis (the plans do not depend on it)\n"
+     "default value: 0 (all hardware threads)\n");
 
   // Set the hidden program options (required args)
   boost::program_options::options_description hidden( "Hidden options" );
@@ -152,8 +271,15 @@ BrachytherapyCommandLineProcessor::BrachytherapyCommandLineProcessor(
   parseUrethraWeight( vm );
   parseRectumWeight( vm );
   parseMarginWeight( vm );
+  parseStructureWeights( vm );
   parseTreatmentPlanOutputFile( vm );
   parseDVHOutputFile( vm );
+  parseExportVTK( vm );
+  parseResultsFile( vm );
+  parseLoadedPlan( vm );
+  parseRobustnessOptions( vm );
+  parseDoseMatrixOptions( vm );
+  parseNumberOfThreads( vm );
 
   // Print a summary of the options specified by the user
   printUserOptionsSummary();
@@ -172,6 +298,38 @@ BrachytherapyCommandLineProcessor::getPlannerType() const
   return d_planner_type;
 }
 
+// Test if the set cover candidates should be evaluated lazily
+bool 
+BrachytherapyCommandLineProcessor::isLazySetCoverEvaluationRequested() const
+{
+  return d_lazy_set_cover_evaluation;
+}
+
+// Test if coarse-to-fine planning was requested
+bool BrachytherapyCommandLineProcessor::isCoarseToFineRequested() const
+{
+  return d_coarse_to_fine;
+}
+
+// Test if the full template fallback of coarse-to-fine planning was requested
+bool 
+BrachytherapyCommandLineProcessor::isCoarseToFineFallbackRequested() const
+{
+  return d_coarse_to_fine_fallback;
+}
+
+// Test if the IIEM trials should be searched (instead of scanned)
+bool BrachytherapyCommandLineProcessor::isIIEMTrialSearchRequested() const
+{
+  return d_iiem_trial_search;
+}
+
+// Return the IIEM search verification window (number of trials)
+unsigned BrachytherapyCommandLineProcessor::getIIEMVerificationWindow() const
+{
+  return d_iiem_verification_window;
+}
+
 // Return the brachytherapy seeds
 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> >&
 BrachytherapyCommandLineProcessor::getSeeds() const
@@ -207,6 +365,13 @@ double BrachytherapyCommandLineProcessor::getMarginWeight() const
   return d_margin_weight;
 }
 
+//! Return the additional structure weights (structure name, weight)
+const std::map<std::string,double>& 
+BrachytherapyCommandLineProcessor::getStructureWeights() const
+{
+  return d_structure_weights;
+}
+
 // Get the treatment plan output stream
 std::ostream& BrachytherapyCommandLineProcessor::getTreatmentPlanOutputStream()
 {
@@ -225,6 +390,79 @@ std::ostream& BrachytherapyCommandLineProcessor::getDVHOutputStream()
     return std::cout;
 }
 
+// Test if the patient data should be exported to a vtk file
+bool BrachytherapyCommandLineProcessor::isVTKExportRequested() const
+{
+  return d_export_vtk;
+}
+
+// Test if the treatment plan results should be exported to an hdf5 file
+bool BrachytherapyCommandLineProcessor::isResultsExportRequested() const
+{
+  return d_export_results;
+}
+
+// Return the treatment plan results hdf5 file
+/*! \details The patient file will be returned if only the export_results
+ * option was given.
+ */
+const std::string& BrachytherapyCommandLineProcessor::getResultsFile() const
+{
+  return d_results_file;
+}
+
+// Test if the treatment plan results should be archived compactly
+bool BrachytherapyCommandLineProcessor::isCompactResultsRequested() const
+{
+  return d_compact_results;
+}
+
+// Test if an archived treatment plan should be loaded (not planned)
+bool BrachytherapyCommandLineProcessor::isPlanLoadRequested() const
+{
+  return d_loaded_plan_name.size() > 0;
+}
+
+// Return the name of the archived treatment plan to load
+const std::string& 
+BrachytherapyCommandLineProcessor::getLoadedPlanName() const
+{
+  return d_loaded_plan_name;
+}
+
+// Return the hdf5 file of the archived treatment plan to load
+const std::string& 
+BrachytherapyCommandLineProcessor::getLoadedPlanFile() const
+{
+  return d_loaded_plan_file;
+}
+
+// Return the number of threads (0 = all hardware threads)
+unsigned BrachytherapyCommandLineProcessor::getNumberOfThreads() const
+{
+  return d_number_of_threads;
+}
+
+// Return the dose matrix settings
+const BrachytherapyDoseMatrixSettings& 
+BrachytherapyCommandLineProcessor::getDoseMatrixSettings() const
+{
+  return d_dose_matrix_settings;
+}
+
+// Return the number of robustness analysis scenarios
+unsigned BrachytherapyCommandLineProcessor::getRobustnessScenarios() const
+{
+  return d_robustness_scenarios;
+}
+
+// Return the seed placement perturbation model
+const BrachytherapyPerturbationModel& 
+BrachytherapyCommandLineProcessor::getPerturbationModel() const
+{
+  return d_perturbation_model;
+}
+
 // Parse the patient file
 void BrachytherapyCommandLineProcessor::parsePatientFile( 
 				    boost::program_options::variables_map &vm )
@@ -302,6 +540,20 @@ void BrachytherapyCommandLineProcessor::parseTreatmentPlannerType(
 	      << std::endl;
     exit( 1 );
   }
+
+  if( vm.count( "eager_set_cover" ) )
+    d_lazy_set_cover_evaluation = false;
+
+  if( vm.count( "coarse_to_fine" ) )
+    d_coarse_to_fine = true;
+
+  if( vm.count( "coarse_to_fine_fallback" ) )
+    d_coarse_to_fine_fallback = true;
+
+  if( vm.count( "iiem_search" ) )
+    d_iiem_trial_search = true;
+
+  d_iiem_verification_window = vm["iiem_verification_window"].as<unsigned>();
 }
 
 // Parse the brachytherapy seeds
@@ -463,6 +715,47 @@ void BrachytherapyCommandLineProcessor::parseMarginWeight(
   }
 }
 
+// Parse the additional structure weights
+/*! \details Each structure weight has the form name=weight. Whether the 
+ * structure exists is only checked once the patient file is loaded.
+ */
+void BrachytherapyCommandLineProcessor::parseStructureWeights( 
+				    boost::program_options::variables_map &vm )
+{
+  if( vm.count( "structure_weight" ) )
+  {
+    const std::vector<std::string> &structure_weights = 
+      vm["structure_weight"].as<std::vector<std::string> >();
+
+    for( unsigned i = 0; i < structure_weights.size(); ++i )
+    {
+      std::string::size_type loc = structure_weights[i].find( '=' );
+
+      if( loc == std::string::npos || loc == 0 )
+      {
+	std::cout << "The structure weight " << structure_weights[i]
+		  << " must have the form name=weight" << std::endl;
+
+	exit( 1 );
+      }
+
+      std::istringstream iss( structure_weights[i].substr( loc+1 ) );
+      double weight;
+      iss >> weight;
+
+      if( iss.fail() || !iss.eof() || weight <= 0.0 )
+      {
+	std::cout << "The " << structure_weights[i].substr( 0, loc )
+		  << " weight must be greater than 0.0" << std::endl;
+
+	exit( 1 );
+      }
+
+      d_structure_weights[structure_weights[i].substr( 0, loc )] = weight;
+    }
+  }
+}
+
 // Parse the treatment plan output file name
 void BrachytherapyCommandLineProcessor::parseTreatmentPlanOutputFile( 
 				    boost::program_options::variables_map &vm )
@@ -492,6 +785,160 @@ void BrachytherapyCommandLineProcessor::parseDVHOutputFile(
   }
 }
 
+// Parse the vtk export flag
+void BrachytherapyCommandLineProcessor::parseExportVTK( 
+				    boost::program_options::variables_map &vm )
+{
+  if( vm.count( "export_vtk" ) )
+    d_export_vtk = true;
+}
+
+// Parse the treatment plan results file name
+void BrachytherapyCommandLineProcessor::parseResultsFile( 
+				    boost::program_options::variables_map &vm )
+{
+  if( vm.count( "results_file" ) )
+  {
+    d_export_results = true;
+    
+    d_results_file = vm["results_file"].as<std::string>();
+  }
+  else if( vm.count( "export_results" ) )
+  {
+    d_export_results = true;
+    
+    d_results_file = d_patient_file;
+  }
+
+  if( vm.count( "compact_results" ) )
+    d_compact_results = true;
+}
+
+// Parse the archived treatment plan to load
+/*! \details A loaded plan is not exported again.
+ */
+void BrachytherapyCommandLineProcessor::parseLoadedPlan( 
+				    boost::program_options::variables_map &vm )
+{
+  if( vm.count( "load_plan" ) )
+  {
+    d_loaded_plan_name = vm["load_plan"].as<std::string>();
+
+    if( d_loaded_plan_name.empty() )
+    {
+      std::cout << "The name of the treatment plan to load must be "
+		<< "specified." << std::endl;
+      
+      exit( 1 );
+    }
+
+    if( vm.count( "results_file" ) )
+      d_loaded_plan_file = d_results_file;
+    else
+      d_loaded_plan_file = d_patient_file;
+
+    d_export_results = false;
+  }
+}
+
+// Parse the robustness analysis options
+void BrachytherapyCommandLineProcessor::parseRobustnessOptions( 
+				    boost::program_options::variables_map &vm )
+{
+  d_robustness_scenarios = vm["robustness_scenarios"].as<unsigned>();
+
+  std::string distribution = vm["shift_distribution"].as<std::string>();
+
+  if( distribution == "normal" )
+    d_perturbation_model.distribution = NORMAL_PERTURBATION;
+  else if( distribution == "uniform" )
+    d_perturbation_model.distribution = UNIFORM_PERTURBATION;
+  else
+  {
+    std::cout << "The shift distribution " << distribution
+	      << " is not valid (normal or uniform)." << std::endl;
+    
+    exit( 1 );
+  }
+
+  // The axis widths default to the width of every axis
+  double seed_width = vm["seed_shift"].as<double>();
+  double needle_width = vm["needle_shift"].as<double>();
+
+  d_perturbation_model.seed_x_width = (vm.count( "seed_shift_x" ) ?
+				       vm["seed_shift_x"].as<double>() :
+				       seed_width);
+  d_perturbation_model.seed_y_width = (vm.count( "seed_shift_y" ) ?
+				       vm["seed_shift_y"].as<double>() :
+				       seed_width);
+  d_perturbation_model.seed_z_width = (vm.count( "seed_shift_z" ) ?
+				       vm["seed_shift_z"].as<double>() :
+				       seed_width);
+  d_perturbation_model.needle_x_width = (vm.count( "needle_shift_x" ) ?
+					 vm["needle_shift_x"].as<double>() :
+					 needle_width);
+  d_perturbation_model.needle_y_width = (vm.count( "needle_shift_y" ) ?
+					 vm["needle_shift_y"].as<double>() :
+					 needle_width);
+  d_perturbation_model.needle_z_width = (vm.count( "needle_shift_z" ) ?
+					 vm["needle_shift_z"].as<double>() :
+					 needle_width);
+
+  if( d_perturbation_model.seed_x_width < 0.0 || 
+      d_perturbation_model.seed_y_width < 0.0 ||
+      d_perturbation_model.seed_z_width < 0.0 ||
+      d_perturbation_model.needle_x_width < 0.0 || 
+      d_perturbation_model.needle_y_width < 0.0 ||
+      d_perturbation_model.needle_z_width < 0.0 )
+  {
+    std::cout << "The seed and needle shifts must be positive." << std::endl;
+    
+    exit( 1 );
+  }
+}
+
+// Parse the dose matrix options
+void BrachytherapyCommandLineProcessor::parseDoseMatrixOptions( 
+				    boost::program_options::variables_map &vm )
+{
+  d_dose_matrix_settings.memory_budget = 
+    vm["dose_matrix_memory"].as<double>();
+  d_dose_matrix_settings.dose_threshold = 
+    vm["dose_matrix_threshold"].as<double>()*100;
+
+  if( d_dose_matrix_settings.memory_budget < 0.0 || 
+      d_dose_matrix_settings.dose_threshold < 0.0 )
+  {
+    std::cout << "The dose matrix memory and threshold must be positive." 
+	      << std::endl;
+    
+    exit( 1 );
+  }
+
+  std::string precision = vm["dose_matrix_precision"].as<std::string>();
+
+  if( precision == "double" )
+    d_dose_matrix_settings.precision = DOUBLE_DOSE_MATRIX;
+  else if( precision == "float" )
+    d_dose_matrix_settings.precision = FLOAT_DOSE_MATRIX;
+  else if( precision == "16bit" )
+    d_dose_matrix_settings.precision = QUANTIZED_DOSE_MATRIX;
+  else
+  {
+    std::cout << "The dose matrix precision " << precision 
+	      << " is not valid (double, float or 16bit)." << std::endl;
+    
+    exit( 1 );
+  }
+}
+
+// Parse the number of threads
+void BrachytherapyCommandLineProcessor::parseNumberOfThreads( 
+				    boost::program_options::variables_map &vm )
+{
+  d_number_of_threads = vm["threads"].as<unsigned>();
+}
+
 // Print the user options summary
 void BrachytherapyCommandLineProcessor::printUserOptionsSummary()
 {
@@ -503,14 +950,53 @@ void BrachytherapyCommandLineProcessor::printUserOptionsSummary()
   {
   case IIEM_TREATMENT_PLANNER:
     std::cout << "IIEMTreatmentPlanner" << std::endl;
+    std::cout << "trial selection:      ";
+    if( d_iiem_trial_search )
+    {
+      std::cout << "search (verification window " 
+		<< d_iiem_verification_window << ")";
+    }
+    else
+      std::cout << "scan";
+    std::cout << std::endl;
     break;
   case DWDMM_TREATMENT_PLANNER:
     std::cout << "DWDMMTreatmentPlanner" << std::endl;
     break;
   case SCM_TREATMENT_PLANNER:
     std::cout << "SCMTreatmentPlanner" << std::endl;
+    std::cout << "set cover evaluation: " 
+	      << (d_lazy_set_cover_evaluation ? "lazy" : "eager") << std::endl;
     break;
   }
+
+  std::cout << "coarse-to-fine:       " 
+	    << (d_coarse_to_fine ? "yes" : "no");
+  if( d_coarse_to_fine && d_coarse_to_fine_fallback )
+    std::cout << " (full template fallback)";
+  std::cout << std::endl;
+
+  std::cout << "dose matrix memory:   ";
+  if( d_dose_matrix_settings.memory_budget > 0.0 )
+  {
+    std::cout << d_dose_matrix_settings.memory_budget << " MB (threshold "
+	      << d_dose_matrix_settings.dose_threshold/100 << " Gy, ";
+    switch( d_dose_matrix_settings.precision )
+    {
+    case DOUBLE_DOSE_MATRIX:
+      std::cout << "double)";
+      break;
+    case FLOAT_DOSE_MATRIX:
+      std::cout << "float)";
+      break;
+    case QUANTIZED_DOSE_MATRIX:
+      std::cout << "16bit)";
+      break;
+    }
+  }
+  else
+    std::cout << "none";
+  std::cout << std::endl;
   
   std::cout << "seeds:                ";
   for( unsigned i = 0; i < d_seeds.size(); ++i )
@@ -527,6 +1013,51 @@ void BrachytherapyCommandLineProcessor::printUserOptionsSummary()
   std::cout << "urethra weight:       " << d_urethra_weight << std::endl;
   std::cout << "rectum weight:        " << d_rectum_weight << std::endl;
   std::cout << "margin weight:        " << d_margin_weight << std::endl;
+  
+  std::map<std::string,double>::const_iterator structure_weight = 
+    d_structure_weights.begin();
+
+  while( structure_weight != d_structure_weights.end() )
+  {
+    std::string label = structure_weight->first + " weight:";
+    label.resize( std::max( label.size()+1, (std::string::size_type)22 ), 
+		  ' ' );
+    
+    std::cout << label << structure_weight->second << std::endl;
+
+    ++structure_weight;
+  }
+  
+  std::cout << "export vtk:           " << (d_export_vtk ? "yes" : "no")
+	    << std::endl;
+  std::cout << "results file:         " 
+	    << (d_export_results ? d_results_file : "none") << std::endl;
+  std::cout << "compact results:      " << (d_compact_results ? "yes" : "no")
+	    << std::endl;
+  if( isPlanLoadRequested() )
+  {
+    std::cout << "loaded plan:          " << d_loaded_plan_name << " ("
+	      << d_loaded_plan_file << ")" << std::endl;
+  }
+  std::cout << "robustness scenarios: " << d_robustness_scenarios;
+  if( d_robustness_scenarios > 0 )
+  {
+    std::cout << " ("
+	      << (d_perturbation_model.distribution == NORMAL_PERTURBATION ?
+		  "normal" : "uniform")
+	      << " seed shift " << d_perturbation_model.seed_x_width << "/"
+	      << d_perturbation_model.seed_y_width << "/"
+	      << d_perturbation_model.seed_z_width << " cm, needle shift "
+	      << d_perturbation_model.needle_x_width << "/"
+	      << d_perturbation_model.needle_y_width << "/"
+	      << d_perturbation_model.needle_z_width << " cm)";
+  }
+  std::cout << std::endl;
+  std::cout << "threads:              ";
+  if( d_number_of_threads > 0 )
+    std::cout << d_number_of_threads << std::endl;
+  else
+    std::cout << "all" << std::endl;
 }
 
 } // end TPOR namespace
@@ -11,6 +11,7 @@
 
 // Std Lib Includes
 #include <vector>
+#include <map>
 #include <iostream>
 #include <fstream>
 
@@ -23,6 +24,8 @@
 // TPOR Includes
 #include "BrachytherapySeedProxy.hpp"
 #include "BrachytherapyTreatmentPlannerType.hpp"
+#include "BrachytherapyDoseMatrix.hpp"
+#include "BrachytherapyPlanRobustnessAnalyzer.hpp"
 
 namespace TPOR{
 
@@ -45,6 +48,22 @@ public:
   //! Return the treament planner type
   BrachytherapyTreatmentPlannerType getPlannerType() const;
 
+  //! Test if the set cover candidates should be evaluated lazily
+  bool isLazySetCoverEvaluationRequested() const;
+
+  //! Test if coarse-to-fine planning was requested
+  bool isCoarseToFineRequested() const;
+
+  //! Test if the full template fallback of coarse-to-fine planning was 
+  //! requested
+  bool isCoarseToFineFallbackRequested() const;
+
+  //! Test if the IIEM trials should be searched (instead of scanned)
+  bool isIIEMTrialSearchRequested() const;
+
+  //! Return the IIEM search verification window (number of trials)
+  unsigned getIIEMVerificationWindow() const;
+
   //! Return the brachytherapy seeds
   const std::vector<boost::shared_ptr<BrachytherapySeedProxy> >& 
   getSeeds() const;
@@ -61,12 +80,48 @@ public:
   //! Return the margin weight
   double getMarginWeight() const;
 
+  //! Return the additional structure weights (structure name, weight)
+  const std::map<std::string,double>& getStructureWeights() const;
+
   //! Get the treatment plan output stream
   std::ostream& getTreatmentPlanOutputStream();
   
   //! Get the dose-volume-histogram output stream
   std::ostream& getDVHOutputStream();
 
+  //! Test if the patient data should be exported to a vtk file
+  bool isVTKExportRequested() const;
+
+  //! Test if the treatment plan results should be exported to an hdf5 file
+  bool isResultsExportRequested() const;
+
+  //! Return the treatment plan results hdf5 file
+  const std::string& getResultsFile() const;
+
+  //! Test if the treatment plan results should be archived compactly
+  bool isCompactResultsRequested() const;
+
+  //! Test if an archived treatment plan should be loaded (not planned)
+  bool isPlanLoadRequested() const;
+
+  //! Return the name of the archived treatment plan to load
+  const std::string& getLoadedPlanName() const;
+
+  //! Return the hdf5 file of the archived treatment plan to load
+  const std::string& getLoadedPlanFile() const;
+
+  //! Return the number of threads (0 = all hardware threads)
+  unsigned getNumberOfThreads() const;
+
+  //! Return the dose matrix settings
+  const BrachytherapyDoseMatrixSettings& getDoseMatrixSettings() const;
+
+  //! Return the number of robustness analysis scenarios
+  unsigned getRobustnessScenarios() const;
+
+  //! Return the seed placement perturbation model
+  const BrachytherapyPerturbationModel& getPerturbationModel() const;
+
 private:
 
   //! Parse the patient file
@@ -93,6 +148,9 @@ private:
   //! Parse the margin weight
   void parseMarginWeight( boost::program_options::variables_map &vm );
 
+  //! Parse the additional structure weights
+  void parseStructureWeights( boost::program_options::variables_map &vm );
+
   //! Parse the treatment plan output file name
   void parseTreatmentPlanOutputFile( 
 				   boost::program_options::variables_map &vm );
@@ -100,6 +158,24 @@ private:
   //! Parse the dose-volume-histogram output file name
   void parseDVHOutputFile( boost::program_options::variables_map &vm );
 
+  //! Parse the vtk export flag
+  void parseExportVTK( boost::program_options::variables_map &vm );
+
+  //! Parse the treatment plan results file name
+  void parseResultsFile( boost::program_options::variables_map &vm );
+
+  //! Parse the archived treatment plan to load
+  void parseLoadedPlan( boost::program_options::variables_map &vm );
+
+  //! Parse the robustness analysis options
+  void parseRobustnessOptions( boost::program_options::variables_map &vm );
+
+  //! Parse the number of threads
+  void parseNumberOfThreads( boost::program_options::variables_map &vm );
+
+  //! Parse the dose matrix options
+  void parseDoseMatrixOptions( boost::program_options::variables_map &vm );
+
   //! Print the user options summary
   void printUserOptionsSummary();
 
@@ -112,6 +188,21 @@ private:
   // The treatment planner type
   BrachytherapyTreatmentPlannerType d_planner_type;
 
+  // Evaluate the set cover candidates lazily
+  bool d_lazy_set_cover_evaluation;
+
+  // Plan on a downsampled mesh first
+  bool d_coarse_to_fine;
+
+  // Plan with all candidates if a coarse-to-fine plan fails
+  bool d_coarse_to_fine_fallback;
+
+  // Search the IIEM trials
+  bool d_iiem_trial_search;
+
+  // The IIEM search verification window
+  unsigned d_iiem_verification_window;
+
   // The seeds
   std::vector<boost::shared_ptr<BrachytherapySeedProxy> > d_seeds;
 
@@ -127,11 +218,45 @@ private:
   // The margin weight
   double d_margin_weight;
 
+  // The additional structure weights
+  std::map<std::string,double> d_structure_weights;
+
   // The treatment plan output file
   boost::scoped_ptr<std::ostream> d_treatment_plan_os;
 
   // The dose-volume-histogram output file
   boost::scoped_ptr<std::ostream>  d_dvh_os;
+
+  // Export the patient data to a vtk file
+  bool d_export_vtk;
+
+  // Export the treatment plan results to an hdf5 file
+  bool d_export_results;
+
+  // The treatment plan results file
+  std::string d_results_file;
+
+  // Archive the treatment plan results compactly (seeds, metrics and 
+  // quantized dose)
+  bool d_compact_results;
+
+  // The name of the archived treatment plan to load (empty if none)
+  std::string d_loaded_plan_name;
+
+  // The hdf5 file of the archived treatment plan to load
+  std::string d_loaded_plan_file;
+
+  // The number of robustness analysis scenarios
+  unsigned d_robustness_scenarios;
+
+  // The seed placement perturbation model
+  BrachytherapyPerturbationModel d_perturbation_model;
+
+  // The dose matrix settings
+  BrachytherapyDoseMatrixSettings d_dose_matrix_settings;
+
+  // The number of threads
+  unsigned d_number_of_threads;
 };
 
 } // end TPOR namespace
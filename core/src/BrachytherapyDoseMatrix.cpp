@@ -0,0 +1,437 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyDoseMatrix.cpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy candidate dose deposition matrix class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <limits>
+
+// Boost Includes
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+// TPOR Includes
+#include "BrachytherapyDoseMatrix.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+//! Calculate the dose that a row of doses adds below a dose limit
+template<typename T>
+double calculateRowCoverage( const unsigned *mesh_indices,
+			     const T *doses,
+			     const unsigned long number_of_entries,
+			     const double scale,
+			     const std::vector<double> &dose_distribution,
+			     const double dose_limit )
+{
+  double coverage = 0.0;
+
+  for( unsigned long e = 0; e < number_of_entries; ++e )
+  {
+    double dose = dose_distribution[mesh_indices[e]];
+
+    if( dose < dose_limit )
+    {
+      double future_dose = dose + doses[e]*scale;
+
+      if( future_dose < dose_limit )
+	coverage += future_dose - dose;
+      else
+	coverage += dose_limit - dose;
+    }
+  }
+
+  return coverage;
+}
+
+//! Calculate the sum of a row of doses truncated at a dose limit
+template<typename T>
+double calculateRowTruncatedDose( const T *doses,
+				  const unsigned long number_of_entries,
+				  const double scale,
+				  const double dose_limit )
+{
+  double truncated_dose = 0.0;
+
+  for( unsigned long e = 0; e < number_of_entries; ++e )
+  {
+    double dose = doses[e]*scale;
+
+    if( dose > dose_limit )
+      truncated_dose += dose_limit;
+    else
+      truncated_dose += dose;
+  }
+
+  return truncated_dose;
+}
+
+// Constructor
+/*! \details The entries of each row are counted first so that the matrix
+ * can be checked against the memory budget before it is stored. The rows
+ * are divided among the threads (all available hardware threads if the
+ * number of threads is 0).
+ */
+BrachytherapyDoseMatrix::BrachytherapyDoseMatrix(
+			    const BrachytherapyCandidateTable &candidates,
+			    const std::vector<bool> &structure_mask,
+			    const BrachytherapyDoseMatrixSettings &settings,
+			    const unsigned number_of_threads )
+  : d_precision( settings.precision ),
+    d_dose_threshold( settings.dose_threshold ),
+    d_stored( false ),
+    d_number_of_rows( candidates.getNumberOfCandidates() ),
+    d_number_of_entries( 0ul ),
+    d_row_offsets( candidates.getNumberOfCandidates() + 1u, 0ul ),
+    d_mesh_indices(),
+    d_double_doses(),
+    d_float_doses(),
+    d_quantized_doses(),
+    d_row_scales()
+{
+  // Make sure that the structure mask is valid
+  testPrecondition( structure_mask.size() == candidates.getMeshXDim()*
+		    candidates.getMeshYDim()*candidates.getMeshZDim() );
+  // Make sure that the settings are valid
+  testPrecondition( settings.memory_budget > 0.0 );
+  testPrecondition( settings.dose_threshold >= 0.0 );
+
+  unsigned threads = number_of_threads;
+
+  if( threads == 0 )
+    threads = std::max( boost::thread::hardware_concurrency(), 1u );
+
+  threads = std::min( threads, std::max( d_number_of_rows, 1u ) );
+
+  // Count the entries of each row
+  processRows( candidates, structure_mask, false, threads );
+
+  for( unsigned row = 0; row < d_number_of_rows; ++row )
+    d_row_offsets[row+1] += d_row_offsets[row];
+
+  d_number_of_entries = d_row_offsets.back();
+
+  // Only store the matrix if it fits in the memory budget
+  if( calculateMemoryUsage( d_number_of_entries ) > settings.memory_budget )
+    return;
+
+  d_mesh_indices.resize( d_number_of_entries );
+
+  switch( d_precision )
+  {
+  case DOUBLE_DOSE_MATRIX:
+    d_double_doses.resize( d_number_of_entries );
+    break;
+  case FLOAT_DOSE_MATRIX:
+    d_float_doses.resize( d_number_of_entries );
+    break;
+  case QUANTIZED_DOSE_MATRIX:
+    d_quantized_doses.resize( d_number_of_entries );
+    d_row_scales.resize( d_number_of_rows );
+    break;
+  }
+
+  // Store the entries of each row
+  processRows( candidates, structure_mask, true, threads );
+
+  d_stored = true;
+}
+
+// Test if the matrix was stored (it fits in the memory budget)
+bool BrachytherapyDoseMatrix::isStored() const
+{
+  return d_stored;
+}
+
+// Return the number of rows (candidates)
+unsigned BrachytherapyDoseMatrix::getNumberOfRows() const
+{
+  return d_number_of_rows;
+}
+
+// Return the number of stored doses
+unsigned long BrachytherapyDoseMatrix::getNumberOfEntries() const
+{
+  return d_number_of_entries;
+}
+
+// Return the memory used by the matrix (MB)
+double BrachytherapyDoseMatrix::getMemoryUsage() const
+{
+  if( d_stored )
+    return calculateMemoryUsage( d_number_of_entries );
+  else
+    return 0.0;
+}
+
+// Calculate the dose that a candidate adds below a dose limit
+/*! \details Only the mesh elements with a dose below the limit contribute.
+ * The contribution of each mesh element is the candidate dose, truncated
+ * so that the total dose does not exceed the limit. With a zero dose
+ * threshold and double precision the result is identical to the sum over
+ * the seed dose mesh.
+ */
+double BrachytherapyDoseMatrix::calculateCoverage(
+			  const unsigned candidate,
+			  const std::vector<double> &dose_distribution,
+			  const double dose_limit ) const
+{
+  // Make sure that the matrix has been stored
+  testPrecondition( d_stored );
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_number_of_rows );
+
+  unsigned long offset = d_row_offsets[candidate];
+  unsigned long number_of_entries = d_row_offsets[candidate+1] - offset;
+
+  if( number_of_entries == 0 )
+    return 0.0;
+
+  const unsigned *mesh_indices = &d_mesh_indices[0] + offset;
+
+  switch( d_precision )
+  {
+  case FLOAT_DOSE_MATRIX:
+    return calculateRowCoverage( mesh_indices,
+				 &d_float_doses[0] + offset,
+				 number_of_entries,
+				 1.0,
+				 dose_distribution,
+				 dose_limit );
+  case QUANTIZED_DOSE_MATRIX:
+    return calculateRowCoverage( mesh_indices,
+				 &d_quantized_doses[0] + offset,
+				 number_of_entries,
+				 d_row_scales[candidate],
+				 dose_distribution,
+				 dose_limit );
+  default:
+    return calculateRowCoverage( mesh_indices,
+				 &d_double_doses[0] + offset,
+				 number_of_entries,
+				 1.0,
+				 dose_distribution,
+				 dose_limit );
+  }
+}
+
+// Calculate the sum of the candidate doses truncated at a dose limit
+double BrachytherapyDoseMatrix::calculateTruncatedDose(
+					       const unsigned candidate,
+					       const double dose_limit ) const
+{
+  // Make sure that the matrix has been stored
+  testPrecondition( d_stored );
+  // Make sure that the candidate is valid
+  testPrecondition( candidate < d_number_of_rows );
+
+  unsigned long offset = d_row_offsets[candidate];
+  unsigned long number_of_entries = d_row_offsets[candidate+1] - offset;
+
+  if( number_of_entries == 0 )
+    return 0.0;
+
+  switch( d_precision )
+  {
+  case FLOAT_DOSE_MATRIX:
+    return calculateRowTruncatedDose( &d_float_doses[0] + offset,
+				      number_of_entries,
+				      1.0,
+				      dose_limit );
+  case QUANTIZED_DOSE_MATRIX:
+    return calculateRowTruncatedDose( &d_quantized_doses[0] + offset,
+				      number_of_entries,
+				      d_row_scales[candidate],
+				      dose_limit );
+  default:
+    return calculateRowTruncatedDose( &d_double_doses[0] + offset,
+				      number_of_entries,
+				      1.0,
+				      dose_limit );
+  }
+}
+
+// Count or store the rows of every n-th candidate
+/*! \details When counting, the number of entries of row c is stored in
+ * d_row_offsets[c+1]. Every thread only writes the entries of its own rows.
+ */
+void BrachytherapyDoseMatrix::processRowStride(
+			       const BrachytherapyCandidateTable &candidates,
+			       const std::vector<bool> &structure_mask,
+			       const bool store,
+			       const unsigned first_row,
+			       const unsigned stride )
+{
+  const unsigned mesh_x_dim = candidates.getMeshXDim();
+  const unsigned mesh_y_dim = candidates.getMeshYDim();
+  const unsigned mesh_z_dim = candidates.getMeshZDim();
+
+  std::vector<unsigned> row_mesh_indices;
+  std::vector<double> row_doses;
+
+  for( unsigned row = first_row; row < d_number_of_rows; row += stride )
+  {
+    row_mesh_indices.clear();
+    row_doses.clear();
+
+    const int x_index = candidates.getXIndex( row );
+    const int y_index = candidates.getYIndex( row );
+    const int z_index = candidates.getZIndex( row );
+
+    const BrachytherapySeedProxy &seed = *candidates.getSeed( row );
+
+    // Only the mesh elements that overlap the seed mesh receive dose
+    DoseDistributionOverlap overlap =
+      seed.getDoseDistributionOverlap( x_index,
+				       y_index,
+				       z_index,
+				       mesh_x_dim,
+				       mesh_y_dim,
+				       mesh_z_dim );
+
+    for( int k = overlap.z_start; k < overlap.z_end; ++k )
+    {
+      for( int j = overlap.y_start; j < overlap.y_end; ++j )
+      {
+	unsigned row_index = j*mesh_x_dim + k*mesh_x_dim*mesh_y_dim;
+
+	const double* seed_dose_row =
+	  seed.getTotalDoseRow( overlap.x_start - x_index,
+				j - y_index,
+				k - z_index );
+
+	for( int i = overlap.x_start; i < overlap.x_end; ++i )
+	{
+	  unsigned index = i + row_index;
+	  double dose = seed_dose_row[i - overlap.x_start];
+
+	  if( structure_mask[index] && dose > d_dose_threshold )
+	  {
+	    row_mesh_indices.push_back( index );
+	    row_doses.push_back( dose );
+	  }
+	}
+      }
+    }
+
+    if( store )
+      storeRow( row, row_mesh_indices, row_doses );
+    else
+      d_row_offsets[row+1] = row_doses.size();
+  }
+}
+
+// Process the rows of the candidates in parallel
+void BrachytherapyDoseMatrix::processRows(
+			       const BrachytherapyCandidateTable &candidates,
+			       const std::vector<bool> &structure_mask,
+			       const bool store,
+			       const unsigned number_of_threads )
+{
+  if( number_of_threads <= 1 )
+  {
+    processRowStride( candidates, structure_mask, store, 0u, 1u );
+  }
+  else
+  {
+    boost::thread_group thread_group;
+
+    for( unsigned i = 0; i < number_of_threads; ++i )
+    {
+      thread_group.create_thread(
+	      boost::bind( &BrachytherapyDoseMatrix::processRowStride,
+			   this,
+			   boost::cref( candidates ),
+			   boost::cref( structure_mask ),
+			   store,
+			   i,
+			   number_of_threads ) );
+    }
+
+    thread_group.join_all();
+  }
+}
+
+// Store a row
+/*! \details The quantized doses of a row are scaled so that the largest
+ * dose of the row is mapped to the largest 16-bit integer.
+ */
+void BrachytherapyDoseMatrix::storeRow( 
+				     const unsigned row,
+				     const std::vector<unsigned> &mesh_indices,
+				     const std::vector<double> &doses )
+{
+  // Make sure that the row has been counted
+  testPrecondition( doses.size() == 
+		    d_row_offsets[row+1] - d_row_offsets[row] );
+
+  unsigned long offset = d_row_offsets[row];
+
+  std::copy( mesh_indices.begin(),
+	     mesh_indices.end(),
+	     d_mesh_indices.begin() + offset );
+
+  switch( d_precision )
+  {
+  case DOUBLE_DOSE_MATRIX:
+    std::copy( doses.begin(), doses.end(), d_double_doses.begin() + offset );
+    break;
+  case FLOAT_DOSE_MATRIX:
+    for( unsigned e = 0; e < doses.size(); ++e )
+      d_float_doses[offset+e] = static_cast<float>( doses[e] );
+    break;
+  case QUANTIZED_DOSE_MATRIX:
+    {
+      double max_dose = 0.0;
+      
+      if( doses.size() > 0 )
+	max_dose = *std::max_element( doses.begin(), doses.end() );
+
+      double scale = max_dose/std::numeric_limits<unsigned short>::max();
+
+      d_row_scales[row] = scale;
+
+      for( unsigned e = 0; e < doses.size(); ++e )
+      {
+	d_quantized_doses[offset+e] =
+	  static_cast<unsigned short>( doses[e]/scale + 0.5 );
+      }
+    }
+    break;
+  }
+}
+
+// Calculate the memory needed by the matrix (MB)
+double BrachytherapyDoseMatrix::calculateMemoryUsage(
+			       const unsigned long number_of_entries ) const
+{
+  double bytes = d_row_offsets.size()*sizeof(unsigned long) +
+    number_of_entries*sizeof(unsigned);
+
+  switch( d_precision )
+  {
+  case DOUBLE_DOSE_MATRIX:
+    bytes += number_of_entries*sizeof(double);
+    break;
+  case FLOAT_DOSE_MATRIX:
+    bytes += number_of_entries*sizeof(float);
+    break;
+  case QUANTIZED_DOSE_MATRIX:
+    bytes += number_of_entries*sizeof(unsigned short) +
+      d_number_of_rows*sizeof(double);
+    break;
+  }
+
+  return bytes/(1024.0*1024.0);
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyDoseMatrix.cpp
+//---------------------------------------------------------------------------//
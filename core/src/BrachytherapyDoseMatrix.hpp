@@ -0,0 +1,159 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyDoseMatrix.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy candidate dose deposition matrix class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_DOSE_MATRIX_HPP
+#define BRACHYTHERAPY_DOSE_MATRIX_HPP
+
+// Std Lib Includes
+#include <vector>
+
+// TPOR Includes
+#include "BrachytherapyCandidateTable.hpp"
+
+namespace TPOR{
+
+//! Dose matrix value precisions
+enum BrachytherapyDoseMatrixPrecision{
+  DOUBLE_DOSE_MATRIX = 0,
+  FLOAT_DOSE_MATRIX,
+  QUANTIZED_DOSE_MATRIX
+};
+
+/*! Dose matrix settings
+ *
+ * The planners only use a dose matrix if the memory budget is positive.
+ * Doses that are not above the dose threshold are not stored. The quantized
+ * doses are 16-bit integers that are scaled by the largest dose of each row.
+ */
+struct BrachytherapyDoseMatrixSettings
+{
+  BrachytherapyDoseMatrixSettings()
+    : memory_budget( 0.0 ),
+      dose_threshold( 0.0 ),
+      precision( DOUBLE_DOSE_MATRIX )
+  { /* ... */ }
+
+  // The memory budget (MB)
+  double memory_budget;
+
+  // The dose threshold (cGy)
+  double dose_threshold;
+
+  // The value precision
+  BrachytherapyDoseMatrixPrecision precision;
+};
+
+/*! Brachytherapy candidate dose deposition matrix
+ *
+ * The dose that each candidate seed position deposits in the mesh elements
+ * of a structure (e.g. the prostate) is stored as a sparse matrix in
+ * compressed sparse row format. Row c holds the mesh indices and the doses
+ * of candidate c (in increasing mesh index order), so the dose sums of the
+ * planners become sparse dot products instead of walks over the seed dose
+ * meshes. The candidate indices must not change (e.g. by sorting the
+ * candidate table) after the matrix is created. The rows are filled in
+ * parallel. If the matrix would exceed its memory budget it is not stored
+ * and the planners fall back to the seed dose meshes.
+ */
+class BrachytherapyDoseMatrix
+{
+
+public:
+
+  //! Constructor
+  BrachytherapyDoseMatrix( const BrachytherapyCandidateTable &candidates,
+			   const std::vector<bool> &structure_mask,
+			   const BrachytherapyDoseMatrixSettings &settings,
+			   const unsigned number_of_threads = 0u );
+
+  //! Destructor
+  ~BrachytherapyDoseMatrix()
+  { /* ... */ }
+
+  //! Test if the matrix was stored (it fits in the memory budget)
+  bool isStored() const;
+
+  //! Return the number of rows (candidates)
+  unsigned getNumberOfRows() const;
+
+  //! Return the number of stored doses
+  unsigned long getNumberOfEntries() const;
+
+  //! Return the memory used by the matrix (MB)
+  double getMemoryUsage() const;
+
+  //! Calculate the dose that a candidate adds below a dose limit
+  double calculateCoverage( const unsigned candidate,
+			    const std::vector<double> &dose_distribution,
+			    const double dose_limit ) const;
+
+  //! Calculate the sum of the candidate doses truncated at a dose limit
+  double calculateTruncatedDose( const unsigned candidate,
+				 const double dose_limit ) const;
+
+private:
+
+  //! Count or store the rows of every n-th candidate
+  void processRowStride( const BrachytherapyCandidateTable &candidates,
+			 const std::vector<bool> &structure_mask,
+			 const bool store,
+			 const unsigned first_row,
+			 const unsigned stride );
+
+  //! Process the rows of the candidates in parallel
+  void processRows( const BrachytherapyCandidateTable &candidates,
+		    const std::vector<bool> &structure_mask,
+		    const bool store,
+		    const unsigned number_of_threads );
+
+  //! Store a row
+  void storeRow( const unsigned row,
+		 const std::vector<unsigned> &mesh_indices,
+		 const std::vector<double> &doses );
+
+  //! Calculate the memory needed by the matrix (MB)
+  double calculateMemoryUsage( const unsigned long number_of_entries ) const;
+
+  // The value precision
+  BrachytherapyDoseMatrixPrecision d_precision;
+
+  // The dose threshold
+  double d_dose_threshold;
+
+  // The matrix has been stored
+  bool d_stored;
+
+  // The number of rows
+  unsigned d_number_of_rows;
+
+  // The number of stored doses
+  unsigned long d_number_of_entries;
+
+  // The row offsets (the entries of row c are stored in
+  // [d_row_offsets[c], d_row_offsets[c+1]))
+  std::vector<unsigned long> d_row_offsets;
+
+  // The mesh index of each entry
+  std::vector<unsigned> d_mesh_indices;
+
+  // The doses of each entry (only one array is used)
+  std::vector<double> d_double_doses;
+  std::vector<float> d_float_doses;
+  std::vector<unsigned short> d_quantized_doses;
+
+  // The quantized dose scale of each row
+  std::vector<double> d_row_scales;
+};
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_DOSE_MATRIX_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyDoseMatrix.hpp
+//---------------------------------------------------------------------------//
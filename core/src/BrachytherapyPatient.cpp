@@ -8,30 +8,29 @@
 
 // Std Lib Includes
 #include <algorithm>
+#include <iterator>
 #include <iomanip>
 #include <map>
 
-// Boost Includes
-#include <boost/scoped_ptr.hpp>
-
-// MOAB Includes
-#include <moab/Interface.hpp>
-#include <moab/Core.hpp>
-#include <moab/Range.hpp>
-
 // TPOR Includes
 #include "BrachytherapyPatient.hpp"
-#include "BrachytherapyPatientFileHandler.hpp"
 #include "ContractException.hpp"
 #include "ExceptionTestMacros.hpp"
 #include "ExceptionCatchMacros.hpp"
-#include "BinarySearch.hpp"
-#include "Interpolation.hpp"
+#include "DoseVolumeHelpers.hpp"
+#include "VTKStructuredPointsWriter.hpp"
+#include "BrachytherapyPlanFileHandler.hpp"
+#include "BrachytherapySeedHelpers.hpp"
 
 namespace TPOR{
 
+// Initialize the saved state checkpoint name static member
+const std::string BrachytherapyPatient::saved_state_checkpoint_name = 
+  "saved_state";
+
 // Constructor
-/*! \details the prescribed dose must be in units of cGy
+/*! \details the prescribed dose must be in units of cGy. The patient 
+ * geometry will be loaded from the patient file and will not be shared.
  */ 
 BrachytherapyPatient::BrachytherapyPatient( 
 					  const std::string &patient_file_name,
@@ -39,86 +38,50 @@ BrachytherapyPatient::BrachytherapyPatient(
 					  const double urethra_weight,
 					  const double rectum_weight,
 					  const double margin_weight )
-  : d_patient_file_name( patient_file_name ),
-    d_prescribed_dose( prescribed_dose ),
+  : d_geometry( new BrachytherapyPatientGeometry( patient_file_name,
+						  prescribed_dose,
+						  urethra_weight,
+						  rectum_weight,
+						  margin_weight ) ),
+    d_mesh_x_dim( d_geometry->getOrganMeshXDim() ),
+    d_mesh_y_dim( d_geometry->getOrganMeshYDim() ),
+    d_mesh_z_dim( d_geometry->getOrganMeshZDim() ),
+    d_treatment_plan(),
+    d_treatment_plan_needles(),
+    d_treatment_plan_positions(),
+    d_dose_distribution( d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim, 0.0 ),
+    d_plan_journal(),
+    d_checkpoints()
+{ /* ... */ }
+
+// Constructor
+/*! \details The patient geometry can be shared by any number of patients
+ * (treatment plan states). Only the treatment plan and the dose distribution
+ * are stored by each patient.
+ */
+BrachytherapyPatient::BrachytherapyPatient( 
+	 const boost::shared_ptr<const BrachytherapyPatientGeometry> &geometry )
+  : d_geometry( geometry ),
     d_mesh_x_dim( 0u ),
     d_mesh_y_dim( 0u ),
     d_mesh_z_dim( 0u ),
-    d_prostate_relative_vol( 0u ),
-    d_urethra_relative_vol( 0u ),
-    d_rectum_relative_vol( 0u ),
-    d_normal_relative_vol( 0u ),
-    d_urethra_weight( urethra_weight ),
-    d_rectum_weight( rectum_weight ),
-    d_margin_weight( margin_weight ),
-    d_prostate_mask(),
-    d_urethra_mask(),
-    d_margin_mask(),
-    d_rectum_mask(),
-    d_needle_template(),
     d_treatment_plan(),
     d_treatment_plan_needles(),
     d_treatment_plan_positions(),
     d_dose_distribution(),
-    d_cached_treatment_plan(),
-    d_cached_treatment_plan_needles(),
-    d_cached_treatment_plan_positions(),
-    d_cached_dose_distribution()
-{
-  // Make sure the prescribed dose is valid
-  testPrecondition( prescribed_dose > 0.0 );
-  // Make sure that the organ weights are valid
-  testPrecondition( urethra_weight > 0.0 );
-  testPrecondition( rectum_weight > 0.0 );
-  testPrecondition( margin_weight > 0.0 );
-  
-  std::cout << std::endl << "creating patient..." << std::endl;
-
-  // Create the file handler for the patient
-  BrachytherapyPatientFileHandler patient_file( d_patient_file_name );
-
-  // Load in the mesh dimensions
-  std::vector<unsigned> mesh_dimensions;
-  patient_file.getOrganMeshDimensions( mesh_dimensions );
-  
-  d_mesh_x_dim = mesh_dimensions[0];
-  d_mesh_y_dim = mesh_dimensions[1];
-  d_mesh_z_dim = mesh_dimensions[2];
-
-  mesh_dimensions.clear();
-
-  // Load the prostate mask relative volume
-  patient_file.getProstateMaskRelativeVolume( d_prostate_relative_vol );
-  
-  // Load in the prostate mask
-  patient_file.getProstateMask( d_prostate_mask );
-
-  // Load the urethra mask relative volume
-  patient_file.getUrethraMaskRelativeVolume( d_urethra_relative_vol );
-  
-  // Load in the urethra mask
-  patient_file.getUrethraMask( d_urethra_mask );
-  
-  // Load in the margin mask
-  patient_file.getMarginMask( d_margin_mask );
+    d_plan_journal(),
+    d_checkpoints()
+{
+  // Make sure the geometry is valid
+  testPrecondition( geometry );
 
-  // Load the rectum mask relative volume
-  patient_file.getRectumMaskRelativeVolume( d_rectum_relative_vol );
+  d_mesh_x_dim = d_geometry->getOrganMeshXDim();
+  d_mesh_y_dim = d_geometry->getOrganMeshYDim();
+  d_mesh_z_dim = d_geometry->getOrganMeshZDim();
   
-  // Load in the rectum mask
-  patient_file.getRectumMask( d_rectum_mask );
-
-  // Set the normal tissue relative volume
-  d_normal_relative_vol = d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim -
-    d_prostate_relative_vol - d_urethra_relative_vol - d_rectum_relative_vol;
-
-  // Load in the needle template
-  patient_file.getNeedleTemplate( d_needle_template );
-
-  // Resize the dose distribution vectors
+  // Resize the dose distribution vector
   unsigned size = d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim;
   d_dose_distribution.resize( size, 0.0 );
-  d_cached_dose_distribution.resize( size, 0.0 );
 }
 
 // Insert a seed at the desired seed position and return the seed id number
@@ -131,6 +94,8 @@ unsigned BrachytherapyPatient::insertSeed(
   // Map the seed dose distribution to the patient dose distribution
   if( d_treatment_plan.size() == 0 )
   {
+    journalDoseDistribution( 0u, d_mesh_z_dim );
+    
     seed_position.mapSeedDoseDistribution<Equal>( d_dose_distribution,
 						  d_mesh_x_dim,
 						  d_mesh_y_dim,
@@ -138,31 +103,148 @@ unsigned BrachytherapyPatient::insertSeed(
   }
   else
   {
+    DoseDistributionOverlap overlap = 
+      seed_position.getDoseDistributionOverlap( d_mesh_x_dim,
+						d_mesh_y_dim,
+						d_mesh_z_dim );
+    
+    journalDoseDistribution( overlap.z_start, overlap.z_end );
+    
     seed_position.mapSeedDoseDistribution<PlusEqual>( d_dose_distribution,
 						      d_mesh_x_dim,
 						      d_mesh_y_dim,
 						      d_mesh_z_dim );
   }
 
+  journalPlanOperation( INSERT_SEED_OPERATION, 
+			seed_position, 
+			d_treatment_plan.size() );
+  
   d_treatment_plan.push_back( seed_position );
 
-  unsigned needle_index = seed_position.getXIndex() +
-    seed_position.getYIndex()*d_mesh_x_dim;
-  d_treatment_plan_needles.insert( needle_index );
+  addToPlanSets( seed_position );
 
-  unsigned seed_index = needle_index + 
-    seed_position.getZIndex()*d_mesh_x_dim*d_mesh_y_dim;
-  d_treatment_plan_positions.insert( seed_index );
+  return d_treatment_plan.size();
+}
+
+// Remove the seed at the desired seed position
+void BrachytherapyPatient::removeSeed( 
+			       const BrachytherapySeedPosition &seed_position )
+{
+  // Make sure that a seed has been inserted at the seed position
+  testPrecondition( !isSeedPositionFree( seed_position ) );
+
+  std::list<BrachytherapySeedPosition>::iterator inserted_seed_position = 
+    std::find( d_treatment_plan.begin(), 
+	       d_treatment_plan.end(), 
+	       seed_position );
+  
+  // Remove the seed dose distribution from the patient dose distribution
+  // Note: the dose distribution is cleared exactly when the last seed is 
+  //       removed so that no round-off from the subtractions remains
+  if( d_treatment_plan.size() == 1 )
+  {
+    journalDoseDistribution( 0u, d_mesh_z_dim );
+    
+    std::fill( d_dose_distribution.begin(), d_dose_distribution.end(), 0.0 );
+  }
+  else
+  {
+    DoseDistributionOverlap overlap = 
+      inserted_seed_position->getDoseDistributionOverlap( d_mesh_x_dim,
+							  d_mesh_y_dim,
+							  d_mesh_z_dim );
+    
+    journalDoseDistribution( overlap.z_start, overlap.z_end );
+    
+    inserted_seed_position->mapSeedDoseDistribution<MinusEqual>( 
+							   d_dose_distribution,
+							   d_mesh_x_dim,
+							   d_mesh_y_dim,
+							   d_mesh_z_dim );
+  }
+
+  journalPlanOperation( REMOVE_SEED_OPERATION,
+			*inserted_seed_position,
+			std::distance( d_treatment_plan.begin(), 
+				       inserted_seed_position ) );
+
+  removeFromPlanSets( *inserted_seed_position );
+  
+  d_treatment_plan.erase( inserted_seed_position );
+}
+
+// Move an inserted seed to a new seed position
+/*! \details The moved seed keeps its place (id number) in the treatment plan.
+ */
+void BrachytherapyPatient::moveSeed( 
+		       const BrachytherapySeedPosition &old_seed_position,
+		       const BrachytherapySeedPosition &new_seed_position )
+{
+  // Make sure that a seed has been inserted at the old seed position
+  testPrecondition( !isSeedPositionFree( old_seed_position ) );
+  // Make sure that the new seed position hasn't already been added
+  testPrecondition( isSeedPositionFree( new_seed_position ) );
+
+  std::list<BrachytherapySeedPosition>::iterator inserted_seed_position = 
+    std::find( d_treatment_plan.begin(), 
+	       d_treatment_plan.end(), 
+	       old_seed_position );
+
+  // Update the patient dose distribution
+  if( d_treatment_plan.size() == 1 )
+  {
+    journalDoseDistribution( 0u, d_mesh_z_dim );
+    
+    new_seed_position.mapSeedDoseDistribution<Equal>( d_dose_distribution,
+						      d_mesh_x_dim,
+						      d_mesh_y_dim,
+						      d_mesh_z_dim );
+  }
+  else
+  {
+    DoseDistributionOverlap old_overlap = 
+      inserted_seed_position->getDoseDistributionOverlap( d_mesh_x_dim,
+							  d_mesh_y_dim,
+							  d_mesh_z_dim );
+    DoseDistributionOverlap new_overlap = 
+      new_seed_position.getDoseDistributionOverlap( d_mesh_x_dim,
+						    d_mesh_y_dim,
+						    d_mesh_z_dim );
+    
+    journalDoseDistribution( old_overlap.z_start, old_overlap.z_end );
+    journalDoseDistribution( new_overlap.z_start, new_overlap.z_end );
+    
+    inserted_seed_position->mapSeedDoseDistribution<MinusEqual>( 
+							   d_dose_distribution,
+							   d_mesh_x_dim,
+							   d_mesh_y_dim,
+							   d_mesh_z_dim );
+    
+    new_seed_position.mapSeedDoseDistribution<PlusEqual>( d_dose_distribution,
+							  d_mesh_x_dim,
+							  d_mesh_y_dim,
+							  d_mesh_z_dim );
+  }
+
+  journalPlanOperation( MOVE_SEED_OPERATION,
+			*inserted_seed_position,
+			std::distance( d_treatment_plan.begin(), 
+				       inserted_seed_position ) );
+
+  // Update the needle and position sets
+  removeFromPlanSets( *inserted_seed_position );
+  addToPlanSets( new_seed_position );
+
+  *inserted_seed_position = new_seed_position;
 }
 
 // Test if the seed position lies on an inserted needle
 bool BrachytherapyPatient::isSeedOnNeedle( 
 			 const BrachytherapySeedPosition &seed_position ) const
 {
-  unsigned needle_index = seed_position.getXIndex() +
-    seed_position.getYIndex()*d_mesh_x_dim;
-  
-  if( d_treatment_plan_needles.count( needle_index ) == 1 )
+  if( d_treatment_plan_needles.count( calculateNeedleIndex( seed_position ) )
+      == 1 )
     return true;
   else
     return false;
@@ -172,16 +254,31 @@ bool BrachytherapyPatient::isSeedOnNeedle(
 bool BrachytherapyPatient::isSeedPositionFree( 
 			 const BrachytherapySeedPosition &seed_position ) const
 {
-  unsigned seed_index = seed_position.getXIndex() +
-    seed_position.getYIndex()*d_mesh_x_dim +
-    seed_position.getZIndex()*d_mesh_x_dim*d_mesh_y_dim;
-  
-  if( d_treatment_plan_positions.count( seed_index ) == 0 )
+  if( d_treatment_plan_positions.count( 
+				 calculatePositionIndex( seed_position ) ) == 0 )
     return true;
   else
     return false;
 }
 
+// Test if the candidate seed position lies on an inserted needle
+bool BrachytherapyPatient::isSeedOnNeedle( 
+			    const BrachytherapyCandidateTable &candidates,
+			    const unsigned candidate ) const
+{
+  return d_treatment_plan_needles.count( 
+			       candidates.getNeedleIndex( candidate ) ) == 1;
+}
+
+// Test if the candidate seed position is free
+bool BrachytherapyPatient::isSeedPositionFree( 
+			    const BrachytherapyCandidateTable &candidates,
+			    const unsigned candidate ) const
+{
+  return d_treatment_plan_positions.count( 
+			     candidates.getPositionIndex( candidate ) ) == 0;
+}
+
 // Return the dose at a seed position
 double BrachytherapyPatient::getDose( 
 			const BrachytherapySeedPosition &seed_position ) const
@@ -190,6 +287,14 @@ double BrachytherapyPatient::getDose(
 		  seed_position.getYIndex(),
 		  seed_position.getZIndex() );
 }
+
+// Return the dose at a candidate seed position (cGy)
+double BrachytherapyPatient::getDose( 
+				const BrachytherapyCandidateTable &candidates,
+				const unsigned candidate ) const
+{
+  return d_dose_distribution[candidates.getPositionIndex( candidate )];
+}
   
 // Return the dose at a mesh point (cGy)
 double BrachytherapyPatient::getDose( const unsigned x_mesh_index,
@@ -207,76 +312,101 @@ double BrachytherapyPatient::getDose( const unsigned x_mesh_index,
   return d_dose_distribution[index];
 }
 
+// Return the patient geometry
+const boost::shared_ptr<const BrachytherapyPatientGeometry>& 
+BrachytherapyPatient::getGeometry() const
+{
+  return d_geometry;
+}
+
 // Return the prescribed dose
 double BrachytherapyPatient::getPrescribedDose() const
 {
-  return d_prescribed_dose;
+  return d_geometry->getPrescribedDose();
 }
-  
+
 // Return the organ mesh x dimension
 unsigned BrachytherapyPatient::getOrganMeshXDim() const
 {
   return d_mesh_x_dim;
 }
-  
+
 // Return the organ mesh y dimension
 unsigned BrachytherapyPatient::getOrganMeshYDim() const
 {
   return d_mesh_y_dim;
 }
-  
+
 // Return the organ mesh z dimension
 unsigned BrachytherapyPatient::getOrganMeshZDim() const
 {
   return d_mesh_z_dim;
 }
 
-// Return the prostate mask size (number of prostate elements)
+// Return the prostate volume
 double BrachytherapyPatient::getProstateVolume() const
 {
-  return d_prostate_relative_vol*0.1*0.1*0.5;
+  return d_geometry->getProstateVolume();
 }
 
-// Return the urethra mask size (number of urethra elements)
+// Return the urethra volume
 double BrachytherapyPatient::getUrethraVolume() const
 {
-  return d_urethra_relative_vol*0.1*0.1*0.5;
+  return d_geometry->getUrethraVolume();
 }
 
-// Return the rectum mask size (number of rectum elements)
+// Return the rectum volume
 double BrachytherapyPatient::getRectumVolume() const
 {
-  return d_rectum_relative_vol*0.1*0.1*0.5;
+  return d_geometry->getRectumVolume();
 }
 
-// Return the normal mask size (number of normal elements)
+// Return the normal volume
 double BrachytherapyPatient::getNormalVolume() const
 {
-  return d_normal_relative_vol*0.1*0.1*0.5;
+  return d_geometry->getNormalVolume();
 }
 
-// Return the prostate size (num prostate elements)
+// Return the prostate size
 unsigned BrachytherapyPatient::getProstateSize() const
 {
-  return d_prostate_relative_vol;
+  return d_geometry->getProstateSize();
 }
 
-// Return the urethra size (num urethra elements)
+// Return the urethra size
 unsigned BrachytherapyPatient::getUrethraSize() const
 {
-  return d_urethra_relative_vol;
+  return d_geometry->getUrethraSize();
 }
 
-// Return the rectum size (num rectum elements)
+// Return the rectum size
 unsigned BrachytherapyPatient::getRectumSize() const
 {
-  return d_rectum_relative_vol;
+  return d_geometry->getRectumSize();
 }
 
-// Return the normal size (num normal elements)
+// Return the normal size
 unsigned BrachytherapyPatient::getNormalSize() const
 {
-  return d_normal_relative_vol;
+  return d_geometry->getNormalSize();
+}
+
+// Return the prostate mask
+const std::vector<bool>& BrachytherapyPatient::getProstateMask() const
+{
+  return d_geometry->getProstateMask();
+}
+
+// Return the urethra mask
+const std::vector<bool>& BrachytherapyPatient::getUrethraMask() const
+{
+  return d_geometry->getUrethraMask();
+}
+
+// Return the rectum mask
+const std::vector<bool>& BrachytherapyPatient::getRectumMask() const
+{
+  return d_geometry->getRectumMask();
 }
 
 // Return the tissue type at a mesh point
@@ -285,193 +415,152 @@ TissueType BrachytherapyPatient::getTissueType(
 					    const unsigned y_mesh_index,
 					    const unsigned z_mesh_index ) const
 {
-  // Make sure that the indices are valid
-  testPrecondition( x_mesh_index < d_mesh_x_dim );
-  testPrecondition( y_mesh_index < d_mesh_y_dim );
-  testPrecondition( z_mesh_index < d_mesh_z_dim );
-
-  unsigned index = x_mesh_index + y_mesh_index*d_mesh_x_dim +
-    z_mesh_index*d_mesh_x_dim*d_mesh_y_dim;
-  
-  if( d_prostate_mask[index] )
-    return PROSTATE_TISSUE;
-  else if( d_urethra_mask[index] )
-    return URETHRA_TISSUE;
-  else if( d_rectum_mask[index] )
-    return RECTUM_TISSUE;
-  else if( d_margin_mask[index] )
-    return MARGIN_TISSUE;
-  else
-    return NORMAL_TISSUE;
+  return d_geometry->getTissueType( x_mesh_index, y_mesh_index, z_mesh_index );
 }
 
-// Return the prostate dose coverage
-double BrachytherapyPatient::getProstatePrescribedDoseCoverage() const
+// Add the candidate seed positions for the desired seeds to a table
+/*! \details The candidates are the prostate mesh elements along the needle
+ * template positions (only the template positions that are also in the 
+ * candidate needle mask, indexed by needle index, if the mask is not empty).
+ * They are added seed by seed, needle by needle and slice by slice. The base
+ * weight of each candidate is the adjoint weight of its position.
+ */
+void BrachytherapyPatient::getCandidateSeedPositions( 
+	  const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	  BrachytherapyCandidateTable &candidates,
+	  const std::vector<bool> &candidate_needle_mask ) const
 {
-  unsigned number_elements_covered = 0;
+  // Make sure that there is at least one seed
+  testPrecondition( seeds.size() > 0 );
+  // Make sure that the candidate needle mask is valid
+  testPrecondition( candidate_needle_mask.empty() ||
+		    candidate_needle_mask.size() == d_mesh_x_dim*d_mesh_y_dim );
   
-  for( unsigned i = 0; i < d_dose_distribution.size(); ++i )
+  const std::vector<bool>& prostate_mask = d_geometry->getProstateMask();
+
+  // The template positions that can hold candidates
+  std::vector<bool> candidate_needles = d_geometry->getNeedleTemplate();
+
+  for( unsigned i = 0; i < candidate_needle_mask.size(); ++i )
+    candidate_needles[i] = candidate_needles[i] && candidate_needle_mask[i];
+
+  // Every prostate element on the template can be a candidate of every seed
+  unsigned template_prostate_size = 0u;
+  
+  for( unsigned index = 0; index < prostate_mask.size(); ++index )
   {
-    if( d_prostate_mask[i] && d_dose_distribution[i] > d_prescribed_dose )
-      ++number_elements_covered;
+    if( prostate_mask[index] && 
+	candidate_needles[index % (d_mesh_x_dim*d_mesh_y_dim)] )
+      ++template_prostate_size;
   }
 
-  return (double)number_elements_covered/d_prostate_relative_vol;
-}
+  candidates.reserve( candidates.getNumberOfCandidates() + 
+		      seeds.size()*template_prostate_size );
 
-// Return the dose covering a portion of the prostate
-/*! \details The dose returned has units of Gy.
- */
-double BrachytherapyPatient::getDoseCoveringProstate( 
-					  const double fraction_covered ) const
-{
-  // Make sure the fraction covered is between 0 and 1
-  testPrecondition( fraction_covered >= 0.0 );
-  testPrecondition( fraction_covered <= 1.0 );
+  std::vector<std::vector<double> > structure_adjoint_data;
 
-  std::vector<double> prostate_doses( d_prostate_relative_vol );
-
-  for( unsigned i = 0, j = 0; i < d_dose_distribution.size(); ++i )
+  for( unsigned s = 0; s < seeds.size(); ++s )
   {
-    if( d_prostate_mask[i] )
+    unsigned seed_id = candidates.addSeed( seeds[s] );
+    
+    // Load or generate the adjoint data for the desired seed
+    d_geometry->getAdjointData( seeds[s], structure_adjoint_data );
+
+    // Filter potential seed positions to those along the template positions
+    for( unsigned j = 0; j < d_mesh_y_dim; ++j )
     {
-      prostate_doses[j] = d_dose_distribution[i];
-      ++j;
+      for( unsigned i = 0; i < d_mesh_x_dim; ++i )
+      {
+	unsigned needle_index = i + j*d_mesh_x_dim;
+	
+	if( !candidate_needles[needle_index] )
+	  continue;
+	
+	for( unsigned slice = 0; slice < d_mesh_z_dim; ++slice )
+	{
+	  unsigned mask_index = needle_index + 
+	    slice*d_mesh_x_dim*d_mesh_y_dim;
+
+	  if( prostate_mask[mask_index] )
+	  {
+	    double weight = 
+	      d_geometry->calculateSeedPositionWeight( structure_adjoint_data,
+						       mask_index );
+	    
+	    candidates.addCandidate( i, j, slice, weight, seed_id );
+	  }
+	}
+      }
     }
   }
 
-  // Sort the prostate doses, reverse so largest doses occur first
-  std::sort( prostate_doses.begin(), prostate_doses.end() );
-  std::reverse( prostate_doses.begin(), prostate_doses.end() );
+  // Make sure that the seed positions have been created
+  testPostcondition( candidates.getNumberOfCandidates() > 0 );
+}
 
-  // Create an array for the volume fraction
-  std::vector<double> prostate_vol_frac( d_prostate_relative_vol );
+// Return the prostate dose coverage
+double BrachytherapyPatient::getProstatePrescribedDoseCoverage() const
+{
+  return calculateOrganDoseCoverage( d_dose_distribution,
+				     d_geometry->getProstateMask(),
+				     d_geometry->getProstateSize(),
+				     d_geometry->getPrescribedDose() );
+}
 
-  for( unsigned i = 0; i < d_prostate_relative_vol; ++i )
-  {
-    prostate_vol_frac[i] = (double)i/d_prostate_relative_vol;
-  }
-  
-  // Search for the desired volume fraction
-  int vol_frac_bin = binarySearch( &prostate_vol_frac[0],
-				   &prostate_vol_frac[d_prostate_relative_vol],
-				   fraction_covered );
+// Return the dose covering a portion of the prostate
+/*! \details The dose returned has units of Gy.
+ */
+double BrachytherapyPatient::getDoseCoveringProstate( 
+					  const double fraction_covered ) const
+{
+  std::vector<double> prostate_doses;
 
-  // Interpolate to find the corresponding dose value
-  double dose_value = linlinInterp( prostate_vol_frac[vol_frac_bin],
-				    prostate_vol_frac[vol_frac_bin+1],
-				    fraction_covered,
-				    prostate_doses[vol_frac_bin],
-				    prostate_doses[vol_frac_bin+1] );
+  extractSortedOrganDoses( d_dose_distribution,
+			   d_geometry->getProstateMask(),
+			   d_geometry->getProstateSize(),
+			   prostate_doses );
 
-  return dose_value/100;
+  return calculateDoseCoveringOrgan( prostate_doses, fraction_covered );
 }
 
 // Return the dose covering a portion of the urethra
 double BrachytherapyPatient::getDoseCoveringUrethra( 
 					  const double fraction_covered ) const
 {
-  // Make sure the fraction covered is between 0 and 1
-  testPrecondition( fraction_covered >= 0.0 );
-  testPrecondition( fraction_covered <= 1.0 );
-
-  std::vector<double> urethra_doses( d_urethra_relative_vol );
-
-  for( unsigned i = 0, j = 0; i < d_dose_distribution.size(); ++i )
-  {
-    if( d_urethra_mask[i] )
-    {
-      urethra_doses[j] = d_dose_distribution[i];
-      ++j;
-    }
-  }
-
-  // Sort the urethra doses, reverse so largest doses occur first
-  std::sort( urethra_doses.begin(), urethra_doses.end() );
-  std::reverse( urethra_doses.begin(), urethra_doses.end() );
+  std::vector<double> urethra_doses;
 
-  // Create an array for the volume fraction
-  std::vector<double> urethra_vol_frac( d_urethra_relative_vol );
+  extractSortedOrganDoses( d_dose_distribution,
+			   d_geometry->getUrethraMask(),
+			   d_geometry->getUrethraSize(),
+			   urethra_doses );
 
-  for( unsigned i = 0; i < d_urethra_relative_vol; ++i )
-  {
-    urethra_vol_frac[i] = (double)i/d_urethra_relative_vol;
-  }
-  
-  // Search for the desired volume fraction
-  int vol_frac_bin = binarySearch( &urethra_vol_frac[0],
-				   &urethra_vol_frac[d_urethra_relative_vol],
-				   fraction_covered );
-
-  // Interpolate to find the corresponding dose value
-  double dose_value = linlinInterp( urethra_vol_frac[vol_frac_bin],
-				    urethra_vol_frac[vol_frac_bin+1],
-				    fraction_covered,
-				    urethra_doses[vol_frac_bin],
-				    urethra_doses[vol_frac_bin+1] );
-
-  return dose_value/100;
+  return calculateDoseCoveringOrgan( urethra_doses, fraction_covered );
 }
 
 // Return the dose covering a portion of the rectum
 double BrachytherapyPatient::getDoseCoveringRectum( 
 					  const double fraction_covered ) const
 {
-  // Make sure the fraction covered is between 0 and 1
-  testPrecondition( fraction_covered >= 0.0 );
-  testPrecondition( fraction_covered <= 1.0 );
+  std::vector<double> rectum_doses;
 
-  std::vector<double> rectum_doses( d_rectum_relative_vol );
+  extractSortedOrganDoses( d_dose_distribution,
+			   d_geometry->getRectumMask(),
+			   d_geometry->getRectumSize(),
+			   rectum_doses );
 
-  for( unsigned i = 0, j = 0; i < d_dose_distribution.size(); ++i )
-  {
-    if( d_rectum_mask[i] )
-    {
-      rectum_doses[j] = d_dose_distribution[i];
-      ++j;
-    }
-  }
-
-  // Sort the rectum doses, reverse so largest doses occur first
-  std::sort( rectum_doses.begin(), rectum_doses.end() );
-  std::reverse( rectum_doses.begin(), rectum_doses.end() );
-
-  // Create an array for the volume fraction
-  std::vector<double> rectum_vol_frac( d_rectum_relative_vol );
-
-  for( unsigned i = 0; i < d_rectum_relative_vol; ++i )
-  {
-    rectum_vol_frac[i] = (double)i/d_rectum_relative_vol;
-  }
-  
-  // Search for the desired volume fraction
-  int vol_frac_bin = binarySearch( &rectum_vol_frac[0],
-				   &rectum_vol_frac[d_rectum_relative_vol],
-				   fraction_covered );
-
-  // Interpolate to find the corresponding dose value
-  double dose_value = linlinInterp( rectum_vol_frac[vol_frac_bin],
-				    rectum_vol_frac[vol_frac_bin+1],
-				    fraction_covered,
-				    rectum_doses[vol_frac_bin],
-				    rectum_doses[vol_frac_bin+1] );
-
-  return dose_value/100;
+  return calculateDoseCoveringOrgan( rectum_doses, fraction_covered );
 }
 
 // Return the dose nonuniformity ratio (DNR)
 double BrachytherapyPatient::getDNR() const
 {
-  // Calculate V150
-  unsigned number_elements_covered = 0;
+  double prescribed_dose = d_geometry->getPrescribedDose();
   
-  for( unsigned i = 0; i < d_dose_distribution.size(); ++i )
-  {
-    if( d_prostate_mask[i] && d_dose_distribution[i] > 1.5*d_prescribed_dose )
-      ++number_elements_covered;
-  }
-
-  double V150 = (double)number_elements_covered/d_prostate_relative_vol;
+  // Calculate V150
+  double V150 = calculateOrganDoseCoverage( d_dose_distribution,
+					    d_geometry->getProstateMask(),
+					    d_geometry->getProstateSize(),
+					    1.5*prescribed_dose );
 
   // Calculate V100
   double V100 = getProstatePrescribedDoseCoverage();
@@ -483,18 +572,14 @@ double BrachytherapyPatient::getDNR() const
 double BrachytherapyPatient::getCN() const
 {
   // Calculate the total volume receiving >= Dp
-  unsigned number_elements_covered = 0;
-  
-  for( unsigned i = 0; i < d_dose_distribution.size(); ++i )
-  {
-    if( d_dose_distribution[i] > d_prescribed_dose )
-      ++number_elements_covered;
-  }
+  unsigned number_elements_covered = 
+    calculateNumElementsCovered( d_dose_distribution, 
+				 d_geometry->getPrescribedDose() );
 
   // Calculate V100
   double V100 = getProstatePrescribedDoseCoverage();
   
-  return V100*V100*d_prostate_relative_vol/number_elements_covered;
+  return V100*V100*d_geometry->getProstateSize()/number_elements_covered;
 }
 
 // Return the number of inserted needles
@@ -503,31 +588,170 @@ unsigned BrachytherapyPatient::getNumInsertedNeedles() const
   return d_treatment_plan_needles.size();
 }
 
+// Return the needle indices of the inserted needles
+/*! \details The needle indices are not sorted.
+ */
+void BrachytherapyPatient::getInsertedNeedles( 
+			       std::vector<unsigned> &needle_indices ) const
+{
+  needle_indices.clear();
+  needle_indices.reserve( d_treatment_plan_needles.size() );
+
+  boost::unordered_map<unsigned,unsigned>::const_iterator needle = 
+    d_treatment_plan_needles.begin();
+
+  while( needle != d_treatment_plan_needles.end() )
+  {
+    needle_indices.push_back( needle->first );
+
+    ++needle;
+  }
+}
+
 // Return the number of inserted seeds
 unsigned BrachytherapyPatient::getNumInsertedSeeds() const
 {
   return d_treatment_plan.size();
 }
 
+// Return the treatment plan (inserted seed positions)
+const std::list<BrachytherapySeedPosition>& 
+BrachytherapyPatient::getTreatmentPlan() const
+{
+  return d_treatment_plan;
+}
+
+// Return the treatment plan dose distribution (cGy)
+/*! \details The dose distribution covers the region of interest of the 
+ * patient geometry.
+ */
+const std::vector<double>& BrachytherapyPatient::getDoseDistribution() const
+{
+  return d_dose_distribution;
+}
+
+// Create a named checkpoint of the current state of the patient
+/*! \details Checkpoints can be nested. Only the treatment plan operations
+ * and the dose distribution z-slices that are modified after a checkpoint
+ * is created are stored so that the cost of restoring a checkpoint is 
+ * proportional to the changes made since the checkpoint.
+ */
+void BrachytherapyPatient::createCheckpoint( 
+					   const std::string &checkpoint_name )
+{
+  // Make sure that the checkpoint name is unique
+  testPrecondition( !checkpointExists( checkpoint_name ) );
+
+  d_checkpoints.push_back( PatientCheckpoint() );
+  
+  d_checkpoints.back().name = checkpoint_name;
+  d_checkpoints.back().journal_size = d_plan_journal.size();
+  d_checkpoints.back().saved_dose_slices.resize( d_mesh_z_dim );
+}
+
+// Restore the state of the patient at a named checkpoint
+/*! \details The checkpoint remains active (it can be restored again) and
+ * all checkpoints created after it are released.
+ */
+void BrachytherapyPatient::restoreCheckpoint( 
+					   const std::string &checkpoint_name )
+{
+  // Make sure that the checkpoint exists
+  testPrecondition( checkpointExists( checkpoint_name ) );
+
+  unsigned checkpoint_index = findCheckpoint( checkpoint_name );
+  unsigned slice_size = d_mesh_x_dim*d_mesh_y_dim;
+
+  // Restore the modified dose slices, from the most recent checkpoint to 
+  // the requested checkpoint (the oldest copy of a slice is restored last)
+  for( unsigned i = d_checkpoints.size(); i > checkpoint_index; --i )
+  {
+    std::vector<std::vector<double> > &saved_dose_slices = 
+      d_checkpoints[i-1].saved_dose_slices;
+    
+    for( unsigned k = 0; k < saved_dose_slices.size(); ++k )
+    {
+      if( saved_dose_slices[k].size() > 0 )
+      {
+	std::copy( saved_dose_slices[k].begin(),
+		   saved_dose_slices[k].end(),
+		   d_dose_distribution.begin() + k*slice_size );
+      }
+    }
+  }
+
+  // Undo the treatment plan operations
+  while( d_plan_journal.size() > d_checkpoints[checkpoint_index].journal_size )
+    undoLastPlanOperation();
+
+  // Release the more recent checkpoints
+  d_checkpoints.resize( checkpoint_index+1 );
+
+  // The current state is the checkpoint state
+  std::vector<std::vector<double> > &saved_dose_slices = 
+    d_checkpoints.back().saved_dose_slices;
+
+  for( unsigned k = 0; k < saved_dose_slices.size(); ++k )
+    saved_dose_slices[k].clear();
+}
+
+// Release a named checkpoint
+void BrachytherapyPatient::releaseCheckpoint( 
+					   const std::string &checkpoint_name )
+{
+  // Make sure that the checkpoint exists
+  testPrecondition( checkpointExists( checkpoint_name ) );
+
+  unsigned checkpoint_index = findCheckpoint( checkpoint_name );
+
+  // The previous checkpoint inherits the dose slices that it has not saved
+  if( checkpoint_index > 0 )
+  {
+    std::vector<std::vector<double> > &saved_dose_slices = 
+      d_checkpoints[checkpoint_index].saved_dose_slices;
+    
+    std::vector<std::vector<double> > &previous_saved_dose_slices = 
+      d_checkpoints[checkpoint_index-1].saved_dose_slices;
+
+    for( unsigned k = 0; k < saved_dose_slices.size(); ++k )
+    {
+      if( previous_saved_dose_slices[k].size() == 0 )
+	previous_saved_dose_slices[k].swap( saved_dose_slices[k] );
+    }
+  }
+
+  d_checkpoints.erase( d_checkpoints.begin() + checkpoint_index );
+
+  // The journal is only needed while checkpoints exist
+  if( d_checkpoints.size() == 0 )
+    d_plan_journal.clear();
+}
+
+// Test if a named checkpoint exists
+bool BrachytherapyPatient::checkpointExists( 
+				     const std::string &checkpoint_name ) const
+{
+  return findCheckpoint( checkpoint_name ) < d_checkpoints.size();
+}
+
 // Save the current state of the patient
+/*! \details Any previously saved state is replaced.
+ */
 void BrachytherapyPatient::saveState()
 {
-  d_cached_treatment_plan = d_treatment_plan;
-  d_cached_treatment_plan_needles = d_treatment_plan_needles;
-  d_cached_treatment_plan_positions = d_treatment_plan_positions;
-  d_cached_dose_distribution = d_dose_distribution;
+  if( checkpointExists( saved_state_checkpoint_name ) )
+    releaseCheckpoint( saved_state_checkpoint_name );
+
+  createCheckpoint( saved_state_checkpoint_name );
 }
 
 // Load the previously saved state of the patient
 void BrachytherapyPatient::loadSavedState()
 {
-  d_treatment_plan = d_cached_treatment_plan;
-  d_treatment_plan_needles = d_cached_treatment_plan_needles;
-  d_treatment_plan_positions = d_cached_treatment_plan_positions;
-  d_dose_distribution = d_cached_dose_distribution;
+  restoreCheckpoint( saved_state_checkpoint_name );
 }
 
-// Reset the state of the patient
+// Reset the state of the patient (all checkpoints are released)
 void BrachytherapyPatient::resetState()
 {
   d_treatment_plan.clear();
@@ -535,6 +759,225 @@ void BrachytherapyPatient::resetState()
   d_treatment_plan_positions.clear();
 
   std::fill( d_dose_distribution.begin(), d_dose_distribution.end(), 0.0 );
+
+  d_plan_journal.clear();
+  d_checkpoints.clear();
+}
+
+// Add a seed position to the needle and position sets
+void BrachytherapyPatient::addToPlanSets( 
+			       const BrachytherapySeedPosition &seed_position )
+{
+  ++d_treatment_plan_needles[calculateNeedleIndex( seed_position )];
+
+  d_treatment_plan_positions.insert( calculatePositionIndex( seed_position ) );
+}
+
+// Remove a seed position from the needle and position sets
+void BrachytherapyPatient::removeFromPlanSets( 
+			       const BrachytherapySeedPosition &seed_position )
+{
+  unsigned needle_index = calculateNeedleIndex( seed_position );
+  
+  if( --d_treatment_plan_needles[needle_index] == 0 )
+    d_treatment_plan_needles.erase( needle_index );
+
+  d_treatment_plan_positions.erase( calculatePositionIndex( seed_position ) );
+}
+
+// Save the dose distribution z-slices that are about to be modified
+// Note: only the most recent checkpoint saves the slices
+void BrachytherapyPatient::journalDoseDistribution( const unsigned z_start,
+						    const unsigned z_end )
+{
+  if( d_checkpoints.size() > 0 )
+  {
+    std::vector<std::vector<double> > &saved_dose_slices = 
+      d_checkpoints.back().saved_dose_slices;
+    
+    unsigned slice_size = d_mesh_x_dim*d_mesh_y_dim;
+
+    for( unsigned k = z_start; k < z_end; ++k )
+    {
+      if( saved_dose_slices[k].size() == 0 )
+      {
+	saved_dose_slices[k].assign( 
+			   d_dose_distribution.begin() + k*slice_size,
+			   d_dose_distribution.begin() + (k+1)*slice_size );
+      }
+    }
+  }
+}
+
+// Record a treatment plan operation in the journal
+void BrachytherapyPatient::journalPlanOperation( 
+			       const PlanOperation operation,
+			       const BrachytherapySeedPosition &seed_position,
+			       const unsigned plan_index )
+{
+  if( d_checkpoints.size() > 0 )
+  {
+    d_plan_journal.push_back( 
+		   PlanJournalEntry( operation, seed_position, plan_index ) );
+  }
+}
+
+// Undo the last treatment plan operation in the journal
+// Note: the dose distribution is restored separately
+void BrachytherapyPatient::undoLastPlanOperation()
+{
+  // Make sure that there is an operation to undo
+  testPrecondition( d_plan_journal.size() > 0 );
+
+  const PlanJournalEntry &entry = d_plan_journal.back();
+
+  switch( entry.operation )
+  {
+  case INSERT_SEED_OPERATION:
+  {
+    removeFromPlanSets( d_treatment_plan.back() );
+    d_treatment_plan.pop_back();
+    break;
+  }
+  case REMOVE_SEED_OPERATION:
+  {
+    std::list<BrachytherapySeedPosition>::iterator plan_position = 
+      d_treatment_plan.begin();
+    std::advance( plan_position, entry.plan_index );
+    
+    d_treatment_plan.insert( plan_position, entry.seed_position );
+    addToPlanSets( entry.seed_position );
+    break;
+  }
+  case MOVE_SEED_OPERATION:
+  {
+    std::list<BrachytherapySeedPosition>::iterator plan_position = 
+      d_treatment_plan.begin();
+    std::advance( plan_position, entry.plan_index );
+    
+    removeFromPlanSets( *plan_position );
+    addToPlanSets( entry.seed_position );
+    *plan_position = entry.seed_position;
+    break;
+  }
+  }
+
+  d_plan_journal.pop_back();
+}
+
+// Return the needle index of a seed position
+unsigned BrachytherapyPatient::calculateNeedleIndex( 
+			 const BrachytherapySeedPosition &seed_position ) const
+{
+  return seed_position.getXIndex() + seed_position.getYIndex()*d_mesh_x_dim;
+}
+
+// Return the mesh index of a seed position
+unsigned BrachytherapyPatient::calculatePositionIndex(
+			 const BrachytherapySeedPosition &seed_position ) const
+{
+  return calculateNeedleIndex( seed_position ) + 
+    seed_position.getZIndex()*d_mesh_x_dim*d_mesh_y_dim;
+}
+
+// Calculate the dose-volume-histogram data (dose bins in Gy)
+/*! \details The fraction of each organ receiving at least the bin dose is
+ * calculated for the dose bins 0, 1, ..., 300 Gy. Each mesh element is 
+ * classified (using the structure labels) and binned once. The cumulative 
+ * histograms are then created from the binned element counts.
+ */
+void BrachytherapyPatient::calculateDoseVolumeHistogram( 
+			       std::vector<double> &doses,
+			       std::vector<double> &prostate_fractions,
+			       std::vector<double> &urethra_fractions,
+			       std::vector<double> &rectum_fractions,
+			       std::vector<double> &normal_fractions ) const
+{
+  const std::vector<unsigned>& structure_labels = 
+    d_geometry->getStructureLabels();
+
+  const unsigned prostate_label = 
+    1u << BrachytherapyPatientGeometry::prostate_structure;
+  const unsigned urethra_label = 
+    1u << BrachytherapyPatientGeometry::urethra_structure;
+  const unsigned rectum_label = 
+    1u << BrachytherapyPatientGeometry::rectum_structure;
+
+  const int max_dose = 300;
+
+  doses.clear();
+  prostate_fractions.clear();
+  urethra_fractions.clear();
+  rectum_fractions.clear();
+  normal_fractions.clear();
+  
+  std::vector<unsigned> prostate_elements( max_dose+1, 0u ), 
+    urethra_elements( max_dose+1, 0u ), 
+    rectum_elements( max_dose+1, 0u ), 
+    normal_elements( max_dose+1, 0u );
+
+  // Bin every element by the largest dose bin that it receives
+  for( unsigned index = 0; index < d_dose_distribution.size(); ++index )
+  {
+    double dose_cgy = d_dose_distribution[index];
+
+    // Elements without a valid dose do not cover any dose bin
+    if( !(dose_cgy >= 0.0) )
+      continue;
+
+    int dose = dose_cgy < max_dose*100 ? (int)(dose_cgy/100) : max_dose;
+
+    while( dose < max_dose && dose_cgy >= (dose+1)*100 )
+      ++dose;
+
+    while( dose > 0 && dose_cgy < dose*100 )
+      --dose;
+
+    if( structure_labels[index] & prostate_label )
+      ++prostate_elements[dose];
+    else if( structure_labels[index] & urethra_label )
+      ++urethra_elements[dose];
+    else if( structure_labels[index] & rectum_label )
+      ++rectum_elements[dose];
+    else
+      ++normal_elements[dose];
+  }
+
+  // Accumulate the binned elements (from the largest dose bin down)
+  for( int dose = max_dose-1; dose >= 0; --dose )
+  {
+    prostate_elements[dose] += prostate_elements[dose+1];
+    urethra_elements[dose] += urethra_elements[dose+1];
+    rectum_elements[dose] += rectum_elements[dose+1];
+    normal_elements[dose] += normal_elements[dose+1];
+  }
+  
+  for( int dose = 0; dose <= max_dose; ++dose )
+  {
+    doses.push_back( dose );
+    prostate_fractions.push_back( 
+	    (double)prostate_elements[dose]/d_geometry->getProstateSize() );
+    urethra_fractions.push_back( 
+	    (double)urethra_elements[dose]/d_geometry->getUrethraSize() );
+    rectum_fractions.push_back( 
+	    (double)rectum_elements[dose]/d_geometry->getRectumSize() );
+    normal_fractions.push_back( 
+	    (double)normal_elements[dose]/d_geometry->getNormalSize() );
+  }
+}
+
+// Return the stack index of a named checkpoint
+// Note: the stack size is returned if the checkpoint does not exist
+unsigned BrachytherapyPatient::findCheckpoint( 
+				     const std::string &checkpoint_name ) const
+{
+  for( unsigned i = 0; i < d_checkpoints.size(); ++i )
+  {
+    if( d_checkpoints[i].name == checkpoint_name )
+      return i;
+  }
+
+  return d_checkpoints.size();
 }
 
 // Print the treatment plan
@@ -542,6 +985,11 @@ void BrachytherapyPatient::printTreatmentPlan( std::ostream &os ) const
 {
   os << "Needle Seed  Seed Type\t\tSeed Indices\n";
 
+  // The seed indices are printed relative to the full organ mesh
+  unsigned x_offset = d_geometry->getROIXOffset();
+  unsigned y_offset = d_geometry->getROIYOffset();
+  unsigned z_offset = d_geometry->getROIZOffset();
+
   std::list<BrachytherapySeedPosition>::const_iterator position, end_position;
   position = d_treatment_plan.begin();
   end_position = d_treatment_plan.end();
@@ -568,9 +1016,9 @@ void BrachytherapyPatient::printTreatmentPlan( std::ostream &os ) const
     os << std::setw(3) << needle_id << "    "
        << std::setw(2) << position_number << "    "
        << position->getSeedName() << " "
-       << std::setw(3) << position->getXIndex() << " "
-       << std::setw(3) << position->getYIndex() << " "
-       << std::setw(2) << position->getZIndex() << "\n";
+       << std::setw(3) << position->getXIndex()+x_offset << " "
+       << std::setw(3) << position->getYIndex()+y_offset << " "
+       << std::setw(2) << position->getZIndex()+z_offset << "\n";
 
     ++position;
     ++position_number;
@@ -588,73 +1036,36 @@ void BrachytherapyPatient::printTreatmentPlan() const
 // Print the treatment plan summary
 void BrachytherapyPatient::printTreatmentPlanSummary( std::ostream &os ) const
 {
-  os << "Prostate Details" << std::endl;
-  os << "  D100 (Gy):                " 
-     << getDoseCoveringProstate( 1.0 ) << std::endl;
-  os << "  V100:                     " 
-     << getProstatePrescribedDoseCoverage() << std::endl;
-  os << "  DNR:                      " << getDNR() << std::endl;
-  os << "  CN:                       " << getCN() << std::endl;
-  os << "Urethra Details" << std::endl;
-  os << "  D90 (Gy):                 " 
-     << getDoseCoveringUrethra( 0.9 ) << std::endl;
-  os << "  D10 (Gy):                 " 
-     << getDoseCoveringUrethra( 0.1 ) << std::endl;
-  os << "Rectum Details" << std::endl;
-  os << "  D90 (Gy):                 " 
-     << getDoseCoveringRectum( 0.9 ) << std::endl;
-  os << "  D10 (Gy):                 " 
-     << getDoseCoveringRectum( 0.1 ) << std::endl;
-  os << std::endl;
+  BrachytherapyPlanMetrics metrics;
+  calculatePlanMetrics( metrics );
+  
+  printBrachytherapyPlanMetrics( os, metrics );
 }
 
 // Print the dose-volume-histogram data
 void BrachytherapyPatient::printDoseVolumeHistogramData( 
 						       std::ostream &os ) const
 {
+  std::vector<double> doses, prostate_fractions, urethra_fractions,
+    rectum_fractions, normal_fractions;
+
+  calculateDoseVolumeHistogram( doses,
+				prostate_fractions,
+				urethra_fractions,
+				rectum_fractions,
+				normal_fractions );
+  
   os << "# Dose[Gy] Prostate Urethra  Rectum   Normal\n";
   os.precision( 6 );
   os.setf( std::ios::fixed, std::ios::floatfield );
 
-  unsigned prostate_elements = 0, urethra_elements = 0, normal_elements = 0,
-    rectum_elements = 0;
-  
-  for( int dose = 0; dose <= 300; ++dose )
+  for( unsigned bin = 0; bin < doses.size(); ++bin )
   {
-    for( int k = 0; k < d_mesh_z_dim; ++k )
-    {
-      for( int j = 0; j < d_mesh_y_dim; ++j )
-      {
-	for( int i = 0; i < d_mesh_x_dim; ++i )
-	{
-	  unsigned index = i + j*d_mesh_x_dim + k*d_mesh_x_dim*d_mesh_y_dim;
-	  double dose_cgy = dose*100;
-	  
-	  if( d_prostate_mask[index] && d_dose_distribution[index] >= 
-	      dose_cgy )
-	    ++prostate_elements;
-	  else if( d_urethra_mask[index] && d_dose_distribution[index] >= 
-		   dose_cgy)
-	    ++urethra_elements;
-	  else if( d_rectum_mask[index] && d_dose_distribution[index] >= 
-		   dose_cgy )
-	    ++rectum_elements;
-	  else if( d_dose_distribution[index] >= dose_cgy )
-	    ++normal_elements;
-	}
-      }
-    }
-
-    os << std::setw( 10 ) << dose << " " 
-       << (double)prostate_elements/d_prostate_relative_vol << " "
-       << (double)urethra_elements/d_urethra_relative_vol << " "
-       << (double)rectum_elements/d_rectum_relative_vol << " "
-       << (double)normal_elements/d_normal_relative_vol << "\n";
-
-    prostate_elements = 0;
-    urethra_elements = 0;
-    rectum_elements = 0;
-    normal_elements = 0;
+    os << std::setw( 10 ) << (int)doses[bin] << " " 
+       << prostate_fractions[bin] << " "
+       << urethra_fractions[bin] << " "
+       << rectum_fractions[bin] << " "
+       << normal_fractions[bin] << "\n";
   }
   
   os << std::endl;
@@ -666,7 +1077,15 @@ void BrachytherapyPatient::printDoseVolumeHistogramData() const
   printDoseVolumeHistogramData( std::cout );
 }
 
-// Export the patient data to a vtk vile for 3D visualization
+// Export the patient data to a vtk file for 3D visualization
+/*! \details A binary legacy vtk file (STRUCTURED_POINTS) is written. The 
+ * tissue type (1 = prostate, 2 = urethra, 3 = rectum, 4 = margin, 
+ * 5 = normal) and the needle template are always written. The dose (Gy) and
+ * the treatment plan (seed type + 1 at each seed position) are written if 
+ * the treatment plan is exported. The ROI is placed at its location in the 
+ * full organ mesh. A std::runtime_error is thrown if the file cannot be 
+ * written (it is not caught, so the export can run on a worker thread).
+ */
 void BrachytherapyPatient::exportDataToVTK( 
 				       const bool export_treatment_plan ) const
 {
@@ -674,445 +1093,373 @@ void BrachytherapyPatient::exportDataToVTK(
   double mesh_element_x_dim = 0.1;
   double mesh_element_y_dim = 0.1;
   double mesh_element_z_dim = 0.5;
+
+  // Create the output file name
+  const std::string& patient_file_name = d_geometry->getPatientFileName();
   
-  // Create the mesh element corner coordinates
-  std::vector<double> coordinates;
-  
-  for( unsigned k = 0; k <= d_mesh_z_dim; ++k )
-  {
-    for( unsigned j = 0; j <= d_mesh_y_dim; ++j )
-    {
-      for( unsigned i = 0; i <= d_mesh_x_dim; ++i )
-      {
-	unsigned index = i + j*(d_mesh_x_dim+1) + 
-	  k*(d_mesh_x_dim+1)*(d_mesh_y_dim+1);
-	
-	coordinates.push_back( i*mesh_element_x_dim );
-	coordinates.push_back( j*mesh_element_y_dim );
-	coordinates.push_back( k*mesh_element_z_dim );
-      }
-    }
-  }
- 
-  try{
-    // Initialize the MOAB interface
-    boost::scoped_ptr<moab::Interface> moab_interface( new moab::Core() );
-
-    // Tag creation flag
-    unsigned tag_creation_flag = moab::MB_TAG_DENSE|moab::MB_TAG_CREAT|
-      moab::MB_TAG_EXCL|moab::MB_TAG_BYTES;
-    
-    // Create MOAB vertices from the coordinates
-    moab::Range vertices;
-    
-    moab::ErrorCode err = moab_interface->create_vertices(&coordinates[0], 
-							  coordinates.size()/3,
-							  vertices );
-    
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
+  std::string vtk_file_name;
+  size_t pos = patient_file_name.find(".h5");
+  if( pos == std::string::npos )
+    vtk_file_name = patient_file_name + ".vtk";
+  else
+    vtk_file_name = patient_file_name.substr( 0, pos ) + ".vtk";
+
+  VTKStructuredPointsWriter vtk_file( 
+	vtk_file_name,
+	"TPOR brachytherapy patient",
+	d_mesh_x_dim,
+	d_mesh_y_dim,
+	d_mesh_z_dim,
+	d_geometry->getROIXOffset()*mesh_element_x_dim,
+	d_geometry->getROIYOffset()*mesh_element_y_dim,
+	d_geometry->getROIZOffset()*mesh_element_z_dim,
+	mesh_element_x_dim,
+	mesh_element_y_dim,
+	mesh_element_z_dim );
+
+  unsigned size = d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim;
     
-    // Create the hexahedrons
-    moab::Range hexahedrons;
-    moab::EntityHandle connections[8];
+  // Create the tissue type label volume
+  std::vector<unsigned char> label_data( size );
     
-    for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  {
+    for( unsigned j = 0; j < d_mesh_y_dim; ++j )
     {
-      for( unsigned j = 0; j < d_mesh_y_dim; ++j )
+      for( unsigned i = 0; i < d_mesh_x_dim; ++i )
       {
-	for( unsigned i = 0; i < d_mesh_x_dim; ++i )
-	{
-	  unsigned index = i + j*(d_mesh_x_dim+1) + 
-	    k*(d_mesh_x_dim+1)*(d_mesh_y_dim+1);
-	  
-	  connections[0] = vertices[index];
-	  connections[1] = vertices[index+1];
-	  connections[2] = vertices[index+(d_mesh_x_dim+1)+1];
-	  connections[3] = vertices[index+(d_mesh_x_dim+1)];
-	  connections[4] = vertices[index+(d_mesh_x_dim+1)*(d_mesh_y_dim+1)];
-	  connections[5] = vertices[index+(d_mesh_x_dim+1)*(d_mesh_y_dim+1)+1];
-	  connections[6] = vertices[index+(d_mesh_x_dim+1)*(d_mesh_y_dim+1)+
-				    (d_mesh_x_dim+1)+1];
-	  connections[7] = vertices[index+(d_mesh_x_dim+1)*(d_mesh_y_dim+1)+
-				    (d_mesh_x_dim+1)];
-	  
-	  // Create a MOAB hexahedron from the connectivity data
-	  moab::EntityHandle hex;
-	  
-	  err = moab_interface->create_element( moab::MBHEX,
-						connections,
-						8,
-						hex );
+	unsigned index = i + j*d_mesh_x_dim + k*d_mesh_x_dim*d_mesh_y_dim;
 	  
-	  TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			      MOABException, 
-			      moab::ErrorCodeStr[err] );
-	  
-	  hexahedrons.insert( hex );
+	switch( d_geometry->getTissueType( i, j, k ) )
+	{
+	case PROSTATE_TISSUE: label_data[index] = 1u; break;
+	case URETHRA_TISSUE: label_data[index] = 2u; break;
+	case RECTUM_TISSUE: label_data[index] = 3u; break;
+	case MARGIN_TISSUE: label_data[index] = 4u; break;
+	default: label_data[index] = 5u;
 	}
       }
     }
+  }
 
-    // Create the organ mask tags
-    moab::Tag prostate_tag;
-    moab::Tag urethra_tag;
-    moab::Tag rectum_tag;
-    moab::Tag margin_tag;
-    moab::Tag normal_tag;
-    moab::Tag needle_template_tag;
-  
-    err = moab_interface->tag_get_handle( "prostate", 
-					  sizeof(int), 
-					  moab::MB_TYPE_INTEGER, 
-					  prostate_tag, 
-					  tag_creation_flag,
-					  0 );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-    
-    err = moab_interface->tag_get_handle( "urethra", 
-					  sizeof(int), 
-					  moab::MB_TYPE_INTEGER, 
-					  urethra_tag, 
-					  tag_creation_flag,
-					  0 );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-    
-    err = moab_interface->tag_get_handle( "rectum",
-					  sizeof(int),
-					  moab::MB_TYPE_INTEGER,
-					  rectum_tag,
-					  tag_creation_flag,
-					  0 );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-    
-    err = moab_interface->tag_get_handle( "margin",
-					  sizeof(int),
-					  moab::MB_TYPE_INTEGER,
-					  margin_tag,
-					  tag_creation_flag,
-					  0 );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-    
-    err = moab_interface->tag_get_handle( "normal",
-					  sizeof(int),
-					  moab::MB_TYPE_INTEGER,
-					  normal_tag,
-					  tag_creation_flag,
-					  0 );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-    
-    err = moab_interface->tag_get_handle( "needle_template",
-					  sizeof(int),
-					  moab::MB_TYPE_INTEGER,
-					  needle_template_tag,
-					  tag_creation_flag,
-					  0 );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-
-    // Convert the boolean organ masks to integer organ masks
-    std::vector<int> int_prostate_mask( d_prostate_mask.size(), 0.0 );
-    std::vector<int> int_urethra_mask( d_urethra_mask.size(), 0.0 );
-    std::vector<int> int_rectum_mask( d_rectum_mask.size(), 0.0 );
-    std::vector<int> int_margin_mask( d_margin_mask.size(), 0.0 );
-    std::vector<int> int_normal_mask( d_margin_mask.size(), 0.0 );
+  vtk_file.writeCellData( "tissue", label_data );
+
+  // Create the expanded needle template
+  const std::vector<bool>& needle_template = 
+    d_geometry->getNeedleTemplate();
     
-    for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  {
+    for( unsigned template_index = 0; 
+	 template_index < needle_template.size(); 
+	 ++template_index )
     {
-      for( unsigned j = 0; j < d_mesh_y_dim; ++j )
-      {
-	for( unsigned i = 0; i < d_mesh_x_dim; ++i )
-	{
-	  unsigned index = i + j*d_mesh_x_dim +
-	    k*d_mesh_x_dim*d_mesh_y_dim;
-
-	  if( d_prostate_mask[index] )
-	    int_prostate_mask[index] = 1;
-	  else if( d_urethra_mask[index] )
-	    int_urethra_mask[index] = 2;
-	  else if( d_rectum_mask[index] )
-	    int_rectum_mask[index] = 3;
-	  else if( d_margin_mask[index] )
-	  {
-	    int_margin_mask[index] = 4;
-	    int_normal_mask[index] = 5;
-	  }
-	  else
-	    int_normal_mask[index] = 5;
-	}
-      }
+      label_data[template_index + k*d_mesh_x_dim*d_mesh_y_dim] = 
+	(needle_template[template_index] ? 1u : 0u);
     }
-    
-    // Tag the hexes
-    err = moab_interface->tag_set_data( prostate_tag, 
-					hexahedrons,
-					&int_prostate_mask[0] );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-
-    err = moab_interface->tag_set_data( urethra_tag,
-					hexahedrons,
-					&int_urethra_mask[0] );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
-
-    err = moab_interface->tag_set_data( rectum_tag,
-    					hexahedrons,
-    					&int_rectum_mask[0] );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-    			MOABException, 
-    			moab::ErrorCodeStr[err] );
-
-    err = moab_interface->tag_set_data( margin_tag,
-    					hexahedrons,
-    					&int_margin_mask[0] );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-    			MOABException, 
-    			moab::ErrorCodeStr[err] );
-
-    err = moab_interface->tag_set_data( normal_tag,
-    					hexahedrons,
-    					&int_normal_mask[0] );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-    			MOABException, 
-    			moab::ErrorCodeStr[err] );
-
-    int_prostate_mask.clear();
-    int_urethra_mask.clear();
-    int_rectum_mask.clear();
-    int_margin_mask.clear();
-    int_normal_mask.clear();
-
-    // Create an expanded needle template
-    std::vector<int> expanded_needle_template( d_prostate_mask.size() );
-    for( unsigned k = 0; k < d_mesh_z_dim; ++k )
-    {
-      for( unsigned j = 0; j < d_mesh_y_dim; ++j )
-      {
-	for( unsigned i = 0; i < d_mesh_x_dim; ++i )
-	{
-	  unsigned template_index = i + j*d_mesh_x_dim;
-	  unsigned ext_template_index = template_index + 
-	    k*d_mesh_x_dim*d_mesh_y_dim;
+  }
 
-	  if( d_needle_template[template_index] )
-	    expanded_needle_template[ext_template_index] = 1;
-	}
-      }
+  vtk_file.writeCellData( "needle_template", label_data );
+
+  if( export_treatment_plan )
+  {
+    // Convert the dose distribution to Gy
+    std::vector<float> dose_data( size );
+
+    for( unsigned index = 0; index < size; ++index )
+      dose_data[index] = d_dose_distribution[index]/100.0;
+
+    vtk_file.writeCellData( "dose", dose_data );
+
+    dose_data.clear();
+
+    // Simplify the treatment plan
+    std::vector<int> treatment_plan_data( size, 0 );
+      
+    std::list<BrachytherapySeedPosition>::const_iterator position,
+      end_position;
+
+    position = d_treatment_plan.begin();
+    end_position = d_treatment_plan.end();
+
+    while( position != end_position )
+    {
+      treatment_plan_data[calculatePositionIndex( *position )] = 
+	position->getSeedType()+1;
+	
+      ++position;
     }
+
+    vtk_file.writeCellData( "treatment_plan", treatment_plan_data );
+  }
+}
+
+// Export the treatment plan results to an hdf5 file
+/*! \details The results are written to the group /plans/plan_name/ of the
+ * file (the patient file if no file name is given). An existing plan with 
+ * the same name will be replaced. The seed indices are relative to the full 
+ * organ mesh while the dose distribution only covers the region of 
+ * interest (its offset is stored with it).
+ */
+void BrachytherapyPatient::exportTreatmentPlanToHDF5( 
+					  const std::string &plan_name,
+					  const std::string &file_name ) const
+{
+  // Make sure that there is a treatment plan to export
+  testPrecondition( d_treatment_plan.size() > 0 );
+  
+  std::vector<BrachytherapySeedRecord> seeds;
+  createSeedRecords( seeds );
+
+  BrachytherapyPlanMetrics metrics;
+  calculatePlanMetrics( metrics );
+
+  // Calculate the dose-volume-histogram
+  std::vector<double> doses, prostate_fractions, urethra_fractions,
+    rectum_fractions, normal_fractions;
+
+  calculateDoseVolumeHistogram( doses,
+				prostate_fractions,
+				urethra_fractions,
+				rectum_fractions,
+				normal_fractions );
+
+  std::vector<unsigned> mesh_dimensions, mesh_offset;
+  getMeshDimensionsAndOffset( mesh_dimensions, mesh_offset );
+
+  // Write the results
+  BrachytherapyPlanFileHandler plan_file( 
+	      (file_name.size() > 0 ? file_name : 
+	       d_geometry->getPatientFileName()) );
+
+  if( plan_file.planExists( plan_name ) )
+    plan_file.removePlan( plan_name );
+
+  plan_file.setSeeds( plan_name, seeds );
+  plan_file.setPlanMetrics( plan_name, metrics );
+  plan_file.setDoseDistribution( plan_name, 
+				 d_dose_distribution,
+				 mesh_dimensions,
+				 mesh_offset );
+  plan_file.setDoseVolumeHistogramDoses( plan_name, doses );
+  plan_file.setDoseVolumeHistogram( plan_name, "prostate", 
+				    prostate_fractions );
+  plan_file.setDoseVolumeHistogram( plan_name, "urethra", 
+				    urethra_fractions );
+  plan_file.setDoseVolumeHistogram( plan_name, "rectum", rectum_fractions );
+  plan_file.setDoseVolumeHistogram( plan_name, "normal", normal_fractions );
+}
+
+// Archive the treatment plan to an hdf5 file
+/*! \details Only the seeds and the plan metrics are written to the group 
+ * /plans/plan_name/ of the file (the patient file if no file name is given).
+ * The dose distribution can optionally be stored as 16-bit integers. The 
+ * full dose distribution can be rebuilt from the seeds with 
+ * loadTreatmentPlanFromHDF5.
+ */
+void BrachytherapyPatient::archiveTreatmentPlanToHDF5( 
+				     const std::string &plan_name,
+				     const std::string &file_name,
+				     const bool store_quantized_dose ) const
+{
+  // Make sure that there is a treatment plan to archive
+  testPrecondition( d_treatment_plan.size() > 0 );
+  
+  std::vector<BrachytherapySeedRecord> seeds;
+  createSeedRecords( seeds );
+
+  BrachytherapyPlanMetrics metrics;
+  calculatePlanMetrics( metrics );
+
+  BrachytherapyPlanFileHandler plan_file( 
+	      (file_name.size() > 0 ? file_name : 
+	       d_geometry->getPatientFileName()) );
+
+  if( plan_file.planExists( plan_name ) )
+    plan_file.removePlan( plan_name );
+
+  plan_file.setSeeds( plan_name, seeds );
+  plan_file.setPlanMetrics( plan_name, metrics );
+
+  if( store_quantized_dose )
+  {
+    std::vector<unsigned> mesh_dimensions, mesh_offset;
+    getMeshDimensionsAndOffset( mesh_dimensions, mesh_offset );
     
-    err = moab_interface->tag_set_data( needle_template_tag,
-    					hexahedrons,
-    					&expanded_needle_template[0] );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-    			MOABException, 
-    			moab::ErrorCodeStr[err] );
-
-    if( export_treatment_plan )
-    {
-      // Create the treatment plan tags
-      moab::Tag prostate_dose;
-      moab::Tag urethra_dose;
-      moab::Tag rectum_dose;
-      moab::Tag margin_dose;
-      moab::Tag normal_dose;
-      moab::Tag treatment_plan;
-      
-      err = moab_interface->tag_get_handle( "prostate_dose",
-					    sizeof(double),
-					    moab::MB_TYPE_DOUBLE,
-					    prostate_dose,
-					    tag_creation_flag,
-					    0 );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			  MOABException, 
-			  moab::ErrorCodeStr[err] );
-      
-      err = moab_interface->tag_get_handle( "urethra_dose",
-					    sizeof(double),
-					    moab::MB_TYPE_DOUBLE,
-					    urethra_dose,
-					    tag_creation_flag,
-					    0 );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			  MOABException, 
-			  moab::ErrorCodeStr[err] );
-      
-      err = moab_interface->tag_get_handle( "rectum_dose",
-					    sizeof(double),
-					    moab::MB_TYPE_DOUBLE,
-					    rectum_dose,
-					    tag_creation_flag,
-					    0 );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			  MOABException, 
-			  moab::ErrorCodeStr[err] );
-      
-      err = moab_interface->tag_get_handle( "margin_dose",
-					    sizeof(double),
-					    moab::MB_TYPE_DOUBLE,
-					    margin_dose,
-					    tag_creation_flag,
-					    0 );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			  MOABException, 
-			  moab::ErrorCodeStr[err] );
-      
-      err = moab_interface->tag_get_handle( "normal_dose",
-					    sizeof(double),
-					    moab::MB_TYPE_DOUBLE,
-					    normal_dose,
-					    tag_creation_flag,
-					    0 );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			  MOABException, 
-			  moab::ErrorCodeStr[err] );
-      
-      err = moab_interface->tag_get_handle( "treatment_plan",
-					    sizeof(int),
-					    moab::MB_TYPE_INTEGER,
-					    treatment_plan,
-					    tag_creation_flag,
-					    0 );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			  MOABException, 
-			  moab::ErrorCodeStr[err] );
-      
-      // Calculate the organ doses
-      std::vector<double> prostate_dose_data( d_prostate_mask.size() );
-      std::vector<double> urethra_dose_data( d_urethra_mask.size() );
-      std::vector<double> rectum_dose_data( d_rectum_mask.size() );
-      std::vector<double> margin_dose_data( d_margin_mask.size() );
-      std::vector<double> normal_dose_data( d_margin_mask.size() );
-
-      for( unsigned k = 0; k < d_mesh_z_dim; ++k )
-      {
-	for( unsigned j = 0; j < d_mesh_y_dim; ++j )
-	{
-	  for( unsigned i = 0; i < d_mesh_x_dim; ++i )
-	  {
-	    unsigned index = i + j*d_mesh_x_dim +
-	      k*d_mesh_x_dim*d_mesh_y_dim;
-	    
-	    if( d_prostate_mask[index] )
-	      prostate_dose_data[index] = d_dose_distribution[index];
-	    else if( d_urethra_mask[index] )
-	      urethra_dose_data[index] = d_dose_distribution[index];
-	    else if( d_rectum_mask[index] )
-	      rectum_dose_data[index] = d_dose_distribution[index];
-	    else if( d_margin_mask[index] )
-	    {
-	      margin_dose_data[index] = d_dose_distribution[index];
-	      normal_dose_data[index] = d_dose_distribution[index];
-	    }
-	    else
-	      normal_dose_data[index] = d_dose_distribution[index];
-	  }
-	}
-      }
+    plan_file.setQuantizedDoseDistribution( plan_name,
+					    d_dose_distribution,
+					    mesh_dimensions,
+					    mesh_offset );
+  }
+}
 
-      err = moab_interface->tag_set_data( prostate_dose,
-      					  hexahedrons,
-      					  &prostate_dose_data[0] );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-      			  MOABException, 
-      			  moab::ErrorCodeStr[err] );
-
-      err = moab_interface->tag_set_data( urethra_dose,
-      					  hexahedrons,
-      					  &urethra_dose_data[0] );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-      			  MOABException, 
-      			  moab::ErrorCodeStr[err] );
-
-      err = moab_interface->tag_set_data( rectum_dose,
-      					  hexahedrons,
-      					  &rectum_dose_data[0] );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-      			  MOABException, 
-      			  moab::ErrorCodeStr[err] );
-
-      err = moab_interface->tag_set_data( margin_dose,
-      					  hexahedrons,
-      					  &margin_dose_data[0] );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-      			  MOABException, 
-      			  moab::ErrorCodeStr[err] );
+// Load a treatment plan from an hdf5 file
+/*! \details The current treatment plan is discarded (all checkpoints are 
+ * released) and the dose distribution is rebuilt by superposition of the 
+ * seed dose distributions. The seed of each stored seed position is looked 
+ * up by type and strength in the seeds that are passed in, so that the seed
+ * dose distributions only need to be loaded once for any number of plans. 
+ * The planner weights are not archived (all loaded positions have unit 
+ * weight). A std::runtime_error is thrown (and the current treatment plan 
+ * is kept) if the plan does not exist, a stored seed was not passed in or a
+ * stored seed position is outside of the region of interest.
+ */
+void BrachytherapyPatient::loadTreatmentPlanFromHDF5( 
+	  const std::string &plan_name,
+	  const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	  const std::string &file_name )
+{
+  std::vector<BrachytherapySeedRecord> seed_records;
+  
+  {
+    BrachytherapyPlanFileHandler plan_file( 
+	      (file_name.size() > 0 ? file_name : 
+	       d_geometry->getPatientFileName()),
+	      true );
+
+    TEST_FOR_EXCEPTION( !plan_file.planExists( plan_name ),
+			std::runtime_error,
+			"Error: the treatment plan " << plan_name << 
+			" does not exist." );
+
+    plan_file.getSeeds( plan_name, seed_records );
+  }
+
+  unsigned x_offset = d_geometry->getROIXOffset();
+  unsigned y_offset = d_geometry->getROIYOffset();
+  unsigned z_offset = d_geometry->getROIZOffset();
+
+  // Find the seed of each stored seed position (the stored positions are 
+  // checked before the current treatment plan is discarded)
+  std::vector<unsigned> seed_indices( seed_records.size() );
+  
+  for( unsigned i = 0; i < seed_records.size(); ++i )
+  {
+    const BrachytherapySeedRecord &record = seed_records[i];
       
-      err = moab_interface->tag_set_data( normal_dose,
-      					  hexahedrons,
-      					  &normal_dose_data[0] );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-      			  MOABException, 
-      			  moab::ErrorCodeStr[err] );
-
-      prostate_dose_data.clear();
-      urethra_dose_data.clear();
-      rectum_dose_data.clear();
-      margin_dose_data.clear();
-      normal_dose_data.clear();      
+    unsigned seed_index = 0;
       
-      // Simplify the treatment plan
-      std::vector<int> treatment_plan_data( d_prostate_mask.size() );
+    while( seed_index < seeds.size() )
+    {
+      if( (unsigned)seeds[seed_index]->getSeedType() == record.seed_type &&
+	  seeds[seed_index]->getSeedStrength() == record.seed_strength )
+	break;
+	
+      ++seed_index;
+    }
+
+    TEST_FOR_EXCEPTION( seed_index == seeds.size(),
+			std::runtime_error,
+			"Error: treatment plan " << plan_name << 
+			" uses a seed (" << 
+			brachytherapySeedName( 
+			   unsignedToBrachytherapySeedType( record.seed_type ) )
+			<< " " << record.seed_strength << 
+			") that was not given." );
+
+    TEST_FOR_EXCEPTION( record.x_index < x_offset ||
+			record.x_index >= x_offset + d_mesh_x_dim ||
+			record.y_index < y_offset ||
+			record.y_index >= y_offset + d_mesh_y_dim ||
+			record.z_index < z_offset ||
+			record.z_index >= z_offset + d_mesh_z_dim,
+			std::runtime_error,
+			"Error: treatment plan " << plan_name << 
+			" has a seed outside of the region of interest." );
+
+    seed_indices[i] = seed_index;
+  }
+
+  resetState();
+
+  for( unsigned i = 0; i < seed_records.size(); ++i )
+  {
+    const BrachytherapySeedRecord &record = seed_records[i];
+    
+    BrachytherapySeedPosition seed_position( record.x_index - x_offset,
+					     record.y_index - y_offset,
+					     record.z_index - z_offset,
+					     1.0,
+					     seeds[seed_indices[i]] );
       
-      std::list<BrachytherapySeedPosition>::const_iterator position,
-	end_position;
+    insertSeed( seed_position );
+  }
+}
 
-      position = d_treatment_plan.begin();
-      end_position = d_treatment_plan.end();
+// Create the seed records of the treatment plan
+/*! \details The seed indices are relative to the full organ mesh. The
+ * needles are numbered in the order that they were first used.
+ */
+void BrachytherapyPatient::createSeedRecords( 
+			   std::vector<BrachytherapySeedRecord> &seeds ) const
+{
+  unsigned x_offset = d_geometry->getROIXOffset();
+  unsigned y_offset = d_geometry->getROIYOffset();
+  unsigned z_offset = d_geometry->getROIZOffset();
+  
+  seeds.clear();
+  seeds.reserve( d_treatment_plan.size() );
 
-      while( position != end_position )
-      {
-	int seed_type = position->getSeedType()+1;
-	unsigned index = position->getXIndex() + 
-	  position->getYIndex()*d_mesh_x_dim +
-	  position->getZIndex()*d_mesh_x_dim*d_mesh_y_dim;
-	
-	treatment_plan_data[index] = seed_type;
-	
-	++position;
-      }
+  std::map<unsigned,unsigned> needle_id_map;
 
-      err = moab_interface->tag_set_data( treatment_plan,
-      					  hexahedrons,
-      					  &treatment_plan_data[0] );
-      TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-      			  MOABException, 
-      			  moab::ErrorCodeStr[err] );
+  std::list<BrachytherapySeedPosition>::const_iterator position, end_position;
+  position = d_treatment_plan.begin();
+  end_position = d_treatment_plan.end();
+
+  while( position != end_position )
+  {
+    unsigned needle_index = calculateNeedleIndex( *position );
+    
+    if( needle_id_map.count( needle_index ) == 0 )
+    {
+      unsigned needle_id = needle_id_map.size()+1;
+      needle_id_map[needle_index] = needle_id;
     }
 
-    // Create the output file name
-    std::string vtk_file_name;
-    size_t pos = d_patient_file_name.find(".h5");
-    if( pos == std::string::npos )
-      vtk_file_name = d_patient_file_name + ".vtk";
-    else
-      vtk_file_name = d_patient_file_name.substr( 0, pos ) + ".vtk";
+    BrachytherapySeedRecord seed;
+    seed.needle_id = needle_id_map[needle_index];
+    seed.x_index = position->getXIndex()+x_offset;
+    seed.y_index = position->getYIndex()+y_offset;
+    seed.z_index = position->getZIndex()+z_offset;
+    seed.seed_type = position->getSeedType();
+    seed.seed_strength = position->getSeedStrength();
 
-    // Write the vtk file
-    err = moab_interface->write_mesh( vtk_file_name.c_str() );
-    TEST_FOR_EXCEPTION( err != moab::MB_SUCCESS, 
-			MOABException, 
-			moab::ErrorCodeStr[err] );
+    seeds.push_back( seed );
+    
+    ++position;
   }
-  MOAB_EXCEPTION_CATCH_AND_EXIT();
 }
 
+// Calculate the treatment plan metrics
+void BrachytherapyPatient::calculatePlanMetrics( 
+				      BrachytherapyPlanMetrics &metrics ) const
+{
+  metrics.prostate_v100 = getProstatePrescribedDoseCoverage();
+  metrics.prostate_d90 = getDoseCoveringProstate( 0.9 );
+  metrics.prostate_d100 = getDoseCoveringProstate( 1.0 );
+  metrics.urethra_d10 = getDoseCoveringUrethra( 0.1 );
+  metrics.urethra_d90 = getDoseCoveringUrethra( 0.9 );
+  metrics.rectum_d10 = getDoseCoveringRectum( 0.1 );
+  metrics.rectum_d90 = getDoseCoveringRectum( 0.9 );
+  metrics.dnr = getDNR();
+  metrics.cn = getCN();
+}
 
+// Return the mesh dimensions and the offset in the full organ mesh
+void BrachytherapyPatient::getMeshDimensionsAndOffset( 
+				  std::vector<unsigned> &mesh_dimensions,
+				  std::vector<unsigned> &mesh_offset ) const
+{
+  mesh_dimensions.resize( 3 );
+  mesh_dimensions[0] = d_mesh_x_dim;
+  mesh_dimensions[1] = d_mesh_y_dim;
+  mesh_dimensions[2] = d_mesh_z_dim;
+
+  mesh_offset.resize( 3 );
+  mesh_offset[0] = d_geometry->getROIXOffset();
+  mesh_offset[1] = d_geometry->getROIYOffset();
+  mesh_offset[2] = d_geometry->getROIZOffset();
+}
 
 } // end TPOR namespace
 
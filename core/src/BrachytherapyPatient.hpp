@@ -18,17 +18,26 @@
 // Boost Includes
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
 
 // TPOR Includes
 #include "TissueType.hpp"
 #include "BrachytherapySeedPosition.hpp"
-#include "BrachytherapyDynamicWeightSeedPosition.hpp"
-#include "BrachytherapySetCoverSeedPosition.hpp"
+#include "BrachytherapyCandidateTable.hpp"
 #include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapySeedRecord.hpp"
+#include "BrachytherapyPlanEvaluator.hpp"
 
 namespace TPOR{
 
-//! Brachytherapy patient class
+/*! Brachytherapy patient class
+ *
+ * The patient stores the state of a single treatment plan (the inserted 
+ * seeds, the dose distribution and the checkpoints). The read-only patient 
+ * geometry can be shared by any number of patients. All mesh indices are 
+ * relative to the region of interest of the patient geometry.
+ */
 class BrachytherapyPatient
 {
 
@@ -41,6 +50,10 @@ public:
 			const double rectum_weight = 1.0,
 			const double margin_weight = 1.0 );
 
+  //! Constructor (shared patient geometry)
+  explicit BrachytherapyPatient( 
+	const boost::shared_ptr<const BrachytherapyPatientGeometry> &geometry );
+
   //! Destructor
   ~BrachytherapyPatient()
   { /* ... */ }
@@ -48,21 +61,44 @@ public:
   //! Insert a seed at the desired seed position and return the seed id number
   unsigned insertSeed( const BrachytherapySeedPosition &seed_position );
 
+  //! Remove the seed at the desired seed position
+  void removeSeed( const BrachytherapySeedPosition &seed_position );
+
+  //! Move an inserted seed to a new seed position
+  void moveSeed( const BrachytherapySeedPosition &old_seed_position,
+		 const BrachytherapySeedPosition &new_seed_position );
+
   //! Test if the seed position lies on an inserted needle
   bool isSeedOnNeedle( const BrachytherapySeedPosition &seed_position ) const;
 
+  //! Test if the candidate seed position lies on an inserted needle
+  bool isSeedOnNeedle( const BrachytherapyCandidateTable &candidates,
+		       const unsigned candidate ) const;
+
   //! Test if the seed position is free
   bool isSeedPositionFree(
 			const BrachytherapySeedPosition &seed_position ) const;
 
+  //! Test if the candidate seed position is free
+  bool isSeedPositionFree( const BrachytherapyCandidateTable &candidates,
+			   const unsigned candidate ) const;
+
   //! Return the dose at a seed position (cGy)
   double getDose( const BrachytherapySeedPosition &seed_position ) const;
+
+  //! Return the dose at a candidate seed position (cGy)
+  double getDose( const BrachytherapyCandidateTable &candidates,
+		  const unsigned candidate ) const;
   
   //! Return the dose at a mesh point (cGy)
   double getDose( const unsigned x_mesh_index,
 		  const unsigned y_mesh_index,
 		  const unsigned z_mesh_index ) const;
 
+  //! Return the patient geometry
+  const boost::shared_ptr<const BrachytherapyPatientGeometry>& 
+  getGeometry() const;
+
   //! Return the prescribed dose
   double getPrescribedDose() const;
   
@@ -99,20 +135,26 @@ public:
   //! Return the normal size (num normal elements)
   unsigned getNormalSize() const;
 
+  //! Return the prostate mask
+  const std::vector<bool>& getProstateMask() const;
+
+  //! Return the urethra mask
+  const std::vector<bool>& getUrethraMask() const;
+
+  //! Return the rectum mask
+  const std::vector<bool>& getRectumMask() const;
+
   //! Return the tissue type at a mesh point
   TissueType getTissueType( const unsigned x_mesh_index,
 			    const unsigned y_mesh_index,
 			    const unsigned z_mesh_index ) const;
 
-  //! Return the potential seed positions for the desired seeds
-  template<typename SeedPosition>
-  std::list<SeedPosition> getPotentialSeedPositions( 
-  const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds ) const;
-
-  //! Return the potential seed positions for the desired seed
-  template<typename SeedPosition>
-  std::list<SeedPosition> getPotentialSeedPositions( 
-		 const boost::shared_ptr<BrachytherapySeedProxy> &seed ) const;
+  //! Add the candidate seed positions for the desired seeds to a table
+  void getCandidateSeedPositions( 
+	  const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	  BrachytherapyCandidateTable &candidates,
+	  const std::vector<bool> &candidate_needle_mask = 
+	  std::vector<bool>() ) const;
 
   //! Return the prostate dose coverage (% of prostate with >= prescribed dose)
   double getProstatePrescribedDoseCoverage() const;
@@ -135,16 +177,37 @@ public:
   //! Return the number of inserted needles
   unsigned getNumInsertedNeedles() const;
 
+  //! Return the needle indices of the inserted needles
+  void getInsertedNeedles( std::vector<unsigned> &needle_indices ) const;
+
   //! Return the number of inserted seeds
   unsigned getNumInsertedSeeds() const;
 
+  //! Return the treatment plan (inserted seed positions)
+  const std::list<BrachytherapySeedPosition>& getTreatmentPlan() const;
+
+  //! Return the treatment plan dose distribution (cGy)
+  const std::vector<double>& getDoseDistribution() const;
+
+  //! Create a named checkpoint of the current state of the patient
+  void createCheckpoint( const std::string &checkpoint_name );
+
+  //! Restore the state of the patient at a named checkpoint
+  void restoreCheckpoint( const std::string &checkpoint_name );
+
+  //! Release a named checkpoint
+  void releaseCheckpoint( const std::string &checkpoint_name );
+
+  //! Test if a named checkpoint exists
+  bool checkpointExists( const std::string &checkpoint_name ) const;
+
   //! Save the current state of the patient
   void saveState();
 
   //! Load the previously saved state of the patient
   void loadSavedState();
 
-  //! Reset the state of the patient
+  //! Reset the state of the patient (all checkpoints are released)
   void resetState();
 
   //! Print the treatment plan
@@ -165,74 +228,124 @@ public:
   //! Export the patient data to a vtk file for 3D visualization
   void exportDataToVTK( const bool export_treatment_plan = true ) const;
 
+  //! Export the treatment plan results to an hdf5 file
+  void exportTreatmentPlanToHDF5( const std::string &plan_name,
+				  const std::string &file_name = "" ) const;
+
+  //! Archive the treatment plan to an hdf5 file (seeds and metrics only)
+  void archiveTreatmentPlanToHDF5( const std::string &plan_name,
+				   const std::string &file_name = "",
+				   const bool store_quantized_dose = true ) const;
+
+  //! Load a treatment plan from an hdf5 file (the dose is rebuilt)
+  void loadTreatmentPlanFromHDF5( 
+	  const std::string &plan_name,
+	  const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	  const std::string &file_name = "" );
+
 private:
 
-  //! BrachytherapySeedPosition creation policy
-  template<typename SeedPosition>
-  friend struct SeedPositionCreationPolicy;
-
-  //! Create potential seed positions
-  template<typename SeedPosition>
-  void createSeedPositions( 
-			std::list<SeedPosition> &seed_positions,
-			const boost::shared_ptr<BrachytherapySeedProxy> &seed,
-			const std::vector<double> &prostate_adjoint_data,
-			const std::vector<double> &urethra_adjoint_data,
-			const std::vector<double> &margin_adjoint_data,
-			const std::vector<double> &rectum_adjoint_data ) const;
-  
-  // The patient file name
-  std::string d_patient_file_name;
+  //! Treatment plan operations that are recorded in the journal
+  enum PlanOperation{
+    INSERT_SEED_OPERATION = 0,
+    REMOVE_SEED_OPERATION,
+    MOVE_SEED_OPERATION
+  };
 
-  // Prescribed dose
-  double d_prescribed_dose;
+  //! Treatment plan journal entry
+  struct PlanJournalEntry
+  {
+    PlanJournalEntry( const PlanOperation operation_type,
+		      const BrachytherapySeedPosition &position,
+		      const unsigned index )
+      : operation( operation_type ),
+	seed_position( position ),
+	plan_index( index )
+    { /* ... */ }
+
+    // The operation that was conducted
+    PlanOperation operation;
+
+    // The inserted, removed or moved (old) seed position
+    BrachytherapySeedPosition seed_position;
+
+    // The index of the seed position in the treatment plan
+    unsigned plan_index;
+  };
+
+  //! Patient state checkpoint
+  struct PatientCheckpoint
+  {
+    // The checkpoint name
+    std::string name;
 
-  // Mesh dimensions  
-  unsigned d_mesh_x_dim;
-  unsigned d_mesh_y_dim;
-  unsigned d_mesh_z_dim;
+    // The journal size when the checkpoint was created
+    unsigned journal_size;
+
+    // The dose distribution z-slices modified since the checkpoint 
+    // (empty if a slice has not been modified)
+    std::vector<std::vector<double> > saved_dose_slices;
+  };
 
-  // Prostate volume (number of mesh elements)
-  unsigned d_prostate_relative_vol;
+  //! Return the needle index of a seed position
+  unsigned calculateNeedleIndex( 
+		        const BrachytherapySeedPosition &seed_position ) const;
 
-  // Urethra volume (number of mesh elements)
-  unsigned d_urethra_relative_vol;
+  //! Return the mesh index of a seed position
+  unsigned calculatePositionIndex(
+			const BrachytherapySeedPosition &seed_position ) const;
 
-  // Rectum volume (number of mesh elements)
-  unsigned d_rectum_relative_vol;
+  //! Add a seed position to the needle and position sets
+  void addToPlanSets( const BrachytherapySeedPosition &seed_position );
 
-  // Normal volume (number of mesh elements)
-  unsigned d_normal_relative_vol;
+  //! Remove a seed position from the needle and position sets
+  void removeFromPlanSets( const BrachytherapySeedPosition &seed_position );
 
-  // Weight of the urethra relative to the prostate 
-  double d_urethra_weight;
-  
-  // Weight of the rectum relative to the prostate
-  double d_rectum_weight;
+  //! Save the dose distribution z-slices that are about to be modified
+  void journalDoseDistribution( const unsigned z_start, const unsigned z_end );
 
-  // Weight of the margin relative to the prostate
-  double d_margin_weight;
+  //! Record a treatment plan operation in the journal
+  void journalPlanOperation( const PlanOperation operation,
+			     const BrachytherapySeedPosition &seed_position,
+			     const unsigned plan_index );
 
-  // Prostate mask
-  std::vector<bool> d_prostate_mask;
+  //! Undo the last treatment plan operation in the journal
+  void undoLastPlanOperation();
 
-  // Urethra mask
-  std::vector<bool> d_urethra_mask;
+  //! Calculate the dose-volume-histogram data (dose bins in Gy)
+  void calculateDoseVolumeHistogram( 
+			       std::vector<double> &doses,
+			       std::vector<double> &prostate_fractions,
+			       std::vector<double> &urethra_fractions,
+			       std::vector<double> &rectum_fractions,
+			       std::vector<double> &normal_fractions ) const;
 
-  // Margin mask
-  std::vector<bool> d_margin_mask;
-  
-  // Rectum mask
-  std::vector<bool> d_rectum_mask;
+  //! Create the seed records of the treatment plan
+  void createSeedRecords( std::vector<BrachytherapySeedRecord> &seeds ) const;
+
+  //! Calculate the treatment plan metrics
+  void calculatePlanMetrics( BrachytherapyPlanMetrics &metrics ) const;
+
+  //! Return the mesh dimensions and the offset in the full organ mesh
+  void getMeshDimensionsAndOffset( std::vector<unsigned> &mesh_dimensions,
+				   std::vector<unsigned> &mesh_offset ) const;
+
+  //! Return the stack index of a named checkpoint
+  unsigned findCheckpoint( const std::string &checkpoint_name ) const;
+
+  // The patient geometry
+  boost::shared_ptr<const BrachytherapyPatientGeometry> d_geometry;
 
-  // Needle template
-  std::vector<bool> d_needle_template;
+  // Mesh dimensions (cached from the geometry)
+  unsigned d_mesh_x_dim;
+  unsigned d_mesh_y_dim;
+  unsigned d_mesh_z_dim;
 
   // Treatment plan 
   std::list<BrachytherapySeedPosition> d_treatment_plan;
 
-  // Treatment plan needle set
-  boost::unordered_set<unsigned> d_treatment_plan_needles;
+  // Treatment plan needle set (needle index, number of seeds on needle)
+  boost::unordered_map<unsigned,unsigned> d_treatment_plan_needles;
 
   // Treatment plan position set
   boost::unordered_set<unsigned> d_treatment_plan_positions;
@@ -240,155 +353,18 @@ private:
   // Treatment plan dose distribution
   std::vector<double> d_dose_distribution;
 
-  // Cached treatment plan 
-  std::list<BrachytherapySeedPosition> d_cached_treatment_plan;
-
-  // Cached treatment plan needle set
-  boost::unordered_set<unsigned> d_cached_treatment_plan_needles;
-
-  // Cached treatment plan position set
-  boost::unordered_set<unsigned> d_cached_treatment_plan_positions;
-
-  // Cached treatment plan dose distribution
-  std::vector<double> d_cached_dose_distribution;
-};
-
-//! Generic seed position creation policy
-template<typename SeedPosition>
-struct SeedPositionCreationPolicy
-{
-  static void create( std::list<SeedPosition> &seed_positions,
-		      const boost::shared_ptr<BrachytherapySeedProxy> &seed,
-		      const BrachytherapyPatient &patient,
-		      const std::vector<double> &prostate_adjoint_data,
-		      const std::vector<double> &urethra_adjoint_data,
-		      const std::vector<double> &margin_adjoint_data,
-		      const std::vector<double> &rectum_adjoint_data,
-		      const unsigned mesh_x_index,
-		      const unsigned mesh_y_index,
-		      const unsigned mesh_z_index )
-  {
-    unsigned mask_index = mesh_x_index + mesh_y_index*patient.d_mesh_x_dim +
-      mesh_z_index*patient.d_mesh_x_dim*patient.d_mesh_y_dim;
-    
-    if( patient.d_prostate_mask[mask_index] )
-    {
-      double weight = 
-	(patient.d_urethra_weight*urethra_adjoint_data[mask_index] +
-	 patient.d_margin_weight*margin_adjoint_data[mask_index] +
-	 patient.d_rectum_weight*rectum_adjoint_data[mask_index])/
-	prostate_adjoint_data[mask_index];
-      
-      seed_positions.push_back( SeedPosition( mesh_x_index, 
-					      mesh_y_index, 
-					      mesh_z_index, 
-					      weight, 
-					      seed ) );
-    }
-  }
-};
+  // Treatment plan journal (only recorded while checkpoints exist)
+  std::vector<PlanJournalEntry> d_plan_journal;
 
-//! BrachytherapyDynamicWeightSeedPosition creation policy specialization
-template<>
-struct SeedPositionCreationPolicy<BrachytherapyDynamicWeightSeedPosition>
-{
-  static void create(
-	     std::list<BrachytherapyDynamicWeightSeedPosition> &seed_positions,
-	     const boost::shared_ptr<BrachytherapySeedProxy> &seed,
-	     const BrachytherapyPatient &patient,
-	     const std::vector<double> &prostate_adjoint_data,
-	     const std::vector<double> &urethra_adjoint_data,
-	     const std::vector<double> &margin_adjoint_data,
-	     const std::vector<double> &rectum_adjoint_data,
-	     const unsigned mesh_x_index,
-	     const unsigned mesh_y_index,
-	     const unsigned mesh_z_index )
-  {
-    unsigned mask_index = mesh_x_index + mesh_y_index*patient.d_mesh_x_dim +
-      mesh_z_index*patient.d_mesh_x_dim*patient.d_mesh_y_dim;
-    
-    if( patient.d_prostate_mask[mask_index] )
-    {
-      double weight = 
-	(patient.d_urethra_weight*urethra_adjoint_data[mask_index] +
-	 patient.d_margin_weight*margin_adjoint_data[mask_index] +
-	 patient.d_rectum_weight*rectum_adjoint_data[mask_index])/
-	prostate_adjoint_data[mask_index];
-      
-      const double* weight_multiplier = 
-	&patient.d_dose_distribution[mask_index];
-      
-      seed_positions.push_back( BrachytherapyDynamicWeightSeedPosition(
-							     mesh_x_index, 
-							     mesh_y_index, 
-							     mesh_z_index, 
-							     weight,
-							     weight_multiplier,
-							     seed ) );
-    }
-  }
-};
+  // Checkpoint stack (the most recent checkpoint is at the back)
+  std::vector<PatientCheckpoint> d_checkpoints;
 
-//! BrachytherapySetCoverSeedPosition creation policy specialization
-template<>
-struct SeedPositionCreationPolicy<BrachytherapySetCoverSeedPosition>
-{
-  static void create(
-	     std::list<BrachytherapySetCoverSeedPosition> &seed_positions,
-	     const boost::shared_ptr<BrachytherapySeedProxy> &seed,
-	     const BrachytherapyPatient &patient,
-	     const std::vector<double> &prostate_adjoint_data,
-	     const std::vector<double> &urethra_adjoint_data,
-	     const std::vector<double> &margin_adjoint_data,
-	     const std::vector<double> &rectum_adjoint_data,
-	     const unsigned mesh_x_index,
-	     const unsigned mesh_y_index,
-	     const unsigned mesh_z_index )
-  {    
-    unsigned mask_index = mesh_x_index + mesh_y_index*patient.d_mesh_x_dim +
-      mesh_z_index*patient.d_mesh_x_dim*patient.d_mesh_y_dim;
-    
-    // Create pointers to the dose distribution and the prostate mask
-    const std::vector<double>* dose_distribution = 
-      &patient.d_dose_distribution;
-    const std::vector<bool>* prostate_mask =
-      &patient.d_prostate_mask;
-    
-    if( patient.d_prostate_mask[mask_index] )
-    {
-      double cost = 
-	(patient.d_urethra_weight*urethra_adjoint_data[mask_index] +
-	 patient.d_margin_weight*margin_adjoint_data[mask_index] +
-	 patient.d_rectum_weight*rectum_adjoint_data[mask_index])/
-	prostate_adjoint_data[mask_index];
-      
-      seed_positions.push_back( BrachytherapySetCoverSeedPosition(
-						     mesh_x_index, 
-						     mesh_y_index, 
-						     mesh_z_index, 
-						     cost,
-						     patient.d_prescribed_dose,
-						     dose_distribution,
-						     prostate_mask,
-						     patient.d_mesh_x_dim,
-						     patient.d_mesh_y_dim,
-						     patient.d_mesh_z_dim,
-						     seed ) );
-      seed_positions.back().updateWeight();
-    }
-  }
+  // The name of the checkpoint used by saveState and loadSavedState
+  static const std::string saved_state_checkpoint_name;
 };
 
 } // end TPOR namespace
 
-//---------------------------------------------------------------------------//
-// Template includes.
-//---------------------------------------------------------------------------//
-
-#include "BrachytherapyPatient_def.hpp"
-
-//---------------------------------------------------------------------------//
-
 #endif // end BRACHYTHERAPY_PATIENT_HPP
 
 //---------------------------------------------------------------------------//
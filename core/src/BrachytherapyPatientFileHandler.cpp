@@ -52,120 +52,159 @@ void BrachytherapyPatientFileHandler::getOrganMeshDimensions(
 					   "mesh_dimensions" );
 }
 
+// Return the organ names (one organ per mask in the organ_masks group)
+/*! \details The organ masks are stored in the organ_masks group as 
+ * <organ name>_mask data sets. Members of the group that do not follow this
+ * naming convention are ignored.
+ */
+void BrachytherapyPatientFileHandler::getOrganNames( 
+				       std::vector<std::string> &organ_names )
+{
+  std::vector<std::string> member_names;
+  d_hdf5_file.getGroupMemberNames( "/organ_masks", member_names );
+
+  const std::string mask_suffix( "_mask" );
+
+  organ_names.clear();
+
+  for( unsigned i = 0; i < member_names.size(); ++i )
+  {
+    const std::string &name = member_names[i];
+    
+    if( name.size() > mask_suffix.size() &&
+	name.compare( name.size() - mask_suffix.size(),
+		      mask_suffix.size(),
+		      mask_suffix ) == 0 )
+    {
+      organ_names.push_back( 
+			 name.substr( 0, name.size() - mask_suffix.size() ) );
+			 }
+			 }
+			 }
+			 
+			 // Test if an organ mask exists
+			 bool BrachytherapyPatientFileHandler::organMaskExists(
+			 const std::string &organ_name )
+{
+  return d_hdf5_file.dataSetExists( getOrganMaskLocation( organ_name ) );
+}
+
+// Return an organ mask
+void BrachytherapyPatientFileHandler::getOrganMask( 
+					       std::vector<bool> &organ_mask,
+					       const std::string &organ_name )
+{
+  std::vector<char> tmp_organ_mask;
+  d_hdf5_file.readArrayFromDataSet( tmp_organ_mask,
+				    getOrganMaskLocation( organ_name ) );
+
+  fillBooleanArray( organ_mask, tmp_organ_mask );
+}
+
+// Return an organ mask relative volume (num elements)
+void BrachytherapyPatientFileHandler::getOrganMaskRelativeVolume( 
+					    unsigned &organ_mask_relative_vol,
+					    const std::string &organ_name )
+{
+  d_hdf5_file.readValueFromDataSetAttribute( 
+					  organ_mask_relative_vol,
+					  getOrganMaskLocation( organ_name ),
+					  "relative_volume" );
+}
+
+// Return an organ mask volume (cm^3)
+void BrachytherapyPatientFileHandler::getOrganMaskVolume( 
+					       double &organ_mask_volume,
+					       const std::string &organ_name )
+{
+  d_hdf5_file.readValueFromDataSetAttribute( 
+					  organ_mask_volume,
+					  getOrganMaskLocation( organ_name ),
+					  "volume" );
+}
+
 // Return the prostate mask
 void BrachytherapyPatientFileHandler::getProstateMask( 
 					     std::vector<bool> &prostate_mask )
 {
-  std::vector<char> tmp_prostate_mask;
-  d_hdf5_file.readArrayFromDataSet( tmp_prostate_mask,
-				    "/organ_masks/prostate_mask" );
-
-  fillBooleanArray( prostate_mask, tmp_prostate_mask );
+  getOrganMask( prostate_mask, "prostate" );
 }
 
 // Return the prostate mask relative volume
 void BrachytherapyPatientFileHandler::getProstateMaskRelativeVolume( 
 					 unsigned &prostate_mask_relative_vol )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( prostate_mask_relative_vol,
-					     "/organ_masks/prostate_mask",
-					     "relative_volume" );
+  getOrganMaskRelativeVolume( prostate_mask_relative_vol, "prostate" );
 }
 
 // Return the prostate mask volume (cm^3)
 void BrachytherapyPatientFileHandler::getProstateMaskVolume( 
-						 double &prostate_mask_volume )
+						double &prostate_mask_volume )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( prostate_mask_volume,
-					     "/organ_masks/prostate_mask",
-					     "volume" );
+  getOrganMaskVolume( prostate_mask_volume, "prostate" );
 }
 
 // Return the urethra mask
 void BrachytherapyPatientFileHandler::getUrethraMask( 
 					      std::vector<bool> &urethra_mask )
 {
-  std::vector<char> tmp_urethra_mask;
-  d_hdf5_file.readArrayFromDataSet( tmp_urethra_mask,
-				    "/organ_masks/urethra_mask" );
-
-  fillBooleanArray( urethra_mask, tmp_urethra_mask );
+  getOrganMask( urethra_mask, "urethra" );
 }
 
 // Return the urethra mask relative volume
 void BrachytherapyPatientFileHandler::getUrethraMaskRelativeVolume( 
 					  unsigned &urethra_mask_relative_vol )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( urethra_mask_relative_vol,
-					     "/organ_masks/urethra_mask",
-					     "relative_volume" );
+  getOrganMaskRelativeVolume( urethra_mask_relative_vol, "urethra" );
 }
 
-// Return the urethra mask volume
-void BrachytherapyPatientFileHandler::getUrethraMaskVolume(
-						  double &urethra_mask_volume )
+// Return the urethra mask volume (cm^3)
+void BrachytherapyPatientFileHandler::getUrethraMaskVolume( 
+						double &urethra_mask_volume )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( urethra_mask_volume,
-					     "/organ_masks/urethra_mask",
-					     "volume" );
+  getOrganMaskVolume( urethra_mask_volume, "urethra" );
 }
 
 // Return the margin mask
 void BrachytherapyPatientFileHandler::getMarginMask( 
 					       std::vector<bool> &margin_mask )
 {
-  std::vector<char> tmp_margin_mask;
-  d_hdf5_file.readArrayFromDataSet( tmp_margin_mask,
-				    "/organ_masks/margin_mask" );
-
-  fillBooleanArray( margin_mask, tmp_margin_mask );
+  getOrganMask( margin_mask, "margin" );
 }
 
 // Return the margin mask relative volume
 void BrachytherapyPatientFileHandler::getMarginMaskRelativeVolume( 
 					   unsigned &margin_mask_relative_vol )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( margin_mask_relative_vol,
-					     "/organ_masks/margin_mask",
-					     "relative_volume" );
+  getOrganMaskRelativeVolume( margin_mask_relative_vol, "margin" );
 }
 
-// Return the margin mask volume
-void BrachytherapyPatientFileHandler::getMarginMaskVolume(
-						   double &margin_mask_volume )
+// Return the margin mask volume (cm^3)
+void BrachytherapyPatientFileHandler::getMarginMaskVolume( 
+						double &margin_mask_volume )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( margin_mask_volume,
-					     "/organ_masks/margin_mask",
-					     "volume" );
+  getOrganMaskVolume( margin_mask_volume, "margin" );
 }
 
 // Return the rectum mask
 void BrachytherapyPatientFileHandler::getRectumMask( 
 					       std::vector<bool> &rectum_mask )
 {
-  std::vector<char> tmp_rectum_mask;
-  d_hdf5_file.readArrayFromDataSet( tmp_rectum_mask,
-				    "/organ_masks/rectum_mask" );
-  
-  fillBooleanArray( rectum_mask, tmp_rectum_mask );
+  getOrganMask( rectum_mask, "rectum" );
 }
 
 // Return the rectum mask relative volume
 void BrachytherapyPatientFileHandler::getRectumMaskRelativeVolume( 
 					   unsigned &rectum_mask_relative_vol )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( rectum_mask_relative_vol,
-					     "/organ_masks/rectum_mask",
-					     "relative_volume" );
+  getOrganMaskRelativeVolume( rectum_mask_relative_vol, "rectum" );
 }
 
-// Return the rectum mask volume
-void BrachytherapyPatientFileHandler::getRectumMaskVolume(
-						   double &rectum_mask_volume )
+// Return the rectum mask volume (cm^3)
+void BrachytherapyPatientFileHandler::getRectumMaskVolume( 
+						double &rectum_mask_volume )
 {
-  d_hdf5_file.readValueFromDataSetAttribute( rectum_mask_volume,
-					     "/organ_masks/rectum_mask",
-					     "volume" );
+  getOrganMaskVolume( rectum_mask_volume, "rectum" );
 }
 
 // Return the needle template
@@ -189,20 +228,57 @@ bool BrachytherapyPatientFileHandler::adjointDataExists(
   return d_hdf5_file.groupExists( group_location );
 }
 
+// Test if organ adjoint data has been generated for a specific seed
+bool BrachytherapyPatientFileHandler::adjointDataExists( 
+						const std::string &seed_name,
+						const std::string &organ_name )
+{
+  return adjointDataExists( seed_name ) &&
+    d_hdf5_file.dataSetExists( getOrganAdjointDataLocation( organ_name,
+							    seed_name ) );
+}
+
+// Return the organ adjoint data for the desired seed
+void BrachytherapyPatientFileHandler::getOrganAdjointData( 
+				    std::vector<double> &organ_adjoint_data,
+				    const std::string &organ_name,
+				    const std::string &desired_seed_name,
+				    const double desired_seed_strength )
+{
+  d_hdf5_file.readArrayFromDataSet( 
+		 organ_adjoint_data,
+		 getOrganAdjointDataLocation( organ_name, desired_seed_name ) );
+
+  // Scale the adjoint data by the desired seed strength
+  scaleAdjointData( organ_adjoint_data, desired_seed_strength );
+}
+
+// Set the organ adjoint data for the desired seed
+void BrachytherapyPatientFileHandler::setOrganAdjointData(
+			      const std::vector<double> &organ_adjoint_data,
+			      const std::string &organ_name,
+			      const std::string &seed_name,
+			      const double seed_strength )
+{
+  // Normalize the adjoint data
+  std::vector<double> normalized_adjoint_data = organ_adjoint_data;
+  scaleAdjointData( normalized_adjoint_data, 1.0/seed_strength );
+  
+  d_hdf5_file.writeArrayToDataSet( 
+			 normalized_adjoint_data,
+			 getOrganAdjointDataLocation( organ_name, seed_name ) );
+}
+
 // Return the prostate adjoint data for the desired seed
 void BrachytherapyPatientFileHandler::getProstateAdjointData( 
 				    std::vector<double> &prostate_adjoint_data,
 				    const std::string &desired_seed_name,
 				    const double desired_seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += desired_seed_name;
-  dataset_location += "/prostate_adjoint_data";
-  
-  d_hdf5_file.readArrayFromDataSet( prostate_adjoint_data, dataset_location );
-
-  // Scale the adjoint data by the desired seed strength
-  scaleAdjointData( prostate_adjoint_data, desired_seed_strength );
+  getOrganAdjointData( prostate_adjoint_data,
+		       "prostate",
+		       desired_seed_name,
+		       desired_seed_strength );
 }
 
 // Set the prostate adjoint data for the desired seed
@@ -211,117 +287,89 @@ void BrachytherapyPatientFileHandler::setProstateAdjointData(
 			      const std::string &seed_name,
 			      const double seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += seed_name;
-  dataset_location += "/prostate_adjoint_data";
-  
-  // Normalize the adjoint data
-  std::vector<double> normalized_adjoint_data = prostate_adjoint_data;
-  scaleAdjointData( normalized_adjoint_data, 1.0/seed_strength );
-  
-  d_hdf5_file.writeArrayToDataSet( normalized_adjoint_data, dataset_location );
+  setOrganAdjointData( prostate_adjoint_data, "prostate", seed_name,
+		       seed_strength );
 }
 
 // Return the urethra adjoint data for the desired seed
 void BrachytherapyPatientFileHandler::getUrethraAdjointData( 
-				 std::vector<double> &urethra_adjoint_data,
-				 const std::string &desired_seed_name,
-				 const double desired_seed_strength )
+				     std::vector<double> &urethra_adjoint_data,
+				     const std::string &desired_seed_name,
+				     const double desired_seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += desired_seed_name;
-  dataset_location += "/urethra_adjoint_data";
-
-  d_hdf5_file.readArrayFromDataSet( urethra_adjoint_data, dataset_location );
-
-  // Scale the adjoint data by the desired seed strength
-  scaleAdjointData( urethra_adjoint_data, desired_seed_strength );
+  getOrganAdjointData( urethra_adjoint_data,
+		       "urethra",
+		       desired_seed_name,
+		       desired_seed_strength );
 }
 
 // Set the urethra adjoint data for the desired seed
-void BrachytherapyPatientFileHandler::setUrethraAdjointData( 
+void BrachytherapyPatientFileHandler::setUrethraAdjointData(
 			       const std::vector<double> &urethra_adjoint_data,
 			       const std::string &seed_name,
 			       const double seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += seed_name;
-  dataset_location += "/urethra_adjoint_data";
-
-  
-  // Normalize the adjoint data
-  std::vector<double> normalized_adjoint_data = urethra_adjoint_data;
-  scaleAdjointData( normalized_adjoint_data, 1.0/seed_strength );
-
-  d_hdf5_file.writeArrayToDataSet( normalized_adjoint_data, dataset_location );
+  setOrganAdjointData( urethra_adjoint_data, "urethra", seed_name,
+		       seed_strength );
 }
 
 // Return the margin adjoint data for the desired seed
 void BrachytherapyPatientFileHandler::getMarginAdjointData( 
-				 std::vector<double> &margin_adjoint_data,
-				 const std::string &desired_seed_name,
-				 const double desired_seed_strength )
+				      std::vector<double> &margin_adjoint_data,
+				      const std::string &desired_seed_name,
+				      const double desired_seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += desired_seed_name;
-  dataset_location += "/margin_adjoint_data";
-
-  d_hdf5_file.readArrayFromDataSet( margin_adjoint_data, dataset_location );
-
-  // Scale the adjoint data by the desired seed strength
-  scaleAdjointData( margin_adjoint_data, desired_seed_strength );
+  getOrganAdjointData( margin_adjoint_data,
+		       "margin",
+		       desired_seed_name,
+		       desired_seed_strength );
 }
 
 // Set the margin adjoint data for the desired seed
-void BrachytherapyPatientFileHandler::setMarginAdjointData( 
-			        const std::vector<double> &margin_adjoint_data,
+void BrachytherapyPatientFileHandler::setMarginAdjointData(
+				const std::vector<double> &margin_adjoint_data,
 				const std::string &seed_name,
 				const double seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += seed_name;
-  dataset_location += "/margin_adjoint_data";
-
-  
-  // Normalize the adjoint data
-  std::vector<double> normalized_adjoint_data = margin_adjoint_data;
-  scaleAdjointData( normalized_adjoint_data, 1.0/seed_strength );
-
-  d_hdf5_file.writeArrayToDataSet( normalized_adjoint_data, dataset_location );
+  setOrganAdjointData( margin_adjoint_data, "margin", seed_name,
+		       seed_strength );
 }
 
 // Return the rectum adjoint data for the desired seed
 void BrachytherapyPatientFileHandler::getRectumAdjointData( 
-				 std::vector<double> &rectum_adjoint_data,
-				 const std::string &desired_seed_name,
-				 const double desired_seed_strength )
+				      std::vector<double> &rectum_adjoint_data,
+				      const std::string &desired_seed_name,
+				      const double desired_seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += desired_seed_name;
-  dataset_location += "/rectum_adjoint_data";
-
-  d_hdf5_file.readArrayFromDataSet( rectum_adjoint_data, dataset_location );
-
-  // Scale the adjoint data by the desired seed strength
-  scaleAdjointData( rectum_adjoint_data, desired_seed_strength );
+  getOrganAdjointData( rectum_adjoint_data,
+		       "rectum",
+		       desired_seed_name,
+		       desired_seed_strength );
 }
 
-//! Set the rectum adjoint data for the desired seed
-void BrachytherapyPatientFileHandler::setRectumAdjointData( 
-			        const std::vector<double> &rectum_adjoint_data,
+// Set the rectum adjoint data for the desired seed
+void BrachytherapyPatientFileHandler::setRectumAdjointData(
+				const std::vector<double> &rectum_adjoint_data,
 				const std::string &seed_name,
 				const double seed_strength )
 {
-  std::string dataset_location = "/adjoint_data/";
-  dataset_location += seed_name;
-  dataset_location += "/rectum_adjoint_data";
+  setOrganAdjointData( rectum_adjoint_data, "rectum", seed_name,
+		       seed_strength );
+}
 
-  
-  // Normalize the adjoint data
-  std::vector<double> normalized_adjoint_data = rectum_adjoint_data;
-  scaleAdjointData( normalized_adjoint_data, 1.0/seed_strength );
+// Return the location of an organ mask in the file
+std::string BrachytherapyPatientFileHandler::getOrganMaskLocation( 
+					       const std::string &organ_name )
+{
+  return "/organ_masks/" + organ_name + "_mask";
+}
 
-  d_hdf5_file.writeArrayToDataSet( normalized_adjoint_data, dataset_location );
+// Return the location of organ adjoint data in the file
+std::string BrachytherapyPatientFileHandler::getOrganAdjointDataLocation( 
+						const std::string &organ_name,
+						const std::string &seed_name )
+{
+  return "/adjoint_data/" + seed_name + "/" + organ_name + "_adjoint_data";
 }
 
 // Fill a boolean array using an array of chars
@@ -11,6 +11,8 @@
 
 // Std Lib Includes
 #include <utility>
+#include <string>
+#include <vector>
 
 // TPOR Includes
 #include "HDF5FileHandler.hpp"
@@ -39,6 +41,24 @@ public:
   //! Return the organ mask dimensions
   void getOrganMeshDimensions( std::vector<unsigned> &mesh_dimensions );
 
+  //! Return the organ names (one organ per mask in the organ_masks group)
+  void getOrganNames( std::vector<std::string> &organ_names );
+
+  //! Test if an organ mask exists
+  bool organMaskExists( const std::string &organ_name );
+
+  //! Return an organ mask
+  void getOrganMask( std::vector<bool> &organ_mask,
+		     const std::string &organ_name );
+
+  //! Return an organ mask relative volume (num elements)
+  void getOrganMaskRelativeVolume( unsigned &organ_mask_relative_vol,
+				   const std::string &organ_name );
+
+  //! Return an organ mask volume (cm^3)
+  void getOrganMaskVolume( double &organ_mask_volume,
+			   const std::string &organ_name );
+
   //! Return the prostate mask
   void getProstateMask( std::vector<bool> &prostate_mask );
 
@@ -81,6 +101,22 @@ public:
   //! Test if adjoint data has been generated for a specific seed
   bool adjointDataExists( const std::string &seed_name );
 
+  //! Test if organ adjoint data has been generated for a specific seed
+  bool adjointDataExists( const std::string &seed_name,
+			  const std::string &organ_name );
+
+  //! Return the organ adjoint data for the desired seed
+  void getOrganAdjointData( std::vector<double> &organ_adjoint_data,
+			    const std::string &organ_name,
+			    const std::string &desired_seed_name,
+			    const double desired_seed_strength );
+
+  //! Set the organ adjoint data for the desired seed
+  void setOrganAdjointData( const std::vector<double> &organ_adjoint_data,
+			    const std::string &organ_name,
+			    const std::string &seed_name,
+			    const double seed_strength );
+
   //! Return the prostate adjoint data for the desired seed
   void getProstateAdjointData( std::vector<double> &prostate_adjoint_data,
 			       const std::string &desired_seed_name,
@@ -123,6 +159,14 @@ public:
 
 private:
 
+  //! Return the location of an organ mask in the file
+  static std::string getOrganMaskLocation( const std::string &organ_name );
+
+  //! Return the location of organ adjoint data in the file
+  static std::string getOrganAdjointDataLocation( 
+					       const std::string &organ_name,
+					       const std::string &seed_name );
+
   //! Fill a boolean array using an array of chars
   void fillBooleanArray( std::vector<bool> &bool_array,
 			 const std::vector<char> &schar_array );
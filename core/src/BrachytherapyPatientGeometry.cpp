@@ -0,0 +1,809 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPatientGeometry.cpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPatientGeometry class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatientFileHandler.hpp"
+#include "BrachytherapyAdjointDataGenerator.hpp"
+#include "ContractException.hpp"
+#include "ExceptionTestMacros.hpp"
+#include "ExceptionCatchMacros.hpp"
+
+namespace TPOR{
+
+// Initialize the ROI padding static members
+const unsigned BrachytherapyPatientGeometry::roi_xy_padding;
+const unsigned BrachytherapyPatientGeometry::roi_z_padding;
+
+// Initialize the structure static members
+const unsigned BrachytherapyPatientGeometry::prostate_structure;
+const unsigned BrachytherapyPatientGeometry::urethra_structure;
+const unsigned BrachytherapyPatientGeometry::margin_structure;
+const unsigned BrachytherapyPatientGeometry::rectum_structure;
+const unsigned BrachytherapyPatientGeometry::max_number_of_structures;
+
+// Initialize the adjoint data cache mutex
+boost::mutex BrachytherapyPatientGeometry::adjoint_data_cache_mutex;
+
+// Constructor
+/*! \details the prescribed dose must be in units of cGy. The structure 
+ * weights override the default weights of any structure other than the 
+ * prostate. Structures that are not in the structure weight map and are not
+ * the urethra, rectum or margin have a weight of 1.0.
+ */ 
+BrachytherapyPatientGeometry::BrachytherapyPatientGeometry( 
+			  const std::string &patient_file_name,
+			  const double prescribed_dose,
+			  const double urethra_weight,
+			  const double rectum_weight,
+			  const double margin_weight,
+			  const StructureWeightMap &structure_weights )
+  : d_patient_file_name( patient_file_name ),
+    d_prescribed_dose( prescribed_dose ),
+    d_downsampling_factor( 1u ),
+    d_full_mesh_x_dim( 0u ),
+    d_full_mesh_y_dim( 0u ),
+    d_full_mesh_z_dim( 0u ),
+    d_roi_x_offset( 0u ),
+    d_roi_y_offset( 0u ),
+    d_roi_z_offset( 0u ),
+    d_mesh_x_dim( 0u ),
+    d_mesh_y_dim( 0u ),
+    d_mesh_z_dim( 0u ),
+    d_structure_names(),
+    d_structure_weights(),
+    d_structure_sizes(),
+    d_structure_masks(),
+    d_structure_labels(),
+    d_normal_relative_vol( 0u ),
+    d_needle_template()
+{
+  // Make sure the prescribed dose is valid
+  testPrecondition( prescribed_dose > 0.0 );
+  // Make sure that the organ weights are valid
+  testPrecondition( urethra_weight > 0.0 );
+  testPrecondition( rectum_weight > 0.0 );
+  testPrecondition( margin_weight > 0.0 );
+  
+  std::cout << std::endl << "creating patient..." << std::endl;
+
+  // Create the file handler for the patient
+  BrachytherapyPatientFileHandler patient_file( d_patient_file_name );
+
+  // Load in the full mesh dimensions
+  std::vector<unsigned> mesh_dimensions;
+  patient_file.getOrganMeshDimensions( mesh_dimensions );
+  
+  d_full_mesh_x_dim = mesh_dimensions[0];
+  d_full_mesh_y_dim = mesh_dimensions[1];
+  d_full_mesh_z_dim = mesh_dimensions[2];
+
+  mesh_dimensions.clear();
+
+  // Create the structure table (the first four structures are fixed)
+  d_structure_names.push_back( "prostate" );
+  d_structure_names.push_back( "urethra" );
+  d_structure_names.push_back( "margin" );
+  d_structure_names.push_back( "rectum" );
+
+  d_structure_weights.push_back( 1.0 );
+  d_structure_weights.push_back( urethra_weight );
+  d_structure_weights.push_back( margin_weight );
+  d_structure_weights.push_back( rectum_weight );
+
+  std::vector<std::string> organ_names;
+  patient_file.getOrganNames( organ_names );
+
+  for( unsigned i = 0; i < organ_names.size(); ++i )
+  {
+    if( std::find( d_structure_names.begin(),
+		   d_structure_names.end(),
+		   organ_names[i] ) == d_structure_names.end() )
+    {
+      d_structure_names.push_back( organ_names[i] );
+      d_structure_weights.push_back( 1.0 );
+    }
+  }
+
+  try
+  {
+    TEST_FOR_EXCEPTION( d_structure_names.size() > max_number_of_structures,
+			std::runtime_error,
+			"The patient file has more than " 
+			<< max_number_of_structures << " organ masks." );
+
+    StructureWeightMap::const_iterator weight = structure_weights.begin();
+
+    while( weight != structure_weights.end() )
+    {
+      unsigned structure = std::find( d_structure_names.begin(),
+				      d_structure_names.end(),
+				      weight->first ) - 
+	d_structure_names.begin();
+
+      TEST_FOR_EXCEPTION( structure == d_structure_names.size(),
+			  std::runtime_error,
+			  "The patient file has no " << weight->first
+			  << " mask." );
+
+      TEST_FOR_EXCEPTION( structure == prostate_structure,
+			  std::runtime_error,
+			  "The prostate is the target and cannot be "
+			  "weighted." );
+
+      TEST_FOR_EXCEPTION( weight->second <= 0.0,
+			  std::runtime_error,
+			  "The " << weight->first << " weight must be "
+			  "greater than 0.0." );
+
+      d_structure_weights[structure] = weight->second;
+
+      ++weight;
+    }
+  }
+  STD_EXCEPTION_CATCH_AND_EXIT();
+
+  // Load in the full organ masks and label the full mesh elements
+  std::vector<unsigned> full_structure_labels( 
+		    d_full_mesh_x_dim*d_full_mesh_y_dim*d_full_mesh_z_dim, 0u );
+
+  std::vector<bool> full_organ_mask;
+
+  for( unsigned s = 0; s < d_structure_names.size(); ++s )
+  {
+    patient_file.getOrganMask( full_organ_mask, d_structure_names[s] );
+
+    // Make sure that the mask is valid
+    testInvariant( full_organ_mask.size() == full_structure_labels.size() );
+
+    for( unsigned i = 0; i < full_organ_mask.size(); ++i )
+    {
+      if( full_organ_mask[i] )
+	full_structure_labels[i] |= getStructureLabelBit( s );
+    }
+  }
+
+  // Calculate the region of interest
+  calculateROI( full_structure_labels );
+
+  // Crop the structure labels to the region of interest
+  extractROIData( full_structure_labels, d_structure_labels );
+
+  // Create the structure masks and sizes
+  createStructureMasks();
+
+  try
+  {
+    for( unsigned s = 0; s < d_structure_names.size(); ++s )
+    {
+      TEST_FOR_EXCEPTION( d_structure_sizes[s] == 0u,
+			  std::runtime_error,
+			  "The " << d_structure_names[s] << " mask is "
+			  "empty." );
+    }
+  }
+  STD_EXCEPTION_CATCH_AND_EXIT();
+
+  // Set the normal tissue relative volume (normal tissue in the ROI only)
+  d_normal_relative_vol = d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim -
+    getProstateSize() - getUrethraSize() - getRectumSize();
+
+  // Load in the needle template and crop it to the region of interest
+  std::vector<bool> full_needle_template;
+  patient_file.getNeedleTemplate( full_needle_template );
+
+  d_needle_template.resize( d_mesh_x_dim*d_mesh_y_dim );
+  
+  for( unsigned j = 0; j < d_mesh_y_dim; ++j )
+  {
+    for( unsigned i = 0; i < d_mesh_x_dim; ++i )
+    {
+      d_needle_template[i+j*d_mesh_x_dim] = 
+	full_needle_template[i+d_roi_x_offset+
+			     (j+d_roi_y_offset)*d_full_mesh_x_dim];
+    }
+  }
+}
+
+// Constructor
+/*! \details The x and y dimensions of the ROI are divided by the 
+ * downsampling factor (rounded up) and the z dimension is kept. Coarse mesh
+ * element (i,j,k) samples the labels of fine mesh element (f*i,f*j,k), which
+ * is where a coarse seed position lies (see the BrachytherapySeedProxy 
+ * downsampling constructor). A structure that is too thin to be sampled is 
+ * given every coarse element whose fine elements overlap it. A needle 
+ * template position is kept if any fine position that it covers is on the 
+ * template. The downsampled ROI is also the full organ mesh.
+ */
+BrachytherapyPatientGeometry::BrachytherapyPatientGeometry(
+			  const BrachytherapyPatientGeometry &geometry,
+			  const unsigned downsampling_factor )
+  : d_patient_file_name( geometry.d_patient_file_name ),
+    d_prescribed_dose( geometry.d_prescribed_dose ),
+    d_downsampling_factor( geometry.d_downsampling_factor*
+			   downsampling_factor ),
+    d_full_mesh_x_dim( 0u ),
+    d_full_mesh_y_dim( 0u ),
+    d_full_mesh_z_dim( 0u ),
+    d_roi_x_offset( 0u ),
+    d_roi_y_offset( 0u ),
+    d_roi_z_offset( 0u ),
+    d_mesh_x_dim( 0u ),
+    d_mesh_y_dim( 0u ),
+    d_mesh_z_dim( geometry.d_mesh_z_dim ),
+    d_structure_names( geometry.d_structure_names ),
+    d_structure_weights( geometry.d_structure_weights ),
+    d_structure_sizes(),
+    d_structure_masks(),
+    d_structure_labels(),
+    d_normal_relative_vol( 0u ),
+    d_needle_template()
+{
+  // Make sure that the downsampling factor is valid
+  testPrecondition( downsampling_factor > 0u );
+
+  const unsigned fine_x_dim = geometry.d_mesh_x_dim;
+  const unsigned fine_y_dim = geometry.d_mesh_y_dim;
+
+  d_mesh_x_dim = (fine_x_dim + downsampling_factor - 1u)/downsampling_factor;
+  d_mesh_y_dim = (fine_y_dim + downsampling_factor - 1u)/downsampling_factor;
+
+  d_full_mesh_x_dim = d_mesh_x_dim;
+  d_full_mesh_y_dim = d_mesh_y_dim;
+  d_full_mesh_z_dim = d_mesh_z_dim;
+
+  // Sample the structure labels and collect the labels of each block of
+  // fine mesh elements
+  d_structure_labels.resize( d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim, 0u );
+
+  std::vector<unsigned> block_labels( d_structure_labels.size(), 0u );
+
+  unsigned sampled_label = 0u, block_label = 0u;
+
+  for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  {
+    for( unsigned j = 0; j < d_mesh_y_dim; ++j )
+    {
+      for( unsigned i = 0; i < d_mesh_x_dim; ++i )
+      {
+	unsigned index = i + j*d_mesh_x_dim + k*d_mesh_x_dim*d_mesh_y_dim;
+
+	for( unsigned fine_j = j*downsampling_factor; 
+	     fine_j < std::min( (j+1)*downsampling_factor, fine_y_dim );
+	     ++fine_j )
+	{
+	  for( unsigned fine_i = i*downsampling_factor; 
+	       fine_i < std::min( (i+1)*downsampling_factor, fine_x_dim );
+	       ++fine_i )
+	  {
+	    block_labels[index] |= geometry.d_structure_labels[
+			 fine_i + fine_j*fine_x_dim + k*fine_x_dim*fine_y_dim];
+	  }
+	}
+
+	d_structure_labels[index] = geometry.d_structure_labels[
+				 i*downsampling_factor + 
+				 j*downsampling_factor*fine_x_dim + 
+				 k*fine_x_dim*fine_y_dim];
+
+	sampled_label |= d_structure_labels[index];
+	block_label |= block_labels[index];
+      }
+    }
+  }
+
+  // Keep every block of the structures that have not been sampled
+  const unsigned missing_label = block_label & ~sampled_label;
+  
+  for( unsigned i = 0; i < d_structure_labels.size(); ++i )
+    d_structure_labels[i] |= block_labels[i] & missing_label;
+
+  // Create the structure masks and sizes
+  createStructureMasks();
+
+  // Set the normal tissue relative volume (normal tissue in the ROI only)
+  d_normal_relative_vol = d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim -
+    getProstateSize() - getUrethraSize() - getRectumSize();
+
+  // Downsample the needle template
+  d_needle_template.resize( d_mesh_x_dim*d_mesh_y_dim, false );
+
+  for( unsigned fine_j = 0; fine_j < fine_y_dim; ++fine_j )
+  {
+    for( unsigned fine_i = 0; fine_i < fine_x_dim; ++fine_i )
+    {
+      if( geometry.d_needle_template[fine_i + fine_j*fine_x_dim] )
+      {
+	d_needle_template[fine_i/downsampling_factor + 
+			  (fine_j/downsampling_factor)*d_mesh_x_dim] = true;
+      }
+    }
+  }
+}
+
+// Return the patient file name
+const std::string& BrachytherapyPatientGeometry::getPatientFileName() const
+{
+  return d_patient_file_name;
+}
+
+// Return the prescribed dose
+double BrachytherapyPatientGeometry::getPrescribedDose() const
+{
+  return d_prescribed_dose;
+}
+
+// Return the in-plane downsampling factor (1 if not downsampled)
+unsigned BrachytherapyPatientGeometry::getDownsamplingFactor() const
+{
+  return d_downsampling_factor;
+}
+
+// Return the organ mesh (ROI) x dimension
+unsigned BrachytherapyPatientGeometry::getOrganMeshXDim() const
+{
+  return d_mesh_x_dim;
+}
+
+// Return the organ mesh (ROI) y dimension
+unsigned BrachytherapyPatientGeometry::getOrganMeshYDim() const
+{
+  return d_mesh_y_dim;
+}
+
+// Return the organ mesh (ROI) z dimension
+unsigned BrachytherapyPatientGeometry::getOrganMeshZDim() const
+{
+  return d_mesh_z_dim;
+}
+
+// Return the full organ mesh x dimension
+unsigned BrachytherapyPatientGeometry::getFullOrganMeshXDim() const
+{
+  return d_full_mesh_x_dim;
+}
+
+// Return the full organ mesh y dimension
+unsigned BrachytherapyPatientGeometry::getFullOrganMeshYDim() const
+{
+  return d_full_mesh_y_dim;
+}
+
+// Return the full organ mesh z dimension
+unsigned BrachytherapyPatientGeometry::getFullOrganMeshZDim() const
+{
+  return d_full_mesh_z_dim;
+}
+
+// Return the x index of the ROI origin in the full organ mesh
+unsigned BrachytherapyPatientGeometry::getROIXOffset() const
+{
+  return d_roi_x_offset;
+}
+
+// Return the y index of the ROI origin in the full organ mesh
+unsigned BrachytherapyPatientGeometry::getROIYOffset() const
+{
+  return d_roi_y_offset;
+}
+
+// Return the z index of the ROI origin in the full organ mesh
+unsigned BrachytherapyPatientGeometry::getROIZOffset() const
+{
+  return d_roi_z_offset;
+}
+
+// Return the number of structures
+unsigned BrachytherapyPatientGeometry::getNumberOfStructures() const
+{
+  return d_structure_names.size();
+}
+
+// Return the name of a structure
+const std::string& BrachytherapyPatientGeometry::getStructureName( 
+					       const unsigned structure ) const
+{
+  // Make sure that the structure is valid
+  testPrecondition( structure < d_structure_names.size() );
+  
+  return d_structure_names[structure];
+}
+
+// Return the weight of a structure relative to the prostate
+double BrachytherapyPatientGeometry::getStructureWeight( 
+					       const unsigned structure ) const
+{
+  // Make sure that the structure is valid
+  testPrecondition( structure < d_structure_weights.size() );
+
+  return d_structure_weights[structure];
+}
+
+// Return the size of a structure (num structure elements)
+unsigned BrachytherapyPatientGeometry::getStructureSize( 
+					       const unsigned structure ) const
+{
+  // Make sure that the structure is valid
+  testPrecondition( structure < d_structure_sizes.size() );
+
+  return d_structure_sizes[structure];
+}
+
+// Return the volume of a structure (cm^3)
+double BrachytherapyPatientGeometry::getStructureVolume( 
+					       const unsigned structure ) const
+{
+  return getStructureSize( structure )*0.1*0.1*0.5*
+    d_downsampling_factor*d_downsampling_factor;
+}
+
+// Return the mask of a structure
+const std::vector<bool>& BrachytherapyPatientGeometry::getStructureMask( 
+					       const unsigned structure ) const
+{
+  // Make sure that the structure is valid
+  testPrecondition( structure < d_structure_masks.size() );
+
+  return d_structure_masks[structure];
+}
+
+// Return the structure labels (bit s is set for elements of structure s)
+const std::vector<unsigned>& 
+BrachytherapyPatientGeometry::getStructureLabels() const
+{
+  return d_structure_labels;
+}
+
+// Return the prostate volume (cm^3)
+double BrachytherapyPatientGeometry::getProstateVolume() const
+{
+  return getStructureVolume( prostate_structure );
+}
+
+// Return the urethra volume (cm^3)
+double BrachytherapyPatientGeometry::getUrethraVolume() const
+{
+  return getStructureVolume( urethra_structure );
+}
+
+// Return the rectum volume (cm^3)
+double BrachytherapyPatientGeometry::getRectumVolume() const
+{
+  return getStructureVolume( rectum_structure );
+}
+
+// Return the normal volume (cm^3)
+double BrachytherapyPatientGeometry::getNormalVolume() const
+{
+  return d_normal_relative_vol*0.1*0.1*0.5*
+    d_downsampling_factor*d_downsampling_factor;
+}
+
+// Return the prostate size (num prostate elements)
+unsigned BrachytherapyPatientGeometry::getProstateSize() const
+{
+  return getStructureSize( prostate_structure );
+}
+
+// Return the urethra size (num urethra elements)
+unsigned BrachytherapyPatientGeometry::getUrethraSize() const
+{
+  return getStructureSize( urethra_structure );
+}
+
+// Return the rectum size (num rectum elements)
+unsigned BrachytherapyPatientGeometry::getRectumSize() const
+{
+  return getStructureSize( rectum_structure );
+}
+
+// Return the normal size (num normal elements)
+unsigned BrachytherapyPatientGeometry::getNormalSize() const
+{
+  return d_normal_relative_vol;
+}
+
+// Return the weight of the urethra relative to the prostate
+double BrachytherapyPatientGeometry::getUrethraWeight() const
+{
+  return getStructureWeight( urethra_structure );
+}
+
+// Return the weight of the rectum relative to the prostate
+double BrachytherapyPatientGeometry::getRectumWeight() const
+{
+  return getStructureWeight( rectum_structure );
+}
+
+// Return the weight of the margin relative to the prostate
+double BrachytherapyPatientGeometry::getMarginWeight() const
+{
+  return getStructureWeight( margin_structure );
+}
+
+// Return the prostate mask
+const std::vector<bool>& BrachytherapyPatientGeometry::getProstateMask() const
+{
+  return getStructureMask( prostate_structure );
+}
+
+// Return the urethra mask
+const std::vector<bool>& BrachytherapyPatientGeometry::getUrethraMask() const
+{
+  return getStructureMask( urethra_structure );
+}
+
+// Return the margin mask
+const std::vector<bool>& BrachytherapyPatientGeometry::getMarginMask() const
+{
+  return getStructureMask( margin_structure );
+}
+
+// Return the rectum mask
+const std::vector<bool>& BrachytherapyPatientGeometry::getRectumMask() const
+{
+  return getStructureMask( rectum_structure );
+}
+
+// Return the needle template
+const std::vector<bool>& 
+BrachytherapyPatientGeometry::getNeedleTemplate() const
+{
+  return d_needle_template;
+}
+
+// Return the tissue type at a mesh point
+TissueType BrachytherapyPatientGeometry::getTissueType( 
+					    const unsigned x_mesh_index,
+					    const unsigned y_mesh_index,
+					    const unsigned z_mesh_index ) const
+{
+  // Make sure that the indices are valid
+  testPrecondition( x_mesh_index < d_mesh_x_dim );
+  testPrecondition( y_mesh_index < d_mesh_y_dim );
+  testPrecondition( z_mesh_index < d_mesh_z_dim );
+
+  unsigned index = x_mesh_index + y_mesh_index*d_mesh_x_dim +
+    z_mesh_index*d_mesh_x_dim*d_mesh_y_dim;
+  
+  unsigned label = d_structure_labels[index];
+  
+  if( label & getStructureLabelBit( prostate_structure ) )
+    return PROSTATE_TISSUE;
+  else if( label & getStructureLabelBit( urethra_structure ) )
+    return URETHRA_TISSUE;
+  else if( label & getStructureLabelBit( rectum_structure ) )
+    return RECTUM_TISSUE;
+  else if( label & getStructureLabelBit( margin_structure ) )
+    return MARGIN_TISSUE;
+  else
+    return NORMAL_TISSUE;
+}
+
+// Return the structure adjoint data for a seed (load from cache or generate)
+/*! \details If the adjoint data of every structure for the seed has not been
+ * cached in the patient file it will be generated (for all structures in a 
+ * single pass) and the missing structure adjoint data will be cached. The 
+ * cached adjoint data always covers the full organ mesh while the returned 
+ * adjoint data only covers the ROI. The adjoint data is ordered by structure.
+ * The cache is written to the patient file, so the whole lookup is 
+ * serialized (over all geometries, which may share a patient file). A seed
+ * that is requested by several threads is only generated once. The adjoint
+ * data of a downsampled geometry is cached under the seed name with a 
+ * downsampling suffix (its full organ mesh is the downsampled ROI).
+ */
+void BrachytherapyPatientGeometry::getAdjointData( 
+	   const boost::shared_ptr<BrachytherapySeedProxy> &seed,
+	   std::vector<std::vector<double> > &structure_adjoint_data ) const
+{
+  boost::mutex::scoped_lock lock( adjoint_data_cache_mutex );
+  
+  // Create the file handler for the patient
+  BrachytherapyPatientFileHandler patient_file( d_patient_file_name );
+
+  // The adjoint data of a downsampled geometry is cached separately
+  std::string seed_name = seed->getSeedName();
+
+  if( d_downsampling_factor > 1u )
+  {
+    std::ostringstream oss;
+    oss << seed_name << "_downsampled_" << d_downsampling_factor;
+    seed_name = oss.str();
+  }
+  
+  // Determine which structures have cached adjoint data
+  std::vector<bool> cached_structures( d_structure_names.size() );
+
+  for( unsigned s = 0; s < d_structure_names.size(); ++s )
+  {
+    cached_structures[s] = 
+      patient_file.adjointDataExists( seed_name, d_structure_names[s] );
+  }
+  
+  std::vector<double> full_mesh_adjoint_data;
+
+  structure_adjoint_data.resize( d_structure_names.size() );
+  
+  // Load the adjoint data for the desired seed if it has been cached  
+  if( std::find( cached_structures.begin(), 
+		 cached_structures.end(), 
+		 false ) == cached_structures.end() )
+  {
+    for( unsigned s = 0; s < d_structure_names.size(); ++s )
+    {
+      patient_file.getOrganAdjointData( full_mesh_adjoint_data,
+					d_structure_names[s],
+					seed_name,
+					seed->getSeedStrength() );
+      extractROIData( full_mesh_adjoint_data, structure_adjoint_data[s] );
+    }
+  }
+  
+  // Genenerate the adjoint data if it is not in the cache
+  else
+  {
+    BrachytherapyAdjointDataGenerator adjoint_gen( seed );
+    
+    std::cout << "generating structure adjoint data for "
+	      << seed_name << "..." << std::endl;
+    adjoint_gen.calculateCondensedAdjointDose( structure_adjoint_data,
+					       d_structure_labels,
+					       d_structure_sizes,
+					       getProstateMask(),
+					       d_mesh_x_dim,
+					       d_mesh_y_dim,
+					       d_mesh_z_dim );
+    
+    // Cache the missing adjoint data
+    for( unsigned s = 0; s < d_structure_names.size(); ++s )
+    {
+      if( !cached_structures[s] )
+      {
+	expandROIData( structure_adjoint_data[s], full_mesh_adjoint_data, 0.0 );
+	patient_file.setOrganAdjointData( full_mesh_adjoint_data,
+					  d_structure_names[s],
+					  seed_name,
+					  seed->getSeedStrength() );
+      }
+    }
+  }
+}
+
+// Return the weight of a seed position at a mesh element
+/*! \details The weight is the weighted sum of the organ at risk adjoint data
+ * relative to the prostate adjoint data. The mesh element must be in the 
+ * prostate.
+ */
+double BrachytherapyPatientGeometry::calculateSeedPositionWeight( 
+	   const std::vector<std::vector<double> > &structure_adjoint_data,
+	   const unsigned mesh_index ) const
+{
+  // Make sure that the adjoint data is valid
+  testPrecondition( structure_adjoint_data.size() == 
+		    d_structure_names.size() );
+  // Make sure that the mesh element is in the prostate
+  testPrecondition( getProstateMask()[mesh_index] );
+
+  double weight = 0.0;
+
+  for( unsigned s = 0; s < d_structure_names.size(); ++s )
+  {
+    if( s != prostate_structure )
+      weight += d_structure_weights[s]*structure_adjoint_data[s][mesh_index];
+  }
+
+  return weight/structure_adjoint_data[prostate_structure][mesh_index];
+}
+
+// Create the structure masks and sizes in a single pass over the labels
+void BrachytherapyPatientGeometry::createStructureMasks()
+{
+  d_structure_sizes.assign( d_structure_names.size(), 0u );
+  d_structure_masks.assign( d_structure_names.size(),
+			    std::vector<bool>( d_structure_labels.size(), 
+					       false ) );
+
+  for( unsigned i = 0; i < d_structure_labels.size(); ++i )
+  {
+    for( unsigned label = d_structure_labels[i], s = 0; label != 0u; 
+	 label >>= 1, ++s )
+    {
+      if( label & 1u )
+      {
+	d_structure_masks[s][i] = true;
+	++d_structure_sizes[s];
+      }
+    }
+  }
+}
+
+// Calculate the ROI (bounding box of the structures plus padding)
+void BrachytherapyPatientGeometry::calculateROI( 
+			   const std::vector<unsigned> &full_structure_labels )
+{
+  // Make sure that the labels are valid
+  testPrecondition( full_structure_labels.size() == 
+		    d_full_mesh_x_dim*d_full_mesh_y_dim*d_full_mesh_z_dim );
+  
+  // Find the bounding box of the structures (half-open)
+  unsigned x_start = d_full_mesh_x_dim, x_end = 0u;
+  unsigned y_start = d_full_mesh_y_dim, y_end = 0u;
+  unsigned z_start = d_full_mesh_z_dim, z_end = 0u;
+  
+  for( unsigned k = 0; k < d_full_mesh_z_dim; ++k )
+  {
+    for( unsigned j = 0; j < d_full_mesh_y_dim; ++j )
+    {
+      for( unsigned i = 0; i < d_full_mesh_x_dim; ++i )
+      {
+	unsigned index = i + j*d_full_mesh_x_dim + 
+	  k*d_full_mesh_x_dim*d_full_mesh_y_dim;
+
+	if( full_structure_labels[index] != 0u )
+	{
+	  x_start = std::min( x_start, i );
+	  x_end = std::max( x_end, i+1 );
+	  y_start = std::min( y_start, j );
+	  y_end = std::max( y_end, j+1 );
+	  z_start = std::min( z_start, k );
+	  z_end = std::max( z_end, k+1 );
+	}
+      }
+    }
+  }
+
+  // Use the full mesh if there are no organs
+  if( x_start >= x_end )
+  {
+    x_start = 0u;
+    x_end = d_full_mesh_x_dim;
+    y_start = 0u;
+    y_end = d_full_mesh_y_dim;
+    z_start = 0u;
+    z_end = d_full_mesh_z_dim;
+  }
+
+  // Pad the bounding box and clip it to the full mesh
+  x_start = (x_start > roi_xy_padding ? x_start - roi_xy_padding : 0u);
+  y_start = (y_start > roi_xy_padding ? y_start - roi_xy_padding : 0u);
+  z_start = (z_start > roi_z_padding ? z_start - roi_z_padding : 0u);
+
+  x_end = std::min( x_end + roi_xy_padding, d_full_mesh_x_dim );
+  y_end = std::min( y_end + roi_xy_padding, d_full_mesh_y_dim );
+  z_end = std::min( z_end + roi_z_padding, d_full_mesh_z_dim );
+
+  d_roi_x_offset = x_start;
+  d_roi_y_offset = y_start;
+  d_roi_z_offset = z_start;
+
+  d_mesh_x_dim = x_end - x_start;
+  d_mesh_y_dim = y_end - y_start;
+  d_mesh_z_dim = z_end - z_start;
+}
+
+// Return the structure label bit of a structure
+unsigned BrachytherapyPatientGeometry::getStructureLabelBit( 
+						     const unsigned structure )
+{
+  // Make sure that the structure is valid
+  testPrecondition( structure < max_number_of_structures );
+  
+  return 1u << structure;
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPatientGeometry.cpp
+//---------------------------------------------------------------------------//
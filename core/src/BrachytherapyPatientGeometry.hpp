@@ -0,0 +1,306 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPatientGeometry.hpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPatientGeometry class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_PATIENT_GEOMETRY_HPP
+#define BRACHYTHERAPY_PATIENT_GEOMETRY_HPP
+
+// Std Lib Includes
+#include <string>
+#include <vector>
+#include <map>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+// TPOR Includes
+#include "TissueType.hpp"
+#include "BrachytherapySeedProxy.hpp"
+
+namespace TPOR{
+
+/*! Brachytherapy patient geometry class
+ *
+ * The patient geometry stores the read-only patient data (organ masks, 
+ * needle template, mesh dimensions, organ weights and prescribed dose). It 
+ * is loaded once and can be shared (as a const object) by any number of 
+ * treatment plan states (BrachytherapyPatient) and threads. The adjoint data
+ * cache in the patient file is the only data that is written after the 
+ * geometry is loaded - all access to it is serialized by a mutex.
+ *
+ * Only the region of interest (ROI) of the organ mesh is stored. The ROI is
+ * the bounding box of all organs (prostate, urethra, margin and rectum),
+ * padded on every side and clipped to the organ mesh. All mesh indices and
+ * mesh data used by the geometry, the patient and the planners are relative
+ * to the ROI. Normal tissue outside of the ROI is excluded from the plan 
+ * (it is neither dosed nor counted in the normal tissue volume).
+ *
+ * The organs are stored in a structure table that is loaded from the 
+ * organ_masks group of the patient file. The prostate (the target), urethra,
+ * margin and rectum are always the first four structures. Any other organ 
+ * masks in the file (e.g. bladder, neurovascular bundles) are appended as 
+ * additional organs at risk. Every ROI mesh element stores a structure label
+ * with one bit per structure so that the adjoint data, seed position weights
+ * and plan metrics can be calculated in a single pass over the mesh.
+ *
+ * A geometry can also be downsampled in-plane (x and y) for coarse 
+ * planning. The adjoint data of a downsampled geometry is cached separately
+ * from the adjoint data of the full mesh.
+ */
+class BrachytherapyPatientGeometry
+{
+
+public:
+  
+  //! Structure weight map (structure name, weight relative to the prostate)
+  typedef std::map<std::string,double> StructureWeightMap;
+
+  //! Constructor
+  BrachytherapyPatientGeometry( 
+	   const std::string &patient_file_name,
+	   const double prescribed_dose,
+	   const double urethra_weight = 1.0,
+	   const double rectum_weight = 1.0,
+	   const double margin_weight = 1.0,
+	   const StructureWeightMap &structure_weights = StructureWeightMap() );
+
+  //! Constructor (downsampled in-plane copy of a geometry)
+  BrachytherapyPatientGeometry( const BrachytherapyPatientGeometry &geometry,
+				const unsigned downsampling_factor );
+
+  //! Destructor
+  ~BrachytherapyPatientGeometry()
+  { /* ... */ }
+
+  //! Return the patient file name
+  const std::string& getPatientFileName() const;
+
+  //! Return the prescribed dose
+  double getPrescribedDose() const;
+
+  //! Return the in-plane downsampling factor (1 if not downsampled)
+  unsigned getDownsamplingFactor() const;
+  
+  //! Return the organ mesh (ROI) x dimension
+  unsigned getOrganMeshXDim() const;
+  
+  //! Return the organ mesh (ROI) y dimension
+  unsigned getOrganMeshYDim() const;
+  
+  //! Return the organ mesh (ROI) z dimension
+  unsigned getOrganMeshZDim() const;
+
+  //! Return the full organ mesh x dimension
+  unsigned getFullOrganMeshXDim() const;
+
+  //! Return the full organ mesh y dimension
+  unsigned getFullOrganMeshYDim() const;
+
+  //! Return the full organ mesh z dimension
+  unsigned getFullOrganMeshZDim() const;
+
+  //! Return the x index of the ROI origin in the full organ mesh
+  unsigned getROIXOffset() const;
+
+  //! Return the y index of the ROI origin in the full organ mesh
+  unsigned getROIYOffset() const;
+
+  //! Return the z index of the ROI origin in the full organ mesh
+  unsigned getROIZOffset() const;
+
+  //! Extract the ROI data from full organ mesh data
+  template<typename T>
+  void extractROIData( const std::vector<T> &full_mesh_data,
+		       std::vector<T> &roi_data ) const;
+
+  //! Expand ROI data to full organ mesh data
+  template<typename T>
+  void expandROIData( const std::vector<T> &roi_data,
+		      std::vector<T> &full_mesh_data,
+		      const T &outside_value ) const;
+
+  //! Return the number of structures
+  unsigned getNumberOfStructures() const;
+
+  //! Return the name of a structure
+  const std::string& getStructureName( const unsigned structure ) const;
+
+  //! Return the weight of a structure relative to the prostate
+  double getStructureWeight( const unsigned structure ) const;
+
+  //! Return the size of a structure (num structure elements)
+  unsigned getStructureSize( const unsigned structure ) const;
+
+  //! Return the volume of a structure (cm^3)
+  double getStructureVolume( const unsigned structure ) const;
+
+  //! Return the mask of a structure
+  const std::vector<bool>& getStructureMask( const unsigned structure ) const;
+
+  //! Return the structure labels (bit s is set for elements of structure s)
+  const std::vector<unsigned>& getStructureLabels() const;
+
+  //! Return the prostate volume (cm^3)
+  double getProstateVolume() const;
+
+  //! Return the urethra volume (cm^3)
+  double getUrethraVolume() const;
+
+  //! Return the rectum volume (cm^3)
+  double getRectumVolume() const;
+
+  //! Return the normal volume (cm^3)
+  double getNormalVolume() const;
+
+  //! Return the prostate size (num prostate elements)
+  unsigned getProstateSize() const;
+
+  //! Return the urethra size (num urethra elements)
+  unsigned getUrethraSize() const;
+
+  //! Return the rectum size (num rectum elements)
+  unsigned getRectumSize() const;
+
+  //! Return the normal size (num normal elements)
+  unsigned getNormalSize() const;
+
+  //! Return the weight of the urethra relative to the prostate
+  double getUrethraWeight() const;
+
+  //! Return the weight of the rectum relative to the prostate
+  double getRectumWeight() const;
+
+  //! Return the weight of the margin relative to the prostate
+  double getMarginWeight() const;
+
+  //! Return the prostate mask
+  const std::vector<bool>& getProstateMask() const;
+
+  //! Return the urethra mask
+  const std::vector<bool>& getUrethraMask() const;
+
+  //! Return the margin mask
+  const std::vector<bool>& getMarginMask() const;
+
+  //! Return the rectum mask
+  const std::vector<bool>& getRectumMask() const;
+
+  //! Return the needle template
+  const std::vector<bool>& getNeedleTemplate() const;
+
+  //! Return the tissue type at a mesh point
+  TissueType getTissueType( const unsigned x_mesh_index,
+			    const unsigned y_mesh_index,
+			    const unsigned z_mesh_index ) const;
+
+  //! Return the structure adjoint data for a seed (load from cache or generate)
+  void getAdjointData( 
+	  const boost::shared_ptr<BrachytherapySeedProxy> &seed,
+	  std::vector<std::vector<double> > &structure_adjoint_data ) const;
+
+  //! Return the weight of a seed position at a mesh element
+  double calculateSeedPositionWeight( 
+	  const std::vector<std::vector<double> > &structure_adjoint_data,
+	  const unsigned mesh_index ) const;
+
+  //! The prostate (target) structure index
+  static const unsigned prostate_structure = 0u;
+
+  //! The urethra structure index
+  static const unsigned urethra_structure = 1u;
+
+  //! The margin structure index
+  static const unsigned margin_structure = 2u;
+
+  //! The rectum structure index
+  static const unsigned rectum_structure = 3u;
+
+  //! The maximum number of structures (one structure label bit each)
+  static const unsigned max_number_of_structures = 32u;
+
+  //! The ROI padding in the x and y directions (mesh elements)
+  static const unsigned roi_xy_padding = 10u;
+
+  //! The ROI padding in the z direction (mesh elements)
+  static const unsigned roi_z_padding = 2u;
+
+private:
+
+  // Create the structure masks and sizes from the structure labels
+  void createStructureMasks();
+
+  // Calculate the ROI (bounding box of the structures plus padding)
+  void calculateROI( const std::vector<unsigned> &full_structure_labels );
+
+  // Return the structure label bit of a structure
+  static unsigned getStructureLabelBit( const unsigned structure );
+
+  // The mutex that serializes the access to the adjoint data caches
+  static boost::mutex adjoint_data_cache_mutex;
+
+  // The patient file name
+  std::string d_patient_file_name;
+
+  // Prescribed dose
+  double d_prescribed_dose;
+
+  // In-plane downsampling factor of the organ mesh
+  unsigned d_downsampling_factor;
+
+  // Full organ mesh dimensions
+  unsigned d_full_mesh_x_dim;
+  unsigned d_full_mesh_y_dim;
+  unsigned d_full_mesh_z_dim;
+
+  // ROI origin in the full organ mesh
+  unsigned d_roi_x_offset;
+  unsigned d_roi_y_offset;
+  unsigned d_roi_z_offset;
+  
+  // ROI mesh dimensions  
+  unsigned d_mesh_x_dim;
+  unsigned d_mesh_y_dim;
+  unsigned d_mesh_z_dim;
+
+  // Structure names (the structure table)
+  std::vector<std::string> d_structure_names;
+
+  // Structure weights relative to the prostate
+  std::vector<double> d_structure_weights;
+
+  // Structure sizes (number of mesh elements)
+  std::vector<unsigned> d_structure_sizes;
+
+  // Structure masks
+  std::vector<std::vector<bool> > d_structure_masks;
+
+  // Structure labels (bit s is set for the elements of structure s)
+  std::vector<unsigned> d_structure_labels;
+
+  // Normal volume (number of mesh elements in the ROI)
+  unsigned d_normal_relative_vol;
+
+  // Needle template
+  std::vector<bool> d_needle_template;
+};
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// Template includes.
+//---------------------------------------------------------------------------//
+
+#include "BrachytherapyPatientGeometry_def.hpp"
+
+//---------------------------------------------------------------------------//
+
+#endif // end BRACHYTHERAPY_PATIENT_GEOMETRY_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPatientGeometry.hpp
+//---------------------------------------------------------------------------//
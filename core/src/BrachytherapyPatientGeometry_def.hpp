@@ -0,0 +1,82 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPatientGeometry_def.hpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPatientGeometry class template definitions.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_PATIENT_GEOMETRY_DEF_HPP
+#define BRACHYTHERAPY_PATIENT_GEOMETRY_DEF_HPP
+
+// TPOR Includes
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Extract the ROI data from full organ mesh data
+template<typename T>
+void BrachytherapyPatientGeometry::extractROIData( 
+				       const std::vector<T> &full_mesh_data,
+				       std::vector<T> &roi_data ) const
+{
+  // Make sure that the full mesh data is valid
+  testPrecondition( full_mesh_data.size() == 
+		    d_full_mesh_x_dim*d_full_mesh_y_dim*d_full_mesh_z_dim );
+  
+  roi_data.resize( d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim );
+
+  for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  {
+    for( unsigned j = 0; j < d_mesh_y_dim; ++j )
+    {
+      unsigned full_index = d_roi_x_offset + 
+	(j+d_roi_y_offset)*d_full_mesh_x_dim +
+	(k+d_roi_z_offset)*d_full_mesh_x_dim*d_full_mesh_y_dim;
+      
+      unsigned roi_index = j*d_mesh_x_dim + k*d_mesh_x_dim*d_mesh_y_dim;
+
+      for( unsigned i = 0; i < d_mesh_x_dim; ++i )
+	roi_data[roi_index+i] = full_mesh_data[full_index+i];
+    }
+  }
+}
+
+// Expand ROI data to full organ mesh data
+template<typename T>
+void BrachytherapyPatientGeometry::expandROIData( 
+					    const std::vector<T> &roi_data,
+					    std::vector<T> &full_mesh_data,
+					    const T &outside_value ) const
+{
+  // Make sure that the ROI data is valid
+  testPrecondition( roi_data.size() == 
+		    d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim );
+
+  full_mesh_data.assign( 
+		  d_full_mesh_x_dim*d_full_mesh_y_dim*d_full_mesh_z_dim,
+		  outside_value );
+
+  for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  {
+    for( unsigned j = 0; j < d_mesh_y_dim; ++j )
+    {
+      unsigned full_index = d_roi_x_offset + 
+	(j+d_roi_y_offset)*d_full_mesh_x_dim +
+	(k+d_roi_z_offset)*d_full_mesh_x_dim*d_full_mesh_y_dim;
+      
+      unsigned roi_index = j*d_mesh_x_dim + k*d_mesh_x_dim*d_mesh_y_dim;
+
+      for( unsigned i = 0; i < d_mesh_x_dim; ++i )
+	full_mesh_data[full_index+i] = roi_data[roi_index+i];
+    }
+  }
+}
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_PATIENT_GEOMETRY_DEF_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPatientGeometry_def.hpp
+//---------------------------------------------------------------------------//
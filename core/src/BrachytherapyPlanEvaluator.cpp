@@ -0,0 +1,218 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPlanEvaluator.cpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy treatment plan evaluator class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+
+// Boost Includes
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPlanEvaluator.hpp"
+#include "DoseVolumeHelpers.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Constructor
+BrachytherapyPlanEvaluator::BrachytherapyPlanEvaluator( 
+    const boost::shared_ptr<const BrachytherapyPatientGeometry> &geometry )
+  : d_geometry( geometry )
+{
+  // Make sure that the patient geometry is valid
+  testPrecondition( geometry );
+}
+
+// Evaluate a treatment plan
+void BrachytherapyPlanEvaluator::evaluatePlan( 
+		  const std::list<BrachytherapySeedPosition> &treatment_plan,
+		  BrachytherapyPlanMetrics &metrics ) const
+{
+  EvaluationScratch scratch;
+
+  evaluatePlan( treatment_plan, scratch, metrics );
+}
+
+// Evaluate a batch of treatment plans in parallel
+/*! \details If the number of threads is zero, the number of hardware 
+ * threads will be used. The metrics of plan i are stored in metrics[i] and
+ * do not depend on the number of threads used.
+ */
+void BrachytherapyPlanEvaluator::evaluatePlans( 
+	     const std::vector<std::list<BrachytherapySeedPosition> > &plans,
+	     std::vector<BrachytherapyPlanMetrics> &metrics,
+	     const unsigned number_of_threads ) const
+{
+  metrics.resize( plans.size() );
+
+  unsigned threads = number_of_threads;
+
+  if( threads == 0 )
+    threads = std::max( boost::thread::hardware_concurrency(), 1u );
+
+  threads = std::min( threads, (unsigned)plans.size() );
+
+  if( threads <= 1 )
+  {
+    evaluatePlanStride( plans, metrics, 0u, 1u );
+  }
+  else
+  {
+    boost::thread_group thread_group;
+    
+    for( unsigned i = 0; i < threads; ++i )
+    {
+      thread_group.create_thread( 
+			boost::bind( &BrachytherapyPlanEvaluator::evaluatePlanStride,
+				     this,
+				     boost::cref( plans ),
+				     boost::ref( metrics ),
+				     i,
+				     threads ) );
+    }
+
+    thread_group.join_all();
+  }
+}
+
+// Evaluate a patient dose distribution (cGy)
+void BrachytherapyPlanEvaluator::evaluateDoseDistribution( 
+			       const std::vector<double> &dose_distribution,
+			       BrachytherapyPlanMetrics &metrics ) const
+{
+  EvaluationScratch scratch;
+
+  evaluateDoseDistribution( dose_distribution, scratch, metrics );
+}
+
+// Evaluate a treatment plan using scratch buffers
+void BrachytherapyPlanEvaluator::evaluatePlan( 
+		  const std::list<BrachytherapySeedPosition> &treatment_plan,
+		  EvaluationScratch &scratch,
+		  BrachytherapyPlanMetrics &metrics ) const
+{
+  unsigned mesh_x_dim = d_geometry->getOrganMeshXDim();
+  unsigned mesh_y_dim = d_geometry->getOrganMeshYDim();
+  unsigned mesh_z_dim = d_geometry->getOrganMeshZDim();
+
+  scratch.dose_distribution.resize( mesh_x_dim*mesh_y_dim*mesh_z_dim );
+  
+  std::fill( scratch.dose_distribution.begin(), 
+	     scratch.dose_distribution.end(),
+	     0.0 );
+
+  std::list<BrachytherapySeedPosition>::const_iterator position, 
+    end_position;
+  position = treatment_plan.begin();
+  end_position = treatment_plan.end();
+
+  while( position != end_position )
+  {
+    position->mapSeedDoseDistribution<PlusEqual>( scratch.dose_distribution,
+						  mesh_x_dim,
+						  mesh_y_dim,
+						  mesh_z_dim );
+
+    ++position;
+  }
+
+  evaluateDoseDistribution( scratch.dose_distribution, scratch, metrics );
+}
+  
+// Evaluate a patient dose distribution using scratch buffers
+void BrachytherapyPlanEvaluator::evaluateDoseDistribution( 
+			       const std::vector<double> &dose_distribution,
+			       EvaluationScratch &scratch,
+			       BrachytherapyPlanMetrics &metrics ) const
+{
+  // Make sure that the dose distribution is valid
+  testPrecondition( dose_distribution.size() == 
+		    d_geometry->getProstateMask().size() );
+  
+  double prescribed_dose = d_geometry->getPrescribedDose();
+
+  // Extract the sorted doses of every structure in a single pass
+  extractSortedStructureDoses( dose_distribution,
+			       d_geometry->getStructureLabels(),
+			       d_geometry->getNumberOfStructures(),
+			       scratch.structure_doses );
+
+  const std::vector<double>& prostate_doses = 
+    scratch.structure_doses[BrachytherapyPatientGeometry::prostate_structure];
+  
+  // Prostate metrics
+  metrics.prostate_v100 = 
+    calculateSortedOrganDoseCoverage( prostate_doses, prescribed_dose );
+
+  metrics.prostate_d90 = calculateDoseCoveringOrgan( prostate_doses, 0.9 );
+  metrics.prostate_d100 = calculateDoseCoveringOrgan( prostate_doses, 1.0 );
+
+  double v150 = calculateSortedOrganDoseCoverage( prostate_doses,
+						  1.5*prescribed_dose );
+
+  metrics.dnr = v150/metrics.prostate_v100;
+
+  unsigned number_elements_covered = 
+    calculateNumElementsCovered( dose_distribution, prescribed_dose );
+
+  metrics.cn = metrics.prostate_v100*metrics.prostate_v100*
+    d_geometry->getProstateSize()/number_elements_covered;
+
+  // Urethra metrics
+  const std::vector<double>& urethra_doses = 
+    scratch.structure_doses[BrachytherapyPatientGeometry::urethra_structure];
+  
+  metrics.urethra_d10 = calculateDoseCoveringOrgan( urethra_doses, 0.1 );
+  metrics.urethra_d90 = calculateDoseCoveringOrgan( urethra_doses, 0.9 );
+
+  // Rectum metrics
+  const std::vector<double>& rectum_doses = 
+    scratch.structure_doses[BrachytherapyPatientGeometry::rectum_structure];
+  
+  metrics.rectum_d10 = calculateDoseCoveringOrgan( rectum_doses, 0.1 );
+  metrics.rectum_d90 = calculateDoseCoveringOrgan( rectum_doses, 0.9 );
+}
+
+// Evaluate every n-th plan of a batch, starting from the first plan
+void BrachytherapyPlanEvaluator::evaluatePlanStride( 
+	     const std::vector<std::list<BrachytherapySeedPosition> > &plans,
+	     std::vector<BrachytherapyPlanMetrics> &metrics,
+	     const unsigned first_plan,
+	     const unsigned stride ) const
+{
+  // Each thread uses its own scratch buffers
+  EvaluationScratch scratch;
+
+  for( unsigned i = first_plan; i < plans.size(); i += stride )
+    evaluatePlan( plans[i], scratch, metrics[i] );
+}
+
+// Print the treatment plan metrics summary
+void printBrachytherapyPlanMetrics( std::ostream &os,
+				    const BrachytherapyPlanMetrics &metrics )
+{
+  os << "Prostate Details" << std::endl;
+  os << "  D100 (Gy):                " << metrics.prostate_d100 << std::endl;
+  os << "  V100:                     " << metrics.prostate_v100 << std::endl;
+  os << "  DNR:                      " << metrics.dnr << std::endl;
+  os << "  CN:                       " << metrics.cn << std::endl;
+  os << "Urethra Details" << std::endl;
+  os << "  D90 (Gy):                 " << metrics.urethra_d90 << std::endl;
+  os << "  D10 (Gy):                 " << metrics.urethra_d10 << std::endl;
+  os << "Rectum Details" << std::endl;
+  os << "  D90 (Gy):                 " << metrics.rectum_d90 << std::endl;
+  os << "  D10 (Gy):                 " << metrics.rectum_d10 << std::endl;
+  os << std::endl;
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPlanEvaluator.cpp
+//---------------------------------------------------------------------------//
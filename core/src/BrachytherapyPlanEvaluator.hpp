@@ -0,0 +1,138 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPlanEvaluator.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy treatment plan evaluator class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_PLAN_EVALUATOR_HPP
+#define BRACHYTHERAPY_PLAN_EVALUATOR_HPP
+
+// Std Lib Includes
+#include <list>
+#include <iostream>
+#include <vector>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapySeedPosition.hpp"
+
+namespace TPOR{
+
+//! Brachytherapy treatment plan quality metrics
+struct BrachytherapyPlanMetrics
+{
+  // Fraction of the prostate receiving more than the prescribed dose
+  double prostate_v100;
+
+  // Dose covering 90% of the prostate (Gy)
+  double prostate_d90;
+
+  // Dose covering 100% of the prostate (Gy)
+  double prostate_d100;
+
+  // Dose covering 10% of the urethra (Gy)
+  double urethra_d10;
+  
+  // Dose covering 90% of the urethra (Gy)
+  double urethra_d90;
+
+  // Dose covering 10% of the rectum (Gy)
+  double rectum_d10;
+
+  // Dose covering 90% of the rectum (Gy)
+  double rectum_d90;
+
+  // Dose nonuniformity ratio
+  double dnr;
+
+  // Conformation number
+  double cn;
+};
+
+//! Print the treatment plan metrics summary
+void printBrachytherapyPlanMetrics( std::ostream &os,
+				    const BrachytherapyPlanMetrics &metrics );
+
+/*! Brachytherapy treatment plan evaluator
+ * 
+ * Treatment plans are evaluated using only the shared patient geometry. All 
+ * evaluation methods are const and only use scratch buffers that are local 
+ * to the calling thread, so a single evaluator can be shared by any number
+ * of threads.
+ */
+class BrachytherapyPlanEvaluator
+{
+
+public:
+
+  //! Constructor
+  BrachytherapyPlanEvaluator( 
+   const boost::shared_ptr<const BrachytherapyPatientGeometry> &geometry );
+
+  //! Destructor
+  ~BrachytherapyPlanEvaluator()
+  { /* ... */ }
+
+  //! Evaluate a treatment plan
+  void evaluatePlan( 
+		const std::list<BrachytherapySeedPosition> &treatment_plan,
+		BrachytherapyPlanMetrics &metrics ) const;
+
+  //! Evaluate a batch of treatment plans in parallel
+  void evaluatePlans( 
+	   const std::vector<std::list<BrachytherapySeedPosition> > &plans,
+	   std::vector<BrachytherapyPlanMetrics> &metrics,
+	   const unsigned number_of_threads = 0 ) const;
+
+  //! Evaluate a patient dose distribution (cGy)
+  void evaluateDoseDistribution( 
+			     const std::vector<double> &dose_distribution,
+			     BrachytherapyPlanMetrics &metrics ) const;
+
+private:
+
+  //! Evaluation scratch buffers (one set per thread)
+  struct EvaluationScratch
+  {
+    // The plan dose distribution
+    std::vector<double> dose_distribution;
+
+    // The sorted structure doses
+    std::vector<std::vector<double> > structure_doses;
+  };
+
+  //! Evaluate a treatment plan using scratch buffers
+  void evaluatePlan( 
+		const std::list<BrachytherapySeedPosition> &treatment_plan,
+		EvaluationScratch &scratch,
+		BrachytherapyPlanMetrics &metrics ) const;
+  
+  //! Evaluate a patient dose distribution using scratch buffers
+  void evaluateDoseDistribution( 
+			     const std::vector<double> &dose_distribution,
+			     EvaluationScratch &scratch,
+			     BrachytherapyPlanMetrics &metrics ) const;
+
+  //! Evaluate every n-th plan of a batch, starting from the first plan
+  void evaluatePlanStride( 
+	   const std::vector<std::list<BrachytherapySeedPosition> > &plans,
+	   std::vector<BrachytherapyPlanMetrics> &metrics,
+	   const unsigned first_plan,
+	   const unsigned stride ) const;
+  
+  // The patient geometry
+  boost::shared_ptr<const BrachytherapyPatientGeometry> d_geometry;
+};
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_PLAN_EVALUATOR_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPlanEvaluator.hpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,466 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPlanFileHandler.cpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy treatment plan hdf5 file handler class definition
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <fstream>
+#include <algorithm>
+#include <limits>
+
+// TPOR Includes
+#include "BrachytherapyPlanFileHandler.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Constructor
+BrachytherapyPlanFileHandler::BrachytherapyPlanFileHandler( 
+						 const std::string &file_name,
+						 const bool read_only )
+  : d_hdf5_file()
+{
+  if( read_only )
+    d_hdf5_file.openHDF5FileAndReadOnly( file_name );
+  else
+  {
+    // Create the file if it does not exist yet
+    std::ifstream test_file( file_name.c_str() );
+    
+    if( test_file.good() )
+    {
+      test_file.close();
+      
+      d_hdf5_file.openHDF5FileAndAppend( file_name );
+    }
+    else
+      d_hdf5_file.openHDF5FileAndOverwrite( file_name );
+  }
+}
+
+// Destructor
+BrachytherapyPlanFileHandler::~BrachytherapyPlanFileHandler()
+{
+  d_hdf5_file.closeHDF5File();
+}
+
+// Test if a treatment plan exists
+bool BrachytherapyPlanFileHandler::planExists( const std::string &plan_name )
+{
+  if( d_hdf5_file.groupExists( "/plans" ) )
+    return d_hdf5_file.groupExists( getPlanLocation( plan_name ) );
+  else
+    return false;
+}
+
+// Remove a treatment plan
+void BrachytherapyPlanFileHandler::removePlan( const std::string &plan_name )
+{
+  // Make sure that the plan exists
+  testPrecondition( planExists( plan_name ) );
+  
+  d_hdf5_file.removeGroup( getPlanLocation( plan_name ) );
+}
+
+// Set the treatment plan seeds
+/*! \details The treatment plan group will be created if it does not exist.
+ */
+void BrachytherapyPlanFileHandler::setSeeds( 
+		      const std::string &plan_name,
+		      const std::vector<BrachytherapySeedRecord> &seeds )
+{
+  // Make sure that there are seeds
+  testPrecondition( seeds.size() > 0 );
+  
+  d_hdf5_file.writeArrayToDataSet( seeds, 
+				   getPlanLocation( plan_name ) + "/seeds" );
+}
+
+// Return the treatment plan seeds
+void BrachytherapyPlanFileHandler::getSeeds( 
+			    const std::string &plan_name,
+			    std::vector<BrachytherapySeedRecord> &seeds )
+{
+  d_hdf5_file.readArrayFromDataSet( seeds, 
+				    getPlanLocation( plan_name ) + "/seeds" );
+}
+
+// Set the treatment plan dose distribution (cGy)
+/*! \details The dose distribution is stored as a 3D (z, y, x) dataset with 
+ * one compressed chunk per z-slice. The mesh dimensions and the mesh offset
+ * are stored as x, y, z triplets.
+ */
+void BrachytherapyPlanFileHandler::setDoseDistribution( 
+			       const std::string &plan_name,
+			       const std::vector<double> &dose_distribution,
+			       const std::vector<unsigned> &mesh_dimensions,
+			       const std::vector<unsigned> &mesh_offset )
+{
+  // Make sure that the mesh dimensions are valid
+  testPrecondition( mesh_dimensions.size() == 3 );
+  testPrecondition( mesh_offset.size() == 3 );
+  testPrecondition( dose_distribution.size() == 
+		    mesh_dimensions[0]*mesh_dimensions[1]*mesh_dimensions[2] );
+  
+  std::string dose_location = getPlanLocation( plan_name ) + "/dose";
+  
+  std::vector<hsize_t> dimensions = 
+    getDoseDistributionDataSetDimensions( mesh_dimensions );
+
+  std::vector<hsize_t> chunk_dimensions( dimensions );
+  chunk_dimensions[0] = 1;
+
+  d_hdf5_file.writeArrayToChunkedDataSet( dose_distribution,
+					  dose_location,
+					  dimensions,
+					  chunk_dimensions );
+
+  d_hdf5_file.writeArrayToDataSetAttribute( mesh_dimensions,
+					    dose_location,
+					    "mesh_dimensions" );
+
+  d_hdf5_file.writeArrayToDataSetAttribute( mesh_offset,
+					    dose_location,
+					    "mesh_offset" );
+}
+
+// Return the treatment plan dose distribution (cGy)
+void BrachytherapyPlanFileHandler::getDoseDistribution( 
+				      const std::string &plan_name,
+				      std::vector<double> &dose_distribution )
+{
+  d_hdf5_file.readArrayFromDataSet( dose_distribution,
+				    getPlanLocation( plan_name ) + "/dose" );
+}
+
+// Return a range of z-slices of the treatment plan dose distribution (cGy)
+/*! \details Only the requested slices are read from the file.
+ */
+void BrachytherapyPlanFileHandler::getDoseDistributionSlices( 
+					    const std::string &plan_name,
+					    const unsigned z_start,
+					    const unsigned num_slices,
+					    std::vector<double> &dose_slices )
+{
+  std::vector<unsigned> mesh_dimensions;
+  getDoseDistributionDimensions( plan_name, mesh_dimensions );
+
+  // Make sure that the slices are valid
+  testPrecondition( num_slices > 0 );
+  testPrecondition( z_start + num_slices <= mesh_dimensions[2] );
+
+  std::vector<hsize_t> offset( 3, 0 );
+  offset[0] = z_start;
+  
+  std::vector<hsize_t> count( 3 );
+  count[0] = num_slices;
+  count[1] = mesh_dimensions[1];
+  count[2] = mesh_dimensions[0];
+
+  d_hdf5_file.readArrayHyperslabFromDataSet( 
+				       dose_slices,
+				       getPlanLocation( plan_name ) + "/dose",
+				       offset,
+				       count );
+}
+
+// Return the dose distribution mesh dimensions (x, y, z)
+void BrachytherapyPlanFileHandler::getDoseDistributionDimensions( 
+				       const std::string &plan_name,
+				       std::vector<unsigned> &mesh_dimensions )
+{
+  d_hdf5_file.readArrayFromDataSetAttribute( 
+				       mesh_dimensions,
+				       getPlanLocation( plan_name ) + "/dose",
+				       "mesh_dimensions" );
+}
+
+// Return the dose distribution offset in the full organ mesh (x, y, z)
+void BrachytherapyPlanFileHandler::getDoseDistributionOffset( 
+					   const std::string &plan_name,
+					   std::vector<unsigned> &mesh_offset )
+{
+  d_hdf5_file.readArrayFromDataSetAttribute( 
+				       mesh_offset,
+				       getPlanLocation( plan_name ) + "/dose",
+				       "mesh_offset" );
+}
+
+// Test if the treatment plan has a dose distribution
+bool BrachytherapyPlanFileHandler::doseDistributionExists( 
+					        const std::string &plan_name )
+{
+  if( planExists( plan_name ) )
+    return d_hdf5_file.dataSetExists( getPlanLocation( plan_name ) + "/dose" );
+  else
+    return false;
+}
+
+// Set the quantized treatment plan dose distribution (cGy)
+/*! \details The dose is mapped linearly onto 16-bit unsigned integers so 
+ * that the maximum dose maps to the largest integer. The scale factor 
+ * (cGy per integer step) and the error bound (half of a step) are stored as
+ * attributes of the dataset. The dataset is chunked and compressed in the 
+ * same way as the full precision dose distribution.
+ */
+void BrachytherapyPlanFileHandler::setQuantizedDoseDistribution( 
+				 const std::string &plan_name,
+				 const std::vector<double> &dose_distribution,
+				 const std::vector<unsigned> &mesh_dimensions,
+				 const std::vector<unsigned> &mesh_offset )
+{
+  // Make sure that the mesh dimensions are valid
+  testPrecondition( mesh_dimensions.size() == 3 );
+  testPrecondition( mesh_offset.size() == 3 );
+  testPrecondition( dose_distribution.size() == 
+		    mesh_dimensions[0]*mesh_dimensions[1]*mesh_dimensions[2] );
+
+  double max_dose = 
+    *std::max_element( dose_distribution.begin(), dose_distribution.end() );
+
+  // Make sure that the dose distribution is valid
+  testPrecondition( 
+	       *std::min_element( dose_distribution.begin(), 
+				  dose_distribution.end() ) >= 0.0 );
+
+  double scale_factor = (max_dose > 0.0 ? 
+			 max_dose/std::numeric_limits<unsigned short>::max() :
+			 1.0);
+  
+  std::vector<unsigned short> quantized_dose( dose_distribution.size() );
+
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    quantized_dose[i] = 
+      (unsigned short)(dose_distribution[i]/scale_factor + 0.5);
+  }
+
+  std::string dose_location = getPlanLocation( plan_name ) + 
+    "/quantized_dose";
+  
+  std::vector<hsize_t> dimensions = 
+    getDoseDistributionDataSetDimensions( mesh_dimensions );
+
+  std::vector<hsize_t> chunk_dimensions( dimensions );
+  chunk_dimensions[0] = 1;
+
+  d_hdf5_file.writeArrayToChunkedDataSet( quantized_dose,
+					  dose_location,
+					  dimensions,
+					  chunk_dimensions );
+
+  d_hdf5_file.writeArrayToDataSetAttribute( mesh_dimensions,
+					    dose_location,
+					    "mesh_dimensions" );
+
+  d_hdf5_file.writeArrayToDataSetAttribute( mesh_offset,
+					    dose_location,
+					    "mesh_offset" );
+
+  d_hdf5_file.writeValueToDataSetAttribute( scale_factor,
+					    dose_location,
+					    "scale_factor" );
+
+  d_hdf5_file.writeValueToDataSetAttribute( scale_factor/2,
+					    dose_location,
+					    "error_bound" );
+}
+
+// Return the dequantized treatment plan dose distribution (cGy)
+void BrachytherapyPlanFileHandler::getQuantizedDoseDistribution( 
+				      const std::string &plan_name,
+				      std::vector<double> &dose_distribution )
+{
+  std::string dose_location = getPlanLocation( plan_name ) + 
+    "/quantized_dose";
+  
+  std::vector<unsigned short> quantized_dose;
+  d_hdf5_file.readArrayFromDataSet( quantized_dose, dose_location );
+
+  double scale_factor;
+  d_hdf5_file.readValueFromDataSetAttribute( scale_factor,
+					     dose_location,
+					     "scale_factor" );
+
+  dose_distribution.resize( quantized_dose.size() );
+
+  for( unsigned i = 0; i < quantized_dose.size(); ++i )
+    dose_distribution[i] = quantized_dose[i]*scale_factor;
+}
+
+// Return the maximum quantization error of the dose distribution (cGy)
+double BrachytherapyPlanFileHandler::getQuantizedDoseDistributionErrorBound( 
+					         const std::string &plan_name )
+{
+  double error_bound;
+  d_hdf5_file.readValueFromDataSetAttribute( 
+			      error_bound,
+			      getPlanLocation( plan_name ) + "/quantized_dose",
+			      "error_bound" );
+
+  return error_bound;
+}
+
+// Test if the treatment plan has a quantized dose distribution
+bool BrachytherapyPlanFileHandler::quantizedDoseDistributionExists( 
+					        const std::string &plan_name )
+{
+  if( planExists( plan_name ) )
+  {
+    return d_hdf5_file.dataSetExists( getPlanLocation( plan_name ) + 
+				      "/quantized_dose" );
+  }
+  else
+    return false;
+}
+
+// Set the dose-volume-histogram dose bins (Gy)
+void BrachytherapyPlanFileHandler::setDoseVolumeHistogramDoses( 
+					     const std::string &plan_name,
+					     const std::vector<double> &doses )
+{
+  d_hdf5_file.writeArrayToDataSet( doses,
+				   getPlanLocation( plan_name ) + "/dvh/dose" );
+}
+
+// Return the dose-volume-histogram dose bins (Gy)
+void BrachytherapyPlanFileHandler::getDoseVolumeHistogramDoses( 
+						 const std::string &plan_name,
+						 std::vector<double> &doses )
+{
+  d_hdf5_file.readArrayFromDataSet( doses,
+				    getPlanLocation( plan_name ) + "/dvh/dose" );
+}
+
+// Set the dose-volume-histogram of an organ (fraction of organ volume)
+void BrachytherapyPlanFileHandler::setDoseVolumeHistogram( 
+			        const std::string &plan_name,
+				const std::string &organ_name,
+				const std::vector<double> &volume_fractions )
+{
+  d_hdf5_file.writeArrayToDataSet( 
+		      volume_fractions,
+		      getPlanLocation( plan_name ) + "/dvh/" + organ_name );
+}
+
+// Return the dose-volume-histogram of an organ
+void BrachytherapyPlanFileHandler::getDoseVolumeHistogram( 
+				      const std::string &plan_name,
+				      const std::string &organ_name,
+				      std::vector<double> &volume_fractions )
+{
+  d_hdf5_file.readArrayFromDataSet( 
+		      volume_fractions,
+		      getPlanLocation( plan_name ) + "/dvh/" + organ_name );
+}
+
+// Set the treatment plan metrics
+/*! \details The metrics are stored as attributes of the treatment plan 
+ * group, which must already exist (set the seeds first).
+ */
+void BrachytherapyPlanFileHandler::setPlanMetrics( 
+				      const std::string &plan_name,
+				      const BrachytherapyPlanMetrics &metrics )
+{
+  // Make sure that the plan exists
+  testPrecondition( planExists( plan_name ) );
+  
+  std::string plan_location = getPlanLocation( plan_name );
+
+  d_hdf5_file.writeValueToGroupAttribute( metrics.prostate_v100,
+					  plan_location,
+					  "prostate_v100" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.prostate_d90,
+					  plan_location,
+					  "prostate_d90" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.prostate_d100,
+					  plan_location,
+					  "prostate_d100" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.urethra_d10,
+					  plan_location,
+					  "urethra_d10" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.urethra_d90,
+					  plan_location,
+					  "urethra_d90" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.rectum_d10,
+					  plan_location,
+					  "rectum_d10" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.rectum_d90,
+					  plan_location,
+					  "rectum_d90" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.dnr,
+					  plan_location,
+					  "dnr" );
+  d_hdf5_file.writeValueToGroupAttribute( metrics.cn,
+					  plan_location,
+					  "cn" );
+}
+
+// Return the treatment plan metrics
+void BrachytherapyPlanFileHandler::getPlanMetrics( 
+					    const std::string &plan_name,
+					    BrachytherapyPlanMetrics &metrics )
+{
+  std::string plan_location = getPlanLocation( plan_name );
+
+  d_hdf5_file.readValueFromGroupAttribute( metrics.prostate_v100,
+					   plan_location,
+					   "prostate_v100" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.prostate_d90,
+					   plan_location,
+					   "prostate_d90" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.prostate_d100,
+					   plan_location,
+					   "prostate_d100" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.urethra_d10,
+					   plan_location,
+					   "urethra_d10" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.urethra_d90,
+					   plan_location,
+					   "urethra_d90" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.rectum_d10,
+					   plan_location,
+					   "rectum_d10" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.rectum_d90,
+					   plan_location,
+					   "rectum_d90" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.dnr,
+					   plan_location,
+					   "dnr" );
+  d_hdf5_file.readValueFromGroupAttribute( metrics.cn,
+					   plan_location,
+					   "cn" );
+}
+
+// Return the location of a treatment plan group
+std::string BrachytherapyPlanFileHandler::getPlanLocation( 
+					         const std::string &plan_name )
+{
+  // Make sure that the plan name is valid
+  testPrecondition( plan_name.size() > 0 );
+  testPrecondition( plan_name.find( "/" ) == std::string::npos );
+  
+  return "/plans/" + plan_name;
+}
+
+// Return the dataset dimensions (z, y, x) of a dose distribution
+std::vector<hsize_t> 
+BrachytherapyPlanFileHandler::getDoseDistributionDataSetDimensions( 
+				  const std::vector<unsigned> &mesh_dimensions )
+{
+  std::vector<hsize_t> dimensions( 3 );
+  dimensions[0] = mesh_dimensions[2];
+  dimensions[1] = mesh_dimensions[1];
+  dimensions[2] = mesh_dimensions[0];
+
+  return dimensions;
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPlanFileHandler.cpp
+//---------------------------------------------------------------------------//
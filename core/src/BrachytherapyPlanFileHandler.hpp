@@ -0,0 +1,150 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPlanFileHandler.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy treatment plan hdf5 file handler class declaration
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_PLAN_FILE_HANDLER_HPP
+#define BRACHYTHERAPY_PLAN_FILE_HANDLER_HPP
+
+// Std Lib Includes
+#include <string>
+#include <vector>
+
+// TPOR Includes
+#include "HDF5FileHandler.hpp"
+#include "BrachytherapySeedRecord.hpp"
+#include "BrachytherapyPlanEvaluator.hpp"
+
+namespace TPOR{
+
+/*! Brachytherapy treatment plan hdf5 file handler
+ *
+ * Each treatment plan is stored in its own group (/plans/plan_name/) of the
+ * file, which can be the patient file or a separate results file. The group
+ * holds the seed list (compound dataset), the dose distribution (chunked 
+ * and compressed with one chunk per z-slice), the dose-volume-histogram 
+ * arrays and the plan metrics (group attributes). Each part can be read
+ * independently. For compact plan archives, the dose distribution can be 
+ * omitted (it can be rebuilt from the seeds) or stored as 16-bit integers
+ * with a per-plan scale factor and error bound.
+ */
+class BrachytherapyPlanFileHandler
+{
+
+public:
+
+  //! Constructor (the file will be created if it does not exist)
+  BrachytherapyPlanFileHandler( const std::string &file_name,
+				const bool read_only = false );
+
+  //! Destructor
+  ~BrachytherapyPlanFileHandler();
+
+  //! Test if a treatment plan exists
+  bool planExists( const std::string &plan_name );
+
+  //! Remove a treatment plan
+  void removePlan( const std::string &plan_name );
+
+  //! Set the treatment plan seeds
+  void setSeeds( const std::string &plan_name,
+		 const std::vector<BrachytherapySeedRecord> &seeds );
+
+  //! Return the treatment plan seeds
+  void getSeeds( const std::string &plan_name,
+		 std::vector<BrachytherapySeedRecord> &seeds );
+
+  //! Set the treatment plan dose distribution (cGy)
+  void setDoseDistribution( const std::string &plan_name,
+			    const std::vector<double> &dose_distribution,
+			    const std::vector<unsigned> &mesh_dimensions,
+			    const std::vector<unsigned> &mesh_offset );
+
+  //! Return the treatment plan dose distribution (cGy)
+  void getDoseDistribution( const std::string &plan_name,
+			    std::vector<double> &dose_distribution );
+
+  //! Return a range of z-slices of the treatment plan dose distribution (cGy)
+  void getDoseDistributionSlices( const std::string &plan_name,
+				  const unsigned z_start,
+				  const unsigned num_slices,
+				  std::vector<double> &dose_slices );
+
+  //! Return the dose distribution mesh dimensions (x, y, z)
+  void getDoseDistributionDimensions( const std::string &plan_name,
+				      std::vector<unsigned> &mesh_dimensions );
+
+  //! Return the dose distribution offset in the full organ mesh (x, y, z)
+  void getDoseDistributionOffset( const std::string &plan_name,
+				  std::vector<unsigned> &mesh_offset );
+
+  //! Test if the treatment plan has a dose distribution
+  bool doseDistributionExists( const std::string &plan_name );
+
+  //! Set the quantized treatment plan dose distribution (cGy)
+  void setQuantizedDoseDistribution( 
+				 const std::string &plan_name,
+				 const std::vector<double> &dose_distribution,
+				 const std::vector<unsigned> &mesh_dimensions,
+				 const std::vector<unsigned> &mesh_offset );
+
+  //! Return the dequantized treatment plan dose distribution (cGy)
+  void getQuantizedDoseDistribution( const std::string &plan_name,
+				     std::vector<double> &dose_distribution );
+
+  //! Return the maximum quantization error of the dose distribution (cGy)
+  double getQuantizedDoseDistributionErrorBound( 
+					        const std::string &plan_name );
+
+  //! Test if the treatment plan has a quantized dose distribution
+  bool quantizedDoseDistributionExists( const std::string &plan_name );
+
+  //! Set the dose-volume-histogram dose bins (Gy)
+  void setDoseVolumeHistogramDoses( const std::string &plan_name,
+				    const std::vector<double> &doses );
+
+  //! Return the dose-volume-histogram dose bins (Gy)
+  void getDoseVolumeHistogramDoses( const std::string &plan_name,
+				    std::vector<double> &doses );
+
+  //! Set the dose-volume-histogram of an organ (fraction of organ volume)
+  void setDoseVolumeHistogram( const std::string &plan_name,
+			       const std::string &organ_name,
+			       const std::vector<double> &volume_fractions );
+
+  //! Return the dose-volume-histogram of an organ 
+  void getDoseVolumeHistogram( const std::string &plan_name,
+			       const std::string &organ_name,
+			       std::vector<double> &volume_fractions );
+
+  //! Set the treatment plan metrics
+  void setPlanMetrics( const std::string &plan_name,
+		       const BrachytherapyPlanMetrics &metrics );
+
+  //! Return the treatment plan metrics
+  void getPlanMetrics( const std::string &plan_name,
+		       BrachytherapyPlanMetrics &metrics );
+
+private:
+
+  //! Return the location of a treatment plan group
+  static std::string getPlanLocation( const std::string &plan_name );
+
+  //! Return the dataset dimensions (z, y, x) of a dose distribution
+  static std::vector<hsize_t> getDoseDistributionDataSetDimensions( 
+				 const std::vector<unsigned> &mesh_dimensions );
+
+  // HDF5FileHandler
+  HDF5FileHandler d_hdf5_file;
+};
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_PLAN_FILE_HANDLER_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPlanFileHandler.hpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,333 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPlanRobustnessAnalyzer.cpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy treatment plan robustness analyzer definition
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <map>
+#include <math.h>
+
+// Boost Includes
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/random/seed_seq.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPlanRobustnessAnalyzer.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Set the mesh element dimensions (should always be the same)
+const double BrachytherapyPlanRobustnessAnalyzer::mesh_element_x_dim = 0.1;
+const double BrachytherapyPlanRobustnessAnalyzer::mesh_element_y_dim = 0.1;
+const double BrachytherapyPlanRobustnessAnalyzer::mesh_element_z_dim = 0.5;
+
+// Constructor
+BrachytherapyPlanRobustnessAnalyzer::BrachytherapyPlanRobustnessAnalyzer(
+			       const BrachytherapyPatient &patient,
+			       const BrachytherapyPerturbationModel &model )
+  : d_geometry( patient.getGeometry() ),
+    d_evaluator( patient.getGeometry() ),
+    d_model( model ),
+    d_seed_positions( patient.getTreatmentPlan().begin(),
+		      patient.getTreatmentPlan().end() ),
+    d_seed_needles(),
+    d_number_of_needles( 0u ),
+    d_nominal_dose_distribution( patient.getDoseDistribution() ),
+    d_nominal_metrics(),
+    d_random_seed( 0u ),
+    d_scenario_metrics()
+{
+  // Make sure that there is a treatment plan to analyze
+  testPrecondition( patient.getNumInsertedSeeds() > 0 );
+  // Make sure that the perturbation model is valid
+  testPrecondition( model.seed_x_width >= 0.0 );
+  testPrecondition( model.seed_y_width >= 0.0 );
+  testPrecondition( model.seed_z_width >= 0.0 );
+  testPrecondition( model.needle_x_width >= 0.0 );
+  testPrecondition( model.needle_y_width >= 0.0 );
+  testPrecondition( model.needle_z_width >= 0.0 );
+
+  // Assign the seeds to needles
+  std::map<unsigned,unsigned> needle_map;
+  d_seed_needles.resize( d_seed_positions.size() );
+  
+  for( unsigned i = 0; i < d_seed_positions.size(); ++i )
+  {
+    unsigned needle_index = d_seed_positions[i].getXIndex() + 
+      d_seed_positions[i].getYIndex()*d_geometry->getOrganMeshXDim();
+
+    if( needle_map.count( needle_index ) == 0 )
+    {
+      unsigned needle = needle_map.size();
+      needle_map[needle_index] = needle;
+    }
+
+    d_seed_needles[i] = needle_map[needle_index];
+  }
+
+  d_number_of_needles = needle_map.size();
+
+  d_evaluator.evaluateDoseDistribution( d_nominal_dose_distribution,
+					d_nominal_metrics );
+}
+
+// Sample and evaluate perturbed seed placements
+/*! \details All available hardware threads will be used if the number of 
+ * threads is 0. The metrics of previously sampled scenarios are discarded.
+ */
+void BrachytherapyPlanRobustnessAnalyzer::sampleScenarios( 
+					  const unsigned number_of_scenarios,
+					  const unsigned random_seed,
+					  const unsigned number_of_threads )
+{
+  // Make sure that the number of scenarios is valid
+  testPrecondition( number_of_scenarios > 0 );
+  
+  d_random_seed = random_seed;
+  
+  d_scenario_metrics.clear();
+  d_scenario_metrics.resize( number_of_scenarios );
+
+  unsigned threads = number_of_threads;
+
+  if( threads == 0 )
+    threads = std::max( boost::thread::hardware_concurrency(), 1u );
+
+  threads = std::min( threads, number_of_scenarios );
+
+  if( threads <= 1 )
+  {
+    sampleScenarioStride( 0u, 1u );
+  }
+  else
+  {
+    boost::thread_group thread_group;
+    
+    for( unsigned i = 0; i < threads; ++i )
+    {
+      thread_group.create_thread( 
+	 boost::bind( &BrachytherapyPlanRobustnessAnalyzer::sampleScenarioStride,
+		      this,
+		      i,
+		      threads ) );
+    }
+
+    thread_group.join_all();
+  }
+}
+
+// Return the nominal plan metrics
+const BrachytherapyPlanMetrics& 
+BrachytherapyPlanRobustnessAnalyzer::getNominalMetrics() const
+{
+  return d_nominal_metrics;
+}
+
+// Return the metrics of the sampled scenarios
+const std::vector<BrachytherapyPlanMetrics>& 
+BrachytherapyPlanRobustnessAnalyzer::getScenarioMetrics() const
+{
+  return d_scenario_metrics;
+}
+
+// Return a percentile of the prostate V100 over the scenarios
+double BrachytherapyPlanRobustnessAnalyzer::getProstateV100Percentile( 
+					       const double percentile ) const
+{
+  return getMetricPercentile( &BrachytherapyPlanMetrics::prostate_v100,
+			      percentile );
+}
+
+// Return a percentile of the prostate D90 (Gy) over the scenarios
+double BrachytherapyPlanRobustnessAnalyzer::getProstateD90Percentile( 
+					       const double percentile ) const
+{
+  return getMetricPercentile( &BrachytherapyPlanMetrics::prostate_d90,
+			      percentile );
+}
+
+// Print the robustness summary (5th, 50th and 95th percentile bands)
+void BrachytherapyPlanRobustnessAnalyzer::printRobustnessSummary( 
+						     std::ostream &os ) const
+{
+  os << "Robustness Details (" << d_scenario_metrics.size() 
+     << " scenarios)" << std::endl;
+  os << "  Prostate V100 (nominal):  " << d_nominal_metrics.prostate_v100
+     << std::endl;
+  os << "  Prostate V100 (5/50/95%): " 
+     << getProstateV100Percentile( 0.05 ) << " "
+     << getProstateV100Percentile( 0.50 ) << " "
+     << getProstateV100Percentile( 0.95 ) << std::endl;
+  os << "  Prostate D90 (nominal):   " << d_nominal_metrics.prostate_d90
+     << std::endl;
+  os << "  Prostate D90 (5/50/95%):  " 
+     << getProstateD90Percentile( 0.05 ) << " "
+     << getProstateD90Percentile( 0.50 ) << " "
+     << getProstateD90Percentile( 0.95 ) << std::endl;
+  os << std::endl;
+}
+
+// Sample every n-th scenario, starting from the first scenario
+void BrachytherapyPlanRobustnessAnalyzer::sampleScenarioStride( 
+						const unsigned first_scenario,
+						const unsigned stride )
+{
+  std::vector<double> dose_distribution;
+
+  for( unsigned scenario = first_scenario; 
+       scenario < d_scenario_metrics.size(); 
+       scenario += stride )
+  {
+    sampleScenario( scenario, 
+		    dose_distribution, 
+		    d_scenario_metrics[scenario] );
+  }
+}
+
+// Sample and evaluate a scenario
+void BrachytherapyPlanRobustnessAnalyzer::sampleScenario( 
+				   const unsigned scenario,
+				   std::vector<double> &dose_distribution,
+				   BrachytherapyPlanMetrics &metrics ) const
+{
+  unsigned mesh_x_dim = d_geometry->getOrganMeshXDim();
+  unsigned mesh_y_dim = d_geometry->getOrganMeshYDim();
+  unsigned mesh_z_dim = d_geometry->getOrganMeshZDim();
+  
+  // Each scenario has its own random number stream
+  unsigned stream_seed[2] = {d_random_seed, scenario};
+  boost::random::seed_seq seed_sequence( stream_seed, stream_seed+2 );
+  boost::mt19937 generator( seed_sequence );
+
+  // Sample the needle shifts
+  std::vector<double> needle_x_shifts( d_number_of_needles );
+  std::vector<double> needle_y_shifts( d_number_of_needles );
+  std::vector<double> needle_z_shifts( d_number_of_needles );
+
+  for( unsigned i = 0; i < d_number_of_needles; ++i )
+  {
+    needle_x_shifts[i] = sampleShift( generator, d_model.needle_x_width );
+    needle_y_shifts[i] = sampleShift( generator, d_model.needle_y_width );
+    needle_z_shifts[i] = sampleShift( generator, d_model.needle_z_width );
+  }
+
+  dose_distribution = d_nominal_dose_distribution;
+  
+  for( unsigned i = 0; i < d_seed_positions.size(); ++i )
+  {
+    const BrachytherapySeedPosition &nominal_position = d_seed_positions[i];
+    unsigned needle = d_seed_needles[i];
+    
+    int x_index = nominal_position.getXIndex() + calculateIndexShift( 
+	      needle_x_shifts[needle] + 
+	      sampleShift( generator, d_model.seed_x_width ),
+	      mesh_element_x_dim );
+    int y_index = nominal_position.getYIndex() + calculateIndexShift( 
+	      needle_y_shifts[needle] + 
+	      sampleShift( generator, d_model.seed_y_width ),
+	      mesh_element_y_dim );
+    int z_index = nominal_position.getZIndex() + calculateIndexShift( 
+	      needle_z_shifts[needle] + 
+	      sampleShift( generator, d_model.seed_z_width ),
+	      mesh_element_z_dim );
+
+    // Keep the seed inside of the region of interest
+    x_index = std::max( 0, std::min( x_index, (int)mesh_x_dim-1 ) );
+    y_index = std::max( 0, std::min( y_index, (int)mesh_y_dim-1 ) );
+    z_index = std::max( 0, std::min( z_index, (int)mesh_z_dim-1 ) );
+
+    // Only the seeds that moved change the dose distribution
+    if( x_index != (int)nominal_position.getXIndex() ||
+	y_index != (int)nominal_position.getYIndex() ||
+	z_index != (int)nominal_position.getZIndex() )
+    {
+      nominal_position.mapSeedDoseDistribution<MinusEqual>( 
+							 dose_distribution,
+							 mesh_x_dim,
+							 mesh_y_dim,
+							 mesh_z_dim );
+
+      BrachytherapySeedPosition perturbed_position( 
+					      x_index,
+					      y_index,
+					      z_index,
+					      nominal_position.getWeight(),
+					      nominal_position.getSeedProxy() );
+
+      perturbed_position.mapSeedDoseDistribution<PlusEqual>( 
+							 dose_distribution,
+							 mesh_x_dim,
+							 mesh_y_dim,
+							 mesh_z_dim );
+    }
+  }
+
+  d_evaluator.evaluateDoseDistribution( dose_distribution, metrics );
+}
+
+// Sample a shift (cm)
+double BrachytherapyPlanRobustnessAnalyzer::sampleShift( 
+					       boost::mt19937 &generator,
+					       const double width ) const
+{
+  if( width == 0.0 )
+    return 0.0;
+  
+  switch( d_model.distribution )
+  {
+  case UNIFORM_PERTURBATION:
+    return boost::random::uniform_real_distribution<double>( 
+					       -width, width )( generator );
+  case NORMAL_PERTURBATION:
+  default:
+    return boost::random::normal_distribution<double>( 
+						  0.0, width )( generator );
+  }
+}
+
+// Return the mesh index shift of a shift (cm)
+int BrachytherapyPlanRobustnessAnalyzer::calculateIndexShift( 
+					     const double shift, 
+					     const double mesh_element_dim )
+{
+  return (int)floor( shift/mesh_element_dim + 0.5 );
+}
+
+// Return a percentile of a metric over the scenarios
+/*! \details The nearest-rank percentile is returned.
+ */
+double BrachytherapyPlanRobustnessAnalyzer::getMetricPercentile( 
+			       double BrachytherapyPlanMetrics::* metric,
+			       const double percentile ) const
+{
+  // Make sure that scenarios have been sampled
+  testPrecondition( d_scenario_metrics.size() > 0 );
+  // Make sure that the percentile is valid
+  testPrecondition( percentile >= 0.0 );
+  testPrecondition( percentile <= 1.0 );
+
+  std::vector<double> values( d_scenario_metrics.size() );
+
+  for( unsigned i = 0; i < d_scenario_metrics.size(); ++i )
+    values[i] = d_scenario_metrics[i].*metric;
+
+  unsigned rank = (unsigned)floor( percentile*(values.size()-1) + 0.5 );
+
+  std::nth_element( values.begin(), values.begin()+rank, values.end() );
+
+  return values[rank];
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPlanRobustnessAnalyzer.cpp
+//---------------------------------------------------------------------------//
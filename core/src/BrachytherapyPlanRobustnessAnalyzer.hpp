@@ -0,0 +1,175 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPlanRobustnessAnalyzer.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy treatment plan robustness analyzer declaration
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_PLAN_ROBUSTNESS_ANALYZER_HPP
+#define BRACHYTHERAPY_PLAN_ROBUSTNESS_ANALYZER_HPP
+
+// Std Lib Includes
+#include <vector>
+#include <iostream>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPlanEvaluator.hpp"
+#include "BrachytherapySeedPosition.hpp"
+
+namespace TPOR{
+
+//! Seed placement perturbation distributions
+enum BrachytherapyPerturbationDistribution{
+  NORMAL_PERTURBATION = 0,
+  UNIFORM_PERTURBATION
+};
+
+/*! Seed placement perturbation model
+ *
+ * Every seed is shifted by the sum of a shift that is shared by all seeds
+ * on its needle (needle deflection and insertion depth error) and a shift
+ * of its own (seed migration). The widths are the standard deviations of 
+ * normal shifts or the half-widths of uniform shifts (cm).
+ */
+struct BrachytherapyPerturbationModel
+{
+  BrachytherapyPerturbationModel()
+    : distribution( NORMAL_PERTURBATION ),
+      seed_x_width( 0.0 ),
+      seed_y_width( 0.0 ),
+      seed_z_width( 0.0 ),
+      needle_x_width( 0.0 ),
+      needle_y_width( 0.0 ),
+      needle_z_width( 0.0 )
+  { /* ... */ }
+
+  // The shift distribution
+  BrachytherapyPerturbationDistribution distribution;
+
+  // The per-seed shift widths (cm)
+  double seed_x_width;
+  double seed_y_width;
+  double seed_z_width;
+
+  // The per-needle shift widths (cm)
+  double needle_x_width;
+  double needle_y_width;
+  double needle_z_width;
+};
+
+/*! Brachytherapy treatment plan robustness analyzer
+ *
+ * Perturbed seed placements of a finished treatment plan are sampled and 
+ * evaluated in parallel. The shifted seeds are snapped to the organ mesh and
+ * kept inside of the region of interest. The dose of each scenario is 
+ * found by removing the seed dose at the nominal position and adding it at
+ * the perturbed position, only for the seeds that actually moved. Each 
+ * scenario has its own random number stream, so the results do not depend
+ * on the number of threads.
+ */
+class BrachytherapyPlanRobustnessAnalyzer
+{
+
+public:
+
+  //! Constructor
+  BrachytherapyPlanRobustnessAnalyzer( 
+			       const BrachytherapyPatient &patient,
+			       const BrachytherapyPerturbationModel &model );
+
+  //! Destructor
+  ~BrachytherapyPlanRobustnessAnalyzer()
+  { /* ... */ }
+
+  //! Sample and evaluate perturbed seed placements
+  void sampleScenarios( const unsigned number_of_scenarios,
+			const unsigned random_seed = 0u,
+			const unsigned number_of_threads = 0u );
+
+  //! Return the nominal plan metrics
+  const BrachytherapyPlanMetrics& getNominalMetrics() const;
+
+  //! Return the metrics of the sampled scenarios
+  const std::vector<BrachytherapyPlanMetrics>& getScenarioMetrics() const;
+
+  //! Return a percentile of the prostate V100 over the scenarios
+  double getProstateV100Percentile( const double percentile ) const;
+
+  //! Return a percentile of the prostate D90 (Gy) over the scenarios
+  double getProstateD90Percentile( const double percentile ) const;
+
+  //! Print the robustness summary (5th, 50th and 95th percentile bands)
+  void printRobustnessSummary( std::ostream &os ) const;
+
+private:
+
+  //! Sample every n-th scenario, starting from the first scenario
+  void sampleScenarioStride( const unsigned first_scenario,
+			     const unsigned stride );
+
+  //! Sample and evaluate a scenario
+  void sampleScenario( const unsigned scenario,
+		       std::vector<double> &dose_distribution,
+		       BrachytherapyPlanMetrics &metrics ) const;
+
+  //! Sample a shift (cm)
+  double sampleShift( boost::mt19937 &generator, const double width ) const;
+
+  //! Return the mesh index shift of a shift (cm)
+  static int calculateIndexShift( const double shift, 
+				  const double mesh_element_dim );
+
+  //! Return a percentile of a metric over the scenarios
+  double getMetricPercentile( double BrachytherapyPlanMetrics::* metric,
+			      const double percentile ) const;
+
+  // The patient geometry
+  boost::shared_ptr<const BrachytherapyPatientGeometry> d_geometry;
+
+  // The treatment plan evaluator
+  BrachytherapyPlanEvaluator d_evaluator;
+
+  // The perturbation model
+  BrachytherapyPerturbationModel d_model;
+
+  // The nominal seed positions
+  std::vector<BrachytherapySeedPosition> d_seed_positions;
+
+  // The needle of each nominal seed position
+  std::vector<unsigned> d_seed_needles;
+
+  // The number of needles
+  unsigned d_number_of_needles;
+
+  // The nominal dose distribution
+  std::vector<double> d_nominal_dose_distribution;
+
+  // The nominal plan metrics
+  BrachytherapyPlanMetrics d_nominal_metrics;
+
+  // The random number seed of the sampled scenarios
+  unsigned d_random_seed;
+
+  // The metrics of the sampled scenarios
+  std::vector<BrachytherapyPlanMetrics> d_scenario_metrics;
+
+  // The mesh element dimensions (cm)
+  static const double mesh_element_x_dim;
+  static const double mesh_element_y_dim;
+  static const double mesh_element_z_dim;
+};
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_PLAN_ROBUSTNESS_ANALYZER_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPlanRobustnessAnalyzer.hpp
+//---------------------------------------------------------------------------//
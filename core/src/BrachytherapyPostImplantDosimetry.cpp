@@ -0,0 +1,286 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPostImplantDosimetry.cpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy post-implant dosimetry class definition
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <math.h>
+
+// Boost Includes
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPostImplantDosimetry.hpp"
+#include "ContractException.hpp"
+#include "ExceptionTestMacros.hpp"
+
+namespace TPOR{
+
+// Set the mesh element dimensions (should always be the same)
+const double BrachytherapyPostImplantDosimetry::mesh_element_x_dim = 0.1;
+const double BrachytherapyPostImplantDosimetry::mesh_element_y_dim = 0.1;
+const double BrachytherapyPostImplantDosimetry::mesh_element_z_dim = 0.5;
+
+// Set the minimum distance from the seed axis (cm)
+const double BrachytherapyPostImplantDosimetry::minimum_radial_distance = 
+  1e-6;
+const double 
+BrachytherapyPostImplantDosimetry::minimum_radial_distance_squared = 1e-12;
+
+// Constructor
+BrachytherapyPostImplantDosimetry::BrachytherapyPostImplantDosimetry( 
+       const boost::shared_ptr<const BrachytherapyPatientGeometry> &geometry,
+       const BrachytherapySeedType seed_type,
+       const double air_kerma_strength )
+  : d_geometry( geometry ),
+    d_seed( BrachytherapySeedFactory::createSeed( seed_type, 
+						  air_kerma_strength ) ),
+    d_evaluator( geometry )
+{
+  // Make sure the geometry is valid
+  testPrecondition( geometry );
+}
+
+// Read the implanted seeds from a text file
+/*! \details Each line of the file holds the seed center (x y z in cm) and 
+ * optionally the seed axis direction (ax ay az). The seed axis is parallel
+ * to the needles (z-axis) if it is not given. Blank lines and lines starting
+ * with # are ignored. A std::runtime_error is thrown if the file cannot be
+ * opened or a line is malformed (e.g. a seed axis with one or two 
+ * components).
+ */
+void BrachytherapyPostImplantDosimetry::readImplantedSeeds( 
+			   const std::string &file_name,
+			   std::vector<BrachytherapyImplantedSeed> &seeds )
+{
+  seeds.clear();
+
+  std::ifstream seed_file( file_name.c_str() );
+
+  TEST_FOR_EXCEPTION( !seed_file,
+		      std::runtime_error,
+		      "Error: the implanted seed file " << file_name << 
+		      " could not be opened." );
+
+  std::string line;
+  unsigned line_number = 0;
+
+  while( std::getline( seed_file, line ) )
+  {
+    ++line_number;
+    
+    std::istringstream iss( line );
+
+    BrachytherapyImplantedSeed seed;
+    
+    // Skip blank lines and comments
+    std::string first_token;
+    if( !(iss >> first_token) || first_token[0] == '#' )
+      continue;
+
+    iss.clear();
+    iss.str( line );
+
+    iss >> seed.x >> seed.y >> seed.z;
+
+    TEST_FOR_EXCEPTION( iss.fail(),
+			std::runtime_error,
+			"Error: line " << line_number << " of the implanted "
+			"seed file " << file_name << " is invalid." );
+
+    // Read the optional seed axis
+    std::vector<double> axis_components;
+    double axis_component;
+
+    while( iss >> axis_component )
+      axis_components.push_back( axis_component );
+
+    TEST_FOR_EXCEPTION( !iss.eof() ||
+			(axis_components.size() != 0 &&
+			 axis_components.size() != 3),
+			std::runtime_error,
+			"Error: line " << line_number << " of the implanted "
+			"seed file " << file_name << " is invalid (the seed "
+			"axis must have three components)." );
+
+    if( axis_components.size() == 3 )
+    {
+      seed.axis_x = axis_components[0];
+      seed.axis_y = axis_components[1];
+      seed.axis_z = axis_components[2];
+    }
+    else
+    {
+      seed.axis_x = 0.0;
+      seed.axis_y = 0.0;
+      seed.axis_z = 1.0;
+    }
+
+    TEST_FOR_EXCEPTION( seed.axis_x == 0.0 && 
+			seed.axis_y == 0.0 && 
+			seed.axis_z == 0.0,
+			std::runtime_error,
+			"Error: the seed axis on line " << line_number << 
+			" of the implanted seed file " << file_name << 
+			" is invalid." );
+
+    seeds.push_back( seed );
+  }
+}
+
+// Calculate the dose distribution of the implanted seeds (cGy)
+/*! \details The dose distribution covers the region of interest of the 
+ * patient geometry. The seeds are divided among the threads (all available 
+ * hardware threads if the number of threads is 0), each of which 
+ * accumulates the dose in its own buffer.
+ */
+void BrachytherapyPostImplantDosimetry::calculateDoseDistribution( 
+			 const std::vector<BrachytherapyImplantedSeed> &seeds,
+			 std::vector<double> &dose_distribution,
+			 const unsigned number_of_threads ) const
+{
+  unsigned size = d_geometry->getOrganMeshXDim()*
+    d_geometry->getOrganMeshYDim()*d_geometry->getOrganMeshZDim();
+  
+  dose_distribution.assign( size, 0.0 );
+
+  unsigned threads = number_of_threads;
+
+  if( threads == 0 )
+    threads = std::max( boost::thread::hardware_concurrency(), 1u );
+
+  threads = std::min( threads, (unsigned)seeds.size() );
+
+  if( threads <= 1 )
+  {
+    addSeedDoseStride( seeds, dose_distribution, 0u, 1u );
+  }
+  else
+  {
+    std::vector<std::vector<double> > thread_dose_distributions( threads );
+    
+    boost::thread_group thread_group;
+    
+    for( unsigned i = 0; i < threads; ++i )
+    {
+      thread_dose_distributions[i].assign( size, 0.0 );
+      
+      thread_group.create_thread( 
+	   boost::bind( &BrachytherapyPostImplantDosimetry::addSeedDoseStride,
+			this,
+			boost::cref( seeds ),
+			boost::ref( thread_dose_distributions[i] ),
+			i,
+			threads ) );
+    }
+
+    thread_group.join_all();
+
+    for( unsigned i = 0; i < threads; ++i )
+    {
+      for( unsigned index = 0; index < size; ++index )
+	dose_distribution[index] += thread_dose_distributions[i][index];
+    }
+  }
+}
+
+// Evaluate the implanted seeds
+void BrachytherapyPostImplantDosimetry::evaluateImplant( 
+			  const std::vector<BrachytherapyImplantedSeed> &seeds,
+			  BrachytherapyPlanMetrics &metrics,
+			  const unsigned number_of_threads ) const
+{
+  std::vector<double> dose_distribution;
+
+  calculateDoseDistribution( seeds, dose_distribution, number_of_threads );
+
+  d_evaluator.evaluateDoseDistribution( dose_distribution, metrics );
+}
+
+// Add the dose of every n-th seed, starting from the first seed
+void BrachytherapyPostImplantDosimetry::addSeedDoseStride( 
+			 const std::vector<BrachytherapyImplantedSeed> &seeds,
+			 std::vector<double> &dose_distribution,
+			 const unsigned first_seed,
+			 const unsigned stride ) const
+{
+  for( unsigned i = first_seed; i < seeds.size(); i += stride )
+    addSeedDose( seeds[i], dose_distribution );
+}
+
+// Add the dose of a seed to the dose distribution
+/*! \details The TG-43 dose only depends on the distance along the seed axis
+ * and the distance from the seed axis, so the displacement of each mesh 
+ * element center is projected onto the seed axis.
+ */
+void BrachytherapyPostImplantDosimetry::addSeedDose( 
+			       const BrachytherapyImplantedSeed &seed,
+			       std::vector<double> &dose_distribution ) const
+{
+  unsigned mesh_x_dim = d_geometry->getOrganMeshXDim();
+  unsigned mesh_y_dim = d_geometry->getOrganMeshYDim();
+  unsigned mesh_z_dim = d_geometry->getOrganMeshZDim();
+
+  // Normalize the seed axis
+  double axis_norm = sqrt( seed.axis_x*seed.axis_x + 
+			   seed.axis_y*seed.axis_y +
+			   seed.axis_z*seed.axis_z );
+  
+  double axis_x = seed.axis_x/axis_norm;
+  double axis_y = seed.axis_y/axis_norm;
+  double axis_z = seed.axis_z/axis_norm;
+
+  // The center of the first mesh element of the region of interest
+  double x_start = (d_geometry->getROIXOffset()+0.5)*mesh_element_x_dim;
+  double y_start = (d_geometry->getROIYOffset()+0.5)*mesh_element_y_dim;
+  double z_start = (d_geometry->getROIZOffset()+0.5)*mesh_element_z_dim;
+
+  for( unsigned k = 0; k < mesh_z_dim; ++k )
+  {
+    double dz = z_start + k*mesh_element_z_dim - seed.z;
+
+    for( unsigned j = 0; j < mesh_y_dim; ++j )
+    {
+      double dy = y_start + j*mesh_element_y_dim - seed.y;
+      
+      double* dose_row = &dose_distribution[j*mesh_x_dim + 
+					    k*mesh_x_dim*mesh_y_dim];
+
+      for( unsigned i = 0; i < mesh_x_dim; ++i )
+      {
+	double dx = x_start + i*mesh_element_x_dim - seed.x;
+
+	double axial_distance = dx*axis_x + dy*axis_y + dz*axis_z;
+	
+	double radial_distance_squared = dx*dx + dy*dy + dz*dz - 
+	  axial_distance*axial_distance;
+	
+	// The seed dose is not defined along the seed axis (theta = 0) 
+	// inside of the seed, so points are never placed exactly on the axis
+	double radial_distance = (radial_distance_squared > 
+				  minimum_radial_distance_squared ?
+				  sqrt( radial_distance_squared ) : 
+				  minimum_radial_distance);
+	
+	dose_row[i] += d_seed->getTotalDose( radial_distance, 
+					     0.0, 
+					     axial_distance );
+      }
+    }
+  }
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPostImplantDosimetry.cpp
+//---------------------------------------------------------------------------//
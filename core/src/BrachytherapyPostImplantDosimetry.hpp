@@ -0,0 +1,119 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapyPostImplantDosimetry.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy post-implant dosimetry class declaration
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_POST_IMPLANT_DOSIMETRY_HPP
+#define BRACHYTHERAPY_POST_IMPLANT_DOSIMETRY_HPP
+
+// Std Lib Includes
+#include <string>
+#include <vector>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPlanEvaluator.hpp"
+#include "BrachytherapySeedFactory.hpp"
+#include "BrachytherapySeedType.hpp"
+
+namespace TPOR{
+
+//! Implanted seed position (cm) and axis direction
+struct BrachytherapyImplantedSeed
+{
+  // The seed center (cm)
+  double x;
+  double y;
+  double z;
+
+  // The seed axis direction (does not need to be normalized)
+  double axis_x;
+  double axis_y;
+  double axis_z;
+};
+
+/*! Brachytherapy post-implant dosimetry
+ *
+ * The dose from implanted seeds that do not lie on the organ mesh is 
+ * calculated by direct evaluation of the TG-43 seed dose at the center of 
+ * every mesh element of the region of interest. The seed positions are 
+ * given in the frame of the full organ mesh: the mesh element (i,j,k) spans
+ * [i*dx,(i+1)*dx) x [j*dy,(j+1)*dy) x [k*dz,(k+1)*dz), which is the frame 
+ * used by the vtk export.
+ */
+class BrachytherapyPostImplantDosimetry
+{
+
+public:
+
+  //! Constructor
+  BrachytherapyPostImplantDosimetry( 
+     const boost::shared_ptr<const BrachytherapyPatientGeometry> &geometry,
+     const BrachytherapySeedType seed_type,
+     const double air_kerma_strength );
+
+  //! Destructor
+  ~BrachytherapyPostImplantDosimetry()
+  { /* ... */ }
+
+  //! Read the implanted seeds from a text file
+  static void readImplantedSeeds( 
+			   const std::string &file_name,
+			   std::vector<BrachytherapyImplantedSeed> &seeds );
+
+  //! Calculate the dose distribution of the implanted seeds (cGy)
+  void calculateDoseDistribution( 
+			 const std::vector<BrachytherapyImplantedSeed> &seeds,
+			 std::vector<double> &dose_distribution,
+			 const unsigned number_of_threads = 0 ) const;
+
+  //! Evaluate the implanted seeds
+  void evaluateImplant( const std::vector<BrachytherapyImplantedSeed> &seeds,
+			BrachytherapyPlanMetrics &metrics,
+			const unsigned number_of_threads = 0 ) const;
+
+private:
+
+  //! Add the dose of every n-th seed, starting from the first seed
+  void addSeedDoseStride( 
+			 const std::vector<BrachytherapyImplantedSeed> &seeds,
+			 std::vector<double> &dose_distribution,
+			 const unsigned first_seed,
+			 const unsigned stride ) const;
+
+  //! Add the dose of a seed to the dose distribution
+  void addSeedDose( const BrachytherapyImplantedSeed &seed,
+		    std::vector<double> &dose_distribution ) const;
+
+  // The patient geometry
+  boost::shared_ptr<const BrachytherapyPatientGeometry> d_geometry;
+
+  // The implanted seed
+  BrachytherapySeedFactory::BrachytherapySeedPtr d_seed;
+
+  // The treatment plan evaluator
+  BrachytherapyPlanEvaluator d_evaluator;
+
+  // The mesh element dimensions (cm)
+  static const double mesh_element_x_dim;
+  static const double mesh_element_y_dim;
+  static const double mesh_element_z_dim;
+
+  // The minimum distance from the seed axis (cm)
+  static const double minimum_radial_distance;
+  static const double minimum_radial_distance_squared;
+};
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_POST_IMPLANT_DOSIMETRY_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapyPostImplantDosimetry.hpp
+//---------------------------------------------------------------------------//
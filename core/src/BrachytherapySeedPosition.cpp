@@ -66,6 +66,30 @@ double BrachytherapySeedPosition::getWeight() const
   return d_weight;
 }
 
+// Return the box of mesh indices that receive dose from this position
+DoseDistributionOverlap BrachytherapySeedPosition::getDoseDistributionOverlap(
+				      const unsigned mesh_x_dimension,
+				      const unsigned mesh_y_dimension,
+				      const unsigned mesh_z_dimension ) const
+{
+  return d_seed->getDoseDistributionOverlap( d_x_index,
+					     d_y_index,
+					     d_z_index,
+					     mesh_x_dimension,
+					     mesh_y_dimension,
+					     mesh_z_dimension );
+}
+
+// Return the contiguous x-row of seed dose starting at a mesh element
+const double* BrachytherapySeedPosition::getSeedDoseRow( const int i,
+							 const int j,
+							 const int k ) const
+{
+  return d_seed->getTotalDoseRow( i - d_x_index, 
+				  j - d_y_index, 
+				  k - d_z_index );
+}
+
 // Return the seed type
 BrachytherapySeedType BrachytherapySeedPosition::getSeedType() const
 {
@@ -78,6 +102,19 @@ std::string BrachytherapySeedPosition::getSeedName() const
   return d_seed->getSeedName();
 }
 
+// Return the seed strength
+double BrachytherapySeedPosition::getSeedStrength() const
+{
+  return d_seed->getSeedStrength();
+}
+
+// Return the seed
+const boost::shared_ptr<BrachytherapySeedProxy>& 
+BrachytherapySeedPosition::getSeedProxy() const
+{
+  return d_seed;
+}
+
 // Set the position x dimension (mesh element x dimension)
 void BrachytherapySeedPosition::setXDimension( const double x_dimension )
 {
@@ -26,6 +26,9 @@ namespace TPOR
 //! = functor
 struct Equal
 {
+  //! Mesh elements that the seed does not reach are set to zero
+  static const bool overwrite = true;
+  
   static void set( double &data, const double value )
   { data = value; }
 };
@@ -33,9 +36,22 @@ struct Equal
 //! += functor
 struct PlusEqual
 {
+  //! Mesh elements that the seed does not reach are left unchanged
+  static const bool overwrite = false;
+  
   static void set( double &data, const double value )
   { data += value; }
 };
+
+//! -= functor
+struct MinusEqual
+{
+  //! Mesh elements that the seed does not reach are left unchanged
+  static const bool overwrite = false;
+  
+  static void set( double &data, const double value )
+  { data -= value; }
+};
   
 //! Class that stores a brachytherapy seed, position indices, and weight
 class BrachytherapySeedPosition
@@ -73,6 +89,23 @@ public:
   //! Return the seed name
   std::string getSeedName() const;
 
+  //! Return the seed strength
+  double getSeedStrength() const;
+
+  //! Return the seed
+  const boost::shared_ptr<BrachytherapySeedProxy>& getSeedProxy() const;
+
+  //! Return the box of mesh indices that receive dose from this position
+  DoseDistributionOverlap getDoseDistributionOverlap( 
+				   const unsigned mesh_x_dimension,
+				   const unsigned mesh_y_dimension,
+				   const unsigned mesh_z_dimension ) const;
+
+  //! Return the contiguous x-row of seed dose starting at a mesh element
+  const double* getSeedDoseRow( const int i, 
+				const int j, 
+				const int k ) const;
+
   //! Map the dose from the seed at this position
   template<typename EqualOp>
   void mapSeedDoseDistribution( std::vector<double> &dose_mesh,
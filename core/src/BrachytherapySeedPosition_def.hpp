@@ -9,6 +9,9 @@
 #ifndef BRACHYTHERAPY_SEED_POSITION_DEF_HPP
 #define BRACHYTHERAPY_SEED_POSITION_DEF_HPP
 
+// Std Lib Includes
+#include <algorithm>
+
 namespace TPOR{
 
 // Map the dose from the seed at this position
@@ -24,21 +27,31 @@ void BrachytherapySeedPosition::mapSeedDoseDistribution(
   testPrecondition( d_y_index < mesh_y_dimension );
   testPrecondition( d_z_index < mesh_z_dimension );
 
-  for( int k = 0; k < mesh_z_dimension; ++k )
+  // Only the mesh elements that overlap the seed mesh receive dose
+  if( EqualOp::overwrite )
+    std::fill( dose_mesh.begin(), dose_mesh.end(), 0.0 );
+  
+  DoseDistributionOverlap overlap = 
+    getDoseDistributionOverlap( mesh_x_dimension,
+				mesh_y_dimension,
+				mesh_z_dimension );
+
+  if( overlap.isEmpty() )
+    return;
+  
+  const int row_length = overlap.x_end - overlap.x_start;
+  
+  for( int k = overlap.z_start; k < overlap.z_end; ++k )
   {
-    for( int j = 0; j < mesh_y_dimension; ++j )
+    for( int j = overlap.y_start; j < overlap.y_end; ++j )
     {
-      for( int i = 0; i < mesh_x_dimension; ++i )
-      {
-	unsigned index = i + j*mesh_x_dimension + 
-	  k*mesh_x_dimension*mesh_y_dimension;
-
-	double dose = d_seed->getTotalDose( i - d_x_index,
-					    j - d_y_index,
-					    k - d_z_index );
-	
-	EqualOp::set( dose_mesh[index], dose );
-      }
+      double* dose_row = &dose_mesh[overlap.x_start + j*mesh_x_dimension +
+				    k*mesh_x_dimension*mesh_y_dimension];
+
+      const double* seed_dose_row = getSeedDoseRow( overlap.x_start, j, k );
+      
+      for( int i = 0; i < row_length; ++i )
+	EqualOp::set( dose_row[i], seed_dose_row[i] );
     }
   }
 }
@@ -6,6 +6,9 @@
 //!
 //---------------------------------------------------------------------------//
 
+// Std Lib Includes
+#include <algorithm>
+
 // TPOR Includes
 #include "BrachytherapySeedProxy.hpp"
 #include "BrachytherapySeedFileHandler.hpp"
@@ -57,6 +60,59 @@ BrachytherapySeedProxy::BrachytherapySeedProxy(
   d_seed_name = brachytherapySeedName( seed_type );
 }
 
+// Constructor
+/*! \details The dose mesh is sampled at every n-th x and y index around the
+ * seed element (n is the downsampling factor), so the dose of a seed at 
+ * coarse element (i,j,k) at coarse element (i',j',k') is the dose of a seed
+ * at fine element (n*i,n*j,k) at fine element (n*i',n*j',k'). The z indices
+ * are kept.
+ */
+BrachytherapySeedProxy::BrachytherapySeedProxy( 
+				     const BrachytherapySeedProxy &seed,
+				     const unsigned downsampling_factor )
+  : d_dose_distribution_mesh(),
+    d_mesh_x_dim(),
+    d_mesh_y_dim(),
+    d_mesh_z_dim( seed.d_mesh_z_dim ),
+    d_seed_x_index( seed.d_seed_x_index/(int)downsampling_factor ),
+    d_seed_y_index( seed.d_seed_y_index/(int)downsampling_factor ),
+    d_seed_z_index( seed.d_seed_z_index ),
+    d_seed_type( seed.d_seed_type ),
+    d_seed_name( seed.d_seed_name ),
+    d_air_kerma_strength( seed.d_air_kerma_strength )
+{
+  // Make sure that the downsampling factor is valid
+  testPrecondition( downsampling_factor > 0u );
+
+  const int factor = (int)downsampling_factor;
+
+  d_mesh_x_dim = d_seed_x_index + 1 + 
+    ((int)seed.d_mesh_x_dim - 1 - seed.d_seed_x_index)/factor;
+  d_mesh_y_dim = d_seed_y_index + 1 + 
+    ((int)seed.d_mesh_y_dim - 1 - seed.d_seed_y_index)/factor;
+
+  d_dose_distribution_mesh.resize( d_mesh_x_dim*d_mesh_y_dim*d_mesh_z_dim );
+
+  for( unsigned k = 0; k < d_mesh_z_dim; ++k )
+  {
+    for( unsigned j = 0; j < d_mesh_y_dim; ++j )
+    {
+      for( unsigned i = 0; i < d_mesh_x_dim; ++i )
+      {
+	unsigned fine_i = 
+	  seed.d_seed_x_index + ((int)i - d_seed_x_index)*factor;
+	unsigned fine_j = 
+	  seed.d_seed_y_index + ((int)j - d_seed_y_index)*factor;
+	
+	d_dose_distribution_mesh[i + j*d_mesh_x_dim + 
+				 k*d_mesh_x_dim*d_mesh_y_dim] =
+	  seed.d_dose_distribution_mesh[fine_i + fine_j*seed.d_mesh_x_dim +
+				       k*seed.d_mesh_x_dim*seed.d_mesh_y_dim];
+      }
+    }
+  }
+}
+
 // Return the seed type
 BrachytherapySeedType BrachytherapySeedProxy::getSeedType() const
 {
@@ -75,6 +131,162 @@ double BrachytherapySeedProxy::getSeedStrength() const
   return d_air_kerma_strength;
 }
 
+// Return the box of mesh indices overlapped by the seed dose distribution
+// Note: (x_index,y_index,z_index) is the seed location in the mesh. Mesh 
+// elements outside of the box receive no dose from the seed.
+DoseDistributionOverlap BrachytherapySeedProxy::getDoseDistributionOverlap(
+					     const int x_index,
+					     const int y_index,
+					     const int z_index,
+					     const unsigned mesh_x_dim,
+					     const unsigned mesh_y_dim,
+					     const unsigned mesh_z_dim ) const
+{
+  DoseDistributionOverlap overlap;
+
+  overlap.x_start = std::max( 0, x_index - d_seed_x_index );
+  overlap.x_end = std::min( (int)mesh_x_dim, 
+			    x_index - d_seed_x_index + (int)d_mesh_x_dim );
+  overlap.y_start = std::max( 0, y_index - d_seed_y_index );
+  overlap.y_end = std::min( (int)mesh_y_dim, 
+			    y_index - d_seed_y_index + (int)d_mesh_y_dim );
+  overlap.z_start = std::max( 0, z_index - d_seed_z_index );
+  overlap.z_end = std::min( (int)mesh_z_dim, 
+			    z_index - d_seed_z_index + (int)d_mesh_z_dim );
+
+  return overlap;
+}
+
+// Return the box of seed positions whose dose distribution overlaps a box
+/*! \details A seed at any position in the returned box delivers dose to at
+ * least one mesh element of the dose box (the inverse of 
+ * getDoseDistributionOverlap). An empty dose box returns an empty box.
+ */
+DoseDistributionOverlap BrachytherapySeedProxy::getSeedPositionOverlap(
+				       const DoseDistributionOverlap &dose_box,
+				       const unsigned mesh_x_dim,
+				       const unsigned mesh_y_dim,
+				       const unsigned mesh_z_dim ) const
+{
+  DoseDistributionOverlap overlap;
+
+  if( dose_box.isEmpty() )
+  {
+    overlap.x_start = overlap.x_end = 0;
+    overlap.y_start = overlap.y_end = 0;
+    overlap.z_start = overlap.z_end = 0;
+
+    return overlap;
+  }
+  
+  overlap.x_start = std::max( 0, dose_box.x_start + d_seed_x_index - 
+			      (int)d_mesh_x_dim + 1 );
+  overlap.x_end = std::min( (int)mesh_x_dim, dose_box.x_end + d_seed_x_index );
+  overlap.y_start = std::max( 0, dose_box.y_start + d_seed_y_index - 
+			      (int)d_mesh_y_dim + 1 );
+  overlap.y_end = std::min( (int)mesh_y_dim, dose_box.y_end + d_seed_y_index );
+  overlap.z_start = std::max( 0, dose_box.z_start + d_seed_z_index - 
+			      (int)d_mesh_z_dim + 1 );
+  overlap.z_end = std::min( (int)mesh_z_dim, dose_box.z_end + d_seed_z_index );
+
+  return overlap;
+}
+
+// Return the box of mesh offsets (from the seed) where the dose exceeds a
+// threshold
+/*! \details The returned box contains every element of the seed dose mesh
+ * with a dose above the threshold (and the seed element). The indices are 
+ * offsets from the seed element. The seed dose is negligible outside of the 
+ * support box, which is usually much smaller than the seed dose mesh.
+ */
+DoseDistributionOverlap BrachytherapySeedProxy::getDoseSupport( 
+				       const double dose_threshold ) const
+{
+  DoseDistributionOverlap support = { 0, 1, 0, 1, 0, 1 };
+
+  for( int k = 0; k < (int)d_mesh_z_dim; ++k )
+  {
+    for( int j = 0; j < (int)d_mesh_y_dim; ++j )
+    {
+      const double* dose_row = 
+	&d_dose_distribution_mesh[(j + k*d_mesh_y_dim)*d_mesh_x_dim];
+      
+      for( int i = 0; i < (int)d_mesh_x_dim; ++i )
+      {
+	if( dose_row[i] > dose_threshold )
+	{
+	  support.x_start = std::min( support.x_start, i - d_seed_x_index );
+	  support.x_end = std::max( support.x_end, i - d_seed_x_index + 1 );
+	  support.y_start = std::min( support.y_start, j - d_seed_y_index );
+	  support.y_end = std::max( support.y_end, j - d_seed_y_index + 1 );
+	  support.z_start = std::min( support.z_start, k - d_seed_z_index );
+	  support.z_end = std::max( support.z_end, k - d_seed_z_index + 1 );
+	}
+      }
+    }
+  }
+
+  return support;
+}
+
+// Return the box of mesh indices in a dose support of a seed at a point
+DoseDistributionOverlap BrachytherapySeedProxy::getDoseSupportOverlap(
+				   const DoseDistributionOverlap &dose_support,
+				   const int x_index,
+				   const int y_index,
+				   const int z_index,
+				   const unsigned mesh_x_dim,
+				   const unsigned mesh_y_dim,
+				   const unsigned mesh_z_dim )
+{
+  DoseDistributionOverlap overlap;
+
+  overlap.x_start = std::max( 0, x_index + dose_support.x_start );
+  overlap.x_end = std::min( (int)mesh_x_dim, x_index + dose_support.x_end );
+  overlap.y_start = std::max( 0, y_index + dose_support.y_start );
+  overlap.y_end = std::min( (int)mesh_y_dim, y_index + dose_support.y_end );
+  overlap.z_start = std::max( 0, z_index + dose_support.z_start );
+  overlap.z_end = std::min( (int)mesh_z_dim, z_index + dose_support.z_end );
+
+  return overlap;
+}
+
+// Return the box of seed positions whose dose support overlaps a box
+/*! \details The dose support of a seed at any position in the returned box
+ * contains at least one mesh element of the dose box (the inverse of 
+ * getDoseSupportOverlap). An empty dose box returns an empty box.
+ */
+DoseDistributionOverlap BrachytherapySeedProxy::getSupportPositionOverlap(
+				   const DoseDistributionOverlap &dose_support,
+				   const DoseDistributionOverlap &dose_box,
+				   const unsigned mesh_x_dim,
+				   const unsigned mesh_y_dim,
+				   const unsigned mesh_z_dim )
+{
+  DoseDistributionOverlap overlap;
+
+  if( dose_box.isEmpty() )
+  {
+    overlap.x_start = overlap.x_end = 0;
+    overlap.y_start = overlap.y_end = 0;
+    overlap.z_start = overlap.z_end = 0;
+
+    return overlap;
+  }
+
+  overlap.x_start = std::max( 0, dose_box.x_start - dose_support.x_end + 1 );
+  overlap.x_end = std::min( (int)mesh_x_dim, 
+			    dose_box.x_end - dose_support.x_start );
+  overlap.y_start = std::max( 0, dose_box.y_start - dose_support.y_end + 1 );
+  overlap.y_end = std::min( (int)mesh_y_dim, 
+			    dose_box.y_end - dose_support.y_start );
+  overlap.z_start = std::max( 0, dose_box.z_start - dose_support.z_end + 1 );
+  overlap.z_end = std::min( (int)mesh_z_dim, 
+			    dose_box.z_end - dose_support.z_start );
+
+  return overlap;
+}
+
 } // end TPOR namespace
 
 //---------------------------------------------------------------------------//
@@ -20,6 +20,21 @@
 
 namespace TPOR{
 
+//! Box of mesh indices [start,end) overlapped by a seed dose distribution
+struct DoseDistributionOverlap
+{
+  int x_start;
+  int x_end;
+  int y_start;
+  int y_end;
+  int z_start;
+  int z_end;
+
+  //! Check if the overlap box is empty
+  bool isEmpty() const
+  { return x_start >= x_end || y_start >= y_end || z_start >= z_end; }
+};
+
 //! Brachytherapy seed proxy class
 class BrachytherapySeedProxy 
 {
@@ -31,6 +46,10 @@ public:
 			  const BrachytherapySeedType seed_type,
 			  const double air_kerma_strength );
 
+  //! Constructor (downsampled in-plane copy of a seed)
+  BrachytherapySeedProxy( const BrachytherapySeedProxy &seed,
+			  const unsigned downsampling_factor );
+
   //! Return the seed type
   BrachytherapySeedType getSeedType() const;
 
@@ -45,6 +64,49 @@ public:
 		       const int y,
 		       const int z ) const;
 
+  //! Return a pointer to the contiguous x-row of the dose mesh at a point
+  const double* getTotalDoseRow( const int x,
+				 const int y,
+				 const int z ) const;
+
+  //! Return the box of mesh indices overlapped by the seed dose distribution
+  DoseDistributionOverlap getDoseDistributionOverlap( 
+					     const int x_index,
+					     const int y_index,
+					     const int z_index,
+					     const unsigned mesh_x_dim,
+					     const unsigned mesh_y_dim,
+					     const unsigned mesh_z_dim ) const;
+
+  //! Return the box of seed positions whose dose distribution overlaps a box
+  DoseDistributionOverlap getSeedPositionOverlap( 
+				  const DoseDistributionOverlap &dose_box,
+				  const unsigned mesh_x_dim,
+				  const unsigned mesh_y_dim,
+				  const unsigned mesh_z_dim ) const;
+
+  //! Return the box of mesh offsets (from the seed) where the dose exceeds
+  //! a threshold
+  DoseDistributionOverlap getDoseSupport( const double dose_threshold ) const;
+
+  //! Return the box of mesh indices in a dose support of a seed at a point
+  static DoseDistributionOverlap getDoseSupportOverlap( 
+				   const DoseDistributionOverlap &dose_support,
+				   const int x_index,
+				   const int y_index,
+				   const int z_index,
+				   const unsigned mesh_x_dim,
+				   const unsigned mesh_y_dim,
+				   const unsigned mesh_z_dim );
+
+  //! Return the box of seed positions whose dose support overlaps a box
+  static DoseDistributionOverlap getSupportPositionOverlap( 
+				   const DoseDistributionOverlap &dose_support,
+				   const DoseDistributionOverlap &dose_box,
+				   const unsigned mesh_x_dim,
+				   const unsigned mesh_y_dim,
+				   const unsigned mesh_z_dim );
+
 private:
 
   // The seed dose distribution mesh
@@ -88,6 +150,26 @@ inline double BrachytherapySeedProxy::getTotalDose( const int x,
 				  (d_seed_z_index+z)*d_mesh_x_dim*d_mesh_y_dim];
 }
 
+// Return a pointer to the contiguous x-row of the dose mesh at a point
+// Note: the row runs from the point to the +x edge of the seed mesh (cGy)
+inline const double* BrachytherapySeedProxy::getTotalDoseRow( 
+							  const int x,
+							  const int y,
+							  const int z ) const
+{
+  // Make sure the x, y, and z indices are in range
+  testPrecondition( d_seed_x_index + x >= 0 );
+  testPrecondition( d_seed_x_index + x < (int)d_mesh_x_dim );
+  testPrecondition( d_seed_y_index + y >= 0 );
+  testPrecondition( d_seed_y_index + y < (int)d_mesh_y_dim );
+  testPrecondition( d_seed_z_index + z >= 0 );
+  testPrecondition( d_seed_z_index + z < (int)d_mesh_z_dim );
+
+  return &d_dose_distribution_mesh[(d_seed_x_index+x)+
+				   (d_seed_y_index+y)*d_mesh_x_dim+
+				   (d_seed_z_index+z)*d_mesh_x_dim*d_mesh_y_dim];
+}
+
 } // end TPOR namespace
 
 #endif // end BRACHYTHERAPY_SEED_PROXY_HPP
@@ -0,0 +1,118 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   BrachytherapySeedRecord.hpp
+//! \author Alex Robinson
+//! \brief  Brachytherapy seed record struct declaration and HDF5 traits.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef BRACHYTHERAPY_SEED_RECORD_HPP
+#define BRACHYTHERAPY_SEED_RECORD_HPP
+
+// HDF5 Includes
+#include <H5Cpp.h>
+
+// TPOR Includes
+#include "HDF5TypeTraits.hpp"
+#include "ExceptionCatchMacros.hpp"
+
+namespace TPOR{
+
+/*! Brachytherapy seed record
+ *
+ * A seed record stores an inserted seed of a treatment plan in a form that
+ * can be written to (and read from) an HDF5 file as a compound type. The
+ * mesh indices are relative to the full organ mesh.
+ */
+struct BrachytherapySeedRecord
+{
+  // The needle id (1 is the first needle that was inserted)
+  unsigned needle_id;
+
+  // The x index of the seed
+  unsigned x_index;
+
+  // The y index of the seed
+  unsigned y_index;
+
+  // The z index of the seed
+  unsigned z_index;
+
+  // The seed type (BrachytherapySeedType)
+  unsigned seed_type;
+
+  // The seed air kerma strength
+  double seed_strength;
+};
+
+namespace Traits{
+
+/*! \brief The specialization of the TPOR::HDF5TypeTraits for the
+ * TPOR::BrachytherapySeedRecord struct
+ * \ingroup hdf5_type_traits
+ */
+template<>
+struct HDF5TypeTraits<BrachytherapySeedRecord>
+{
+  //! Return the HDF5 data type object corresponding to the seed record
+  static inline H5::CompType dataType()
+  {
+    H5::CompType memtype( sizeof(BrachytherapySeedRecord) );
+
+    // The insertMember function can throw H5::DataTypeIException exceptions
+    try
+    {
+      memtype.insertMember( "needle_id",
+			    HOFFSET( BrachytherapySeedRecord, needle_id ),
+			    HDF5TypeTraits<unsigned>::dataType() );
+      
+      memtype.insertMember( "x_index",
+			    HOFFSET( BrachytherapySeedRecord, x_index ),
+			    HDF5TypeTraits<unsigned>::dataType() );
+
+      memtype.insertMember( "y_index",
+			    HOFFSET( BrachytherapySeedRecord, y_index ),
+			    HDF5TypeTraits<unsigned>::dataType() );
+
+      memtype.insertMember( "z_index",
+			    HOFFSET( BrachytherapySeedRecord, z_index ),
+			    HDF5TypeTraits<unsigned>::dataType() );
+
+      memtype.insertMember( "seed_type",
+			    HOFFSET( BrachytherapySeedRecord, seed_type ),
+			    HDF5TypeTraits<unsigned>::dataType() );
+
+      memtype.insertMember( "seed_strength",
+			    HOFFSET( BrachytherapySeedRecord, seed_strength ),
+			    HDF5TypeTraits<double>::dataType() );
+    }
+
+    HDF5_EXCEPTION_CATCH_AND_EXIT();
+
+    return memtype;
+  }
+
+  //! Returns the zero value for this type
+  static inline BrachytherapySeedRecord zero()
+  {
+    BrachytherapySeedRecord record = {0u, 0u, 0u, 0u, 0u, 0.0};
+    return record;
+  }
+
+  //! Returns the unity value for this type
+  static inline BrachytherapySeedRecord one()
+  {
+    BrachytherapySeedRecord record = {1u, 1u, 1u, 1u, 1u, 1.0};
+    return record;
+  }
+};
+
+} // end Traits namespace
+
+} // end TPOR namespace
+
+#endif // end BRACHYTHERAPY_SEED_RECORD_HPP
+
+//---------------------------------------------------------------------------//
+// end BrachytherapySeedRecord.hpp
+//---------------------------------------------------------------------------//
@@ -11,6 +11,7 @@
 #include "IIEMTreatmentPlanner.hpp"
 #include "DWDMMTreatmentPlanner.hpp"
 #include "SCMTreatmentPlanner.hpp"
+#include "CoarseToFineTreatmentPlanner.hpp"
 #include "ContractException.hpp"
 
 
@@ -19,32 +20,87 @@ namespace TPOR{
 // Constructor
 BrachytherapyTreatmentPlannerFactory::BrachytherapyTreatmentPlannerFactory(
 	 const boost::shared_ptr<BrachytherapyPatient> &patient,
-	 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds )
+	 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	 const bool lazy_set_cover_evaluation,
+	 const BrachytherapyDoseMatrixSettings &dose_matrix_settings,
+	 const unsigned number_of_threads,
+	 const bool coarse_to_fine,
+	 const bool coarse_to_fine_fallback,
+	 const bool iiem_trial_search,
+	 const unsigned iiem_verification_window )
   : d_patient( patient ),
-    d_seeds( seeds )
+    d_seeds( seeds ),
+    d_lazy_set_cover_evaluation( lazy_set_cover_evaluation ),
+    d_dose_matrix_settings( dose_matrix_settings ),
+    d_number_of_threads( number_of_threads ),
+    d_coarse_to_fine( coarse_to_fine ),
+    d_coarse_to_fine_fallback( coarse_to_fine_fallback ),
+    d_iiem_trial_search( iiem_trial_search ),
+    d_iiem_verification_window( iiem_verification_window )
 { 
   // Make sure that at least one seed has been requested
   testPrecondition( seeds.size() > 0 );
 }
 
 // Brachytherapy treatment planner construction method 
+/*! \details The candidate seed positions of the planner are restricted to
+ * the needle template positions in the candidate needle mask (indexed by 
+ * needle index) if the mask is not empty. If coarse-to-fine planning was 
+ * requested the planner is wrapped in a coarse-to-fine planner, which 
+ * creates the planners of each pass with a copy of this factory (the 
+ * candidate needle mask must be empty).
+ */
 BrachytherapyTreatmentPlannerFactory::BrachytherapyTreatmentPlannerPtr 
 BrachytherapyTreatmentPlannerFactory::createTreatmentPlanner(
-			 const BrachytherapyTreatmentPlannerType planner_type )
+			 const BrachytherapyTreatmentPlannerType planner_type,
+			 const std::vector<bool> &candidate_needle_mask )
 {
+  // Make sure that the candidate needle mask is valid
+  testPrecondition( !d_coarse_to_fine || candidate_needle_mask.empty() );
+
   BrachytherapyTreatmentPlannerFactory::BrachytherapyTreatmentPlannerPtr
     treatment_planner;
+
+  if( d_coarse_to_fine )
+  {
+    BrachytherapyTreatmentPlannerFactory pass_factory( *this );
+    pass_factory.d_coarse_to_fine = false;
+
+    treatment_planner.reset( 
+	       new CoarseToFineTreatmentPlanner( d_patient,
+						 pass_factory,
+						 planner_type,
+						 d_coarse_to_fine_fallback ) );
+
+    return treatment_planner;
+  }
   
   switch( planner_type )
   {
   case IIEM_TREATMENT_PLANNER:
-    treatment_planner.reset( new IIEMTreatmentPlanner( d_patient, d_seeds[0]));
+    treatment_planner.reset( 
+		     new IIEMTreatmentPlanner( d_patient, 
+					       d_seeds[0],
+					       d_dose_matrix_settings,
+					       d_number_of_threads,
+					       d_iiem_trial_search,
+					       d_iiem_verification_window,
+					       candidate_needle_mask ) );
     break;
   case DWDMM_TREATMENT_PLANNER:
-    treatment_planner.reset( new DWDMMTreatmentPlanner( d_patient, d_seeds ) );
+    treatment_planner.reset( 
+		     new DWDMMTreatmentPlanner( d_patient, 
+						d_seeds,
+						candidate_needle_mask ) );
     break;
   case SCM_TREATMENT_PLANNER:
-    treatment_planner.reset( new SCMTreatmentPlanner( d_patient, d_seeds ) );
+    treatment_planner.reset( 
+		     new SCMTreatmentPlanner( d_patient, 
+					      d_seeds,
+					      d_lazy_set_cover_evaluation,
+					      d_dose_matrix_settings,
+					      d_number_of_threads,
+					      candidate_needle_mask ) );
     break;
   }
 
@@ -54,6 +110,44 @@ BrachytherapyTreatmentPlannerFactory::createTreatmentPlanner(
   return treatment_planner;
 }
 
+// Create a factory for an in-plane downsampled copy of the patient
+/*! \details The patient geometry and the seeds are downsampled (see the 
+ * downsampling constructors of BrachytherapyPatientGeometry and 
+ * BrachytherapySeedProxy) and the new patient has no treatment plan. All of
+ * the planner options are kept.
+ */
+BrachytherapyTreatmentPlannerFactory 
+BrachytherapyTreatmentPlannerFactory::createDownsampledFactory(
+				   const unsigned downsampling_factor ) const
+{
+  // Make sure that the downsampling factor is valid
+  testPrecondition( downsampling_factor > 0u );
+
+  BrachytherapyTreatmentPlannerFactory downsampled_factory( *this );
+
+  boost::shared_ptr<const BrachytherapyPatientGeometry> geometry(
+		 new BrachytherapyPatientGeometry( *d_patient->getGeometry(),
+						   downsampling_factor ) );
+
+  downsampled_factory.d_patient.reset( new BrachytherapyPatient( geometry ) );
+
+  for( unsigned s = 0; s < d_seeds.size(); ++s )
+  {
+    downsampled_factory.d_seeds[s].reset( 
+			new BrachytherapySeedProxy( *d_seeds[s], 
+						    downsampling_factor ) );
+  }
+
+  return downsampled_factory;
+}
+
+// Return the patient
+const boost::shared_ptr<BrachytherapyPatient>& 
+BrachytherapyTreatmentPlannerFactory::getPatient() const
+{
+  return d_patient;
+}
+
 } // end TPOR namespace
 
 //---------------------------------------------------------------------------//
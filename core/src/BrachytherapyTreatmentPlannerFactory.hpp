@@ -20,6 +20,7 @@
 #include "BrachytherapyTreatmentPlanner.hpp"
 #include "BrachytherapyTreatmentPlannerType.hpp"
 #include "BrachytherapyPatient.hpp"
+#include "BrachytherapyDoseMatrix.hpp"
 
 namespace TPOR{
 
@@ -35,7 +36,15 @@ public:
   //! Constructor
   BrachytherapyTreatmentPlannerFactory( 
 	const boost::shared_ptr<BrachytherapyPatient> &patient,
-        const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds );
+        const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	const bool lazy_set_cover_evaluation = true,
+	const BrachytherapyDoseMatrixSettings &dose_matrix_settings = 
+	BrachytherapyDoseMatrixSettings(),
+	const unsigned number_of_threads = 0u,
+	const bool coarse_to_fine = false,
+	const bool coarse_to_fine_fallback = false,
+	const bool iiem_trial_search = false,
+	const unsigned iiem_verification_window = 0u );
 
   //! Destructor
   ~BrachytherapyTreatmentPlannerFactory()
@@ -43,7 +52,16 @@ public:
 
   //! Brachytherapy treatment planner construction method
   BrachytherapyTreatmentPlannerPtr createTreatmentPlanner(
-			const BrachytherapyTreatmentPlannerType planner_type );
+			const BrachytherapyTreatmentPlannerType planner_type,
+			const std::vector<bool> &candidate_needle_mask = 
+			std::vector<bool>() );
+
+  //! Create a factory for an in-plane downsampled copy of the patient
+  BrachytherapyTreatmentPlannerFactory createDownsampledFactory(
+			const unsigned downsampling_factor ) const;
+
+  //! Return the patient
+  const boost::shared_ptr<BrachytherapyPatient>& getPatient() const;
 
 private:
 
@@ -52,6 +70,27 @@ private:
 
   // Seeds
   std::vector<boost::shared_ptr<BrachytherapySeedProxy> > d_seeds;
+
+  // Evaluate the set cover candidates lazily (SCM)
+  bool d_lazy_set_cover_evaluation;
+
+  // The dose matrix settings (IIEM and SCM)
+  BrachytherapyDoseMatrixSettings d_dose_matrix_settings;
+
+  // The number of threads used by the planners (0 = all hardware threads)
+  unsigned d_number_of_threads;
+
+  // Wrap the planners in a coarse-to-fine planner
+  bool d_coarse_to_fine;
+
+  // Plan with all of the candidates if a coarse-to-fine plan fails
+  bool d_coarse_to_fine_fallback;
+
+  // Search the trials (IIEM)
+  bool d_iiem_trial_search;
+
+  // The search verification window (IIEM)
+  unsigned d_iiem_verification_window;
 };
 
 } // end TPOR namespace
@@ -0,0 +1,338 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   CoarseToFineTreatmentPlanner.cpp
+//! \author Alex Robinson
+//! \brief  Coarse-to-fine brachytherapy treatment planner class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <limits>
+#include <list>
+
+// Boost Includes
+#include <boost/chrono.hpp>
+
+// TPOR Includes
+#include "CoarseToFineTreatmentPlanner.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Initialize the static member data
+const unsigned CoarseToFineTreatmentPlanner::no_rank =
+  std::numeric_limits<unsigned>::max();
+
+// Constructor
+/*! \details The planner factory must not create coarse-to-fine planners.
+ * A fine template position is kept if its template column and row are at
+ * most the needle neighbourhood away from the column and row of a template
+ * position covered by a coarse needle.
+ */
+CoarseToFineTreatmentPlanner::CoarseToFineTreatmentPlanner(
+		 const boost::shared_ptr<BrachytherapyPatient> &patient,
+		 const BrachytherapyTreatmentPlannerFactory &planner_factory,
+		 const BrachytherapyTreatmentPlannerType planner_type,
+		 const bool full_template_fallback,
+		 const unsigned downsampling_factor,
+		 const unsigned needle_neighbourhood )
+  : d_patient( patient ),
+    d_planner_factory( planner_factory ),
+    d_planner_type( planner_type ),
+    d_full_template_fallback( full_template_fallback ),
+    d_downsampling_factor( downsampling_factor ),
+    d_needle_neighbourhood( needle_neighbourhood ),
+    d_prostate_needles(),
+    d_column_ranks(),
+    d_row_ranks(),
+    d_number_of_coarse_needles( 0u ),
+    d_number_of_fine_template_positions( 0u ),
+    d_full_template_planned( false ),
+    d_full_template_used( false ),
+    d_opt_time( 0.0 )
+{
+  // Make sure that the downsampling factor is valid
+  testPrecondition( downsampling_factor > 0u );
+
+  rankTemplatePositions();
+}
+
+// Calculate optimum treatment plan
+/*! \details If the coarse plan does not reach the prostate coverage goal or
+ * no template position is found around the coarse needles the fine plan is
+ * made with all of the candidates.
+ */
+void CoarseToFineTreatmentPlanner::calculateOptimumTreatmentPlan()
+{
+  boost::chrono::steady_clock::time_point start_clock =
+    boost::chrono::steady_clock::now();
+
+  // Plan on the downsampled mesh
+  std::cout << std::endl 
+	    << "conducting coarse treatment plan optimization..." 
+	    << std::endl;
+
+  BrachytherapyTreatmentPlannerFactory coarse_factory = 
+    d_planner_factory.createDownsampledFactory( d_downsampling_factor );
+
+  coarse_factory.createTreatmentPlanner( d_planner_type )->
+    calculateOptimumTreatmentPlan();
+
+  std::vector<unsigned> coarse_needles;
+
+  coarse_factory.getPatient()->getInsertedNeedles( coarse_needles );
+
+  d_number_of_coarse_needles = coarse_needles.size();
+
+  // Plan on the full mesh with the template positions around the coarse 
+  // needles (the needles of a failed coarse plan are not used)
+  std::vector<bool> needle_mask;
+
+  if( coarse_factory.getPatient()->getProstatePrescribedDoseCoverage() >= 
+      0.98 )
+  {
+    createFineNeedleMask( coarse_needles,
+			  coarse_factory.getPatient()->getOrganMeshXDim(),
+			  needle_mask );
+  }
+  else
+  {
+    std::cout << "Warning: The coarse treatment plan did not reach the "
+	      << "prostate coverage goal. All of the candidates will be "
+	      << "used by the fine treatment plan." << std::endl;
+  }
+
+  d_number_of_fine_template_positions = 
+    std::count( needle_mask.begin(), needle_mask.end(), true );
+
+  d_full_template_used = d_number_of_fine_template_positions == 0u;
+  d_full_template_planned = d_full_template_used;
+
+  if( d_full_template_used )
+    needle_mask.clear();
+  
+  std::cout << std::endl 
+	    << "conducting fine treatment plan optimization..." 
+	    << std::endl;
+
+  d_patient->resetState();
+
+  d_planner_factory.createTreatmentPlanner( d_planner_type, needle_mask )->
+    calculateOptimumTreatmentPlan();
+
+  // Plan with all of the candidates if the fine plan failed (the plan with
+  // the highest prostate coverage is kept)
+  double fine_coverage = d_patient->getProstatePrescribedDoseCoverage();
+  
+  if( d_full_template_fallback && !d_full_template_used && 
+      fine_coverage < 0.98 )
+  {
+    std::list<BrachytherapySeedPosition> fine_plan = 
+      d_patient->getTreatmentPlan();
+    
+    std::cout << std::endl << "conducting full treatment plan optimization..."
+	      << std::endl;
+
+    d_patient->resetState();
+
+    d_planner_factory.createTreatmentPlanner( d_planner_type )->
+      calculateOptimumTreatmentPlan();
+
+    d_full_template_planned = true;
+    d_full_template_used = true;
+
+    if( d_patient->getProstatePrescribedDoseCoverage() < fine_coverage )
+    {
+      d_patient->resetState();
+
+      std::list<BrachytherapySeedPosition>::const_iterator seed_position = 
+	fine_plan.begin();
+
+      while( seed_position != fine_plan.end() )
+      {
+	d_patient->insertSeed( *seed_position );
+
+	++seed_position;
+      }
+
+      d_full_template_used = false;
+    }
+  }
+
+  boost::chrono::duration<double> seconds =
+    boost::chrono::steady_clock::now() - start_clock;
+
+  // Store the optimization time
+  d_opt_time = seconds.count();
+
+  // Print the treatment plan summary
+  printTreatmentPlanSummary( std::cout );
+}
+
+// Return the number of needles in the coarse plan
+unsigned CoarseToFineTreatmentPlanner::getNumberOfCoarseNeedles() const
+{
+  return d_number_of_coarse_needles;
+}
+
+// Return the number of template positions used by the fine plan
+/*! \details Zero is returned if the fine plan was made with all of the
+ * candidates.
+ */
+unsigned 
+CoarseToFineTreatmentPlanner::getNumberOfFineTemplatePositions() const
+{
+  return d_number_of_fine_template_positions;
+}
+
+// Test if the plan was made with all of the candidates
+bool CoarseToFineTreatmentPlanner::isFullTemplateUsed() const
+{
+  return d_full_template_used;
+}
+
+// Rank the needle template columns and rows
+/*! \details Only the needle template positions that cross the prostate are
+ * considered. The template columns (rows) are the x (y) indices that hold at
+ * least one of these positions. They are ranked in increasing order.
+ */
+void CoarseToFineTreatmentPlanner::rankTemplatePositions()
+{
+  const unsigned mesh_x_dim = d_patient->getOrganMeshXDim();
+  const unsigned mesh_y_dim = d_patient->getOrganMeshYDim();
+
+  const std::vector<bool> &prostate_mask = d_patient->getProstateMask();
+  const std::vector<bool> &needle_template = 
+    d_patient->getGeometry()->getNeedleTemplate();
+
+  d_prostate_needles.assign( mesh_x_dim*mesh_y_dim, false );
+
+  std::vector<bool> template_columns( mesh_x_dim, false );
+  std::vector<bool> template_rows( mesh_y_dim, false );
+
+  for( unsigned index = 0; index < prostate_mask.size(); ++index )
+  {
+    unsigned needle_index = index % (mesh_x_dim*mesh_y_dim);
+    
+    if( prostate_mask[index] && needle_template[needle_index] )
+    {
+      d_prostate_needles[needle_index] = true;
+      template_columns[needle_index % mesh_x_dim] = true;
+      template_rows[needle_index / mesh_x_dim] = true;
+    }
+  }
+
+  d_column_ranks.assign( mesh_x_dim, no_rank );
+  d_row_ranks.assign( mesh_y_dim, no_rank );
+
+  unsigned rank = 0u;
+
+  for( unsigned i = 0; i < mesh_x_dim; ++i )
+  {
+    if( template_columns[i] )
+      d_column_ranks[i] = rank++;
+  }
+
+  rank = 0u;
+
+  for( unsigned j = 0; j < mesh_y_dim; ++j )
+  {
+    if( template_rows[j] )
+      d_row_ranks[j] = rank++;
+  }
+}
+
+// Create the mask of the template positions around the coarse needles
+/*! \details A coarse needle covers the template positions of the fine mesh
+ * elements that were downsampled to it. A template position (that crosses 
+ * the prostate) is kept if its template column and row are at most the 
+ * needle neighbourhood away from the column and row of one of the covered 
+ * template positions.
+ */
+void CoarseToFineTreatmentPlanner::createFineNeedleMask(
+				   const std::vector<unsigned> &coarse_needles,
+				   const unsigned coarse_mesh_x_dim,
+				   std::vector<bool> &needle_mask ) const
+{
+  const unsigned mesh_x_dim = d_column_ranks.size();
+  const unsigned mesh_y_dim = d_row_ranks.size();
+
+  // Find the template positions covered by the coarse needles
+  std::vector<unsigned> needles;
+
+  for( unsigned n = 0; n < coarse_needles.size(); ++n )
+  {
+    unsigned coarse_i = coarse_needles[n] % coarse_mesh_x_dim;
+    unsigned coarse_j = coarse_needles[n] / coarse_mesh_x_dim;
+
+    for( unsigned j = coarse_j*d_downsampling_factor; 
+	 j < std::min( (coarse_j+1)*d_downsampling_factor, mesh_y_dim );
+	 ++j )
+    {
+      for( unsigned i = coarse_i*d_downsampling_factor; 
+	   i < std::min( (coarse_i+1)*d_downsampling_factor, mesh_x_dim );
+	   ++i )
+      {
+	if( d_prostate_needles[i + j*mesh_x_dim] )
+	  needles.push_back( i + j*mesh_x_dim );
+      }
+    }
+  }
+
+  needle_mask.assign( mesh_x_dim*mesh_y_dim, false );
+
+  for( unsigned n = 0; n < needles.size(); ++n )
+  {
+    unsigned needle_column_rank = d_column_ranks[needles[n] % mesh_x_dim];
+    unsigned needle_row_rank = d_row_ranks[needles[n] / mesh_x_dim];
+
+    for( unsigned j = 0; j < mesh_y_dim; ++j )
+    {
+      if( d_row_ranks[j] == no_rank ||
+	  d_row_ranks[j] + d_needle_neighbourhood < needle_row_rank ||
+	  needle_row_rank + d_needle_neighbourhood < d_row_ranks[j] )
+	continue;
+
+      for( unsigned i = 0; i < mesh_x_dim; ++i )
+      {
+	if( d_column_ranks[i] == no_rank ||
+	    d_column_ranks[i] + d_needle_neighbourhood < needle_column_rank ||
+	    needle_column_rank + d_needle_neighbourhood < d_column_ranks[i] )
+	  continue;
+
+	needle_mask[i + j*mesh_x_dim] = d_prostate_needles[i + j*mesh_x_dim];
+      }
+    }
+  }
+}
+
+// Print the treatment plan summary
+void CoarseToFineTreatmentPlanner::printTreatmentPlanSummary(
+						     std::ostream &os ) const
+{
+  os.precision( 3 );
+  os.setf( std::ios::fixed, std::ios::floatfield );
+  os << "...Coarse-To-Fine Treatment Plan Summary..." << std::endl;
+  os << "Plan Optimization Time (s): " << d_opt_time << std::endl;
+  os << "Downsampling Factor:        " << d_downsampling_factor
+     << std::endl;
+  os << "Coarse Needles Chosen:      " << d_number_of_coarse_needles
+     << std::endl;
+  os << "Fine Template Positions:    " << d_number_of_fine_template_positions
+     << std::endl;
+  os << "Full Template Planned:      " 
+     << (d_full_template_planned ? "Yes" : "No") << std::endl;
+  os << "Full Template Used:         " << (d_full_template_used ? "Yes" : "No")
+     << std::endl;
+  os << "Needles Chosen:             " << d_patient->getNumInsertedNeedles()
+     << std::endl;
+  os << "Seeds Chosen:               " << d_patient->getNumInsertedSeeds()
+     << std::endl;
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end CoarseToFineTreatmentPlanner.cpp
+//---------------------------------------------------------------------------//
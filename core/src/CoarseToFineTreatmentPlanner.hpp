@@ -0,0 +1,134 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   CoarseToFineTreatmentPlanner.hpp
+//! \author Alex Robinson
+//! \brief  Coarse-to-fine brachytherapy treatment planner class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef COARSE_TO_FINE_TREATMENT_PLANNER_HPP
+#define COARSE_TO_FINE_TREATMENT_PLANNER_HPP
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+
+// TPOR Includes
+#include "BrachytherapyTreatmentPlanner.hpp"
+#include "BrachytherapyTreatmentPlannerFactory.hpp"
+#include "BrachytherapyTreatmentPlannerType.hpp"
+#include "BrachytherapyPatient.hpp"
+
+namespace TPOR{
+
+/*! Coarse-to-fine treatment planner
+ *
+ * Any of the treatment planners is first run on a copy of the patient that
+ * is downsampled in-plane (e.g. 2 mm x 2 mm x 5 mm mesh elements), with seed
+ * dose kernels that are resampled on the same mesh. The planner is then run
+ * on the full mesh with only the candidates on the needle template positions
+ * around the needles of the coarse plan (all of the candidates are used if
+ * the coarse plan does not reach the prostate coverage goal). If the fine
+ * plan does not reach the prostate coverage goal the planner can optionally
+ * be run a last time with all of the candidates - the plan with the highest
+ * coverage is kept.
+ */
+class CoarseToFineTreatmentPlanner : public BrachytherapyTreatmentPlanner
+{
+
+public:
+
+  //! Constructor
+  CoarseToFineTreatmentPlanner(
+		 const boost::shared_ptr<BrachytherapyPatient> &patient,
+		 const BrachytherapyTreatmentPlannerFactory &planner_factory,
+		 const BrachytherapyTreatmentPlannerType planner_type,
+		 const bool full_template_fallback = false,
+		 const unsigned downsampling_factor = 2u,
+		 const unsigned needle_neighbourhood = 1u );
+
+  //! Destructor
+  ~CoarseToFineTreatmentPlanner()
+  { /* ... */ }
+
+  //! Calculate optimum treatment plan
+  void calculateOptimumTreatmentPlan();
+
+  //! Return the number of needles in the coarse plan
+  unsigned getNumberOfCoarseNeedles() const;
+
+  //! Return the number of template positions used by the fine plan
+  unsigned getNumberOfFineTemplatePositions() const;
+
+  //! Test if the plan was made with all of the candidates
+  bool isFullTemplateUsed() const;
+
+private:
+
+  //! Rank the needle template columns and rows
+  void rankTemplatePositions();
+
+  //! Create the mask of the template positions around the coarse needles
+  void createFineNeedleMask( const std::vector<unsigned> &coarse_needles,
+			     const unsigned coarse_mesh_x_dim,
+			     std::vector<bool> &needle_mask ) const;
+
+  //! Print the treatment plan summary
+  void printTreatmentPlanSummary( std::ostream &os ) const;
+
+  // The value that marks a column or row without template positions
+  static const unsigned no_rank;
+
+  // The patient
+  boost::shared_ptr<BrachytherapyPatient> d_patient;
+
+  // The factory of the planners used by each pass
+  BrachytherapyTreatmentPlannerFactory d_planner_factory;
+
+  // The planner type
+  BrachytherapyTreatmentPlannerType d_planner_type;
+
+  // Plan with all of the candidates if the fine plan fails
+  bool d_full_template_fallback;
+
+  // The in-plane downsampling factor of the coarse mesh
+  unsigned d_downsampling_factor;
+
+  // The fine needle neighbourhood (in template positions)
+  unsigned d_needle_neighbourhood;
+
+  // The needle template positions that cross the prostate
+  std::vector<bool> d_prostate_needles;
+
+  // The rank of each mesh column (x index) among the template columns
+  std::vector<unsigned> d_column_ranks;
+
+  // The rank of each mesh row (y index) among the template rows
+  std::vector<unsigned> d_row_ranks;
+
+  // The number of needles in the coarse plan
+  unsigned d_number_of_coarse_needles;
+
+  // The number of template positions used by the fine plan
+  unsigned d_number_of_fine_template_positions;
+
+  // The planner was run with all of the candidates
+  bool d_full_template_planned;
+
+  // The plan was made with all of the candidates
+  bool d_full_template_used;
+
+  // Optimization time
+  double d_opt_time;
+};
+
+} // end TPOR namespace
+
+#endif // end COARSE_TO_FINE_TREATMENT_PLANNER_HPP
+
+//---------------------------------------------------------------------------//
+// end CoarseToFineTreatmentPlanner.hpp
+//---------------------------------------------------------------------------//
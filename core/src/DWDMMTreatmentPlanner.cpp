@@ -25,21 +25,49 @@ namespace TPOR{
 // Initialize the name static member
 const std::string DWDMMTreatmentPlanner::name = "DWDMMTreatmentPlanner";
 
+// Initialize the support dose fraction static member
+const double DWDMMTreatmentPlanner::support_dose_fraction = 0.01;
+
 // Constructor
 DWDMMTreatmentPlanner::DWDMMTreatmentPlanner( 
 	 const boost::shared_ptr<BrachytherapyPatient> &patient,
-	 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds )
+	 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	 const std::vector<bool> &candidate_needle_mask )
   : d_patient( patient ),
     d_opt_time( 0.0 ),
-    d_seed_positions()
+    d_candidates( patient->getOrganMeshXDim(),
+		  patient->getOrganMeshYDim(),
+		  patient->getOrganMeshZDim() ),
+    d_dose_supports(),
+    d_number_of_updates( 0u ),
+    d_weight_updates(),
+    d_occupied_candidates(),
+    d_skipped_candidates(),
+    d_penalized_candidates(),
+    d_updated_candidates()
 {
-  // Get the potential seed positions
-  typedef BrachytherapyDynamicWeightSeedPosition SeedPosition;
-  
-  std::list<SeedPosition> seed_positions =
-    d_patient->getPotentialSeedPositions<SeedPosition>( seeds );
+  // Get the candidate seed positions
+  d_patient->getCandidateSeedPositions( seeds, 
+					d_candidates,
+					candidate_needle_mask );
+
+  // Queue the candidates by dynamic weight and index their positions
+  d_candidates.enableDynamicWeightQueue();
+  d_candidates.buildPositionIndex();
+
+  // Find the dose support of each seed
+  const double dose_threshold = 
+    support_dose_fraction*d_patient->getPrescribedDose();
   
-  d_seed_positions.splice( d_seed_positions.end(), seed_positions );
+  for( unsigned seed_id = 0; seed_id < d_candidates.getNumberOfSeeds();
+       ++seed_id )
+  {
+    d_dose_supports.push_back( d_candidates.getSeedWithId( seed_id )->
+			       getDoseSupport( dose_threshold ) );
+  }
+
+  // The base weights are up to date until the first update
+  d_weight_updates.resize( d_candidates.getNumberOfCandidates(), 0u );
 }
 
 // Calculate optimum treatment plan
@@ -51,30 +79,26 @@ void DWDMMTreatmentPlanner::calculateOptimumTreatmentPlan()
   boost::chrono::steady_clock::time_point start_clock = 
     boost::chrono::steady_clock::now();
   
-  std::list<BrachytherapyDynamicWeightSeedPosition>::iterator position;
+  unsigned candidate;
   
   // Select the first seed position
-  position = min_element( d_seed_positions.begin(), d_seed_positions.end() );
-  d_patient->insertSeed( *position );
-  position = d_seed_positions.erase( position );
-  updateSeedPositions();
+  candidate = selectCandidate();
+  insertSeed( candidate );
   
   // Select the seed position with the smallest weight until 98% of the
   // prostate volume recieves the prescribed dose
   while( d_patient->getProstatePrescribedDoseCoverage() < 0.98 &&
-	 d_seed_positions.size() > 0 )
+	 d_candidates.getNumberOfAliveCandidates() > 0 )
   {
-    position = min_element( d_seed_positions.begin(), d_seed_positions.end() );
+    candidate = selectCandidate();
     
     // Determine if a needle penalty must be applied
     while(true)
     {
       // No penalty for using the same needle
-      if( d_patient->isSeedOnNeedle( *position ) )
+      if( d_patient->isSeedOnNeedle( d_candidates, candidate ) )
       {
-	d_patient->insertSeed( *position );
-	position = d_seed_positions.erase( position );
-	updateSeedPositions();
+	insertSeed( candidate );
 	break;
       }
       
@@ -86,18 +110,17 @@ void DWDMMTreatmentPlanner::calculateOptimumTreatmentPlan()
 	  0.5*sqrt((30.0*30.0+(num_needles+1)*(num_needles+1))/
 		   (30.0*30.0-(num_needles+1)*(num_needles+1)));
 	
-	position->multiplyWeight( needle_penalty );
+	d_candidates.multiplyDynamicWeight( candidate, needle_penalty );
+
+	// The penalty only lasts until the next update
+	d_penalized_candidates.push_back( candidate );
 
-	std::list<BrachytherapyDynamicWeightSeedPosition>::iterator 
-	  test_position = min_element( d_seed_positions.begin(), 
-				       d_seed_positions.end() );
+	unsigned test_candidate = selectCandidate();
 
 	// The needle penalty had no effect
-	if( position == test_position )
+	if( candidate == test_candidate )
 	{
-	  d_patient->insertSeed( *position );
-	  position = d_seed_positions.erase( position );
-	  updateSeedPositions();
+	  insertSeed( candidate );
 	  break;
 	}
 	
@@ -105,7 +128,7 @@ void DWDMMTreatmentPlanner::calculateOptimumTreatmentPlan()
 	// applied
 	else
 	{
-	  position = test_position;
+	  candidate = test_candidate;
 	}
       }
     }
@@ -133,23 +156,185 @@ void DWDMMTreatmentPlanner::calculateOptimumTreatmentPlan()
   printTreatmentPlanSummary( std::cout );
 }
 
+// Select the candidate with the smallest weight
+/*! \details Only the candidates in the dose support of an inserted seed are
+ * updated, so the weights in the queue may be out of date. The dose can only
+ * increase, so an out of date weight is a lower bound of the current weight.
+ * The candidate at the top of the queue is brought up to date until a 
+ * candidate that is up to date stays on top. This is the candidate that an 
+ * update of every candidate would select (ties are broken by candidate 
+ * index). The candidates that have been skipped or penalized since the last
+ * update are up to date.
+ */
+unsigned DWDMMTreatmentPlanner::selectCandidate()
+{
+  const std::vector<double>& dose_distribution = 
+    d_patient->getDoseDistribution();
+  
+  unsigned candidate = d_candidates.findMinimumDynamicWeightCandidate();
+
+  while( candidate < d_candidates.getNumberOfCandidates() &&
+	 d_weight_updates[candidate] < d_number_of_updates )
+  {
+    unsigned position_index = d_candidates.getPositionIndex( candidate );
+    
+    d_candidates.setDynamicWeight( candidate,
+				   d_candidates.getBaseWeight( candidate )*
+				   dose_distribution[position_index] );
+
+    d_weight_updates[candidate] = d_number_of_updates;
+
+    candidate = d_candidates.findMinimumDynamicWeightCandidate();
+  }
+
+  return candidate;
+}
+
+// Insert a seed at a candidate seed position and update the candidates
+/*! \details The dynamic weight of a free candidate is its base weight
+ * multiplied by the dose at its position. The candidates are updated before
+ * the seed dose is added to the patient. The candidates that the update 
+ * skips keep their weight from the previous update, so they are brought up
+ * to date before the seed is inserted. The candidates in the dose support of
+ * the inserted seed (and the candidates skipped by the previous update or 
+ * penalized since the previous update) are updated once the seed has been 
+ * inserted. The weights of the other candidates change by a small fraction 
+ * and are brought up to date when they reach the top of the queue.
+ */
+void DWDMMTreatmentPlanner::insertSeed( const unsigned candidate )
+{
+  BrachytherapySeedPosition seed_position = 
+    d_candidates.createSeedPosition( candidate );
+  
+  d_candidates.removeCandidate( candidate );
+
+  std::vector<unsigned> skipped_candidates;
+
+  updateSeedPositions( candidate, skipped_candidates );
+
+  const std::vector<double>& dose_distribution = 
+    d_patient->getDoseDistribution();
+
+  for( unsigned i = 0; i < skipped_candidates.size(); ++i )
+  {
+    unsigned skipped_candidate = skipped_candidates[i];
+    
+    if( d_weight_updates[skipped_candidate] < d_number_of_updates )
+    {
+      unsigned position_index = 
+	d_candidates.getPositionIndex( skipped_candidate );
+      double base_weight = d_candidates.getBaseWeight( skipped_candidate );
+
+      d_candidates.setDynamicWeight( skipped_candidate,
+				     base_weight*
+				     dose_distribution[position_index] );
+    }
+
+    d_weight_updates[skipped_candidate] = d_number_of_updates + 1u;
+  }
+
+  d_patient->insertSeed( seed_position );
+
+  ++d_number_of_updates;
+
+  // Update the candidates that were not skipped
+  for( unsigned i = 0; i < d_updated_candidates.size(); ++i )
+  {
+    unsigned updated_candidate = d_updated_candidates[i];
+
+    if( std::binary_search( skipped_candidates.begin(),
+			    skipped_candidates.end(),
+			    updated_candidate ) )
+      continue;
+    
+    unsigned position_index = 
+      d_candidates.getPositionIndex( updated_candidate );
+    double base_weight = d_candidates.getBaseWeight( updated_candidate );
+      
+    d_candidates.setDynamicWeight( updated_candidate,
+				   base_weight*
+				   dose_distribution[position_index] );
+
+    d_weight_updates[updated_candidate] = d_number_of_updates;
+  }
+
+  d_penalized_candidates.clear();
+  
+  d_skipped_candidates.swap( skipped_candidates );
+}
+
 // Update the seed positions
-void DWDMMTreatmentPlanner::updateSeedPositions()
+/*! \details The candidates at occupied positions (including the position of
+ * the seed that is about to be inserted) are removed. The original list 
+ * based implementation updated the candidates with a single pass in which 
+ * the candidate that followed a removed candidate was skipped. The occupied
+ * candidates are removed in the same order and the skipped candidates are 
+ * returned so that the treatment plans are unchanged. Every candidate is 
+ * updated by the first update. Otherwise, the candidates in the dose support
+ * of the inserted seed and the candidates skipped by the previous update or
+ * penalized since the previous update are stored as the candidates to 
+ * update.
+ */
+void DWDMMTreatmentPlanner::updateSeedPositions( 
+				   const unsigned inserted_candidate,
+				   std::vector<unsigned> &skipped_candidates )
 {
-  std::list<BrachytherapyDynamicWeightSeedPosition>::iterator position,
-    end_position;
+  const unsigned mesh_x_dim = d_patient->getOrganMeshXDim();
+  const unsigned mesh_y_dim = d_patient->getOrganMeshYDim();
+  const unsigned mesh_z_dim = d_patient->getOrganMeshZDim();
+  
+  const int x_index = d_candidates.getXIndex( inserted_candidate );
+  const int y_index = d_candidates.getYIndex( inserted_candidate );
+  const int z_index = d_candidates.getZIndex( inserted_candidate );
+  
+  // Remove the candidates at the inserted seed position
+  DoseDistributionOverlap position_box = { x_index, x_index + 1,
+					   y_index, y_index + 1,
+					   z_index, z_index + 1 };
+  
+  d_candidates.findAliveCandidatesInBox( position_box, 
+					 d_occupied_candidates );
+  
+  d_candidates.removeOccupiedCandidates( d_occupied_candidates,
+					 skipped_candidates );
 
-  position = d_seed_positions.begin();
-  end_position = d_seed_positions.end();
+  // Find the candidates that must be updated
+  d_updated_candidates.clear();
 
-  while( position != end_position )
+  if( d_number_of_updates > 0u )
   {
-    if( d_patient->isSeedPositionFree( *position ) )
-      position->updateWeight();
-    else
-      position = d_seed_positions.erase( position );
+    DoseDistributionOverlap support_box = 
+      BrachytherapySeedProxy::getDoseSupportOverlap( 
+		 d_dose_supports[d_candidates.getSeedId( inserted_candidate )],
+		 x_index,
+		 y_index,
+		 z_index,
+		 mesh_x_dim,
+		 mesh_y_dim,
+		 mesh_z_dim );
+    
+    d_candidates.findAliveCandidatesInBox( support_box, 
+					   d_updated_candidates );
+
+    for( unsigned i = 0; i < d_skipped_candidates.size(); ++i )
+    {
+      if( d_candidates.isAlive( d_skipped_candidates[i] ) )
+	d_updated_candidates.push_back( d_skipped_candidates[i] );
+    }
 
-    ++position;
+    for( unsigned i = 0; i < d_penalized_candidates.size(); ++i )
+    {
+      if( d_candidates.isAlive( d_penalized_candidates[i] ) )
+	d_updated_candidates.push_back( d_penalized_candidates[i] );
+    }
+  }
+  else
+  {
+    // Every candidate weight changes with the first update
+    for( unsigned c = d_candidates.getFirstAliveCandidate();
+	 c != d_candidates.getNumberOfCandidates();
+	 c = d_candidates.getNextAliveCandidate( c ) )
+      d_updated_candidates.push_back( c );
   }
 }
 
@@ -18,7 +18,7 @@
 // TPOR Includes
 #include "BrachytherapyTreatmentPlanner.hpp"
 #include "BrachytherapyPatient.hpp"
-#include "BrachytherapyDynamicWeightSeedPosition.hpp"
+#include "BrachytherapyCandidateTable.hpp"
 
 namespace TPOR{
 
@@ -31,7 +31,8 @@ public:
   //! Constructor
   DWDMMTreatmentPlanner( 
 	const boost::shared_ptr<BrachytherapyPatient> &patient,
-	const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds );
+	const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	const std::vector<bool> &candidate_needle_mask = std::vector<bool>() );
 
   //! Destructor
   ~DWDMMTreatmentPlanner()
@@ -45,8 +46,15 @@ public:
 
 private:
 
+  //! Select the candidate with the smallest weight
+  unsigned selectCandidate();
+
+  //! Insert a seed at a candidate seed position and update the candidates
+  void insertSeed( const unsigned candidate );
+
   //! Update the seed positions
-  void updateSeedPositions();
+  void updateSeedPositions( const unsigned inserted_candidate,
+			    std::vector<unsigned> &skipped_candidates );
 
   //! Print the treatment plan summary
   void printTreatmentPlanSummary( std::ostream &os ) const;
@@ -57,8 +65,32 @@ private:
   // Optimization time
   double d_opt_time;
 
-  // Seed positions
-  std::list<BrachytherapyDynamicWeightSeedPosition> d_seed_positions;
+  // The fraction of the prescribed dose that bounds the seed dose supports
+  static const double support_dose_fraction;
+
+  // Candidate seed positions
+  BrachytherapyCandidateTable d_candidates;
+
+  // The dose support of each seed (mesh offsets from the seed)
+  std::vector<DoseDistributionOverlap> d_dose_supports;
+
+  // The number of updates (inserted seeds)
+  unsigned d_number_of_updates;
+
+  // The update after which each candidate weight was last brought up to date
+  std::vector<unsigned> d_weight_updates;
+
+  // The occupied candidates that have not been removed
+  std::vector<unsigned> d_occupied_candidates;
+
+  // The candidates skipped by the last update
+  std::vector<unsigned> d_skipped_candidates;
+
+  // The candidates penalized since the last update
+  std::vector<unsigned> d_penalized_candidates;
+
+  // The candidates visited by the last update
+  std::vector<unsigned> d_updated_candidates;
 };
 
 } // end TPOR namespace
@@ -0,0 +1,196 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   DoseVolumeHelpers.cpp
+//! \author Alex Robinson
+//! \brief  Dose-volume helper function definitions.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <functional>
+#include <math.h>
+
+// TPOR Includes
+#include "DoseVolumeHelpers.hpp"
+#include "Interpolation.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Return the fraction of an organ receiving more than a dose
+double calculateOrganDoseCoverage( 
+				const std::vector<double> &dose_distribution,
+				const std::vector<bool> &organ_mask,
+				const unsigned organ_size,
+				const double dose )
+{
+  // Make sure that the organ mask is valid
+  testPrecondition( organ_mask.size() == dose_distribution.size() );
+  testPrecondition( organ_size > 0 );
+  
+  unsigned number_elements_covered = 0;
+  
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    if( organ_mask[i] && dose_distribution[i] > dose )
+      ++number_elements_covered;
+  }
+
+  return (double)number_elements_covered/organ_size;
+}
+
+// Return the number of mesh elements receiving more than a dose
+unsigned calculateNumElementsCovered( 
+				const std::vector<double> &dose_distribution,
+				const double dose )
+{
+  unsigned number_elements_covered = 0;
+  
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    if( dose_distribution[i] > dose )
+      ++number_elements_covered;
+  }
+
+  return number_elements_covered;
+}
+
+// Extract the organ doses sorted from largest to smallest
+void extractSortedOrganDoses( const std::vector<double> &dose_distribution,
+			      const std::vector<bool> &organ_mask,
+			      const unsigned organ_size,
+			      std::vector<double> &organ_doses )
+{
+  // Make sure that the organ mask is valid
+  testPrecondition( organ_mask.size() == dose_distribution.size() );
+  testPrecondition( organ_size > 0 );
+
+  organ_doses.resize( organ_size );
+
+  for( unsigned i = 0, j = 0; i < dose_distribution.size(); ++i )
+  {
+    if( organ_mask[i] )
+    {
+      organ_doses[j] = dose_distribution[i];
+      ++j;
+    }
+  }
+
+  std::sort( organ_doses.begin(), organ_doses.end(), 
+	     std::greater<double>() );
+}
+
+// Extract the doses of every structure sorted from largest to smallest
+/*! \details The structure labels store one bit per structure (bit s is set 
+ * if the mesh element belongs to structure s). The doses of all structures 
+ * are extracted in a single pass over the dose distribution.
+ */
+void extractSortedStructureDoses( 
+		     const std::vector<double> &dose_distribution,
+		     const std::vector<unsigned> &structure_labels,
+		     const unsigned number_of_structures,
+		     std::vector<std::vector<double> > &structure_doses )
+{
+  // Make sure that the structure labels are valid
+  testPrecondition( structure_labels.size() == dose_distribution.size() );
+  
+  structure_doses.resize( number_of_structures );
+
+  // Clearing the structure doses keeps the allocated storage
+  for( unsigned s = 0; s < number_of_structures; ++s )
+    structure_doses[s].clear();
+
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    for( unsigned label = structure_labels[i], s = 0; label != 0u;
+	 label >>= 1, ++s )
+    {
+      if( label & 1u )
+      {
+	// Make sure that the label is valid
+	testInvariant( s < number_of_structures );
+	
+	structure_doses[s].push_back( dose_distribution[i] );
+      }
+    }
+  }
+
+  for( unsigned s = 0; s < structure_doses.size(); ++s )
+  {
+    std::sort( structure_doses[s].begin(), structure_doses[s].end(), 
+	       std::greater<double>() );
+  }
+}
+
+// Return the fraction of an organ receiving more than a dose (sorted doses)
+/*! \details The organ doses must be sorted from largest to smallest.
+ */
+double calculateSortedOrganDoseCoverage( 
+				     const std::vector<double> &organ_doses,
+				     const double dose )
+{
+  // Make sure the organ doses are valid
+  testPrecondition( organ_doses.size() > 0 );
+
+  // The organ doses greater than the dose are at the front
+  unsigned number_elements_covered = 
+    std::lower_bound( organ_doses.begin(), 
+		      organ_doses.end(), 
+		      dose,
+		      std::greater<double>() ) - organ_doses.begin();
+
+  return (double)number_elements_covered/organ_doses.size();
+}
+
+// Return the dose covering a fraction of an organ (sorted organ doses)
+/*! \details The organ doses must be sorted from largest to smallest. The
+ * organ element i covers the volume fraction i/organ_size. The dose is 
+ * linearly interpolated between elements and the dose covering the fraction
+ * past the last element is the minimum organ dose. The dose returned has 
+ * units of Gy.
+ */
+double calculateDoseCoveringOrgan( const std::vector<double> &organ_doses,
+				   const double fraction_covered )
+{
+  // Make sure the organ doses are valid
+  testPrecondition( organ_doses.size() > 0 );
+  // Make sure the fraction covered is between 0 and 1
+  testPrecondition( fraction_covered >= 0.0 );
+  testPrecondition( fraction_covered <= 1.0 );
+
+  const unsigned organ_size = organ_doses.size();
+
+  // Find the last volume fraction bin that is <= the fraction covered
+  unsigned vol_frac_bin = 
+    std::min( (unsigned)floor( fraction_covered*organ_size ), organ_size-1 );
+
+  while( vol_frac_bin+1 < organ_size && 
+	 (double)(vol_frac_bin+1)/organ_size <= fraction_covered )
+    ++vol_frac_bin;
+
+  while( vol_frac_bin > 0 && 
+	 (double)vol_frac_bin/organ_size > fraction_covered )
+    --vol_frac_bin;
+
+  double dose_value;
+  
+  if( vol_frac_bin+1 == organ_size )
+    dose_value = organ_doses[vol_frac_bin];
+  else
+  {
+    dose_value = linlinInterp( (double)vol_frac_bin/organ_size,
+			       (double)(vol_frac_bin+1)/organ_size,
+			       fraction_covered,
+			       organ_doses[vol_frac_bin],
+			       organ_doses[vol_frac_bin+1] );
+  }
+
+  return dose_value/100;
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end DoseVolumeHelpers.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,57 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   DoseVolumeHelpers.hpp
+//! \author Alex Robinson
+//! \brief  Dose-volume helper function declarations.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef DOSE_VOLUME_HELPERS_HPP
+#define DOSE_VOLUME_HELPERS_HPP
+
+// Std Lib Includes
+#include <vector>
+
+namespace TPOR{
+
+//! Return the fraction of an organ receiving more than a dose
+double calculateOrganDoseCoverage( 
+				const std::vector<double> &dose_distribution,
+				const std::vector<bool> &organ_mask,
+				const unsigned organ_size,
+				const double dose );
+
+//! Return the number of mesh elements receiving more than a dose
+unsigned calculateNumElementsCovered( 
+				const std::vector<double> &dose_distribution,
+				const double dose );
+
+//! Extract the organ doses sorted from largest to smallest
+void extractSortedOrganDoses( const std::vector<double> &dose_distribution,
+			      const std::vector<bool> &organ_mask,
+			      const unsigned organ_size,
+			      std::vector<double> &organ_doses );
+
+//! Extract the doses of every structure sorted from largest to smallest
+void extractSortedStructureDoses( 
+		     const std::vector<double> &dose_distribution,
+		     const std::vector<unsigned> &structure_labels,
+		     const unsigned number_of_structures,
+		     std::vector<std::vector<double> > &structure_doses );
+
+//! Return the fraction of an organ receiving more than a dose (sorted doses)
+double calculateSortedOrganDoseCoverage( 
+				     const std::vector<double> &organ_doses,
+				     const double dose );
+
+//! Return the dose covering a fraction of an organ (sorted organ doses)
+double calculateDoseCoveringOrgan( const std::vector<double> &organ_doses,
+				   const double fraction_covered );
+
+} // end TPOR namespace
+
+#endif // end DOSE_VOLUME_HELPERS_HPP
+
+//---------------------------------------------------------------------------//
+// end DoseVolumeHelpers.hpp
+//---------------------------------------------------------------------------//
@@ -15,6 +15,7 @@
 // TPOR Includes
 #include "HDF5FileHandler.hpp"
 #include "ExceptionCatchMacros.hpp"
+#include "ContractException.hpp"
 
 namespace TPOR{
 
@@ -103,6 +104,74 @@ bool HDF5FileHandler::groupExists( const std::string &group_name )
   return group_exists;
 }
 
+// Test if a data set exists
+bool HDF5FileHandler::dataSetExists( const std::string &dataset_name )
+{
+  bool dataset_exists = true;
+  // The H5::File openDataSet member function can throw a H5::FileIException 
+  // exception
+  try
+  {
+    H5::DataSet dataset( d_hdf5_file->openDataSet( dataset_name ) );
+  }
+  // The H5::DataSet has not been created
+  catch( const H5::FileIException &exception )
+  {
+    dataset_exists = false;
+  }
+  // Any other exceptions will cause the program to exit
+  HDF5_EXCEPTION_CATCH_AND_EXIT();
+  
+  return dataset_exists;
+}
+
+// Remove a group and all of its contents
+/*! \details The group is unlinked from the file. The space that it used is
+ * not reclaimed until the file is repacked (h5repack).
+ */
+void HDF5FileHandler::removeGroup( const std::string &group_name )
+{
+  // The group must exist
+  testPrecondition( groupExists( group_name ) );
+
+  // The H5::File unlink member function can throw a H5::FileIException
+  // exception
+  try
+  {
+    d_hdf5_file->unlink( group_name );
+  }
+
+  HDF5_EXCEPTION_CATCH_AND_EXIT();
+}
+
+// Return the names of the members (groups and data sets) of a group
+/*! \details The member names are returned in the group's index order 
+ * (alphabetical unless the file tracks the creation order).
+ */
+void HDF5FileHandler::getGroupMemberNames( 
+				      const std::string &group_name,
+				      std::vector<std::string> &member_names )
+{
+  // The group must exist
+  testPrecondition( groupExists( group_name ) );
+
+  member_names.clear();
+
+  // The H5::File openGroup member function can throw a H5::FileIException
+  // exception
+  try
+  {
+    H5::Group group( d_hdf5_file->openGroup( group_name ) );
+
+    hsize_t number_of_members = group.getNumObjs();
+
+    for( hsize_t i = 0; i < number_of_members; ++i )
+      member_names.push_back( group.getObjnameByIdx( i ) );
+  }
+
+  HDF5_EXCEPTION_CATCH_AND_EXIT();
+}
+
 /*! \details This function can be used to create a group heirarchy or to
  * create a directory at the desired location of the HDF5 file.
  * \param[in] path_name The name of the path containing parent groups that
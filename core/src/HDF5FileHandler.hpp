@@ -11,6 +11,7 @@
 
 // Std Lib Includes
 #include <string>
+#include <vector>
 
 // Boost Includes
 #include <boost/scoped_ptr.hpp>
@@ -54,6 +55,16 @@ public:
   //! Test if a group exists
   bool groupExists( const std::string &group_name );
 
+  //! Test if a data set exists
+  bool dataSetExists( const std::string &dataset_name );
+
+  //! Remove a group and all of its contents
+  void removeGroup( const std::string &group_name );
+
+  //! Return the names of the members (groups and data sets) of a group
+  void getGroupMemberNames( const std::string &group_name,
+			    std::vector<std::string> &member_names );
+
   //! Write data in array to HDF5 file data set
   template<typename Array>
   void writeArrayToDataSet( const Array &data,
@@ -64,6 +75,22 @@ public:
   void readArrayFromDataSet( Array &data,
 			     const std::string &location_in_file );
 
+  //! Write data in array to a chunked, compressed HDF5 file data set
+  template<typename Array>
+  void writeArrayToChunkedDataSet( 
+			    const Array &data,
+			    const std::string &location_in_file,
+			    const std::vector<hsize_t> &dimensions,
+			    const std::vector<hsize_t> &chunk_dimensions,
+			    const unsigned compression_level = 6u );
+
+  //! Read in a hyperslab of an HDF5 file data set and save it to an array
+  template<typename Array>
+  void readArrayHyperslabFromDataSet( Array &data,
+				      const std::string &location_in_file,
+				      const std::vector<hsize_t> &offset,
+				      const std::vector<hsize_t> &count );
+
   //! Write an attribute to an HDF5 file data set
   template<typename Array>
   void writeArrayToDataSetAttribute( const Array &data,
@@ -9,10 +9,14 @@
 #ifndef HDF5_FILE_HANDLER_DEF_HPP
 #define HDF5_FILE_HANDLER_DEF_HPP
 
+// Std Lib Includes
+#include <sstream>
+
 // TPOR includes
 #include "HDF5TypeTraits.hpp"
 #include "ArrayTraits.hpp"
 #include "ExceptionCatchMacros.hpp"
+#include "ExceptionTestMacros.hpp"
 #include "ContractException.hpp"
 
 namespace TPOR{
@@ -127,6 +131,148 @@ void HDF5FileHandler::readArrayFromDataSet( Array &data,
   HDF5_EXCEPTION_CATCH_AND_EXIT();
 }
 
+// Write data in array to a chunked, compressed HDF5 file dataset
+/*! \tparam Array An array class. Any array class that has a 
+ *          TPOR::Traits::ArrayTraits specialization can be used. 
+ * \param[in] data The data array to write to the HDF5 file dataset.
+ * \param[in] location_in_file The location in the HDF5 file where the data will
+ * be written.
+ * \param[in] dimensions The dimensions of the dataset (slowest varying 
+ * dimension first).
+ * \param[in] chunk_dimensions The dimensions of a dataset chunk.
+ * \param[in] compression_level The deflate (gzip) compression level (0-9).
+ * \pre 
+ * <ul>
+ *  <li> A valid location string, which is any string that starts with
+ *       a "/", must be given to this function.
+ *  <li> The dataset dimensions must match the size of the array and the 
+ *       chunk dimensions must have the same rank as the dataset.
+ * </ul>
+ * \note The chunks are the units of compression and of partial (hyperslab)
+ * reads, so they should match the way that the data will be read.
+ */
+template<typename Array>
+void HDF5FileHandler::writeArrayToChunkedDataSet( 
+				  const Array &data,
+				  const std::string &location_in_file,
+				  const std::vector<hsize_t> &dimensions,
+				  const std::vector<hsize_t> &chunk_dimensions,
+				  const unsigned compression_level )
+{
+  // The dataset_location must be absolute (start with /)
+  testPrecondition( location_in_file.compare( 0, 1, "/" ) == 0 );
+  // The chunk dimensions must have the same rank as the dataset
+  testPrecondition( dimensions.size() > 0 );
+  testPrecondition( chunk_dimensions.size() == dimensions.size() );
+  // The compression level must be valid
+  testPrecondition( compression_level <= 9u );
+
+  // Type contained in the array
+  typedef typename Traits::ArrayTraits<Array>::value_type value_type;
+  
+  // Create any parent groups that do not exist yet in the location path
+  createParentGroups( location_in_file );
+  
+  // HDF5 exceptions can be thrown when creating a dataset or writing to a 
+  // dataset
+  try
+  {
+    H5::DataSpace space( dimensions.size(), &dimensions[0] );
+    
+    H5::DSetCreatPropList properties;
+    properties.setChunk( chunk_dimensions.size(), &chunk_dimensions[0] );
+    
+    if( compression_level > 0u )
+    {
+      properties.setShuffle();
+      properties.setDeflate( compression_level );
+    }
+    
+    H5::DataSet dataset(d_hdf5_file->createDataSet( 
+				location_in_file,
+				Traits::HDF5TypeTraits<value_type>::dataType(),
+				space,
+				properties ) );
+    dataset.write( getHeadPtr( data ),
+		   Traits::HDF5TypeTraits<value_type>::dataType() );
+  }
+  
+  HDF5_EXCEPTION_CATCH_AND_EXIT();
+}
+
+// Read in a hyperslab of an HDF5 file dataset and save it to an array
+/*! \tparam Array An array class. Any array class that has a 
+ *          TPOR::Traits::ArrayTraits specialization can be used. 
+ * \param[in,out] data The data array that will be used to store the 
+ *                hyperslab.
+ * \param[in] location_in_file The location in the HDF5 file where the data 
+ *            will be read from.
+ * \param[in] offset The offset of the hyperslab in each dimension.
+ * \param[in] count The number of elements in each dimension of the 
+ *            hyperslab.
+ * \pre 
+ * <ul>
+ *  <li> A valid location string, which is any string that starts with
+ *       a "/", must be given to this function.
+ *  <li> The offset and count must have the same rank as the dataset.
+ * </ul>
+ * \note Only the chunks that overlap the hyperslab are read (and 
+ * decompressed) from the file.
+ */
+template<typename Array>
+void HDF5FileHandler::readArrayHyperslabFromDataSet( 
+				       Array &data,
+				       const std::string &location_in_file,
+				       const std::vector<hsize_t> &offset,
+				       const std::vector<hsize_t> &count )
+{
+  // The dataset_location must be absolute (start with /)
+  testPrecondition( location_in_file.compare( 0, 1, "/" ) == 0 ); 
+  // The offset and the count must have the same rank
+  testPrecondition( offset.size() > 0 );
+  testPrecondition( count.size() == offset.size() );
+
+  // Type contained in the array
+  typedef typename Traits::ArrayTraits<Array>::value_type value_type;
+  // The size type associated with the array
+  typedef typename Traits::ArrayTraits<Array>::size_type size_type;
+  
+  // HDF5 exceptions can be thrown when opening and reading from datasets
+  try
+  {
+    H5::DataSet dataset(d_hdf5_file->openDataSet( location_in_file ) );
+    
+    // Select the hyperslab in the dataspace of the dataset
+    H5::DataSpace file_space = dataset.getSpace();
+
+    TEST_FOR_EXCEPTION( file_space.getSimpleExtentNdims() != 
+			(int)offset.size(),
+			H5::DataSetIException,
+			"Error: the hyperslab rank does not match the rank "
+			"of dataset " << location_in_file );
+    
+    file_space.selectHyperslab( H5S_SELECT_SET, &count[0], &offset[0] );
+    
+    // Resize the output array to the size of the hyperslab
+    size_type size = count[0];
+    for( unsigned int i = 1; i < count.size(); ++i )
+      size *= count[i];
+    
+    resizeArray( data, size );
+    
+    hsize_t memory_dim = size;
+    H5::DataSpace memory_space( 1, &memory_dim );
+
+    // Read the hyperslab and save it to the output array
+    dataset.read( getHeadPtr( data ),
+		  Traits::HDF5TypeTraits<value_type>::dataType(),
+		  memory_space,
+		  file_space );
+  }
+  
+  HDF5_EXCEPTION_CATCH_AND_EXIT();
+}
+
 // Write attribute to HDF5 file dataset
 /*! \tparam Array An array class. Any array class that has a 
  *          TPOR::Traits::ArrayTraits specialization can be used. 
@@ -96,6 +96,25 @@ struct HDF5TypeTraits<unsigned int>
   { return 1u; }
 };
 
+/*! \brief The specialization of the TPOR::HDF5TypeTraits for unsigned short
+ * \ingroup hdf5_type_traits
+ */
+template<>
+struct HDF5TypeTraits<unsigned short>
+{
+  //! Returns the HDF5 data type object corresponding to unsigned short
+  static inline H5::PredType dataType() 
+  { return H5::PredType::NATIVE_USHORT; }
+
+  //! Returns the zero value for this type
+  static inline unsigned short zero()
+  { return 0u; }
+
+  //! Returns the unity value for this type
+  static inline unsigned short one()
+  { return 1u; }
+};
+
 /*! \brief The specialization of the TPOR::HDF5TypeTraits for char
  * \ingroup hdf5_type_traits
  */
@@ -16,9 +16,13 @@
 
 // Boost Includes
 #include <boost/chrono.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 // TPOR includes
 #include "IIEMTreatmentPlanner.hpp"
+#include "BinarySearch.hpp"
 #include "ContractException.hpp"
 
 namespace TPOR{
@@ -28,21 +32,37 @@ const std::string IIEMTreatmentPlanner::name = "IIEMTreatmentPlanner";
 
 // Constructor
 IIEMTreatmentPlanner::IIEMTreatmentPlanner( 
-			const boost::shared_ptr<BrachytherapyPatient> &patient,
-			const boost::shared_ptr<BrachytherapySeedProxy> &seed )
+	 const boost::shared_ptr<BrachytherapyPatient> &patient,
+	 const boost::shared_ptr<BrachytherapySeedProxy> &seed,
+	 const BrachytherapyDoseMatrixSettings &dose_matrix_settings,
+	 const unsigned number_of_threads,
+	 const bool search_trials,
+	 const unsigned verification_window,
+	 const std::vector<bool> &candidate_needle_mask )
 		     
   : d_patient( patient ),
     d_min_number_of_needles( 0 ),
     d_min_isodose_constant( 0.0 ),
     d_opt_time( 0.0 ),
-    d_seed_positions()
+    d_number_of_threads( number_of_threads ),
+    d_search_trials( search_trials ),
+    d_verification_window( verification_window ),
+    d_number_of_trials( 0u ),
+    d_seed_selection_traces(),
+    d_candidates( patient->getOrganMeshXDim(),
+		  patient->getOrganMeshYDim(),
+		  patient->getOrganMeshZDim() )
 {
-  // Get the potential seed positions
-  d_seed_positions = 
-    d_patient->getPotentialSeedPositions<BrachytherapySeedPosition>( seed );
+  // Get the candidate seed positions
+  std::vector<boost::shared_ptr<BrachytherapySeedProxy> > seeds( 1, seed );
   
-  // Sort the seed positions
-  d_seed_positions.sort();
+  d_patient->getCandidateSeedPositions( seeds, 
+					d_candidates,
+					candidate_needle_mask );
+  
+  // Sort the candidate seed positions and index them by needle
+  d_candidates.sortByBaseWeight();
+  d_candidates.buildPositionIndex();
 
   // Determine the minimum number of needles that will be needed 
   // (Sua's linear fit)  
@@ -50,10 +70,27 @@ IIEMTreatmentPlanner::IIEMTreatmentPlanner(
     static_cast<unsigned>(floor(0.24*d_patient->getProstateVolume() + 11.33));
   
   // Determine the minimum seed isodose constant for the seed selection process
-  d_min_isodose_constant = calculateMinSeedIsodoseConstant();
+  d_min_isodose_constant = 
+    calculateMinSeedIsodoseConstant( dose_matrix_settings, 
+				     number_of_threads );
+
+  if( d_number_of_threads == 0 )
+  {
+    d_number_of_threads = 
+      std::max( boost::thread::hardware_concurrency(), 1u );
+  }
 }
 
 // Calculate optimum treatment plan
+/*! \details The needle goals and the isodose constants are either scanned
+ * in increasing order (the first successful trial is kept) or searched by
+ * bracketing and bisection (the success of a trial is assumed to be 
+ * monotone). A search conducts the trials in the verification window below
+ * its result in increasing order and keeps the first successful one. If 
+ * the trial success is not monotone the search can keep a different trial
+ * than the scan, unless the verification window covers every trial below
+ * the search result.
+ */
 void IIEMTreatmentPlanner::calculateOptimumTreatmentPlan()
 {
   std::cout << std::endl << "starting treatment plan optimization..." 
@@ -61,28 +98,37 @@ void IIEMTreatmentPlanner::calculateOptimumTreatmentPlan()
   boost::chrono::steady_clock::time_point start_clock = 
     boost::chrono::steady_clock::now();
   
+  d_number_of_trials = 0u;
+
+  d_seed_selection_traces.clear();
+  
   // Start the selection process
   // Outer iteration: needle_goal
   // Inner iteration A: isodose_constant
   // Inner iteration B: needle_isodose_constant
-  for( unsigned needle_goal = d_min_number_of_needles; 
-       needle_goal <= 30;
-       ++needle_goal )
-  {
-    // Conduct the inner iteration A
-    std::cout << "conducting isodose constant iteration for needle goal of "
-	      << needle_goal << "..." << std::endl;
-    
-    conductIsodoseConstantIteration( needle_goal );
-    
-    // Check for a failed inner iteration A
-    if( d_patient->getProstatePrescribedDoseCoverage() < 0.98 )
-      continue;
+  unsigned number_of_needle_goals = 0u;
 
-    // The inner iterations were successful
-    else
-      break;
-  }   
+  if( d_min_number_of_needles <= 30 )
+    number_of_needle_goals = 31 - d_min_number_of_needles;
+  
+  if( d_search_trials )
+  {
+    searchFirstSuccessfulTrial( 
+	 number_of_needle_goals,
+	 boost::bind( &IIEMTreatmentPlanner::conductNeedleGoalTrial,
+		      this,
+		      d_min_number_of_needles,
+		      _1 ) );
+  }
+  else
+  {
+    for( unsigned trial = 0; trial < number_of_needle_goals; ++trial )
+    {
+      // The inner iterations were successful
+      if( conductNeedleGoalTrial( d_min_number_of_needles, trial ) )
+	break;
+    }
+  }
   
   boost::chrono::duration<double> seconds =
     boost::chrono::steady_clock::now() - start_clock;
@@ -106,92 +152,518 @@ void IIEMTreatmentPlanner::calculateOptimumTreatmentPlan()
   printTreatmentPlanSummary( std::cout );
 }
 
+// Return the minimum seed isodose constant
+double IIEMTreatmentPlanner::getMinSeedIsodoseConstant() const
+{
+  return d_min_isodose_constant;
+}
+
+// Return the number of isodose constant trials conducted
+/*! \details A scan of the isodose constants counts the trials up to the
+ * first successful trial (or all trials if none succeeded), so the count
+ * does not depend on the number of threads. A search counts the trials 
+ * that it conducts.
+ */
+unsigned IIEMTreatmentPlanner::getNumberOfTrials() const
+{
+  return d_number_of_trials;
+}
+
+// Conduct the needle goal trial (inner iteration A for a needle goal)
+bool IIEMTreatmentPlanner::conductNeedleGoalTrial( 
+					    const unsigned first_needle_goal,
+					    const unsigned trial )
+{
+  unsigned needle_goal = first_needle_goal + trial;
+  
+  // Conduct the inner iteration A
+  std::cout << "conducting isodose constant iteration for needle goal of "
+	    << needle_goal << "..." << std::endl;
+    
+  conductIsodoseConstantIteration( needle_goal );
+    
+  // Check for a successful inner iteration A
+  return d_patient->getProstatePrescribedDoseCoverage() >= 0.98;
+}
+
 // Conduct the isodose constant iteration
+/*! \details Each isodose constant is tried from a reset patient state and
+ * the first successful trial is kept (the patient state of the last trial 
+ * is kept if no trial succeeds). The trials are independent, so with 
+ * several threads each thread conducts trials on its own copy of the 
+ * patient. The threads take the trials in increasing order and a 
+ * successful trial cancels the trials of the higher constants. The patient
+ * state that is kept does not depend on the number of threads.
+ */
 void IIEMTreatmentPlanner::conductIsodoseConstantIteration( 
 						   const unsigned needle_goal )
 	       
 {
+  std::vector<double> isodose_constants;
+  
   for( double isodose_constant = 0.001; 
        isodose_constant <= d_min_isodose_constant;
        isodose_constant += 0.001 )
+    isodose_constants.push_back( isodose_constant );
+
+  // The seed selections of the earlier needle goals are reused
+  if( d_seed_selection_traces.size() != isodose_constants.size() )
+    d_seed_selection_traces.resize( isodose_constants.size() );
+
+  if( d_search_trials )
   {
-    // Copy the stored seed positions
-    std::list<BrachytherapySeedPosition> remaining_seed_positions = 
-      d_seed_positions;
+    BrachytherapyCandidateTable remaining_candidates = d_candidates;
+    
+    searchFirstSuccessfulTrial( 
+	isodose_constants.size(),
+	boost::bind( &IIEMTreatmentPlanner::conductSearchIsodoseConstantTrial,
+		     this,
+		     boost::cref( isodose_constants ),
+		     needle_goal,
+		     boost::ref( remaining_candidates ),
+		     _1 ) );
 
-    // Reset the patient state
-    d_patient->resetState();
+    return;
+  }
+  
+  unsigned threads = std::min( d_number_of_threads, 
+			       (unsigned)isodose_constants.size() );
+  
+  if( threads <= 1 )
+  {
+    BrachytherapyCandidateTable remaining_candidates = d_candidates;
     
-    // Select the first seed
-    d_patient->insertSeed( remaining_seed_positions.front() );
-    remaining_seed_positions.pop_front();
+    for( unsigned trial = 0; trial < isodose_constants.size(); ++trial )
+    {
+      ++d_number_of_trials;
+      
+      if( conductIsodoseConstantTrial( *d_patient,
+				       remaining_candidates,
+				       d_seed_selection_traces,
+				       isodose_constants[trial],
+				       needle_goal,
+				       trial,
+				       NULL ) )
+	break;
+    }
+  }
+  else
+  {
+    IsodoseConstantSweep sweep;
+    sweep.next_trial = 0u;
+    sweep.successful_trial = isodose_constants.size();
     
-    // Keep selecting seeds until the needle goal has been reached
-    while( d_patient->getNumInsertedNeedles() < needle_goal )
+    boost::thread_group thread_group;
+
+    for( unsigned i = 0; i < threads; ++i )
+    {
+      thread_group.create_thread( 
+	   boost::bind( &IIEMTreatmentPlanner::conductIsodoseConstantTrials,
+			this,
+			boost::cref( isodose_constants ),
+			needle_goal,
+			boost::ref( d_seed_selection_traces ),
+			boost::ref( sweep ) ) );
+    }
+
+    thread_group.join_all();
+
+    // Only the trials up to the kept trial are counted (as in a serial
+    // sweep), the trials that were cancelled are not
+    if( sweep.successful_patient )
+      d_number_of_trials += sweep.successful_trial + 1u;
+    else
+      d_number_of_trials += isodose_constants.size();
+
+    if( sweep.successful_patient )
+      *d_patient = *sweep.successful_patient;
+    else if( sweep.last_patient )
+      *d_patient = *sweep.last_patient;
+  }
+}
+
+// Conduct an isodose constant trial on the patient (search)
+bool IIEMTreatmentPlanner::conductSearchIsodoseConstantTrial(
+			     const std::vector<double> &isodose_constants,
+			     const unsigned needle_goal,
+			     BrachytherapyCandidateTable &remaining_candidates,
+			     const unsigned trial )
+{
+  ++d_number_of_trials;
+  
+  return conductIsodoseConstantTrial( *d_patient,
+				      remaining_candidates,
+				      d_seed_selection_traces,
+				      isodose_constants[trial],
+				      needle_goal,
+				      trial,
+				      NULL );
+}
+
+// Search for the first successful trial
+/*! \details The trial predicate conducts a trial on the patient. The 
+ * patient is left in the state of the first successful trial that was 
+ * found (or of the last trial if no trial was successful), as it would be 
+ * after a scan of the trials in increasing order.
+ */
+unsigned IIEMTreatmentPlanner::searchFirstSuccessfulTrial( 
+		     const unsigned number_of_trials,
+		     const boost::function<bool (unsigned)> &trial_predicate )
+{
+  TrialSearch search;
+  search.outcomes.assign( number_of_trials, UNTRIED_TRIAL );
+  search.successful_trial = number_of_trials;
+  
+  unsigned first_trial = findFirstSuccessfulTrial( 
+	      number_of_trials,
+	      boost::bind( &IIEMTreatmentPlanner::conductSearchTrial,
+			   this,
+			   _1,
+			   boost::cref( trial_predicate ),
+			   boost::ref( search ) ) );
+
+  // Verify that no trial in the window below the result is successful
+  unsigned verification_start = 0u;
+
+  if( first_trial > d_verification_window )
+    verification_start = first_trial - d_verification_window;
+
+  for( unsigned trial = verification_start; trial < first_trial; ++trial )
+  {
+    if( conductSearchTrial( trial, trial_predicate, search ) )
     {
-      // Select the next acceptable seed position
-      std::list<BrachytherapySeedPosition>::iterator seed_position;
+      first_trial = trial;
       
-      for( seed_position = remaining_seed_positions.begin(); 
-	   seed_position != remaining_seed_positions.end();
-	   ++seed_position )
-      {	
-	double dose_cutoff = d_patient->getPrescribedDose()*isodose_constant*
-	  d_patient->getNumInsertedSeeds();
-	  	
-	if( d_patient->getDose( *seed_position ) < dose_cutoff )
-	{
-	  d_patient->insertSeed( *seed_position );
-	  seed_position = remaining_seed_positions.erase( seed_position );
-	  
-	  break;
-	}
-      }
+      break;
+    }
+  }
+
+  // Restore the state of the kept trial
+  if( search.successful_patient )
+    *d_patient = *search.successful_patient;
+  else if( search.last_patient )
+    *d_patient = *search.last_patient;
+
+  return first_trial;
+}
+
+// Conduct a trial of a search (each trial is only conducted once)
+/*! \details The patient state is stored if the trial is the first 
+ * successful trial so far or if it is the last trial.
+ */
+bool IIEMTreatmentPlanner::conductSearchTrial( 
+		    const unsigned trial,
+		    const boost::function<bool (unsigned)> &trial_predicate,
+		    TrialSearch &search )
+{
+  if( search.outcomes[trial] != UNTRIED_TRIAL )
+    return search.outcomes[trial] == SUCCESSFUL_TRIAL;
+
+  bool success = trial_predicate( trial );
+
+  search.outcomes[trial] = (success ? SUCCESSFUL_TRIAL : FAILED_TRIAL);
+
+  if( success && trial < search.successful_trial )
+  {
+    search.successful_trial = trial;
+    search.successful_patient.reset( new BrachytherapyPatient( *d_patient ) );
+  }
+  else if( !success && trial + 1u == search.outcomes.size() )
+    search.last_patient.reset( new BrachytherapyPatient( *d_patient ) );
+
+  return success;
+}
+
+// Conduct the isodose constant trials taken from a shared sweep
+/*! \details The patient state at the end of a trial is stored in the sweep
+ * if it is the lowest successful trial so far or if it is the last trial.
+ */
+void IIEMTreatmentPlanner::conductIsodoseConstantTrials( 
+			       const std::vector<double> &isodose_constants,
+			       const unsigned needle_goal,
+			       std::vector<SeedSelectionTrace> &traces,
+			       IsodoseConstantSweep &sweep ) const
+{
+  // Each thread uses its own patient state and candidate seed positions
+  BrachytherapyPatient patient( *d_patient );
+  
+  BrachytherapyCandidateTable remaining_candidates = d_candidates;
+
+  while( true )
+  {
+    unsigned trial;
+    
+    {
+      boost::mutex::scoped_lock lock( sweep.mutex );
       
-      // If no acceptable seed position was found, exit this inner iteration
-      if( seed_position == remaining_seed_positions.end() )
-	break;
+      trial = sweep.next_trial;
+
+      if( trial >= isodose_constants.size() || 
+	  trial > sweep.successful_trial )
+	return;
+
+      ++sweep.next_trial;
+    }
+
+    bool success = conductIsodoseConstantTrial( patient,
+						remaining_candidates,
+						traces,
+						isodose_constants[trial],
+						needle_goal,
+						trial,
+						&sweep );
+
+    boost::mutex::scoped_lock lock( sweep.mutex );
+
+    if( success && trial < sweep.successful_trial )
+    {
+      sweep.successful_trial = trial;
+      sweep.successful_patient.reset( new BrachytherapyPatient( patient ) );
+    }
+    else if( !success && trial + 1u == isodose_constants.size() )
+      sweep.last_patient.reset( new BrachytherapyPatient( patient ) );
+  }
+}
+
+// Conduct an isodose constant trial
+/*! \details The seeds are selected from a reset patient state until the 
+ * needle goal is reached (inner iteration A) and the needle isodose 
+ * constant iteration is then conducted (inner iteration B). The trial is 
+ * successful if inner iteration B is successful. If the trial is part of a
+ * parallel sweep it is abandoned (unsuccessful) as soon as a lower trial
+ * succeeds and the progress messages are not printed. The seeds selected 
+ * by inner iteration A are recorded in the trace of the isodose constant.
+ * A trial with a higher needle goal repeats the recorded seeds up to its 
+ * needle goal without searching for them and only searches for the seeds
+ * that follow.
+ */
+bool IIEMTreatmentPlanner::conductIsodoseConstantTrial( 
+			     BrachytherapyPatient &patient,
+			     BrachytherapyCandidateTable &remaining_candidates,
+			     std::vector<SeedSelectionTrace> &traces,
+			     const double isodose_constant,
+			     const unsigned needle_goal,
+			     const unsigned trial,
+			     IsodoseConstantSweep *sweep ) const
+{
+  // The seeds that have been selected with the isodose constant
+  SeedSelectionTrace &trace = traces[trial];
+
+  // A trial that ran out of acceptable candidates before the needle goal
+  // was reached also fails with a higher needle goal (only the state of the
+  // last trial is kept if no trial succeeds, so it is always conducted)
+  if( trace.exhausted && trace.number_of_needles < needle_goal &&
+      trial + 1u < traces.size() )
+    return false;
+  
+  // Copy the stored candidate seed positions
+  remaining_candidates = d_candidates;
+
+  const unsigned end_candidate = remaining_candidates.getNumberOfCandidates();
+
+  // Reset the patient state
+  patient.resetState();
+
+  // Repeat the seed selections of the earlier trials with the isodose 
+  // constant (the selections do not depend on the needle goal, which only
+  // determines when the selection stops)
+  unsigned number_of_selections = 0u;
+
+  while( number_of_selections < trace.candidates.size() &&
+	 (number_of_selections == 0u || 
+	  patient.getNumInsertedNeedles() < needle_goal) )
+  {
+    unsigned candidate = trace.candidates[number_of_selections];
+    
+    patient.insertSeed( remaining_candidates.createSeedPosition( candidate ) );
+    remaining_candidates.removeCandidate( candidate );
+
+    ++number_of_selections;
+  }
+
+  // The selection was exited after the last repeated seed
+  if( trace.exhausted && number_of_selections == trace.candidates.size() &&
+      patient.getNumInsertedNeedles() < needle_goal )
+    return false;
+
+  // The candidate doses (only the remaining candidates have a finite dose)
+  std::vector<double> remaining_candidate_doses( 
+				end_candidate, 
+				std::numeric_limits<double>::infinity() );
+
+  for( unsigned i = 0; i < end_candidate; ++i )
+  {
+    if( remaining_candidates.isAlive( i ) )
+    {
+      remaining_candidate_doses[i] = 
+	patient.getDose( remaining_candidates, i );
+    }
+  }
+  
+  MinSegmentTree candidate_doses;
+
+  candidate_doses.reset( remaining_candidate_doses );
+    
+  // Keep selecting seeds until the needle goal has been reached
+  // Note: the iteration is also exited when the last remaining candidate
+  //       is selected
+  while( patient.getNumInsertedNeedles() < needle_goal )
+  {
+    if( isTrialCancelled( trial, sweep ) )
+      return false;
+    
+    // Select the next acceptable seed position (the first seed is the first
+    // remaining candidate)
+    unsigned candidate;
+    
+    if( trace.candidates.empty() )
+      candidate = remaining_candidates.getFirstAliveCandidate();
+    else
+    {
+      double dose_cutoff = patient.getPrescribedDose()*isodose_constant*
+	patient.getNumInsertedSeeds();
+    
+      candidate = findAcceptableCandidate( patient,
+					   remaining_candidates,
+					   candidate_doses,
+					   dose_cutoff );
+    }
+      
+    // If no acceptable seed position was found, exit this inner iteration
+    if( candidate == end_candidate )
+    {
+      trace.exhausted = true;
+      
+      break;
+    }
+
+    patient.insertSeed( remaining_candidates.createSeedPosition( candidate ) );
+    remaining_candidates.removeCandidate( candidate );
+    candidate_doses.setValue( candidate, 
+			      std::numeric_limits<double>::infinity() );
+
+    trace.candidates.push_back( candidate );
+    trace.number_of_needles = patient.getNumInsertedNeedles();
+    
+    if( remaining_candidates.getNextAliveCandidate( candidate ) == 
+	end_candidate )
+    {
+      trace.exhausted = true;
       
+      break;
     }
+  }
     
-    // Check for a failed iteration
-    if( d_patient->getNumInsertedNeedles() != needle_goal )
-      continue;
+  // Check for a failed iteration
+  if( patient.getNumInsertedNeedles() != needle_goal )
+    return false;
+
+  if( isTrialCancelled( trial, sweep ) )
+    return false;
 
-    // Store a copy of the treatment plan for running refined inner iteration B
-    d_patient->saveState();
+  // Store a copy of the treatment plan for running refined inner iteration B
+  patient.saveState();
         
-    // Conduct the inner iteration B
+  // Conduct the inner iteration B
+  if( !sweep )
+  {
     std::cout << "conducting needle isodose constant iteration..."
 	      << std::endl;
-    double needle_isodose_constant = 
-      conductNeedleIsodoseConstantIteration( 1.02,
-					     1.08,
-					     0.02,
-					     remaining_seed_positions );
-
-    // Check for a successful inner iteration B
-    if( d_patient->getProstatePrescribedDoseCoverage() >= 0.98 )
-    {
-      // Run a refined inner iteration B
-      d_patient->loadSavedState();
+  }
+  
+  double needle_isodose_constant = 
+    conductNeedleIsodoseConstantIteration( patient,
+					   1.02,
+					   1.08,
+					   0.02,
+					   remaining_candidates );
+
+  // Check for a failed inner iteration B
+  if( patient.getProstatePrescribedDoseCoverage() < 0.98 )
+    return false;
+  
+  if( isTrialCancelled( trial, sweep ) )
+    return false;
+  
+  // Run a refined inner iteration B
+  patient.loadSavedState();
             
-      needle_isodose_constant = 
-	conductNeedleIsodoseConstantIteration( needle_isodose_constant-0.019,
-					       needle_isodose_constant,
-					       0.001,
-					       remaining_seed_positions );
+  needle_isodose_constant = 
+    conductNeedleIsodoseConstantIteration( patient,
+					   needle_isodose_constant-0.019,
+					   needle_isodose_constant,
+					   0.001,
+					   remaining_candidates );
+  
+  return true;
+}
+
+// Test if a trial has been cancelled by a successful lower trial
+bool IIEMTreatmentPlanner::isTrialCancelled( 
+				       const unsigned trial,
+				       IsodoseConstantSweep *sweep ) const
+{
+  if( !sweep )
+    return false;
+
+  boost::mutex::scoped_lock lock( sweep->mutex );
+
+  return sweep->successful_trial < trial;
+}
+
+// Find the first remaining candidate with a dose below a cutoff
+/*! \details The candidate dose tree must store a lower bound of the current
+ * dose of every remaining candidate (and an infinite dose for the other 
+ * candidates). This holds as long as seeds are only inserted after the
+ * tree is filled, since an inserted seed can only raise the doses. The 
+ * first candidate (in selection order) with a stored dose below the cutoff
+ * is checked. If its current dose is not below the cutoff its stored dose 
+ * is raised and the search is repeated, so the candidates that are known
+ * to be above the cutoff are never visited again. The candidate that is
+ * found is the candidate that a scan of the remaining candidates in 
+ * selection order would find.
+ */
+unsigned IIEMTreatmentPlanner::findAcceptableCandidate( 
+		  const BrachytherapyPatient &patient,
+		  const BrachytherapyCandidateTable &remaining_candidates,
+		  MinSegmentTree &candidate_doses,
+		  const double dose_cutoff ) const
+{
+  // Make sure that the tree is valid
+  testPrecondition( candidate_doses.size() == 
+		    remaining_candidates.getNumberOfCandidates() );
+  
+  unsigned candidate = candidate_doses.findFirstBelow( dose_cutoff );
+  
+  while( candidate != candidate_doses.size() )
+  {
+    double dose = patient.getDose( remaining_candidates, candidate );
+
+    // Make sure that the stored dose is a lower bound
+    testInvariant( candidate_doses.getValue( candidate ) <= dose );
+    
+    if( dose < dose_cutoff )
       break;
-    }
+
+    candidate_doses.setValue( candidate, dose );
+
+    candidate = candidate_doses.findFirstBelow( dose_cutoff );
   }
+
+  return candidate;
 }
 
 // Conduct the needle isodose constant iteration
+/*! \details Only the candidates on the inserted needles can be selected. 
+ * The candidate doses are refilled from the checkpoint state for each 
+ * needle isodose constant (restoring the checkpoint lowers the doses).
+ */
 double IIEMTreatmentPlanner::conductNeedleIsodoseConstantIteration( 
+	 BrachytherapyPatient &patient,
 	 const double start_constant,
 	 const double end_constant,
 	 const double step,
-	 const std::list<BrachytherapySeedPosition> &remaining_seed_positions )
+	 const BrachytherapyCandidateTable &remaining_candidates ) const
 {
   // Make sure the start constant is valid
   testPrecondition( start_constant > 0.0 );
@@ -200,106 +672,188 @@ double IIEMTreatmentPlanner::conductNeedleIsodoseConstantIteration(
   // Make sure the step is less than the distance between the start/end const
   testPrecondition( step <= end_constant - start_constant );
   
-  // Save the patient state
-  d_patient->saveState();
+  // Create a checkpoint of the patient state (nested in the saved state)
+  patient.createCheckpoint( "needle_isodose_constant_iteration" );
 
-  // Store a copy of the remaining seed positions
-  std::list<BrachytherapySeedPosition> remaining_seed_positions_copy = 
-    remaining_seed_positions;
+  // Store a copy of the remaining candidate seed positions
+  BrachytherapyCandidateTable remaining_candidates_copy = 
+    remaining_candidates;
+
+  const unsigned end_candidate = remaining_candidates.getNumberOfCandidates();
 
   // Store the optimum needle isodose constant
   double optimum_needle_isodose_constant = 0.0;
+
+  // Only seeds on the inserted needles can be selected (no needles are 
+  // inserted by this iteration)
+  std::vector<unsigned> needles;
+  
+  patient.getInsertedNeedles( needles );
+  
+  // The candidate doses (only the remaining candidates on the needles have
+  // a finite dose)
+  MinSegmentTree candidate_doses;
+  
+  std::vector<double> needle_candidate_doses;
   
   for( double needle_isodose_constant = start_constant;
        needle_isodose_constant <= end_constant;
        needle_isodose_constant += step )
   {    
-    // Select seeds along current needles until 98% of prostate receives 
-    // prescribed dose
-    while( d_patient->getProstatePrescribedDoseCoverage() < 0.98 )
+    needle_candidate_doses.assign( end_candidate, 
+				   std::numeric_limits<double>::infinity() );
+
+    for( unsigned n = 0; n < needles.size(); ++n )
     {
-      // Select the next acceptable seed position
-      std::list<BrachytherapySeedPosition>::iterator seed_position;
-      
-      for( seed_position = remaining_seed_positions_copy.begin(); 
-	   seed_position != remaining_seed_positions_copy.end();
-	   ++seed_position )
-      {
-	double dose_cutoff = 
-	  d_patient->getPrescribedDose()*needle_isodose_constant;
+      unsigned number_of_column_candidates = 
+	remaining_candidates_copy.getNumberOfColumnCandidates( needles[n] );
 	
-	if( d_patient->getDose( *seed_position ) < dose_cutoff &&
-	    d_patient->isSeedOnNeedle( *seed_position ) )
+      for( unsigned i = 0; i < number_of_column_candidates; ++i )
+      {
+	unsigned column_candidate = 
+	  remaining_candidates_copy.getColumnCandidate( needles[n], i );
+
+	if( remaining_candidates_copy.isAlive( column_candidate ) )
 	{
-	  d_patient->insertSeed( *seed_position );
-	  seed_position = remaining_seed_positions_copy.erase( seed_position );
-	  
-	  break;
+	  needle_candidate_doses[column_candidate] = 
+	    patient.getDose( remaining_candidates_copy, column_candidate );
 	}
       }
+    }
+
+    candidate_doses.reset( needle_candidate_doses );
+    
+    // Select seeds along current needles until 98% of prostate receives 
+    // prescribed dose
+    while( patient.getProstatePrescribedDoseCoverage() < 0.98 )
+    {
+      // Select the next acceptable seed position (the first acceptable 
+      // candidate on any of the needles)
+      double dose_cutoff = 
+	patient.getPrescribedDose()*needle_isodose_constant;
+      
+      unsigned candidate = findAcceptableCandidate( patient,
+						    remaining_candidates_copy,
+						    candidate_doses,
+						    dose_cutoff );
       
       // If no acceptable seed position was found, exit this inner iteration
-      if( seed_position == remaining_seed_positions_copy.end() )
+      if( candidate == end_candidate )
+	break;
+      
+      patient.insertSeed( 
+		    remaining_candidates_copy.createSeedPosition( candidate ) );
+      remaining_candidates_copy.removeCandidate( candidate );
+      candidate_doses.setValue( candidate, 
+				std::numeric_limits<double>::infinity() );
+
+      // Note: the iteration is also exited when the selected candidate was
+      //       the last remaining candidate
+      if( remaining_candidates_copy.getNextAliveCandidate( candidate ) ==
+	  end_candidate )
 	break;
     }
 
     // Check if the inner iteration was successful
-    if( d_patient->getProstatePrescribedDoseCoverage() >= 0.98 )
+    if( patient.getProstatePrescribedDoseCoverage() >= 0.98 )
     {
       optimum_needle_isodose_constant = needle_isodose_constant;
       break;
     }
     else
     {
-      d_patient->loadSavedState();
+      patient.restoreCheckpoint( "needle_isodose_constant_iteration" );
             
-      // Reset the remaining seed positions
-      remaining_seed_positions_copy = remaining_seed_positions;
+      // Reset the remaining candidate seed positions
+      remaining_candidates_copy = remaining_candidates;
     }
   }
 
+  patient.releaseCheckpoint( "needle_isodose_constant_iteration" );
+
   return optimum_needle_isodose_constant;
 }
 
 // Calculate the minimum seed isodose constant
-double IIEMTreatmentPlanner::calculateMinSeedIsodoseConstant() const
+/*! \details If a dose matrix is requested the candidate doses in the 
+ * prostate are computed in parallel and summed as sparse rows.
+ */
+double IIEMTreatmentPlanner::calculateMinSeedIsodoseConstant( 
+	     const BrachytherapyDoseMatrixSettings &dose_matrix_settings,
+	     const unsigned number_of_threads ) const
 {
   double min_isodose_constant = std::numeric_limits<double>::infinity();
   double isodose_constant = 0.0;
 
-  std::list<BrachytherapySeedPosition>::const_iterator 
-    position, end_position;
-  
-  position = d_seed_positions.begin();
-  end_position = d_seed_positions.end();
-
   unsigned mesh_x_dim = d_patient->getOrganMeshXDim();
   unsigned mesh_y_dim = d_patient->getOrganMeshYDim();
   unsigned mesh_z_dim = d_patient->getOrganMeshZDim();
+
+  // Store the candidate doses in the prostate (if requested)
+  boost::scoped_ptr<BrachytherapyDoseMatrix> dose_matrix;
+
+  if( dose_matrix_settings.memory_budget > 0.0 )
+  {
+    dose_matrix.reset( 
+	       new BrachytherapyDoseMatrix( d_candidates,
+					    d_patient->getProstateMask(),
+					    dose_matrix_settings,
+					    number_of_threads ) );
+
+    if( !dose_matrix->isStored() )
+    {
+      std::cout << "Warning: the dose matrix does not fit in the memory "
+		<< "budget. The seed dose meshes will be used." << std::endl;
+
+      dose_matrix.reset();
+    }
+  }
   
-  std::vector<double> tmp_dose_distribution( mesh_x_dim*mesh_y_dim*mesh_z_dim);
-  
-  while( position != end_position )
+  for( unsigned c = 0; c < d_candidates.getNumberOfCandidates(); ++c )
   {
-    position->mapSeedDoseDistribution<Equal>( tmp_dose_distribution,
-					      mesh_x_dim,
-					      mesh_y_dim,
-					      mesh_z_dim );
-        
-    for( unsigned k = 0; k < mesh_z_dim; ++k )
+    if( dose_matrix )
     {
-      for( unsigned j = 0; j < mesh_y_dim; ++j )
+      isodose_constant += 
+	dose_matrix->calculateTruncatedDose( c, 
+					     d_patient->getPrescribedDose() );
+    }
+    else
+    {
+      const int x_index = d_candidates.getXIndex( c );
+      const int y_index = d_candidates.getYIndex( c );
+      const int z_index = d_candidates.getZIndex( c );
+      
+      const BrachytherapySeedProxy &seed = *d_candidates.getSeed( c );
+      
+      // Prostate elements outside of the overlap box receive no dose
+      DoseDistributionOverlap overlap = 
+	seed.getDoseDistributionOverlap( x_index,
+					 y_index,
+					 z_index,
+					 mesh_x_dim, 
+					 mesh_y_dim, 
+					 mesh_z_dim );
+      
+      for( int k = overlap.z_start; k < overlap.z_end; ++k )
       {
-	for( unsigned i = 0; i < mesh_x_dim; ++i )
+	for( int j = overlap.y_start; j < overlap.y_end; ++j )
 	{
-	  if( d_patient->getTissueType( i, j, k ) == PROSTATE_TISSUE )
+	  const double* seed_dose_row = 
+	    seed.getTotalDoseRow( overlap.x_start - x_index, 
+				  j - y_index, 
+				  k - z_index );
+	  
+	  for( int i = overlap.x_start; i < overlap.x_end; ++i )
 	  {
-	    unsigned index = i + j*mesh_x_dim + k*mesh_x_dim*mesh_y_dim;
-	    
-	    if( tmp_dose_distribution[index] > d_patient->getPrescribedDose() )
-	      isodose_constant += d_patient->getPrescribedDose();
-	    else
-	      isodose_constant += tmp_dose_distribution[index];
+	    if( d_patient->getTissueType( i, j, k ) == PROSTATE_TISSUE )
+	    {
+	      double dose = seed_dose_row[i - overlap.x_start];
+	      
+	      if( dose > d_patient->getPrescribedDose() )
+		isodose_constant += d_patient->getPrescribedDose();
+	      else
+		isodose_constant += dose;
+	    }
 	  }
 	}
       }
@@ -310,8 +864,6 @@ double IIEMTreatmentPlanner::calculateMinSeedIsodoseConstant() const
       
     if( isodose_constant < min_isodose_constant )
       min_isodose_constant = isodose_constant;
-
-    ++position;
   }
 
   return min_isodose_constant;
@@ -331,6 +883,7 @@ void IIEMTreatmentPlanner::printTreatmentPlanSummary( std::ostream &os ) const
      << std::endl;
   os << "Seeds Chosen:               " << d_patient->getNumInsertedSeeds()
      << std::endl;
+  os << "Trial Plans Built:          " << d_number_of_trials << std::endl;
 }
 
 } // end TPOR namespace
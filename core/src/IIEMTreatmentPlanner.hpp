@@ -13,16 +13,22 @@
 // Std Lib Includes
 #include <list>
 #include <string>
+#include <vector>
 #include <iostream>
 
 // Boost Includes
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/function.hpp>
 
 // TPOR includes
 #include "BrachytherapyTreatmentPlanner.hpp"
 #include "BrachytherapySeedPosition.hpp"
 #include "BrachytherapySeedProxy.hpp"
 #include "BrachytherapyPatient.hpp"
+#include "BrachytherapyCandidateTable.hpp"
+#include "BrachytherapyDoseMatrix.hpp"
+#include "MinSegmentTree.hpp"
 
 namespace TPOR
 {
@@ -34,8 +40,15 @@ class IIEMTreatmentPlanner : public BrachytherapyTreatmentPlanner
 public:
 
   //! Constructor
-  IIEMTreatmentPlanner( const boost::shared_ptr<BrachytherapyPatient> &patient,
-			const boost::shared_ptr<BrachytherapySeedProxy> &seed);
+  IIEMTreatmentPlanner( 
+	const boost::shared_ptr<BrachytherapyPatient> &patient,
+	const boost::shared_ptr<BrachytherapySeedProxy> &seed,
+	const BrachytherapyDoseMatrixSettings &dose_matrix_settings = 
+	BrachytherapyDoseMatrixSettings(),
+	const unsigned number_of_threads = 0u,
+	const bool search_trials = false,
+	const unsigned verification_window = 0u,
+	const std::vector<bool> &candidate_needle_mask = std::vector<bool>() );
   
   //! Destructor
   ~IIEMTreatmentPlanner()
@@ -43,25 +56,144 @@ public:
 
   //! Calculate optimum treatment plan
   void calculateOptimumTreatmentPlan();
+
+  //! Return the minimum seed isodose constant
+  double getMinSeedIsodoseConstant() const;
+
+  //! Return the number of isodose constant trials conducted
+  unsigned getNumberOfTrials() const;
   
   // Treatment planner name
   static const std::string name;
 
 private:
 
+  //! The state of an isodose constant sweep that is shared by the threads
+  struct IsodoseConstantSweep
+  {
+    // The mutex that protects the sweep state
+    boost::mutex mutex;
+
+    // The next trial that will be started
+    unsigned next_trial;
+
+    // The first successful trial (the number of trials if none succeeded)
+    unsigned successful_trial;
+
+    // The patient state at the end of the first successful trial
+    boost::shared_ptr<BrachytherapyPatient> successful_patient;
+
+    // The patient state at the end of the last trial
+    boost::shared_ptr<BrachytherapyPatient> last_patient;
+  };
+
+  //! The seeds selected by inner iteration A with an isodose constant
+  struct SeedSelectionTrace
+  {
+    SeedSelectionTrace()
+      : candidates(),
+	number_of_needles( 0u ),
+	exhausted( false )
+    { /* ... */ }
+
+    // The selected candidates (in selection order)
+    std::vector<unsigned> candidates;
+
+    // The number of needles of the selected candidates
+    unsigned number_of_needles;
+
+    // No seed can be selected after the last selected candidate
+    bool exhausted;
+  };
+
+  //! The outcomes of the trials of a search
+  enum TrialOutcome{
+    UNTRIED_TRIAL = 0,
+    FAILED_TRIAL,
+    SUCCESSFUL_TRIAL
+  };
+
+  //! The state of a search for the first successful trial
+  struct TrialSearch
+  {
+    // The outcome of each trial (untried, failed or successful)
+    std::vector<unsigned char> outcomes;
+
+    // The first successful trial (the number of trials if none succeeded)
+    unsigned successful_trial;
+
+    // The patient state at the end of the first successful trial
+    boost::shared_ptr<BrachytherapyPatient> successful_patient;
+
+    // The patient state at the end of the last trial
+    boost::shared_ptr<BrachytherapyPatient> last_patient;
+  };
+
+  //! Conduct the needle goal trial (inner iteration A for a needle goal)
+  bool conductNeedleGoalTrial( const unsigned first_needle_goal,
+			       const unsigned trial );
+
   //! Conduct the isodose constant iteration 
   void conductIsodoseConstantIteration( const unsigned needle_goal );
-	      
+
+  //! Conduct an isodose constant trial on the patient (search)
+  bool conductSearchIsodoseConstantTrial(
+			    const std::vector<double> &isodose_constants,
+			    const unsigned needle_goal,
+			    BrachytherapyCandidateTable &remaining_candidates,
+			    const unsigned trial );
+
+  //! Search for the first successful trial
+  unsigned searchFirstSuccessfulTrial( 
+		    const unsigned number_of_trials,
+		    const boost::function<bool (unsigned)> &trial_predicate );
+
+  //! Conduct a trial of a search (each trial is only conducted once)
+  bool conductSearchTrial( 
+		    const unsigned trial,
+		    const boost::function<bool (unsigned)> &trial_predicate,
+		    TrialSearch &search );
+
+  //! Conduct the isodose constant trials taken from a shared sweep
+  void conductIsodoseConstantTrials( 
+			    const std::vector<double> &isodose_constants,
+			    const unsigned needle_goal,
+			    std::vector<SeedSelectionTrace> &traces,
+			    IsodoseConstantSweep &sweep ) const;
+
+  //! Conduct an isodose constant trial
+  bool conductIsodoseConstantTrial( 
+			    BrachytherapyPatient &patient,
+			    BrachytherapyCandidateTable &remaining_candidates,
+			    std::vector<SeedSelectionTrace> &traces,
+			    const double isodose_constant,
+			    const unsigned needle_goal,
+			    const unsigned trial,
+			    IsodoseConstantSweep *sweep ) const;
+
+  //! Test if a trial has been cancelled by a successful lower trial
+  bool isTrialCancelled( const unsigned trial,
+			 IsodoseConstantSweep *sweep ) const;
+
+  //! Find the first remaining candidate with a dose below a cutoff
+  unsigned findAcceptableCandidate(
+		   const BrachytherapyPatient &patient,
+		   const BrachytherapyCandidateTable &remaining_candidates,
+		   MinSegmentTree &candidate_doses,
+		   const double dose_cutoff ) const;
 
   //! Conduct the needle isodose constant iteration
   double conductNeedleIsodoseConstantIteration(
+	BrachytherapyPatient &patient,
 	const double start_constant,
 	const double end_constant,
 	const double step,
-        const std::list<BrachytherapySeedPosition> &remaining_seed_positions );
+	const BrachytherapyCandidateTable &remaining_candidates ) const;
 
   //! Calculate the minimum seed isodose constant
-  double calculateMinSeedIsodoseConstant() const;
+  double calculateMinSeedIsodoseConstant( 
+	    const BrachytherapyDoseMatrixSettings &dose_matrix_settings,
+	    const unsigned number_of_threads ) const;
 
   //! Print the treatment plan summary
   void printTreatmentPlanSummary( std::ostream &os ) const;
@@ -78,8 +210,23 @@ private:
   // Optimization time
   double d_opt_time;
 
-  // Seed positions
-  std::list<BrachytherapySeedPosition> d_seed_positions;
+  // The number of threads used by the isodose constant iteration
+  unsigned d_number_of_threads;
+
+  // Search for the first successful needle goal and isodose constant
+  bool d_search_trials;
+
+  // The number of trials below a search result that are conducted in order
+  unsigned d_verification_window;
+
+  // The number of isodose constant trials conducted
+  unsigned d_number_of_trials;
+
+  // The seed selection trace of each isodose constant
+  std::vector<SeedSelectionTrace> d_seed_selection_traces;
+
+  // Candidate seed positions (sorted by weight)
+  BrachytherapyCandidateTable d_candidates;
 };
 
 } // end TPOR namespace
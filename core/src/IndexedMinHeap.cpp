@@ -0,0 +1,273 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   IndexedMinHeap.cpp
+//! \author Alex Robinson
+//! \brief  Indexed d-ary min heap class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <limits>
+
+// TPOR Includes
+#include "IndexedMinHeap.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Initialize the static member data
+const unsigned IndexedMinHeap::not_stored =
+  std::numeric_limits<unsigned>::max();
+
+// Constructor
+IndexedMinHeap::IndexedMinHeap( const unsigned number_of_ids,
+				const unsigned arity )
+  : d_arity( arity ),
+    d_heap(),
+    d_heap_positions( number_of_ids, not_stored ),
+    d_keys( number_of_ids, 0.0 )
+{
+  // Make sure that the arity is valid
+  testPrecondition( arity >= 2u );
+}
+
+// Reset the heap for a number of ids (all ids are removed)
+void IndexedMinHeap::reset( const unsigned number_of_ids )
+{
+  d_heap.clear();
+  d_heap.reserve( number_of_ids );
+
+  d_heap_positions.assign( number_of_ids, not_stored );
+  d_keys.assign( number_of_ids, 0.0 );
+}
+
+// Return the number of ids that can be stored
+unsigned IndexedMinHeap::getNumberOfIds() const
+{
+  return d_heap_positions.size();
+}
+
+// Return the number of stored ids
+unsigned IndexedMinHeap::size() const
+{
+  return d_heap.size();
+}
+
+// Test if there are no stored ids
+bool IndexedMinHeap::empty() const
+{
+  return d_heap.empty();
+}
+
+// Test if an id is stored
+bool IndexedMinHeap::contains( const unsigned id ) const
+{
+  // Make sure that the id is valid
+  testPrecondition( id < d_heap_positions.size() );
+
+  return d_heap_positions[id] != not_stored;
+}
+
+// Return the key of a stored id
+double IndexedMinHeap::getKey( const unsigned id ) const
+{
+  // Make sure that the id is stored
+  testPrecondition( contains( id ) );
+
+  return d_keys[id];
+}
+
+// Return the stored id with the smallest key
+unsigned IndexedMinHeap::top() const
+{
+  // Make sure that the heap is not empty
+  testPrecondition( !empty() );
+
+  return d_heap.front();
+}
+
+// Return the smallest key
+double IndexedMinHeap::getTopKey() const
+{
+  // Make sure that the heap is not empty
+  testPrecondition( !empty() );
+
+  return d_keys[d_heap.front()];
+}
+
+// Store an id with a key
+void IndexedMinHeap::push( const unsigned id, const double key )
+{
+  // Make sure that the id is not stored
+  testPrecondition( !contains( id ) );
+  // Make sure that the key is valid
+  testPrecondition( key == key ); // Nan test
+
+  d_keys[id] = key;
+  d_heap_positions[id] = d_heap.size();
+  d_heap.push_back( id );
+
+  siftUp( d_heap.size() - 1u );
+}
+
+// Remove the stored id with the smallest key
+void IndexedMinHeap::pop()
+{
+  // Make sure that the heap is not empty
+  testPrecondition( !empty() );
+
+  remove( d_heap.front() );
+}
+
+// Change the key of a stored id (decrease-key or increase-key)
+void IndexedMinHeap::update( const unsigned id, const double key )
+{
+  // Make sure that the id is stored
+  testPrecondition( contains( id ) );
+  // Make sure that the key is valid
+  testPrecondition( key == key ); // Nan test
+
+  double old_key = d_keys[id];
+
+  d_keys[id] = key;
+
+  if( key < old_key )
+    siftUp( d_heap_positions[id] );
+  else if( key > old_key )
+    siftDown( d_heap_positions[id] );
+}
+
+// Remove a stored id
+/*! \details The last id in the heap is moved into the vacated position and
+ * is then sifted up or down as needed.
+ */
+void IndexedMinHeap::remove( const unsigned id )
+{
+  // Make sure that the id is stored
+  testPrecondition( contains( id ) );
+
+  unsigned heap_position = d_heap_positions[id];
+  unsigned last_heap_position = d_heap.size() - 1u;
+
+  if( heap_position != last_heap_position )
+    swap( heap_position, last_heap_position );
+
+  d_heap.pop_back();
+  d_heap_positions[id] = not_stored;
+
+  if( heap_position < d_heap.size() )
+  {
+    unsigned moved_id = d_heap[heap_position];
+
+    siftUp( heap_position );
+
+    if( d_heap_positions[moved_id] == heap_position )
+      siftDown( heap_position );
+  }
+}
+
+// Test if the heap order is valid
+bool IndexedMinHeap::isValid() const
+{
+  for( unsigned position = 1u; position < d_heap.size(); ++position )
+  {
+    if( isHigher( position, (position - 1u)/d_arity ) )
+      return false;
+  }
+
+  for( unsigned position = 0u; position < d_heap.size(); ++position )
+  {
+    if( d_heap_positions[d_heap[position]] != position )
+      return false;
+  }
+
+  return true;
+}
+
+// Test if the id at one heap position belongs above another
+/*! \details Ids with equal keys are ordered by id.
+ */
+bool IndexedMinHeap::isHigher( const unsigned heap_position_a,
+			       const unsigned heap_position_b ) const
+{
+  unsigned id_a = d_heap[heap_position_a];
+  unsigned id_b = d_heap[heap_position_b];
+
+  if( d_keys[id_a] < d_keys[id_b] )
+    return true;
+  else if( d_keys[id_b] < d_keys[id_a] )
+    return false;
+  else
+    return id_a < id_b;
+}
+
+// Swap the ids at two heap positions
+void IndexedMinHeap::swap( const unsigned heap_position_a,
+			   const unsigned heap_position_b )
+{
+  unsigned id_a = d_heap[heap_position_a];
+  unsigned id_b = d_heap[heap_position_b];
+
+  d_heap[heap_position_a] = id_b;
+  d_heap[heap_position_b] = id_a;
+
+  d_heap_positions[id_a] = heap_position_b;
+  d_heap_positions[id_b] = heap_position_a;
+}
+
+// Move the id at a heap position up until the heap order is restored
+void IndexedMinHeap::siftUp( unsigned heap_position )
+{
+  while( heap_position > 0u )
+  {
+    unsigned parent_position = (heap_position - 1u)/d_arity;
+
+    if( !isHigher( heap_position, parent_position ) )
+      break;
+
+    swap( heap_position, parent_position );
+
+    heap_position = parent_position;
+  }
+}
+
+// Move the id at a heap position down until the heap order is restored
+void IndexedMinHeap::siftDown( unsigned heap_position )
+{
+  while( true )
+  {
+    unsigned first_child_position = heap_position*d_arity + 1u;
+
+    if( first_child_position >= d_heap.size() )
+      break;
+
+    unsigned end_child_position = first_child_position + d_arity;
+
+    if( end_child_position > d_heap.size() )
+      end_child_position = d_heap.size();
+
+    // Find the highest child
+    unsigned highest_child_position = first_child_position;
+
+    for( unsigned child_position = first_child_position + 1u;
+	 child_position < end_child_position;
+	 ++child_position )
+    {
+      if( isHigher( child_position, highest_child_position ) )
+	highest_child_position = child_position;
+    }
+
+    if( !isHigher( highest_child_position, heap_position ) )
+      break;
+
+    swap( heap_position, highest_child_position );
+
+    heap_position = highest_child_position;
+  }
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end IndexedMinHeap.cpp
+//---------------------------------------------------------------------------//
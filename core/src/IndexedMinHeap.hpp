@@ -0,0 +1,115 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   IndexedMinHeap.hpp
+//! \author Alex Robinson
+//! \brief  Indexed d-ary min heap class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef INDEXED_MIN_HEAP_HPP
+#define INDEXED_MIN_HEAP_HPP
+
+// Std Lib Includes
+#include <vector>
+
+namespace TPOR{
+
+/*! Indexed d-ary min heap
+ *
+ * The heap stores a subset of the ids 0,...,N-1 with a key for each stored
+ * id. The position of every id in the heap is tracked so that the key of any
+ * stored id can be decreased or increased, and any stored id can be removed,
+ * in O(log N) time. Ids with equal keys are ordered by id (the smallest id
+ * is at the top), which matches the first minimum found by a linear scan
+ * over the ids (e.g. std::min_element).
+ */
+class IndexedMinHeap
+{
+
+public:
+
+  //! Constructor
+  explicit IndexedMinHeap( const unsigned number_of_ids = 0u,
+			   const unsigned arity = 4u );
+
+  //! Destructor
+  ~IndexedMinHeap()
+  { /* ... */ }
+
+  //! Reset the heap for a number of ids (all ids are removed)
+  void reset( const unsigned number_of_ids );
+
+  //! Return the number of ids that can be stored
+  unsigned getNumberOfIds() const;
+
+  //! Return the number of stored ids
+  unsigned size() const;
+
+  //! Test if there are no stored ids
+  bool empty() const;
+
+  //! Test if an id is stored
+  bool contains( const unsigned id ) const;
+
+  //! Return the key of a stored id
+  double getKey( const unsigned id ) const;
+
+  //! Return the stored id with the smallest key
+  unsigned top() const;
+
+  //! Return the smallest key
+  double getTopKey() const;
+
+  //! Store an id with a key
+  void push( const unsigned id, const double key );
+
+  //! Remove the stored id with the smallest key
+  void pop();
+
+  //! Change the key of a stored id (decrease-key or increase-key)
+  void update( const unsigned id, const double key );
+
+  //! Remove a stored id
+  void remove( const unsigned id );
+
+  //! Test if the heap order is valid
+  bool isValid() const;
+
+private:
+
+  //! Test if the id at one heap position belongs above another
+  bool isHigher( const unsigned heap_position_a,
+		 const unsigned heap_position_b ) const;
+
+  //! Swap the ids at two heap positions
+  void swap( const unsigned heap_position_a, const unsigned heap_position_b );
+
+  //! Move the id at a heap position up until the heap order is restored
+  void siftUp( unsigned heap_position );
+
+  //! Move the id at a heap position down until the heap order is restored
+  void siftDown( unsigned heap_position );
+
+  // The value that marks an id that is not stored
+  static const unsigned not_stored;
+
+  // The heap arity
+  unsigned d_arity;
+
+  // The stored ids in heap order
+  std::vector<unsigned> d_heap;
+
+  // The heap position of each id (not_stored if the id is not stored)
+  std::vector<unsigned> d_heap_positions;
+
+  // The key of each id
+  std::vector<double> d_keys;
+};
+
+} // end TPOR namespace
+
+#endif // end INDEXED_MIN_HEAP_HPP
+
+//---------------------------------------------------------------------------//
+// end IndexedMinHeap.hpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,144 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   MinSegmentTree.cpp
+//! \author Alex Robinson
+//! \brief  Minimum segment tree class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <algorithm>
+#include <limits>
+
+// TPOR Includes
+#include "MinSegmentTree.hpp"
+#include "ContractException.hpp"
+
+namespace TPOR{
+
+// Constructor
+MinSegmentTree::MinSegmentTree( const unsigned number_of_ids )
+  : d_size( 0u ),
+    d_first_leaf( 1u ),
+    d_nodes()
+{
+  resize( number_of_ids );
+}
+
+// Reset the tree for a number of ids (all values are infinite)
+void MinSegmentTree::reset( const unsigned number_of_ids )
+{
+  resize( number_of_ids );
+}
+
+// Reset the tree with the value of each id
+/*! \details The inner nodes are filled bottom-up in O(N) time.
+ */
+void MinSegmentTree::reset( const std::vector<double> &values )
+{
+  resize( values.size() );
+
+  std::copy( values.begin(), values.end(), d_nodes.begin() + d_first_leaf );
+
+  for( unsigned node = d_first_leaf - 1u; node > 0u; --node )
+    d_nodes[node] = std::min( d_nodes[2u*node], d_nodes[2u*node+1u] );
+}
+
+// Return the number of ids
+unsigned MinSegmentTree::size() const
+{
+  return d_size;
+}
+
+// Return the value of an id
+double MinSegmentTree::getValue( const unsigned id ) const
+{
+  // Make sure that the id is valid
+  testPrecondition( id < d_size );
+
+  return d_nodes[d_first_leaf+id];
+}
+
+// Return the smallest value
+double MinSegmentTree::getMinValue() const
+{
+  return d_nodes[1];
+}
+
+// Set the value of an id
+void MinSegmentTree::setValue( const unsigned id, const double value )
+{
+  // Make sure that the id is valid
+  testPrecondition( id < d_size );
+
+  unsigned node = d_first_leaf + id;
+
+  d_nodes[node] = value;
+
+  for( node /= 2u; node > 0u; node /= 2u )
+  {
+    double min_value = std::min( d_nodes[2u*node], d_nodes[2u*node+1u] );
+
+    // The nodes above are not changed either
+    if( d_nodes[node] == min_value )
+      break;
+
+    d_nodes[node] = min_value;
+  }
+}
+
+// Return the first id with a value below a limit (size() if none)
+/*! \details The search descends into the left child whenever it holds a
+ * value below the limit.
+ */
+unsigned MinSegmentTree::findFirstBelow( const double limit ) const
+{
+  if( !(d_nodes[1] < limit) )
+    return d_size;
+
+  unsigned node = 1u;
+
+  while( node < d_first_leaf )
+  {
+    node *= 2u;
+
+    if( !(d_nodes[node] < limit) )
+      ++node;
+  }
+
+  // Make sure that a stored id was found
+  testPostcondition( node - d_first_leaf < d_size );
+
+  return node - d_first_leaf;
+}
+
+// Test if every node stores the smallest value below it
+bool MinSegmentTree::isValid() const
+{
+  for( unsigned node = 1u; node < d_first_leaf; ++node )
+  {
+    if( d_nodes[node] != std::min( d_nodes[2u*node], d_nodes[2u*node+1u] ) )
+      return false;
+  }
+
+  return true;
+}
+
+// Resize the tree for a number of ids (all values are infinite)
+void MinSegmentTree::resize( const unsigned number_of_ids )
+{
+  d_size = number_of_ids;
+
+  d_first_leaf = 1u;
+
+  while( d_first_leaf < number_of_ids )
+    d_first_leaf *= 2u;
+
+  d_nodes.assign( 2u*d_first_leaf, std::numeric_limits<double>::infinity() );
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end MinSegmentTree.cpp
+//---------------------------------------------------------------------------//
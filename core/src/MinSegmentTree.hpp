@@ -0,0 +1,83 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   MinSegmentTree.hpp
+//! \author Alex Robinson
+//! \brief  Minimum segment tree class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef MIN_SEGMENT_TREE_HPP
+#define MIN_SEGMENT_TREE_HPP
+
+// Std Lib Includes
+#include <vector>
+
+namespace TPOR{
+
+/*! Minimum segment tree
+ *
+ * The tree stores a value for each of the ids 0,...,N-1. Every node of the
+ * tree stores the smallest value of the ids below it, so the value of any
+ * id can be changed and the first id (in id order) with a value below a
+ * limit can be found in O(log N) time. Ids that should never be found can
+ * be given an infinite value.
+ */
+class MinSegmentTree
+{
+
+public:
+
+  //! Constructor
+  explicit MinSegmentTree( const unsigned number_of_ids = 0u );
+
+  //! Destructor
+  ~MinSegmentTree()
+  { /* ... */ }
+
+  //! Reset the tree for a number of ids (all values are infinite)
+  void reset( const unsigned number_of_ids );
+
+  //! Reset the tree with the value of each id
+  void reset( const std::vector<double> &values );
+
+  //! Return the number of ids
+  unsigned size() const;
+
+  //! Return the value of an id
+  double getValue( const unsigned id ) const;
+
+  //! Return the smallest value
+  double getMinValue() const;
+
+  //! Set the value of an id
+  void setValue( const unsigned id, const double value );
+
+  //! Return the first id with a value below a limit (size() if none)
+  unsigned findFirstBelow( const double limit ) const;
+
+  //! Test if every node stores the smallest value below it
+  bool isValid() const;
+
+private:
+
+  //! Resize the tree for a number of ids (all values are infinite)
+  void resize( const unsigned number_of_ids );
+
+  // The number of ids
+  unsigned d_size;
+
+  // The node of the first id (the number of leaves - a power of two)
+  unsigned d_first_leaf;
+
+  // The node values (node n has the children 2n and 2n+1, node 1 is the
+  // root and the leaves past the last id are infinite)
+  std::vector<double> d_nodes;
+};
+
+} // end TPOR namespace
+
+#endif // end MIN_SEGMENT_TREE_HPP
+
+//---------------------------------------------------------------------------//
+// end MinSegmentTree.hpp
+//---------------------------------------------------------------------------//
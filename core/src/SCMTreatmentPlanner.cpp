@@ -12,9 +12,12 @@
 #include <iomanip>
 #include <math.h>
 #include <limits>
+#include <utility>
 
 // Boost Includes
 #include <boost/chrono.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 
 // TPOR Includes
 #include "SCMTreatmentPlanner.hpp"
@@ -25,21 +28,95 @@ namespace TPOR{
 // Initialize the name static member
 const std::string SCMTreatmentPlanner::name = "SCMTreatmentPlanner";
 
+// Initialize the smallest number of candidates evaluated by a thread
+const unsigned SCMTreatmentPlanner::min_candidates_per_thread = 64u;
+
+// Initialize the support dose fraction static member
+const double SCMTreatmentPlanner::support_dose_fraction = 0.01;
+
 // Constructor
 SCMTreatmentPlanner::SCMTreatmentPlanner(
 	 const boost::shared_ptr<BrachytherapyPatient> &patient,
-	 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds )
+	 const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	 const bool lazy_evaluation,
+	 const BrachytherapyDoseMatrixSettings &dose_matrix_settings,
+	 const unsigned number_of_threads,
+	 const std::vector<bool> &candidate_needle_mask )
   : d_patient( patient ),
     d_opt_time( 0.0 ),
-    d_seed_positions()
+    d_lazy_evaluation( lazy_evaluation ),
+    d_number_of_threads( number_of_threads ),
+    d_candidates( patient->getOrganMeshXDim(),
+		  patient->getOrganMeshYDim(),
+		  patient->getOrganMeshZDim() ),
+    d_dose_supports(),
+    d_number_of_updates( 0u ),
+    d_weight_updates(),
+    d_occupied_candidates(),
+    d_skipped_candidates(),
+    d_updated_candidates(),
+    d_evaluated_candidates(),
+    d_evaluated_weights(),
+    d_group_indices(),
+    d_group_offsets(),
+    d_dose_matrix()
 {
-  // Get the potential seed positions
-  typedef BrachytherapySetCoverSeedPosition SeedPosition;
+  // Get the candidate seed positions (the base weight is the cost)
+  d_patient->getCandidateSeedPositions( seeds, 
+					d_candidates,
+					candidate_needle_mask );
+
+  // Store the candidate doses in the prostate (if requested)
+  if( dose_matrix_settings.memory_budget > 0.0 )
+  {
+    d_dose_matrix.reset( 
+	       new BrachytherapyDoseMatrix( d_candidates,
+					    d_patient->getProstateMask(),
+					    dose_matrix_settings,
+					    number_of_threads ) );
+
+    if( !d_dose_matrix->isStored() )
+    {
+      std::cout << "Warning: the dose matrix does not fit in the memory "
+		<< "budget. The seed dose meshes will be used." << std::endl;
 
-  std::list<SeedPosition> seed_positions = 
-    d_patient->getPotentialSeedPositions<SeedPosition>( seeds );
+      d_dose_matrix.reset();
+    }
+  }
+
+  if( d_number_of_threads == 0 )
+  {
+    d_number_of_threads = 
+      std::max( boost::thread::hardware_concurrency(), 1u );
+  }
 
-  d_seed_positions.splice( d_seed_positions.end(), seed_positions );
+  // Index the candidate positions
+  d_candidates.buildPositionIndex();
+
+  // Calculate the initial cost/coverage of each candidate
+  d_evaluated_candidates.resize( d_candidates.getNumberOfCandidates() );
+  
+  for( unsigned c = 0; c < d_candidates.getNumberOfCandidates(); ++c )
+    d_evaluated_candidates[c] = c;
+
+  updateCandidateWeights( d_evaluated_candidates );
+
+  // All candidates have been evaluated with the initial dose distribution
+  d_weight_updates.resize( d_candidates.getNumberOfCandidates(), 0u );
+
+  // Find the dose support of each seed
+  const double dose_threshold = 
+    support_dose_fraction*d_patient->getPrescribedDose();
+  
+  for( unsigned seed_id = 0; seed_id < d_candidates.getNumberOfSeeds();
+       ++seed_id )
+  {
+    d_dose_supports.push_back( d_candidates.getSeedWithId( seed_id )->
+			       getDoseSupport( dose_threshold ) );
+  }
+
+  // Queue the candidates by dynamic weight (cost/coverage)
+  d_candidates.enableDynamicWeightQueue();
 }
 
 // Calculate optimum treatment plan
@@ -51,33 +128,29 @@ void SCMTreatmentPlanner::calculateOptimumTreatmentPlan()
   boost::chrono::steady_clock::time_point start_clock =
     boost::chrono::steady_clock::now();
 
-  std::list<BrachytherapySetCoverSeedPosition>::iterator position;
+  unsigned candidate;
 
   // Select the first seed position
-  position = min_element( d_seed_positions.begin(), d_seed_positions.end() );
-  d_patient->insertSeed( *position );
-  position = d_seed_positions.erase( position );
-  updateSeedPositions();
+  candidate = selectCandidate();
+  insertSeed( candidate );
 
   // Select the seed position with the smallest cost/coverage (weight) until
   // 98% of the prostate volume recieves the prescribed dose
   while( d_patient->getProstatePrescribedDoseCoverage() < 0.98 &&
-	 d_seed_positions.size() > 0 )
+	 d_candidates.getNumberOfAliveCandidates() > 0 )
   {
-    position = min_element( d_seed_positions.begin(), d_seed_positions.end() );
+    candidate = selectCandidate();
 
-    d_patient->insertSeed( *position );
-    position = d_seed_positions.erase( position );
-    updateSeedPositions();
+    insertSeed( candidate );
 
     // Determine if a needle penalty must be applied
     // while(true)
     // {
     //   // No penalty for using the same needle
-    //   if( d_patient->isSeedOnNeedle( *position ) )
+    //   if( d_patient->isSeedOnNeedle( d_candidates, candidate ) )
     //   {
-    // 	d_patient->insertSeed( *position );
-    // 	position = d_seed_positions.erase( position );
+    // 	d_patient->insertSeed( d_candidates.createSeedPosition( candidate ) );
+    // 	d_candidates.removeCandidate( candidate );
     // 	updateSeedPositions();
     // 	break;
     //   }
@@ -90,17 +163,16 @@ void SCMTreatmentPlanner::calculateOptimumTreatmentPlan()
     // 	  0.5*sqrt((30.0*30.0+(num_needles+1)*(num_needles+1))/
     // 		   (30.0*30.0-(num_needles+1)*(num_needles+1)));
 	
-    // 	position->multiplyWeight( needle_penalty );
+    // 	d_candidates.multiplyDynamicWeight( candidate, needle_penalty );
 
-    // 	std::list<BrachytherapyDynamicWeightSeedPosition>::iterator 
-    // 	  test_position = min_element( d_seed_positions.begin(), 
-    // 				       d_seed_positions.end() );
+    // 	unsigned test_candidate = 
+    // 	  d_candidates.findMinimumDynamicWeightCandidate();
 
     // 	// The needle penalty had no effect
-    // 	if( position == test_position )
+    // 	if( candidate == test_candidate )
     // 	{
-    // 	  d_patient->insertSeed( *position );
-    // 	  position = d_seed_positions.erase( position );
+    // 	  d_patient->insertSeed( d_candidates.createSeedPosition( candidate ) );
+    // 	  d_candidates.removeCandidate( candidate );
     // 	  updateSeedPositions();
     // 	  break;
     // 	}
@@ -109,7 +181,7 @@ void SCMTreatmentPlanner::calculateOptimumTreatmentPlan()
     // 	// applied
     // 	else
     // 	{
-    // 	  position = test_position;
+    // 	  candidate = test_candidate;
     // 	}
     //   }
     // }
@@ -137,23 +209,435 @@ void SCMTreatmentPlanner::calculateOptimumTreatmentPlan()
   printTreatmentPlanSummary( std::cout );
 }
 
+// Select the candidate with the smallest cost/coverage (weight)
+/*! \details The weights in the queue may be out of date (every weight in 
+ * lazy evaluation mode and the weights of the candidates outside of the dose
+ * support of the inserted seeds in eager mode). The coverage of a candidate
+ * can only decrease as dose is added to the prostate, so an out of date 
+ * weight is a lower bound of the current weight. The candidate at the top of
+ * the queue is re-evaluated until a candidate that is up to date stays on 
+ * top. This is the candidate that a re-evaluation of every candidate would 
+ * select (ties are broken by candidate index). The out of date candidates of
+ * the other seeds at the position of the candidate are re-evaluated with it
+ * (they share the walk over the dose distribution).
+ */
+unsigned SCMTreatmentPlanner::selectCandidate()
+{
+  unsigned candidate = d_candidates.findMinimumDynamicWeightCandidate();
+
+  while( candidate < d_candidates.getNumberOfCandidates() &&
+	 d_weight_updates[candidate] < d_number_of_updates )
+  {
+    unsigned position_id = d_candidates.getPositionId( candidate );
+
+    d_evaluated_candidates.clear();
+
+    for( unsigned i = 0; 
+	 i < d_candidates.getNumberOfPositionCandidates( position_id );
+	 ++i )
+    {
+      unsigned position_candidate = 
+	d_candidates.getPositionCandidate( position_id, i );
+
+      if( d_candidates.isAlive( position_candidate ) &&
+	  d_weight_updates[position_candidate] < d_number_of_updates )
+      {
+	d_evaluated_candidates.push_back( position_candidate );
+
+	d_weight_updates[position_candidate] = d_number_of_updates;
+      }
+    }
+
+    updateCandidateWeights( d_evaluated_candidates );
+
+    candidate = d_candidates.findMinimumDynamicWeightCandidate();
+  }
+
+  return candidate;
+}
+
+// Insert a seed at a candidate seed position and update the candidates
+/*! \details The candidates are updated before the seed dose is added to 
+ * the patient. The candidates that the update skips keep their weight from
+ * the previous selection, so they are brought up to date before the seed is
+ * inserted. In eager mode the candidates whose dose support overlaps the 
+ * dose support of the inserted seed (and the candidates skipped by the 
+ * previous update) are re-evaluated once the seed has been inserted. The 
+ * coverages of the other candidates change by a small fraction. Every other
+ * weight is out of date after the insertion and is re-evaluated when it
+ * reaches the top of the queue.
+ */
+void SCMTreatmentPlanner::insertSeed( const unsigned candidate )
+{
+  BrachytherapySeedPosition seed_position = 
+    d_candidates.createSeedPosition( candidate );
+  
+  d_candidates.removeCandidate( candidate );
+
+  std::vector<unsigned> skipped_candidates;
+
+  updateSeedPositions( candidate, skipped_candidates );
+
+  d_evaluated_candidates.clear();
+    
+  for( unsigned i = 0; i < skipped_candidates.size(); ++i )
+  {
+    unsigned skipped_candidate = skipped_candidates[i];
+      
+    if( d_weight_updates[skipped_candidate] < d_number_of_updates )
+      d_evaluated_candidates.push_back( skipped_candidate );
+
+    d_weight_updates[skipped_candidate] = d_number_of_updates + 1u;
+  }
+
+  updateCandidateWeights( d_evaluated_candidates );
+
+  d_patient->insertSeed( seed_position );
+
+  ++d_number_of_updates;
+
+  d_evaluated_candidates.clear();
+  
+  for( unsigned i = 0; i < d_updated_candidates.size(); ++i )
+  {
+    unsigned updated_candidate = d_updated_candidates[i];
+
+    if( std::binary_search( skipped_candidates.begin(),
+			    skipped_candidates.end(),
+			    updated_candidate ) )
+      continue;
+    
+    d_evaluated_candidates.push_back( updated_candidate );
+
+    d_weight_updates[updated_candidate] = d_number_of_updates;
+  }
+
+  updateCandidateWeights( d_evaluated_candidates );
+
+  d_skipped_candidates.swap( skipped_candidates );
+}
+
 // Update the seed positions
-void SCMTreatmentPlanner::updateSeedPositions()
+/*! \details The candidates at occupied positions (including the position of
+ * the seed that is about to be inserted) are removed. The original list 
+ * based implementation updated the candidates with a single pass in which 
+ * the candidate that followed a removed candidate was skipped. The occupied
+ * candidates are removed in the same order and the skipped candidates that
+ * are never visited are returned so that the treatment plans are unchanged.
+ * In eager mode the candidates whose dose support overlaps the dose support
+ * of the inserted seed and the candidates skipped by the previous update are
+ * stored as the candidates to update.
+ */
+void SCMTreatmentPlanner::updateSeedPositions( 
+				   const unsigned inserted_candidate,
+				   std::vector<unsigned> &skipped_candidates )
 {
-  std::list<BrachytherapySetCoverSeedPosition>::iterator position,
-    end_position;
+  const unsigned mesh_x_dim = d_patient->getOrganMeshXDim();
+  const unsigned mesh_y_dim = d_patient->getOrganMeshYDim();
+  const unsigned mesh_z_dim = d_patient->getOrganMeshZDim();
+  
+  const int x_index = d_candidates.getXIndex( inserted_candidate );
+  const int y_index = d_candidates.getYIndex( inserted_candidate );
+  const int z_index = d_candidates.getZIndex( inserted_candidate );
+  
+  // Remove the candidates at the inserted seed position
+  DoseDistributionOverlap position_box = { x_index, x_index + 1,
+					   y_index, y_index + 1,
+					   z_index, z_index + 1 };
+  
+  d_candidates.findAliveCandidatesInBox( position_box, 
+					 d_occupied_candidates );
+  
+  d_candidates.removeOccupiedCandidates( d_occupied_candidates,
+					 skipped_candidates );
+
+  // Find the candidates to re-evaluate (eager evaluation)
+  d_updated_candidates.clear();
 
-  position = d_seed_positions.begin();
-  end_position = d_seed_positions.end();
+  if( d_lazy_evaluation )
+    return;
+  
+  DoseDistributionOverlap support_box = 
+    BrachytherapySeedProxy::getDoseSupportOverlap( 
+		 d_dose_supports[d_candidates.getSeedId( inserted_candidate )],
+		 x_index,
+		 y_index,
+		 z_index,
+		 mesh_x_dim,
+		 mesh_y_dim,
+		 mesh_z_dim );
+
+  for( unsigned seed_id = 0; seed_id < d_candidates.getNumberOfSeeds(); 
+       ++seed_id )
+  {
+    DoseDistributionOverlap seed_position_box = 
+      BrachytherapySeedProxy::getSupportPositionOverlap( 
+						   d_dose_supports[seed_id],
+						   support_box,
+						   mesh_x_dim,
+						   mesh_y_dim,
+						   mesh_z_dim );
+
+    d_candidates.findAliveCandidatesInBox( seed_position_box,
+					   seed_id,
+					   d_updated_candidates );
+  }
 
-  while( position != end_position )
+  for( unsigned i = 0; i < d_skipped_candidates.size(); ++i )
   {
-    if( d_patient->isSeedPositionFree( *position ) )
-      position->updateWeight();
+    if( d_candidates.isAlive( d_skipped_candidates[i] ) )
+      d_updated_candidates.push_back( d_skipped_candidates[i] );
+  }
+}
+
+// Update the dynamic weights (cost/coverage) of a set of candidates
+/*! \details The candidates are grouped by seed position and the weights of
+ * the groups are calculated in parallel (the groups are divided among the
+ * threads). The weights are then stored in the candidate table by this 
+ * thread, in the order of the candidates. The stored weights and the 
+ * selected candidates do not depend on the number of threads. A candidate 
+ * with no coverage has an infinite weight.
+ */
+void SCMTreatmentPlanner::updateCandidateWeights( 
+				   const std::vector<unsigned> &candidates )
+{
+  groupCandidatesByPosition( candidates );
+  
+  unsigned threads = std::min( d_number_of_threads, 
+			       (unsigned)candidates.size()/
+			       min_candidates_per_thread );
+  
+  d_evaluated_weights.resize( candidates.size() );
+  
+  if( threads <= 1 )
+  {
+    calculatePositionWeightStride( candidates, d_evaluated_weights, 0u, 1u );
+  }
+  else
+  {
+    boost::thread_group thread_group;
+
+    for( unsigned i = 0; i < threads; ++i )
+    {
+      thread_group.create_thread( 
+	   boost::bind( &SCMTreatmentPlanner::calculatePositionWeightStride,
+			this,
+			boost::cref( candidates ),
+			boost::ref( d_evaluated_weights ),
+			i,
+			threads ) );
+    }
+
+    thread_group.join_all();
+  }
+
+  for( unsigned i = 0; i < candidates.size(); ++i )
+    d_candidates.setDynamicWeight( candidates[i], d_evaluated_weights[i] );
+}
+
+// Group a set of candidates by seed position
+/*! \details The groups are ordered by position id and the candidates of 
+ * each group keep their order in the set.
+ */
+void SCMTreatmentPlanner::groupCandidatesByPosition( 
+				   const std::vector<unsigned> &candidates )
+{
+  std::vector<std::pair<unsigned,unsigned> > position_ids( candidates.size() );
+
+  for( unsigned i = 0; i < candidates.size(); ++i )
+  {
+    position_ids[i].first = d_candidates.getPositionId( candidates[i] );
+    position_ids[i].second = i;
+  }
+
+  std::sort( position_ids.begin(), position_ids.end() );
+
+  d_group_indices.resize( candidates.size() );
+  d_group_offsets.assign( 1u, 0u );
+
+  for( unsigned i = 0; i < position_ids.size(); ++i )
+  {
+    if( i > 0 && position_ids[i].first != position_ids[i-1].first )
+      d_group_offsets.push_back( i );
+
+    d_group_indices[i] = position_ids[i].second;
+  }
+
+  if( candidates.size() > 0 )
+    d_group_offsets.push_back( candidates.size() );
+}
+
+// Calculate the weights of every n-th position group, starting from the
+// first
+void SCMTreatmentPlanner::calculatePositionWeightStride( 
+				      const std::vector<unsigned> &candidates,
+				      std::vector<double> &weights,
+				      const unsigned first_group,
+				      const unsigned stride ) const
+{
+  std::vector<unsigned> position_candidates;
+  std::vector<double> coverages;
+  
+  for( unsigned g = first_group; g + 1u < d_group_offsets.size(); g += stride )
+  {
+    position_candidates.clear();
+    
+    for( unsigned i = d_group_offsets[g]; i < d_group_offsets[g+1u]; ++i )
+      position_candidates.push_back( candidates[d_group_indices[i]] );
+
+    calculatePositionCoverages( position_candidates, coverages );
+
+    for( unsigned i = 0; i < position_candidates.size(); ++i )
+    {
+      unsigned index = d_group_indices[d_group_offsets[g] + i];
+      
+      if( coverages[i] == 0.0 )
+	weights[index] = std::numeric_limits<double>::infinity();
+      else
+      {
+	weights[index] = 
+	  d_candidates.getBaseWeight( position_candidates[i] )/coverages[i];
+      }
+    }
+  }
+}
+
+// Calculate the coverages of the candidates at a seed position
+/*! \details The coverage is the dose that the candidate seed would add to 
+ * the prostate elements that have not reached the prescribed dose (capped at
+ * the prescribed dose). The coverage is a sparse dot product if the dose 
+ * matrix has been stored. Otherwise the open prostate elements (below the 
+ * prescribed dose) of each row of the position are found once and the seed
+ * dose meshes of every candidate are only read at these elements. The 
+ * elements of each candidate are summed in mesh order, so the coverages 
+ * equal the coverages calculated candidate by candidate.
+ */
+void SCMTreatmentPlanner::calculatePositionCoverages( 
+			     const std::vector<unsigned> &position_candidates,
+			     std::vector<double> &coverages ) const
+{
+  const std::vector<double>& dose_distribution = 
+    d_patient->getDoseDistribution();
+  const std::vector<bool>& prostate_mask = d_patient->getProstateMask();
+  
+  const double prescribed_dose = d_patient->getPrescribedDose();
+
+  coverages.assign( position_candidates.size(), 0.0 );
+
+  if( d_dose_matrix )
+  {
+    for( unsigned c = 0; c < position_candidates.size(); ++c )
+    {
+      coverages[c] = d_dose_matrix->calculateCoverage( position_candidates[c],
+						       dose_distribution,
+						       prescribed_dose );
+    }
+
+    return;
+  }
+  
+  const unsigned mesh_x_dim = d_patient->getOrganMeshXDim();
+  const unsigned mesh_y_dim = d_patient->getOrganMeshYDim();
+  const unsigned mesh_z_dim = d_patient->getOrganMeshZDim();
+  
+  const int x_index = d_candidates.getXIndex( position_candidates.front() );
+  const int y_index = d_candidates.getYIndex( position_candidates.front() );
+  const int z_index = d_candidates.getZIndex( position_candidates.front() );
+
+  // Only the mesh elements that overlap a seed mesh can be covered
+  std::vector<DoseDistributionOverlap> overlaps( position_candidates.size() );
+  
+  DoseDistributionOverlap position_overlap;
+
+  for( unsigned c = 0; c < position_candidates.size(); ++c )
+  {
+    const BrachytherapySeedProxy &seed = 
+      *d_candidates.getSeed( position_candidates[c] );
+    
+    overlaps[c] = seed.getDoseDistributionOverlap( x_index,
+						   y_index,
+						   z_index,
+						   mesh_x_dim,
+						   mesh_y_dim,
+						   mesh_z_dim );
+    
+    if( c == 0 )
+      position_overlap = overlaps[c];
     else
-      position = d_seed_positions.erase( position );
+    {
+      position_overlap.x_start = 
+	std::min( position_overlap.x_start, overlaps[c].x_start );
+      position_overlap.x_end = 
+	std::max( position_overlap.x_end, overlaps[c].x_end );
+      position_overlap.y_start = 
+	std::min( position_overlap.y_start, overlaps[c].y_start );
+      position_overlap.y_end = 
+	std::max( position_overlap.y_end, overlaps[c].y_end );
+      position_overlap.z_start = 
+	std::min( position_overlap.z_start, overlaps[c].z_start );
+      position_overlap.z_end = 
+	std::max( position_overlap.z_end, overlaps[c].z_end );
+    }
+  }
+
+  std::vector<int> open_elements;
+  double future_dose;
+  
+  for( int k = position_overlap.z_start; k < position_overlap.z_end; ++k )
+  {
+    for( int j = position_overlap.y_start; j < position_overlap.y_end; ++j )
+    {
+      unsigned row_index = j*mesh_x_dim + k*mesh_x_dim*mesh_y_dim;
+
+      // Find the open prostate elements of the row
+      open_elements.clear();
+      
+      for( int i = position_overlap.x_start; i < position_overlap.x_end; ++i )
+      {
+	unsigned index = i + row_index;
+
+	if( prostate_mask[index] && dose_distribution[index] < prescribed_dose )
+	  open_elements.push_back( i );
+      }
+
+      if( open_elements.empty() )
+	continue;
 
-    ++position;
+      for( unsigned c = 0; c < position_candidates.size(); ++c )
+      {
+	const DoseDistributionOverlap &overlap = overlaps[c];
+
+	if( k < overlap.z_start || k >= overlap.z_end ||
+	    j < overlap.y_start || j >= overlap.y_end )
+	  continue;
+	
+	const BrachytherapySeedProxy &seed = 
+	  *d_candidates.getSeed( position_candidates[c] );
+	
+	const double* seed_dose_row = 
+	  seed.getTotalDoseRow( overlap.x_start - x_index, 
+				j - y_index, 
+				k - z_index );
+
+	for( unsigned e = 0; e < open_elements.size(); ++e )
+	{
+	  int i = open_elements[e];
+
+	  if( i < overlap.x_start || i >= overlap.x_end )
+	    continue;
+	  
+	  unsigned index = i + row_index;
+	  
+	  future_dose = dose_distribution[index] +
+	    seed_dose_row[i - overlap.x_start];
+	  
+	  if( future_dose < prescribed_dose )
+	    coverages[c] += future_dose - dose_distribution[index];
+	  else
+	    coverages[c] += prescribed_dose - dose_distribution[index];
+	}
+      }
+    }
   }
 }
 
@@ -171,6 +655,12 @@ void SCMTreatmentPlanner::printTreatmentPlanSummary( std::ostream &os ) const
      << std::endl;
   os << "Seeds Chosen:               " << d_patient->getNumInsertedSeeds()
      << std::endl;
+  
+  if( d_dose_matrix )
+  {
+    os << "Dose Matrix Memory (MB):    " << d_dose_matrix->getMemoryUsage()
+       << std::endl;
+  }
 }
 
 } // end TPOR namespace
@@ -14,10 +14,14 @@
 #include <iostream>
 #include <vector>
 
+// Boost Includes
+#include <boost/scoped_ptr.hpp>
+
 // TPOR Includes
 #include "BrachytherapyTreatmentPlanner.hpp"
 #include "BrachytherapyPatient.hpp"
-#include "BrachytherapySetCoverSeedPosition.hpp"
+#include "BrachytherapyCandidateTable.hpp"
+#include "BrachytherapyDoseMatrix.hpp"
 
 namespace TPOR{
 
@@ -30,7 +34,12 @@ public:
   //! Constructor
   SCMTreatmentPlanner(
 	const boost::shared_ptr<BrachytherapyPatient> &patient,
-	const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds );
+	const std::vector<boost::shared_ptr<BrachytherapySeedProxy> > &seeds,
+	const bool lazy_evaluation = true,
+	const BrachytherapyDoseMatrixSettings &dose_matrix_settings = 
+	BrachytherapyDoseMatrixSettings(),
+	const unsigned number_of_threads = 0u,
+	const std::vector<bool> &candidate_needle_mask = std::vector<bool>() );
 
   //! Destructor
   ~SCMTreatmentPlanner()
@@ -44,8 +53,34 @@ public:
 
 private:
 
+  //! Select the candidate with the smallest cost/coverage (weight)
+  unsigned selectCandidate();
+
+  //! Insert a seed at a candidate seed position and update the candidates
+  void insertSeed( const unsigned candidate );
+
   //! Update the seed positions
-  void updateSeedPositions();
+  void updateSeedPositions( const unsigned inserted_candidate,
+			    std::vector<unsigned> &skipped_candidates );
+
+  //! Update the dynamic weights (cost/coverage) of a set of candidates
+  void updateCandidateWeights( const std::vector<unsigned> &candidates );
+
+  //! Group a set of candidates by seed position
+  void groupCandidatesByPosition( const std::vector<unsigned> &candidates );
+
+  //! Calculate the weights of every n-th position group, starting from the
+  //! first
+  void calculatePositionWeightStride( 
+				      const std::vector<unsigned> &candidates,
+				      std::vector<double> &weights,
+				      const unsigned first_group,
+				      const unsigned stride ) const;
+
+  //! Calculate the coverages of the candidates at a seed position
+  void calculatePositionCoverages( 
+			     const std::vector<unsigned> &position_candidates,
+			     std::vector<double> &coverages ) const;
 
   //! Print the treatment plan summary
   void printTreatmentPlanSummary( std::ostream &os ) const;
@@ -56,8 +91,51 @@ private:
   // Optimization time
   double d_opt_time;
 
-  // Seed positions
-  std::list<BrachytherapySetCoverSeedPosition> d_seed_positions;
+  // The smallest number of candidates evaluated by a thread
+  static const unsigned min_candidates_per_thread;
+
+  // Only re-evaluate the candidates that reach the top of the queue
+  bool d_lazy_evaluation;
+
+  // The number of threads used to evaluate the candidates
+  unsigned d_number_of_threads;
+
+  // The fraction of the prescribed dose that bounds the seed dose supports
+  static const double support_dose_fraction;
+
+  // Candidate seed positions
+  BrachytherapyCandidateTable d_candidates;
+
+  // The dose support of each seed (mesh offsets from the seed)
+  std::vector<DoseDistributionOverlap> d_dose_supports;
+
+  // The number of updates (inserted seeds)
+  unsigned d_number_of_updates;
+
+  // The update after which each candidate weight was last evaluated
+  std::vector<unsigned> d_weight_updates;
+
+  // The occupied candidates that have not been removed
+  std::vector<unsigned> d_occupied_candidates;
+
+  // The candidates skipped by the last update
+  std::vector<unsigned> d_skipped_candidates;
+
+  // The candidates re-evaluated by the last update (eager evaluation)
+  std::vector<unsigned> d_updated_candidates;
+
+  // The candidates that are being evaluated and their new weights
+  std::vector<unsigned> d_evaluated_candidates;
+  std::vector<double> d_evaluated_weights;
+
+  // The evaluated candidates grouped by seed position (the indices of the
+  // candidates of group g are stored in [d_group_offsets[g],
+  // d_group_offsets[g+1]) of d_group_indices)
+  std::vector<unsigned> d_group_indices;
+  std::vector<unsigned> d_group_offsets;
+
+  // The candidate doses in the prostate (optional)
+  boost::scoped_ptr<BrachytherapyDoseMatrix> d_dose_matrix;
 };
 
 } // end TPOR namespace
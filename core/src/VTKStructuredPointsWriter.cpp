@@ -0,0 +1,74 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   VTKStructuredPointsWriter.cpp
+//! \author Alex Robinson
+//! \brief  VTK legacy structured points file writer class definition.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <sstream>
+#include <stdexcept>
+
+// TPOR Includes
+#include "VTKStructuredPointsWriter.hpp"
+#include "ContractException.hpp"
+#include "ExceptionTestMacros.hpp"
+
+namespace TPOR{
+
+// Constructor
+/*! \details The dimensions are the number of cells in each direction. The
+ * origin is the location of the first cell corner and the spacing is the 
+ * size of a cell in each direction.
+ */
+VTKStructuredPointsWriter::VTKStructuredPointsWriter( 
+					       const std::string &file_name,
+					       const std::string &title,
+					       const unsigned x_dim,
+					       const unsigned y_dim,
+					       const unsigned z_dim,
+					       const double x_origin,
+					       const double y_origin,
+					       const double z_origin,
+					       const double x_spacing,
+					       const double y_spacing,
+					       const double z_spacing )
+  : d_file( file_name.c_str(), std::ofstream::trunc|std::ofstream::binary ),
+    d_num_cells( x_dim*y_dim*z_dim ),
+    d_cell_data_started( false )
+{
+  // Make sure that the dimensions are valid
+  testPrecondition( x_dim > 0 );
+  testPrecondition( y_dim > 0 );
+  testPrecondition( z_dim > 0 );
+  // Make sure that the spacing is valid
+  testPrecondition( x_spacing > 0.0 );
+  testPrecondition( y_spacing > 0.0 );
+  testPrecondition( z_spacing > 0.0 );
+  // Make sure that the title fits on one line
+  testPrecondition( title.find( '\n' ) == std::string::npos );
+
+  TEST_FOR_EXCEPTION( !d_file,
+		      std::runtime_error,
+		      "Error: the vtk file " << file_name << 
+		      " could not be opened." );
+
+  // The points are the cell corners
+  d_file << "# vtk DataFile Version 3.0\n"
+	 << title.substr( 0, 255 ) << "\n"
+	 << "BINARY\n"
+	 << "DATASET STRUCTURED_POINTS\n"
+	 << "DIMENSIONS " << x_dim+1 << " " << y_dim+1 << " " << z_dim+1 
+	 << "\n"
+	 << "ORIGIN " << x_origin << " " << y_origin << " " << z_origin 
+	 << "\n"
+	 << "SPACING " << x_spacing << " " << y_spacing << " " << z_spacing
+	 << "\n";
+}
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// end VTKStructuredPointsWriter.cpp
+//---------------------------------------------------------------------------//
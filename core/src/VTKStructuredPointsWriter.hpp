@@ -0,0 +1,83 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   VTKStructuredPointsWriter.hpp
+//! \author Alex Robinson
+//! \brief  VTK legacy structured points file writer class declaration.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef VTK_STRUCTURED_POINTS_WRITER_HPP
+#define VTK_STRUCTURED_POINTS_WRITER_HPP
+
+// Std Lib Includes
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace TPOR{
+
+/*! VTK legacy structured points file writer
+ *
+ * The writer creates a binary legacy VTK file with a STRUCTURED_POINTS 
+ * dataset. The dataset is a regular grid of cells (voxels) and every field 
+ * that is written is stored as cell data. The data is streamed directly to 
+ * the file (in big-endian byte order as required by the legacy format).
+ */
+class VTKStructuredPointsWriter
+{
+
+public:
+
+  //! Constructor (the file header is written)
+  VTKStructuredPointsWriter( const std::string &file_name,
+			     const std::string &title,
+			     const unsigned x_dim,
+			     const unsigned y_dim,
+			     const unsigned z_dim,
+			     const double x_origin,
+			     const double y_origin,
+			     const double z_origin,
+			     const double x_spacing,
+			     const double y_spacing,
+			     const double z_spacing );
+
+  //! Destructor
+  ~VTKStructuredPointsWriter()
+  { /* ... */ }
+
+  //! Write a cell data field
+  template<typename T>
+  void writeCellData( const std::string &field_name,
+		      const std::vector<T> &field_data );
+
+private:
+
+  //! Write a block of values in big-endian byte order
+  template<typename T>
+  void writeBigEndian( const T* values, const unsigned num_values );
+
+  // The output file
+  std::ofstream d_file;
+
+  // The number of cells
+  unsigned d_num_cells;
+
+  // Records if the cell data section has been started
+  bool d_cell_data_started;
+};
+
+} // end TPOR namespace
+
+//---------------------------------------------------------------------------//
+// Template includes.
+//---------------------------------------------------------------------------//
+
+#include "VTKStructuredPointsWriter_def.hpp"
+
+//---------------------------------------------------------------------------//
+
+#endif // end VTK_STRUCTURED_POINTS_WRITER_HPP
+
+//---------------------------------------------------------------------------//
+// end VTKStructuredPointsWriter.hpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,101 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   VTKStructuredPointsWriter_def.hpp
+//! \author Alex Robinson
+//! \brief  VTK legacy structured points file writer template definitions.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef VTK_STRUCTURED_POINTS_WRITER_DEF_HPP
+#define VTK_STRUCTURED_POINTS_WRITER_DEF_HPP
+
+// Std Lib Includes
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// TPOR Includes
+#include "VTKTypeTraits.hpp"
+#include "ContractException.hpp"
+#include "ExceptionTestMacros.hpp"
+
+namespace TPOR{
+
+// Write a cell data field
+template<typename T>
+void VTKStructuredPointsWriter::writeCellData( 
+					   const std::string &field_name,
+					   const std::vector<T> &field_data )
+{
+  // Make sure that there is a value for every cell
+  testPrecondition( field_data.size() == d_num_cells );
+  // Make sure that the field name is valid (no white space)
+  testPrecondition( field_name.size() > 0 );
+  testPrecondition( field_name.find_first_of( " \t\n" ) == std::string::npos );
+
+  if( !d_cell_data_started )
+  {
+    d_file << "CELL_DATA " << d_num_cells << "\n";
+    
+    d_cell_data_started = true;
+  }
+
+  d_file << "SCALARS " << field_name << " " 
+	 << Traits::VTKTypeTraits<T>::name() << " 1\n";
+  d_file << "LOOKUP_TABLE default\n";
+  
+  writeBigEndian( &field_data[0], field_data.size() );
+  
+  d_file << "\n";
+
+  TEST_FOR_EXCEPTION( !d_file,
+		      std::runtime_error,
+		      "Error: the vtk field " << field_name << 
+		      " could not be written." );
+}
+
+// Write a block of values in big-endian byte order
+template<typename T>
+void VTKStructuredPointsWriter::writeBigEndian( const T* values,
+						const unsigned num_values )
+{
+  const unsigned short endian_test = 1u;
+  const bool little_endian = 
+    *reinterpret_cast<const unsigned char*>( &endian_test ) == 1u;
+
+  if( !little_endian || sizeof(T) == 1 )
+  {
+    d_file.write( reinterpret_cast<const char*>( values ), 
+		  num_values*sizeof(T) );
+  }
+  else
+  {
+    // Swap the bytes of the values one buffer at a time
+    const unsigned buffer_values = 4096u;
+    std::vector<char> buffer( buffer_values*sizeof(T) );
+
+    for( unsigned start = 0; start < num_values; start += buffer_values )
+    {
+      unsigned end = std::min( start + buffer_values, num_values );
+      
+      for( unsigned i = start; i < end; ++i )
+      {
+	const char* value_bytes = reinterpret_cast<const char*>( &values[i] );
+	
+	std::reverse_copy( value_bytes, 
+			   value_bytes + sizeof(T),
+			   &buffer[(i-start)*sizeof(T)] );
+      }
+
+      d_file.write( &buffer[0], (end-start)*sizeof(T) );
+    }
+  }
+}
+
+} // end TPOR namespace
+
+#endif // end VTK_STRUCTURED_POINTS_WRITER_DEF_HPP
+
+//---------------------------------------------------------------------------//
+// end VTKStructuredPointsWriter_def.hpp
+//---------------------------------------------------------------------------//
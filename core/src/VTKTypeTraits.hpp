@@ -0,0 +1,78 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   VTKTypeTraits.hpp
+//! \author Alex Robinson
+//! \brief  VTK Type Traits declaration and specializations
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef VTK_TYPE_TRAITS_HPP
+#define VTK_TYPE_TRAITS_HPP
+
+namespace TPOR{
+
+namespace Traits{
+
+/*! \brief This structure defines the VTK legacy file data type name 
+ * associated with a C++ type.
+ *
+ * The primary template is never defined so that unsupported types cause a
+ * compile time error.
+ * \ingroup vtk_type_traits
+ */
+template<typename T>
+struct VTKTypeTraits;
+
+/*! \brief The specialization of the TPOR::VTKTypeTraits for unsigned char
+ * \ingroup vtk_type_traits
+ */
+template<>
+struct VTKTypeTraits<unsigned char>
+{
+  //! Returns the VTK data type name corresponding to unsigned char
+  static inline const char* name()
+  { return "unsigned_char"; }
+};
+
+/*! \brief The specialization of the TPOR::VTKTypeTraits for int
+ * \ingroup vtk_type_traits
+ */
+template<>
+struct VTKTypeTraits<int>
+{
+  //! Returns the VTK data type name corresponding to int
+  static inline const char* name()
+  { return "int"; }
+};
+
+/*! \brief The specialization of the TPOR::VTKTypeTraits for float
+ * \ingroup vtk_type_traits
+ */
+template<>
+struct VTKTypeTraits<float>
+{
+  //! Returns the VTK data type name corresponding to float
+  static inline const char* name()
+  { return "float"; }
+};
+
+/*! \brief The specialization of the TPOR::VTKTypeTraits for double
+ * \ingroup vtk_type_traits
+ */
+template<>
+struct VTKTypeTraits<double>
+{
+  //! Returns the VTK data type name corresponding to double
+  static inline const char* name()
+  { return "double"; }
+};
+
+} // end Traits namespace
+
+} // end TPOR namespace
+
+#endif // end VTK_TYPE_TRAITS_HPP
+
+//---------------------------------------------------------------------------//
+// end VTKTypeTraits.hpp
+//---------------------------------------------------------------------------//
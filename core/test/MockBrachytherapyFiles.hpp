@@ -0,0 +1,217 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   MockBrachytherapyFiles.hpp
+//! \author Alex Robinson
+//! \brief  Mock patient and seed hdf5 files used by the unit tests.
+//!
+//---------------------------------------------------------------------------//
+
+#ifndef MOCK_BRACHYTHERAPY_FILES_HPP
+#define MOCK_BRACHYTHERAPY_FILES_HPP
+
+// Std Lib Includes
+#include <string>
+#include <vector>
+#include <cmath>
+
+// TPOR Includes
+#include "HDF5FileHandler.hpp"
+#include "BrachytherapySeedFactory.hpp"
+#include "BrachytherapySeedHelpers.hpp"
+
+//---------------------------------------------------------------------------//
+// Mock File Dimensions.
+//---------------------------------------------------------------------------//
+// The mock patient mesh (0.1 x 0.1 x 0.5 cm elements)
+#define MOCK_PATIENT_X_DIM 44u
+#define MOCK_PATIENT_Y_DIM 44u
+#define MOCK_PATIENT_Z_DIM 12u
+
+// The mock seed mesh (the seed is at the center element)
+#define MOCK_SEED_X_DIM 41u
+#define MOCK_SEED_Y_DIM 41u
+#define MOCK_SEED_Z_DIM 9u
+
+//---------------------------------------------------------------------------//
+// Mock File Generators.
+//---------------------------------------------------------------------------//
+// Write a mock patient file
+/*! The prostate is an ellipsoid around the urethra with a margin shell. The
+ * rectum is a box below the prostate. The needle template has a hole every
+ * needle_spacing elements over the prostate (5 x 5 holes every 0.5 cm by
+ * default). The mesh and the organs can be scaled in-plane (x and y).
+ */
+inline void writeMockPatientFile( const std::string &file_name,
+				  const unsigned needle_spacing = 5u,
+				  const double scale = 1.0 )
+{
+  const unsigned nx = (unsigned)( MOCK_PATIENT_X_DIM*scale );
+  const unsigned ny = (unsigned)( MOCK_PATIENT_Y_DIM*scale );
+  const unsigned nz = MOCK_PATIENT_Z_DIM;
+
+  std::vector<double> mesh_element_dimensions( 3 );
+  mesh_element_dimensions[0] = 0.1;
+  mesh_element_dimensions[1] = 0.1;
+  mesh_element_dimensions[2] = 0.5;
+
+  std::vector<unsigned> mesh_dimensions( 3 );
+  mesh_dimensions[0] = nx;
+  mesh_dimensions[1] = ny;
+  mesh_dimensions[2] = nz;
+
+  std::vector<std::vector<char> > masks( 4, std::vector<char>( nx*ny*nz ) );
+  std::vector<unsigned> volumes( 4, 0u );
+
+  for( unsigned k = 0; k < nz; ++k )
+  {
+    for( unsigned j = 0; j < ny; ++j )
+    {
+      for( unsigned i = 0; i < nx; ++i )
+      {
+	unsigned index = i + j*nx + k*nx*ny;
+
+	double x = (i - 22.0*scale)/(9.0*scale);
+	double y = (j - 21.0*scale)/(7.5*scale);
+	double z = (k - 6.0)/3.2;
+	double r = x*x + y*y + z*z;
+
+	double urethra_r = ((i - 22.0*scale)*(i - 22.0*scale) + 
+			    (j - 22.0*scale)*(j - 22.0*scale))/(scale*scale);
+
+	unsigned organ = 4u;
+
+	if( urethra_r <= 2.0 && std::fabs( k - 6.0 ) < 4.0 )
+	  organ = 1u;
+	else if( r <= 1.0 )
+	  organ = 0u;
+	else if( r <= 1.6 )
+	  organ = 2u;
+	else if( j >= 31*scale && j <= 35*scale && 
+		 i >= 14*scale && i <= 30*scale && k >= 2 && k <= 10 )
+	  organ = 3u;
+
+	if( organ < 4u )
+	{
+	  masks[organ][index] = 1;
+	  ++volumes[organ];
+	}
+      }
+    }
+  }
+
+  std::vector<char> needle_template( nx*ny );
+
+  for( unsigned j = 0; j < ny; ++j )
+  {
+    for( unsigned i = 0; i < nx; ++i )
+    {
+      if( j < 11*scale || j > 31*scale || i < 10*scale || i > 34*scale )
+	continue;
+      
+      if( (i - 2) % needle_spacing == 0 && (j - 1) % needle_spacing == 0 )
+	needle_template[i + j*nx] = 1;
+    }
+  }
+
+  TPOR::HDF5FileHandler file_handle;
+  file_handle.openHDF5FileAndOverwrite( file_name );
+
+  std::string patient_name( "Mock" );
+
+  file_handle.writeArrayToGroupAttribute( patient_name, "/", "patient_name" );
+  file_handle.writeArrayToGroupAttribute( mesh_element_dimensions,
+					  "/",
+					  "mesh_element_dimensions" );
+  file_handle.writeArrayToGroupAttribute( mesh_dimensions,
+					  "/",
+					  "mesh_dimensions" );
+  file_handle.writeArrayToDataSet( needle_template, "/needle_template" );
+
+  const char* organ_names[4] = { "prostate", "urethra", "margin", "rectum" };
+
+  for( unsigned organ = 0; organ < 4u; ++organ )
+  {
+    std::string mask_path =
+      std::string( "/organ_masks/" ) + organ_names[organ] + "_mask";
+
+    file_handle.writeArrayToDataSet( masks[organ], mask_path );
+    file_handle.writeValueToDataSetAttribute( volumes[organ],
+					      mask_path,
+					      "relative_volume" );
+    file_handle.writeValueToDataSetAttribute( volumes[organ]*0.005,
+					      mask_path,
+					      "volume" );
+  }
+
+  file_handle.closeHDF5File();
+}
+
+// Write a mock seed file (the data meshes of every seed type)
+inline void writeMockSeedFile( const std::string &file_name )
+{
+  const unsigned nx = MOCK_SEED_X_DIM;
+  const unsigned ny = MOCK_SEED_Y_DIM;
+  const unsigned nz = MOCK_SEED_Z_DIM;
+
+  std::vector<unsigned> mesh_dimensions( 3 );
+  mesh_dimensions[0] = nx;
+  mesh_dimensions[1] = ny;
+  mesh_dimensions[2] = nz;
+
+  std::vector<unsigned> seed_position( 3 );
+  seed_position[0] = nx/2;
+  seed_position[1] = ny/2;
+  seed_position[2] = nz/2;
+
+  std::vector<double> element_dimensions( 3 );
+  element_dimensions[0] = 0.1;
+  element_dimensions[1] = 0.1;
+  element_dimensions[2] = 0.5;
+
+  TPOR::HDF5FileHandler file_handle;
+  file_handle.openHDF5FileAndOverwrite( file_name );
+
+  file_handle.writeArrayToGroupAttribute( mesh_dimensions,
+					  "/",
+					  "mesh_dimensions" );
+  file_handle.writeArrayToGroupAttribute( seed_position,
+					  "/",
+					  "seed_position" );
+  file_handle.writeArrayToGroupAttribute( element_dimensions,
+					  "/",
+					  "mesh_element_dimensions" );
+
+  std::vector<double> seed_mesh( nx*ny*nz );
+
+  for( unsigned seed_id = TPOR::SEED_min; seed_id <= TPOR::SEED_max; ++seed_id)
+  {
+    TPOR::BrachytherapySeedFactory::BrachytherapySeedPtr seed =
+      TPOR::BrachytherapySeedFactory::createSeed(
+			   TPOR::unsignedToBrachytherapySeedType( seed_id ),
+			   1.0 );
+
+    for( unsigned k = 0; k < nz; ++k )
+    {
+      for( unsigned j = 0; j < ny; ++j )
+      {
+	for( unsigned i = 0; i < nx; ++i )
+	{
+	  seed_mesh[i + j*nx + k*nx*ny] = seed->getTotalDose(
+		      ((int)i - (int)seed_position[0])*element_dimensions[0],
+		      ((int)j - (int)seed_position[1])*element_dimensions[1],
+		      ((int)k - (int)seed_position[2])*element_dimensions[2] );
+	}
+      }
+    }
+
+    file_handle.writeArrayToDataSet( seed_mesh, "/" + seed->getSeedName() );
+  }
+
+  file_handle.closeHDF5File();
+}
+
+#endif // end MOCK_BRACHYTHERAPY_FILES_HPP
+
+//---------------------------------------------------------------------------//
+// end MockBrachytherapyFiles.hpp
+//---------------------------------------------------------------------------//
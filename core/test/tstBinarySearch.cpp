@@ -8,6 +8,8 @@
 
 // Std Lib Includes
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 // Boost Includes
 #define BOOST_TEST_MAIN
@@ -24,6 +26,28 @@
 //---------------------------------------------------------------------------//
 typedef boost::mpl::list<float, double> test_types;
 
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+// Trial predicate that succeeds from a threshold trial and records its calls
+struct ThresholdTrial
+{
+  ThresholdTrial( const unsigned threshold, std::vector<unsigned> &calls )
+    : d_threshold( threshold ),
+      d_calls( calls )
+  { /* ... */ }
+
+  bool operator()( const unsigned trial )
+  {
+    d_calls.push_back( trial );
+    
+    return trial >= d_threshold;
+  }
+
+  unsigned d_threshold;
+  std::vector<unsigned> &d_calls;
+};
+
 //---------------------------------------------------------------------------//
 // Tests.
 //---------------------------------------------------------------------------//
@@ -64,6 +88,49 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( binarySearch, ScalarType, test_types )
   BOOST_REQUIRE_EQUAL( index, 8 );
 }
 
+//---------------------------------------------------------------------------//
+// Check that the first successful trial is found with few unique trials
+BOOST_AUTO_TEST_CASE( findFirstSuccessfulTrial )
+{
+  std::vector<unsigned> calls;
+  
+  BOOST_CHECK_EQUAL( TPOR::findFirstSuccessfulTrial( 0u, 
+						     ThresholdTrial( 0u, 
+								     calls ) ),
+		     0u );
+  BOOST_CHECK( calls.empty() );
+  
+  for( unsigned number_of_trials = 1u; number_of_trials <= 200u; 
+       ++number_of_trials )
+  {
+    for( unsigned threshold = 0u; threshold <= number_of_trials; ++threshold )
+    {
+      calls.clear();
+
+      unsigned first_trial = 
+	TPOR::findFirstSuccessfulTrial( number_of_trials,
+					ThresholdTrial( threshold, calls ) );
+
+      BOOST_REQUIRE_EQUAL( first_trial, threshold );
+
+      // No trial is conducted twice
+      std::sort( calls.begin(), calls.end() );
+
+      BOOST_REQUIRE( std::adjacent_find( calls.begin(), calls.end() ) == 
+		     calls.end() );
+      BOOST_REQUIRE( calls.back() < number_of_trials );
+      
+      // The bracket and the bisection take at most 2*log2(n+1)+2 trials
+      unsigned log_trials = 0u;
+
+      while( (1u << log_trials) < number_of_trials + 1u )
+	++log_trials;
+      
+      BOOST_REQUIRE( calls.size() <= 2u*log_trials + 2u );
+    }
+  }
+}
+
 //---------------------------------------------------------------------------//
 // end tstBinarySearch.cpp
 //---------------------------------------------------------------------------//
@@ -0,0 +1,459 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstBrachytherapyCandidateTable.cpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyCandidateTable class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <list>
+#include <algorithm>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE BrachytherapyCandidateTable
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyCandidateTable.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define SEED_TEST_FILE_NAME "candidate_table_test_seeds.h5"
+
+//---------------------------------------------------------------------------//
+// Test Mesh Dimensions.
+//---------------------------------------------------------------------------//
+#define MESH_X_DIM 6u
+#define MESH_Y_DIM 5u
+#define MESH_Z_DIM 4u
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Return a test seed
+boost::shared_ptr<TPOR::BrachytherapySeedProxy> getSeed(
+				       const TPOR::BrachytherapySeedType type )
+{
+  return boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+		 new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+						   type,
+						   0.5 ) );
+}
+
+// Fill a table with the candidates of two seeds (every mesh element of
+// every other needle column)
+void fillTable( TPOR::BrachytherapyCandidateTable &table )
+{
+  table.addSeed( getSeed( TPOR::AMERSHAM_6711_SEED ) );
+  table.addSeed( getSeed( TPOR::BEST_2301_SEED ) );
+
+  for( unsigned j = 0; j < MESH_Y_DIM; ++j )
+  {
+    for( unsigned i = (j % 2); i < MESH_X_DIM; i += 2 )
+    {
+      for( unsigned k = 0; k < MESH_Z_DIM; ++k )
+      {
+	double weight = 1.0 + ((i*7 + j*3 + k*5) % 11);
+
+	table.addCandidate( i, j, k, weight, 0u );
+	table.addCandidate( i, j, k, weight + 0.5, 1u );
+      }
+    }
+  }
+}
+
+// Simulate the original full update pass over a candidate list: an occupied
+// candidate is erased and the candidate that follows it is skipped (erasing
+// the last candidate restarts the pass at the first candidate). The alive
+// candidates that are never visited are returned.
+void simulateFullUpdatePass( const std::vector<bool> &alive,
+			     const std::vector<bool> &occupied,
+			     std::vector<bool> &remaining,
+			     std::vector<unsigned> &unvisited_candidates )
+{
+  std::list<unsigned> candidates;
+
+  for( unsigned c = 0; c < alive.size(); ++c )
+  {
+    if( alive[c] )
+      candidates.push_back( c );
+  }
+
+  std::vector<bool> visited( alive.size(), false );
+
+  std::list<unsigned>::iterator candidate = candidates.begin();
+
+  while( candidate != candidates.end() )
+  {
+    if( occupied[*candidate] )
+    {
+      candidate = candidates.erase( candidate );
+
+      if( candidate == candidates.end() )
+	candidate = candidates.begin();
+      else
+	++candidate;
+    }
+    else
+    {
+      visited[*candidate] = true;
+
+      ++candidate;
+    }
+  }
+
+  remaining.assign( alive.size(), false );
+  unvisited_candidates.clear();
+
+  for( candidate = candidates.begin();
+       candidate != candidates.end();
+       ++candidate )
+  {
+    remaining[*candidate] = true;
+
+    if( !visited[*candidate] )
+      unvisited_candidates.push_back( *candidate );
+  }
+}
+
+// Return the alive candidate with the smallest dynamic weight (linear scan)
+unsigned findMinimumDynamicWeight(
+			      const TPOR::BrachytherapyCandidateTable &table )
+{
+  unsigned min_candidate = table.getNumberOfCandidates();
+
+  for( unsigned c = 0; c < table.getNumberOfCandidates(); ++c )
+  {
+    if( table.isAlive( c ) &&
+	(min_candidate == table.getNumberOfCandidates() ||
+	 table.getDynamicWeight( c ) < table.getDynamicWeight( min_candidate )))
+      min_candidate = c;
+  }
+
+  return min_candidate;
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the alive candidates can be iterated over
+BOOST_AUTO_TEST_CASE( getNextAliveCandidate )
+{
+  TPOR::BrachytherapyCandidateTable table( MESH_X_DIM, MESH_Y_DIM, MESH_Z_DIM);
+  fillTable( table );
+
+  unsigned number_of_candidates = table.getNumberOfCandidates();
+
+  BOOST_CHECK_EQUAL( table.getFirstAliveCandidate(), 0u );
+  BOOST_CHECK_EQUAL( table.getNumberOfAliveCandidates(),
+		     number_of_candidates );
+
+  // Remove the first candidate, the last candidate and a run of candidates
+  table.removeCandidate( 0u );
+  table.removeCandidate( number_of_candidates - 1u );
+
+  for( unsigned c = 5u; c < 9u; ++c )
+    table.removeCandidate( c );
+
+  BOOST_CHECK_EQUAL( table.getNumberOfAliveCandidates(),
+		     number_of_candidates - 6u );
+  BOOST_CHECK_EQUAL( table.getFirstAliveCandidate(), 1u );
+  BOOST_CHECK_EQUAL( table.getNextAliveCandidate( 1u ), 2u );
+  BOOST_CHECK_EQUAL( table.getNextAliveCandidate( 4u ), 9u );
+  BOOST_CHECK_EQUAL( table.getNextAliveCandidate( 5u ), 9u );
+  BOOST_CHECK_EQUAL( table.getNextAliveCandidate( number_of_candidates - 2u),
+		     number_of_candidates );
+
+  unsigned number_of_alive_candidates = 0u;
+
+  for( unsigned c = table.getFirstAliveCandidate();
+       c < number_of_candidates;
+       c = table.getNextAliveCandidate( c ) )
+  {
+    BOOST_CHECK( table.isAlive( c ) );
+
+    ++number_of_alive_candidates;
+  }
+
+  BOOST_CHECK_EQUAL( number_of_alive_candidates,
+		     table.getNumberOfAliveCandidates() );
+
+  // A table without alive candidates
+  for( unsigned c = table.getFirstAliveCandidate();
+       c < number_of_candidates;
+       c = table.getNextAliveCandidate( c ) )
+    table.removeCandidate( c );
+
+  BOOST_CHECK_EQUAL( table.getNumberOfAliveCandidates(), 0u );
+  BOOST_CHECK_EQUAL( table.getFirstAliveCandidate(), number_of_candidates );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the alive candidates in a box can be found
+BOOST_AUTO_TEST_CASE( findAliveCandidatesInBox )
+{
+  TPOR::BrachytherapyCandidateTable table( MESH_X_DIM, MESH_Y_DIM, MESH_Z_DIM);
+  fillTable( table );
+
+  for( unsigned c = 0; c < table.getNumberOfCandidates(); c += 3u )
+    table.removeCandidate( c );
+
+  table.buildPositionIndex();
+
+  TPOR::DoseDistributionOverlap boxes[4] = { { 0, 6, 0, 5, 0, 4 },
+					     { 1, 4, 2, 5, 1, 3 },
+					     { 5, 6, 0, 1, 3, 4 },
+					     { 2, 2, 0, 5, 0, 4 } };
+
+  for( unsigned b = 0; b < 4u; ++b )
+  {
+    const TPOR::DoseDistributionOverlap &box = boxes[b];
+
+    std::vector<unsigned> candidates, seed_candidates;
+    std::vector<unsigned> expected_candidates, expected_seed_candidates;
+
+    table.findAliveCandidatesInBox( box, candidates );
+    table.findAliveCandidatesInBox( box, 1u, seed_candidates );
+
+    for( unsigned c = 0; c < table.getNumberOfCandidates(); ++c )
+    {
+      int x = table.getXIndex( c );
+      int y = table.getYIndex( c );
+      int z = table.getZIndex( c );
+
+      if( table.isAlive( c ) &&
+	  x >= box.x_start && x < box.x_end &&
+	  y >= box.y_start && y < box.y_end &&
+	  z >= box.z_start && z < box.z_end )
+      {
+	expected_candidates.push_back( c );
+
+	if( table.getSeedId( c ) == 1u )
+	  expected_seed_candidates.push_back( c );
+      }
+    }
+
+    std::sort( candidates.begin(), candidates.end() );
+    std::sort( seed_candidates.begin(), seed_candidates.end() );
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( candidates.begin(),
+				   candidates.end(),
+				   expected_candidates.begin(),
+				   expected_candidates.end() );
+    BOOST_CHECK_EQUAL_COLLECTIONS( seed_candidates.begin(),
+				   seed_candidates.end(),
+				   expected_seed_candidates.begin(),
+				   expected_seed_candidates.end() );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the occupied candidates are removed in the order of a full
+// update pass (every set of occupied candidates of a small table)
+BOOST_AUTO_TEST_CASE( removeOccupiedCandidates )
+{
+  const unsigned number_of_candidates = 10u;
+
+  for( unsigned pattern = 0; pattern < (1u << number_of_candidates);
+       ++pattern )
+  {
+    TPOR::BrachytherapyCandidateTable table( number_of_candidates, 1u, 1u );
+    table.addSeed( getSeed( TPOR::AMERSHAM_6711_SEED ) );
+
+    for( unsigned c = 0; c < number_of_candidates; ++c )
+      table.addCandidate( c, 0u, 0u, 1.0, 0u );
+
+    // The second and the seventh candidate have already been removed
+    table.removeCandidate( 1u );
+    table.removeCandidate( 6u );
+
+    std::vector<bool> alive( number_of_candidates ), occupied( alive.size() );
+    std::vector<unsigned> occupied_candidates;
+
+    for( unsigned c = 0; c < number_of_candidates; ++c )
+    {
+      alive[c] = table.isAlive( c );
+      occupied[c] = (pattern >> c) & 1u;
+
+      // The occupied candidates are passed in any order
+      if( occupied[c] )
+	occupied_candidates.insert( occupied_candidates.begin(), c );
+    }
+
+    std::vector<bool> expected_alive;
+    std::vector<unsigned> expected_skipped_candidates;
+
+    simulateFullUpdatePass( alive,
+			    occupied,
+			    expected_alive,
+			    expected_skipped_candidates );
+
+    std::vector<unsigned> skipped_candidates;
+
+    table.removeOccupiedCandidates( occupied_candidates, skipped_candidates );
+
+    std::vector<unsigned> expected_occupied_candidates;
+
+    for( unsigned c = 0; c < number_of_candidates; ++c )
+    {
+      BOOST_CHECK_EQUAL( table.isAlive( c ), expected_alive[c] );
+
+      if( expected_alive[c] && occupied[c] )
+	expected_occupied_candidates.push_back( c );
+    }
+
+    BOOST_CHECK_EQUAL_COLLECTIONS( skipped_candidates.begin(),
+				   skipped_candidates.end(),
+				   expected_skipped_candidates.begin(),
+				   expected_skipped_candidates.end() );
+    BOOST_CHECK_EQUAL_COLLECTIONS( occupied_candidates.begin(),
+				   occupied_candidates.end(),
+				   expected_occupied_candidates.begin(),
+				   expected_occupied_candidates.end() );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check the skip order and the wrap of a full update pass
+BOOST_AUTO_TEST_CASE( removeOccupiedCandidatesWrap )
+{
+  TPOR::BrachytherapyCandidateTable table( 6u, 1u, 1u );
+  table.addSeed( getSeed( TPOR::AMERSHAM_6711_SEED ) );
+
+  for( unsigned c = 0; c < 6u; ++c )
+    table.addCandidate( c, 0u, 0u, 1.0, 0u );
+
+  // 1 is removed and 2 is skipped, 3 is removed and 4 is skipped, 5 is
+  // removed and the pass restarts: 0 is visited, 2 is removed and 4 is
+  // skipped again
+  std::vector<unsigned> occupied_candidates( 4u );
+  occupied_candidates[0] = 5u;
+  occupied_candidates[1] = 1u;
+  occupied_candidates[2] = 3u;
+  occupied_candidates[3] = 2u;
+
+  std::vector<unsigned> skipped_candidates;
+
+  table.removeOccupiedCandidates( occupied_candidates, skipped_candidates );
+
+  BOOST_CHECK( table.isAlive( 0u ) );
+  BOOST_CHECK( !table.isAlive( 1u ) );
+  BOOST_CHECK( !table.isAlive( 2u ) );
+  BOOST_CHECK( !table.isAlive( 3u ) );
+  BOOST_CHECK( table.isAlive( 4u ) );
+  BOOST_CHECK( !table.isAlive( 5u ) );
+
+  BOOST_CHECK_EQUAL( occupied_candidates.size(), 0u );
+  BOOST_REQUIRE_EQUAL( skipped_candidates.size(), 1u );
+  BOOST_CHECK_EQUAL( skipped_candidates[0], 4u );
+
+  // 4 is removed and the pass restarts: 0 is visited in both passes
+  occupied_candidates.assign( 1u, 4u );
+
+  table.removeOccupiedCandidates( occupied_candidates, skipped_candidates );
+
+  BOOST_CHECK( !table.isAlive( 4u ) );
+  BOOST_CHECK_EQUAL( table.getNumberOfAliveCandidates(), 1u );
+  BOOST_CHECK_EQUAL( occupied_candidates.size(), 0u );
+  BOOST_CHECK_EQUAL( skipped_candidates.size(), 0u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the dynamic weight queue returns the minimum dynamic weight
+BOOST_AUTO_TEST_CASE( findMinimumDynamicWeightCandidate )
+{
+  TPOR::BrachytherapyCandidateTable table( MESH_X_DIM, MESH_Y_DIM, MESH_Z_DIM);
+  fillTable( table );
+
+  TPOR::BrachytherapyCandidateTable queue_table( MESH_X_DIM,
+						 MESH_Y_DIM,
+						 MESH_Z_DIM );
+  fillTable( queue_table );
+
+  queue_table.enableDynamicWeightQueue();
+
+  BOOST_CHECK( queue_table.isDynamicWeightQueueEnabled() );
+  BOOST_CHECK( !table.isDynamicWeightQueueEnabled() );
+
+  unsigned number_of_candidates = table.getNumberOfCandidates();
+
+  BOOST_CHECK_EQUAL( queue_table.findMinimumDynamicWeightCandidate(),
+		     findMinimumDynamicWeight( table ) );
+
+  for( unsigned step = 0; step < 3u*number_of_candidates; ++step )
+  {
+    unsigned c = (step*37u) % number_of_candidates;
+
+    if( step % 5u == 0u )
+    {
+      table.setDynamicWeight( c, 0.25*(step % 13u) );
+      queue_table.setDynamicWeight( c, 0.25*(step % 13u) );
+    }
+    else if( step % 5u == 1u )
+    {
+      table.multiplyDynamicWeight( c, 1.5 );
+      queue_table.multiplyDynamicWeight( c, 1.5 );
+    }
+    else if( step % 5u == 2u )
+    {
+      table.multiplyDynamicWeight( c, 0.5 );
+      queue_table.multiplyDynamicWeight( c, 0.5 );
+    }
+    else if( step % 5u == 3u && table.isAlive( c ) &&
+	     table.getNumberOfAliveCandidates() > 1u )
+    {
+      table.removeCandidate( c );
+      queue_table.removeCandidate( c );
+    }
+
+    BOOST_CHECK_EQUAL( queue_table.getDynamicWeight( c ),
+		       table.getDynamicWeight( c ) );
+
+    unsigned min_candidate = findMinimumDynamicWeight( table );
+
+    BOOST_CHECK_EQUAL( queue_table.findMinimumDynamicWeightCandidate(),
+		       min_candidate );
+    BOOST_CHECK_EQUAL( table.findMinimumDynamicWeightCandidate(),
+		       min_candidate );
+  }
+
+  // A dead candidate with the smallest weight is never returned
+  unsigned min_candidate = queue_table.findMinimumDynamicWeightCandidate();
+
+  queue_table.removeCandidate( min_candidate );
+  queue_table.setDynamicWeight( min_candidate, -1.0 );
+
+  BOOST_CHECK( queue_table.findMinimumDynamicWeightCandidate() !=
+	       min_candidate );
+  BOOST_CHECK_EQUAL( queue_table.findMinimumDynamicWeightCandidate(),
+		     findMinimumDynamicWeight( queue_table ) );
+}
+
+//---------------------------------------------------------------------------//
+// end tstBrachytherapyCandidateTable.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,807 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstBrachytherapyPatient.cpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPatient class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cmath>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE BrachytherapyPatient
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "BrachytherapyCandidateTable.hpp"
+#include "BrachytherapyPlanFileHandler.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "patient_test_file.h5"
+#define SEED_TEST_FILE_NAME "patient_test_seeds.h5"
+#define PLAN_TEST_FILE_NAME "patient_test_plans.h5"
+#define PLAN_NAME "test_plan"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME );
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// The seed container type
+typedef std::vector<boost::shared_ptr<TPOR::BrachytherapySeedProxy> >
+SeedVector;
+
+// Create the test seeds
+void createSeeds( SeedVector &seeds )
+{
+  seeds.clear();
+
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::AMERSHAM_6711_SEED,
+					       0.55 ) ) );
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::BEST_2301_SEED,
+					       0.5 ) ) );
+}
+
+// Create a patient
+boost::shared_ptr<TPOR::BrachytherapyPatient> createPatient()
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     14500.0 ) );
+
+  return boost::shared_ptr<TPOR::BrachytherapyPatient>(
+				   new TPOR::BrachytherapyPatient( geometry ) );
+}
+
+// Insert a treatment plan that uses both test seeds on three needles
+void insertTreatmentPlan( TPOR::BrachytherapyPatient &patient,
+			  const SeedVector &seeds )
+{
+  unsigned x = patient.getOrganMeshXDim()/2;
+  unsigned y = patient.getOrganMeshYDim()/2;
+  unsigned z = patient.getOrganMeshZDim()/2;
+
+  patient.insertSeed( TPOR::BrachytherapySeedPosition( x, y, z,
+						       1.0, seeds[0] ) );
+  patient.insertSeed( TPOR::BrachytherapySeedPosition( x+5, y, z-2,
+						       1.0, seeds[1] ) );
+  patient.insertSeed( TPOR::BrachytherapySeedPosition( x, y, z+2,
+						       1.0, seeds[0] ) );
+  patient.insertSeed( TPOR::BrachytherapySeedPosition( x-5, y+5, z,
+						       1.0, seeds[1] ) );
+}
+
+// Return the sorted needle indices of the inserted needles
+std::vector<unsigned> getSortedNeedles( 
+				   const TPOR::BrachytherapyPatient &patient )
+{
+  std::vector<unsigned> needle_indices;
+  patient.getInsertedNeedles( needle_indices );
+
+  std::sort( needle_indices.begin(), needle_indices.end() );
+
+  return needle_indices;
+}
+
+// Check that two treatment plans (and their needle sets) are equal
+void checkPlansEqual( const TPOR::BrachytherapyPatient &patient,
+		      const TPOR::BrachytherapyPatient &expected_patient )
+{
+  const std::list<TPOR::BrachytherapySeedPosition> &plan =
+    patient.getTreatmentPlan();
+  const std::list<TPOR::BrachytherapySeedPosition> &expected_plan =
+    expected_patient.getTreatmentPlan();
+
+  BOOST_REQUIRE_EQUAL( plan.size(), expected_plan.size() );
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed =
+    plan.begin();
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator expected_seed =
+    expected_plan.begin();
+
+  while( seed != plan.end() )
+  {
+    BOOST_CHECK_EQUAL( seed->getXIndex(), expected_seed->getXIndex() );
+    BOOST_CHECK_EQUAL( seed->getYIndex(), expected_seed->getYIndex() );
+    BOOST_CHECK_EQUAL( seed->getZIndex(), expected_seed->getZIndex() );
+    BOOST_CHECK_EQUAL( seed->getSeedType(), expected_seed->getSeedType() );
+    BOOST_CHECK( !patient.isSeedPositionFree( *seed ) );
+    BOOST_CHECK( patient.isSeedOnNeedle( *seed ) );
+
+    ++seed;
+    ++expected_seed;
+  }
+
+  std::vector<unsigned> needles = getSortedNeedles( patient );
+  std::vector<unsigned> expected_needles = getSortedNeedles( expected_patient );
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( needles.begin(),
+				 needles.end(),
+				 expected_needles.begin(),
+				 expected_needles.end() );
+}
+
+// Check that two dose distributions are equal to within round-off
+void checkDosesClose( const std::vector<double> &dose_distribution,
+		      const std::vector<double> &expected_dose_distribution )
+{
+  BOOST_REQUIRE_EQUAL( dose_distribution.size(), 
+		       expected_dose_distribution.size() );
+
+  unsigned number_of_errors = 0u;
+
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    if( fabs( dose_distribution[i] - expected_dose_distribution[i] ) >
+	1e-9*fabs( expected_dose_distribution[i] ) + 1e-9 )
+      ++number_of_errors;
+  }
+
+  BOOST_CHECK_EQUAL( number_of_errors, 0u );
+}
+
+// The state of a patient at a checkpoint
+struct PatientState
+{
+  std::list<TPOR::BrachytherapySeedPosition> treatment_plan;
+  std::vector<unsigned> needles;
+  std::vector<double> dose_distribution;
+};
+
+// Return the current state of a patient
+PatientState getPatientState( const TPOR::BrachytherapyPatient &patient )
+{
+  PatientState state;
+
+  state.treatment_plan = patient.getTreatmentPlan();
+  state.needles = getSortedNeedles( patient );
+  state.dose_distribution = patient.getDoseDistribution();
+
+  return state;
+}
+
+// Check that the state of a patient is restored bit-for-bit
+void checkPatientStateRestored( const TPOR::BrachytherapyPatient &patient,
+				const PatientState &state )
+{
+  const std::list<TPOR::BrachytherapySeedPosition> &plan =
+    patient.getTreatmentPlan();
+
+  BOOST_REQUIRE_EQUAL( plan.size(), state.treatment_plan.size() );
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed =
+    plan.begin();
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator expected_seed =
+    state.treatment_plan.begin();
+
+  while( seed != plan.end() )
+  {
+    BOOST_CHECK( *seed == *expected_seed );
+    BOOST_CHECK_EQUAL( seed->getSeedType(), expected_seed->getSeedType() );
+    BOOST_CHECK( !patient.isSeedPositionFree( *seed ) );
+
+    ++seed;
+    ++expected_seed;
+  }
+
+  std::vector<unsigned> needles = getSortedNeedles( patient );
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( needles.begin(),
+				 needles.end(),
+				 state.needles.begin(),
+				 state.needles.end() );
+  BOOST_CHECK( patient.getDoseDistribution() == state.dose_distribution );
+}
+
+// Insert, remove and move seeds of a patient (around a mesh element offset)
+void modifyTreatmentPlan( TPOR::BrachytherapyPatient &patient,
+			  const SeedVector &seeds,
+			  const int offset )
+{
+  unsigned x = patient.getOrganMeshXDim()/2 + offset;
+  unsigned y = patient.getOrganMeshYDim()/2 - offset;
+  unsigned z = patient.getOrganMeshZDim()/2;
+
+  patient.insertSeed( TPOR::BrachytherapySeedPosition( x+2, y+2, z-1,
+						       1.0, seeds[0] ) );
+  patient.insertSeed( TPOR::BrachytherapySeedPosition( x-2, y+3, z+1,
+						       1.0, seeds[1] ) );
+
+  if( patient.getNumInsertedSeeds() > 2u )
+    patient.removeSeed( patient.getTreatmentPlan().front() );
+
+  patient.moveSeed( patient.getTreatmentPlan().back(),
+		    TPOR::BrachytherapySeedPosition( x-3, y-2, z+2,
+						     1.0, seeds[1] ) );
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that an archived treatment plan can be loaded
+BOOST_AUTO_TEST_CASE( archiveAndLoadTreatmentPlan )
+{
+  std::remove( PLAN_TEST_FILE_NAME );
+
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+
+  patient->archiveTreatmentPlanToHDF5( PLAN_NAME, PLAN_TEST_FILE_NAME );
+
+  // Load the plan into a patient with a different treatment plan
+  boost::shared_ptr<TPOR::BrachytherapyPatient> loaded_patient =
+    createPatient();
+
+  loaded_patient->insertSeed( TPOR::BrachytherapySeedPosition( 1, 1, 1,
+							       1.0,
+							       seeds[0] ) );
+
+  loaded_patient->loadTreatmentPlanFromHDF5( PLAN_NAME,
+					     seeds,
+					     PLAN_TEST_FILE_NAME );
+
+  BOOST_CHECK_EQUAL( loaded_patient->getNumInsertedSeeds(),
+		     patient->getNumInsertedSeeds() );
+  BOOST_CHECK_EQUAL( loaded_patient->getNumInsertedNeedles(),
+		     patient->getNumInsertedNeedles() );
+
+  unsigned x_dim = patient->getOrganMeshXDim();
+  unsigned y_dim = patient->getOrganMeshYDim();
+  unsigned z_dim = patient->getOrganMeshZDim();
+
+  for( unsigned k = 0; k < z_dim; ++k )
+  {
+    for( unsigned j = 0; j < y_dim; ++j )
+    {
+      for( unsigned i = 0; i < x_dim; ++i )
+      {
+	BOOST_CHECK_SMALL( loaded_patient->getDose( i, j, k ) -
+			   patient->getDose( i, j, k ),
+			   1e-9*patient->getDose( i, j, k ) + 1e-12 );
+      }
+    }
+  }
+
+  // The archived quantized dose is within its error bound of the dose
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  BOOST_REQUIRE( plan_file.quantizedDoseDistributionExists( PLAN_NAME ) );
+
+  std::vector<double> quantized_dose;
+  plan_file.getQuantizedDoseDistribution( PLAN_NAME, quantized_dose );
+
+  double error_bound =
+    plan_file.getQuantizedDoseDistributionErrorBound( PLAN_NAME );
+
+  BOOST_CHECK( error_bound > 0.0 );
+  BOOST_REQUIRE_EQUAL( quantized_dose.size(), x_dim*y_dim*z_dim );
+
+  unsigned number_of_errors = 0u;
+
+  for( unsigned k = 0; k < z_dim; ++k )
+  {
+    for( unsigned j = 0; j < y_dim; ++j )
+    {
+      for( unsigned i = 0; i < x_dim; ++i )
+      {
+	unsigned index = i + j*x_dim + k*x_dim*y_dim;
+
+	if( fabs( quantized_dose[index] - loaded_patient->getDose( i, j, k ) )
+	    > error_bound*(1.0 + 1e-9) )
+	  ++number_of_errors;
+      }
+    }
+  }
+
+  BOOST_CHECK_EQUAL( number_of_errors, 0u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that a missing plan or a plan with a missing seed cannot be loaded
+BOOST_AUTO_TEST_CASE( loadTreatmentPlanWithMissingSeed )
+{
+  std::remove( PLAN_TEST_FILE_NAME );
+
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+
+  patient->archiveTreatmentPlanToHDF5( PLAN_NAME,
+				       PLAN_TEST_FILE_NAME,
+				       false );
+
+  // Only the first seed is given
+  seeds.pop_back();
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> loaded_patient =
+    createPatient();
+
+  loaded_patient->insertSeed( TPOR::BrachytherapySeedPosition( 1, 1, 1,
+							       1.0,
+							       seeds[0] ) );
+
+  BOOST_CHECK_THROW( loaded_patient->loadTreatmentPlanFromHDF5(
+						     PLAN_NAME,
+						     seeds,
+						     PLAN_TEST_FILE_NAME ),
+		     std::runtime_error );
+
+  BOOST_CHECK_THROW( loaded_patient->loadTreatmentPlanFromHDF5(
+						     "missing_plan",
+						     seeds,
+						     PLAN_TEST_FILE_NAME ),
+		     std::runtime_error );
+
+  // The current treatment plan is kept
+  BOOST_CHECK_EQUAL( loaded_patient->getNumInsertedSeeds(), 1u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the candidate seed positions can be restricted to a needle mask
+BOOST_AUTO_TEST_CASE( getCandidateSeedPositionsWithNeedleMask )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+  seeds.pop_back();
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  unsigned x_dim = patient->getOrganMeshXDim();
+  unsigned y_dim = patient->getOrganMeshYDim();
+
+  TPOR::BrachytherapyCandidateTable candidates( x_dim,
+						y_dim,
+						patient->getOrganMeshZDim() );
+
+  patient->getCandidateSeedPositions( seeds, candidates );
+
+  // Keep every other needle (the base weights of the masked candidates may
+  // be loaded from the adjoint data cache)
+  std::vector<bool> needle_mask( x_dim*y_dim, false );
+  std::vector<bool> needles( x_dim*y_dim, false );
+  unsigned number_of_needles = 0u;
+
+  for( unsigned c = 0; c < candidates.getNumberOfCandidates(); ++c )
+  {
+    unsigned needle = candidates.getXIndex( c ) + 
+      candidates.getYIndex( c )*x_dim;
+
+    if( !needles[needle] )
+    {
+      needles[needle] = true;
+      needle_mask[needle] = (number_of_needles++ % 2u == 0u);
+    }
+  }
+
+  unsigned number_of_masked_candidates = 0u;
+
+  for( unsigned c = 0; c < candidates.getNumberOfCandidates(); ++c )
+  {
+    if( needle_mask[candidates.getXIndex( c ) + 
+		    candidates.getYIndex( c )*x_dim] )
+      ++number_of_masked_candidates;
+  }
+
+  TPOR::BrachytherapyCandidateTable masked_candidates( 
+						 x_dim,
+						 y_dim,
+						 patient->getOrganMeshZDim() );
+
+  patient->getCandidateSeedPositions( seeds, masked_candidates, needle_mask );
+
+  BOOST_CHECK( number_of_masked_candidates < 
+	       candidates.getNumberOfCandidates() );
+  BOOST_REQUIRE_EQUAL( masked_candidates.getNumberOfCandidates(),
+		       number_of_masked_candidates );
+
+  for( unsigned c = 0, m = 0; c < candidates.getNumberOfCandidates(); ++c )
+  {
+    if( !needle_mask[candidates.getXIndex( c ) + 
+		     candidates.getYIndex( c )*x_dim] )
+      continue;
+
+    BOOST_CHECK_EQUAL( masked_candidates.getXIndex( m ), 
+		       candidates.getXIndex( c ) );
+    BOOST_CHECK_EQUAL( masked_candidates.getYIndex( m ), 
+		       candidates.getYIndex( c ) );
+    BOOST_CHECK_EQUAL( masked_candidates.getZIndex( m ), 
+		       candidates.getZIndex( c ) );
+    BOOST_CHECK_CLOSE( masked_candidates.getBaseWeight( m ), 
+		       candidates.getBaseWeight( c ),
+		       1e-9 );
+    ++m;
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that removing an inserted seed restores the previous state
+BOOST_AUTO_TEST_CASE( removeSeed )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+  boost::shared_ptr<TPOR::BrachytherapyPatient> expected_patient = 
+    createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+  insertTreatmentPlan( *expected_patient, seeds );
+
+  // The new seed shares a needle with the first seed of the plan
+  unsigned x = patient->getOrganMeshXDim()/2;
+  unsigned y = patient->getOrganMeshYDim()/2;
+  unsigned z = patient->getOrganMeshZDim()/2;
+
+  TPOR::BrachytherapySeedPosition seed_position( x, y, z-2, 1.0, seeds[1] );
+
+  patient->insertSeed( seed_position );
+
+  BOOST_CHECK( !patient->isSeedPositionFree( seed_position ) );
+  BOOST_CHECK_EQUAL( patient->getNumInsertedSeeds(), 5u );
+
+  patient->removeSeed( seed_position );
+
+  BOOST_CHECK( patient->isSeedPositionFree( seed_position ) );
+  BOOST_CHECK( patient->isSeedOnNeedle( seed_position ) );
+  checkPlansEqual( *patient, *expected_patient );
+  checkDosesClose( patient->getDoseDistribution(),
+		   expected_patient->getDoseDistribution() );
+
+  // A seed on its own needle removes the needle
+  TPOR::BrachytherapySeedPosition needle_seed_position( x+2, y+2, z,
+							1.0, seeds[0] );
+
+  patient->insertSeed( needle_seed_position );
+
+  BOOST_CHECK_EQUAL( patient->getNumInsertedNeedles(), 
+		     expected_patient->getNumInsertedNeedles()+1 );
+
+  patient->removeSeed( needle_seed_position );
+
+  BOOST_CHECK( !patient->isSeedOnNeedle( needle_seed_position ) );
+  checkPlansEqual( *patient, *expected_patient );
+  checkDosesClose( patient->getDoseDistribution(),
+		   expected_patient->getDoseDistribution() );
+
+  // Removing a seed from the middle of the plan keeps the plan order
+  std::list<TPOR::BrachytherapySeedPosition> plan = 
+    patient->getTreatmentPlan();
+
+  patient->removeSeed( *(++plan.begin()) );
+  plan.erase( ++plan.begin() );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> removed_patient = 
+    createPatient();
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed = 
+    plan.begin();
+
+  while( seed != plan.end() )
+  {
+    removed_patient->insertSeed( *seed );
+    
+    ++seed;
+  }
+
+  checkPlansEqual( *patient, *removed_patient );
+  checkDosesClose( patient->getDoseDistribution(),
+		   removed_patient->getDoseDistribution() );
+}
+
+//---------------------------------------------------------------------------//
+// Check that removing the last seed clears the dose distribution exactly
+BOOST_AUTO_TEST_CASE( removeLastSeed )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+
+  while( patient->getNumInsertedSeeds() > 0u )
+    patient->removeSeed( patient->getTreatmentPlan().back() );
+
+  BOOST_CHECK_EQUAL( patient->getNumInsertedNeedles(), 0u );
+
+  const std::vector<double> &dose_distribution = 
+    patient->getDoseDistribution();
+
+  unsigned number_of_nonzero_doses = 0u;
+
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    if( dose_distribution[i] != 0.0 )
+      ++number_of_nonzero_doses;
+  }
+
+  BOOST_CHECK_EQUAL( number_of_nonzero_doses, 0u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that a moved seed has the dose of a seed inserted at the new position
+BOOST_AUTO_TEST_CASE( moveSeed )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+
+  // Move the second seed onto the needle of the first seed
+  unsigned x = patient->getOrganMeshXDim()/2;
+  unsigned y = patient->getOrganMeshYDim()/2;
+  unsigned z = patient->getOrganMeshZDim()/2;
+
+  TPOR::BrachytherapySeedPosition old_seed_position = 
+    *(++patient->getTreatmentPlan().begin());
+  TPOR::BrachytherapySeedPosition new_seed_position( x, y, z-2, 
+						     1.0, seeds[1] );
+
+  unsigned number_of_needles = patient->getNumInsertedNeedles();
+
+  patient->moveSeed( old_seed_position, new_seed_position );
+
+  BOOST_CHECK( patient->isSeedPositionFree( old_seed_position ) );
+  BOOST_CHECK( !patient->isSeedOnNeedle( old_seed_position ) );
+  BOOST_CHECK_EQUAL( patient->getNumInsertedNeedles(), number_of_needles-1 );
+
+  // The moved seed keeps its place in the treatment plan
+  std::list<TPOR::BrachytherapySeedPosition> plan = 
+    patient->getTreatmentPlan();
+
+  BOOST_CHECK( *(++plan.begin()) == new_seed_position );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> expected_patient = 
+    createPatient();
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed = 
+    plan.begin();
+
+  while( seed != plan.end() )
+  {
+    expected_patient->insertSeed( *seed );
+    
+    ++seed;
+  }
+
+  checkPlansEqual( *patient, *expected_patient );
+  checkDosesClose( patient->getDoseDistribution(),
+		   expected_patient->getDoseDistribution() );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the only seed of a plan can be moved
+BOOST_AUTO_TEST_CASE( moveSingleSeed )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+  boost::shared_ptr<TPOR::BrachytherapyPatient> expected_patient = 
+    createPatient();
+
+  unsigned x = patient->getOrganMeshXDim()/2;
+  unsigned y = patient->getOrganMeshYDim()/2;
+  unsigned z = patient->getOrganMeshZDim()/2;
+
+  TPOR::BrachytherapySeedPosition old_seed_position( x, y, z, 
+						     1.0, seeds[0] );
+  TPOR::BrachytherapySeedPosition new_seed_position( x-3, y+4, z+1, 
+						     1.0, seeds[1] );
+
+  patient->insertSeed( old_seed_position );
+  patient->moveSeed( old_seed_position, new_seed_position );
+
+  expected_patient->insertSeed( new_seed_position );
+
+  checkPlansEqual( *patient, *expected_patient );
+  BOOST_CHECK( !patient->isSeedOnNeedle( old_seed_position ) );
+
+  // The dose distribution is overwritten by the seed dose distribution
+  const std::vector<double> &dose_distribution = 
+    patient->getDoseDistribution();
+  const std::vector<double> &expected_dose_distribution = 
+    expected_patient->getDoseDistribution();
+
+  BOOST_CHECK( dose_distribution == expected_dose_distribution );
+}
+
+//---------------------------------------------------------------------------//
+// Check that a checkpoint restores the dose and plan bit-for-bit
+BOOST_AUTO_TEST_CASE( restoreCheckpoint )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  // A checkpoint of the empty plan
+  patient->createCheckpoint( "empty" );
+
+  PatientState empty_state = getPatientState( *patient );
+
+  insertTreatmentPlan( *patient, seeds );
+
+  patient->createCheckpoint( "plan" );
+
+  PatientState state = getPatientState( *patient );
+
+  modifyTreatmentPlan( *patient, seeds, 0 );
+
+  patient->restoreCheckpoint( "plan" );
+
+  checkPatientStateRestored( *patient, state );
+
+  // The checkpoint can be restored again
+  BOOST_CHECK( patient->checkpointExists( "plan" ) );
+
+  modifyTreatmentPlan( *patient, seeds, 1 );
+
+  while( patient->getNumInsertedSeeds() > 0u )
+    patient->removeSeed( patient->getTreatmentPlan().front() );
+
+  patient->insertSeed( state.treatment_plan.back() );
+
+  patient->restoreCheckpoint( "plan" );
+
+  checkPatientStateRestored( *patient, state );
+
+  // Restoring an older checkpoint releases the newer checkpoints
+  patient->restoreCheckpoint( "empty" );
+
+  checkPatientStateRestored( *patient, empty_state );
+  BOOST_CHECK( patient->checkpointExists( "empty" ) );
+  BOOST_CHECK( !patient->checkpointExists( "plan" ) );
+
+  patient->releaseCheckpoint( "empty" );
+}
+
+//---------------------------------------------------------------------------//
+// Check that nested checkpoints restore their own states
+BOOST_AUTO_TEST_CASE( restoreNestedCheckpoints )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+
+  patient->createCheckpoint( "outer" );
+
+  PatientState outer_state = getPatientState( *patient );
+
+  modifyTreatmentPlan( *patient, seeds, 0 );
+
+  patient->createCheckpoint( "inner" );
+
+  PatientState inner_state = getPatientState( *patient );
+
+  modifyTreatmentPlan( *patient, seeds, 1 );
+
+  patient->restoreCheckpoint( "inner" );
+
+  checkPatientStateRestored( *patient, inner_state );
+
+  modifyTreatmentPlan( *patient, seeds, -1 );
+
+  patient->restoreCheckpoint( "outer" );
+
+  checkPatientStateRestored( *patient, outer_state );
+  BOOST_CHECK( !patient->checkpointExists( "inner" ) );
+
+  patient->releaseCheckpoint( "outer" );
+}
+
+//---------------------------------------------------------------------------//
+// Check that releasing a checkpoint keeps the older checkpoints valid
+BOOST_AUTO_TEST_CASE( releaseCheckpoint )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  insertTreatmentPlan( *patient, seeds );
+
+  patient->createCheckpoint( "outer" );
+
+  PatientState outer_state = getPatientState( *patient );
+
+  modifyTreatmentPlan( *patient, seeds, 0 );
+
+  patient->createCheckpoint( "middle" );
+
+  modifyTreatmentPlan( *patient, seeds, 1 );
+
+  patient->createCheckpoint( "inner" );
+
+  PatientState inner_state = getPatientState( *patient );
+
+  modifyTreatmentPlan( *patient, seeds, -1 );
+
+  // The outer checkpoint inherits the slices saved by the middle checkpoint
+  patient->releaseCheckpoint( "middle" );
+
+  BOOST_CHECK( !patient->checkpointExists( "middle" ) );
+  BOOST_CHECK( patient->checkpointExists( "inner" ) );
+
+  patient->restoreCheckpoint( "inner" );
+
+  checkPatientStateRestored( *patient, inner_state );
+
+  // The outer checkpoint inherits the slices saved by the inner checkpoint
+  modifyTreatmentPlan( *patient, seeds, 2 );
+
+  patient->releaseCheckpoint( "inner" );
+
+  patient->restoreCheckpoint( "outer" );
+
+  checkPatientStateRestored( *patient, outer_state );
+
+  // Without checkpoints the plan operations are not journaled
+  patient->releaseCheckpoint( "outer" );
+
+  BOOST_CHECK( !patient->checkpointExists( "outer" ) );
+
+  modifyTreatmentPlan( *patient, seeds, 0 );
+
+  patient->createCheckpoint( "outer" );
+
+  PatientState state = getPatientState( *patient );
+
+  modifyTreatmentPlan( *patient, seeds, 1 );
+
+  patient->restoreCheckpoint( "outer" );
+
+  checkPatientStateRestored( *patient, state );
+}
+
+//---------------------------------------------------------------------------//
+// end tstBrachytherapyPatient.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,284 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstBrachytherapyPlanFileHandler.cpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPlanFileHandler class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+
+// Boost Includes
+#define BOOST_TEST_MODULE BrachytherapyPlanFileHandler
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPlanFileHandler.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PLAN_TEST_FILE_NAME "plan_test_file.h5"
+#define PLAN_NAME "test_plan"
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Write a mock treatment plan to the test file
+void writeMockPlan()
+{
+  std::remove( PLAN_TEST_FILE_NAME );
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME );
+
+  std::vector<TPOR::BrachytherapySeedRecord> seeds( 2 );
+  seeds[0].needle_id = 1u;
+  seeds[0].x_index = 2u;
+  seeds[0].y_index = 3u;
+  seeds[0].z_index = 4u;
+  seeds[0].seed_type = 5u;
+  seeds[0].seed_strength = 0.5;
+  seeds[1].needle_id = 2u;
+  seeds[1].x_index = 6u;
+  seeds[1].y_index = 7u;
+  seeds[1].z_index = 8u;
+  seeds[1].seed_type = 9u;
+  seeds[1].seed_strength = 1.5;
+
+  plan_file.setSeeds( PLAN_NAME, seeds );
+
+  TPOR::BrachytherapyPlanMetrics metrics;
+  metrics.prostate_v100 = 0.95;
+  metrics.prostate_d90 = 160.0;
+  metrics.prostate_d100 = 140.0;
+  metrics.urethra_d10 = 170.0;
+  metrics.urethra_d90 = 150.0;
+  metrics.rectum_d10 = 80.0;
+  metrics.rectum_d90 = 20.0;
+  metrics.dnr = 0.5;
+  metrics.cn = 0.7;
+
+  plan_file.setPlanMetrics( PLAN_NAME, metrics );
+
+  // 2x3x4 mesh
+  std::vector<double> dose( 2*3*4 );
+  for( unsigned i = 0; i < dose.size(); ++i )
+    dose[i] = 100.0*i;
+
+  std::vector<unsigned> mesh_dimensions( 3 );
+  mesh_dimensions[0] = 2u;
+  mesh_dimensions[1] = 3u;
+  mesh_dimensions[2] = 4u;
+
+  std::vector<unsigned> mesh_offset( 3 );
+  mesh_offset[0] = 1u;
+  mesh_offset[1] = 2u;
+  mesh_offset[2] = 0u;
+
+  plan_file.setDoseDistribution( PLAN_NAME, dose, mesh_dimensions, 
+				 mesh_offset );
+
+  std::vector<double> dvh_doses( 3 );
+  dvh_doses[0] = 0.0;
+  dvh_doses[1] = 1.0;
+  dvh_doses[2] = 2.0;
+
+  plan_file.setDoseVolumeHistogramDoses( PLAN_NAME, dvh_doses );
+
+  std::vector<double> prostate_fractions( 3 );
+  prostate_fractions[0] = 1.0;
+  prostate_fractions[1] = 0.5;
+  prostate_fractions[2] = 0.0;
+
+  plan_file.setDoseVolumeHistogram( PLAN_NAME, "prostate", 
+				    prostate_fractions );
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that a treatment plan can be tested for existence and removed
+BOOST_AUTO_TEST_CASE( planExists )
+{
+  writeMockPlan();
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME );
+
+  BOOST_CHECK( plan_file.planExists( PLAN_NAME ) );
+  BOOST_CHECK( !plan_file.planExists( "missing_plan" ) );
+
+  plan_file.removePlan( PLAN_NAME );
+
+  BOOST_CHECK( !plan_file.planExists( PLAN_NAME ) );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the treatment plan seeds can be read
+BOOST_AUTO_TEST_CASE( getSeeds )
+{
+  writeMockPlan();
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  std::vector<TPOR::BrachytherapySeedRecord> seeds;
+  plan_file.getSeeds( PLAN_NAME, seeds );
+
+  BOOST_REQUIRE_EQUAL( seeds.size(), 2 );
+  BOOST_CHECK_EQUAL( seeds[0].needle_id, 1u );
+  BOOST_CHECK_EQUAL( seeds[0].x_index, 2u );
+  BOOST_CHECK_EQUAL( seeds[0].y_index, 3u );
+  BOOST_CHECK_EQUAL( seeds[0].z_index, 4u );
+  BOOST_CHECK_EQUAL( seeds[0].seed_type, 5u );
+  BOOST_CHECK_EQUAL( seeds[0].seed_strength, 0.5 );
+  BOOST_CHECK_EQUAL( seeds[1].needle_id, 2u );
+  BOOST_CHECK_EQUAL( seeds[1].z_index, 8u );
+  BOOST_CHECK_EQUAL( seeds[1].seed_strength, 1.5 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the treatment plan metrics can be read
+BOOST_AUTO_TEST_CASE( getPlanMetrics )
+{
+  writeMockPlan();
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  TPOR::BrachytherapyPlanMetrics metrics;
+  plan_file.getPlanMetrics( PLAN_NAME, metrics );
+
+  BOOST_CHECK_EQUAL( metrics.prostate_v100, 0.95 );
+  BOOST_CHECK_EQUAL( metrics.prostate_d90, 160.0 );
+  BOOST_CHECK_EQUAL( metrics.prostate_d100, 140.0 );
+  BOOST_CHECK_EQUAL( metrics.urethra_d10, 170.0 );
+  BOOST_CHECK_EQUAL( metrics.urethra_d90, 150.0 );
+  BOOST_CHECK_EQUAL( metrics.rectum_d10, 80.0 );
+  BOOST_CHECK_EQUAL( metrics.rectum_d90, 20.0 );
+  BOOST_CHECK_EQUAL( metrics.dnr, 0.5 );
+  BOOST_CHECK_EQUAL( metrics.cn, 0.7 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the treatment plan dose distribution can be read
+BOOST_AUTO_TEST_CASE( getDoseDistribution )
+{
+  writeMockPlan();
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  std::vector<double> dose;
+  plan_file.getDoseDistribution( PLAN_NAME, dose );
+
+  BOOST_REQUIRE_EQUAL( dose.size(), 2*3*4 );
+  BOOST_CHECK_EQUAL( dose[0], 0.0 );
+  BOOST_CHECK_EQUAL( dose[23], 2300.0 );
+
+  std::vector<unsigned> mesh_dimensions;
+  plan_file.getDoseDistributionDimensions( PLAN_NAME, mesh_dimensions );
+
+  BOOST_REQUIRE_EQUAL( mesh_dimensions.size(), 3 );
+  BOOST_CHECK_EQUAL( mesh_dimensions[0], 2u );
+  BOOST_CHECK_EQUAL( mesh_dimensions[1], 3u );
+  BOOST_CHECK_EQUAL( mesh_dimensions[2], 4u );
+
+  std::vector<unsigned> mesh_offset;
+  plan_file.getDoseDistributionOffset( PLAN_NAME, mesh_offset );
+
+  BOOST_REQUIRE_EQUAL( mesh_offset.size(), 3 );
+  BOOST_CHECK_EQUAL( mesh_offset[0], 1u );
+  BOOST_CHECK_EQUAL( mesh_offset[1], 2u );
+  BOOST_CHECK_EQUAL( mesh_offset[2], 0u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that z-slices of the treatment plan dose distribution can be read
+BOOST_AUTO_TEST_CASE( getDoseDistributionSlices )
+{
+  writeMockPlan();
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  std::vector<double> dose_slices;
+  plan_file.getDoseDistributionSlices( PLAN_NAME, 2u, 2u, dose_slices );
+
+  BOOST_REQUIRE_EQUAL( dose_slices.size(), 2*3*2 );
+  BOOST_CHECK_EQUAL( dose_slices.front(), 1200.0 );
+  BOOST_CHECK_EQUAL( dose_slices.back(), 2300.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the dose-volume-histogram can be read
+BOOST_AUTO_TEST_CASE( getDoseVolumeHistogram )
+{
+  writeMockPlan();
+  
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  std::vector<double> dvh_doses;
+  plan_file.getDoseVolumeHistogramDoses( PLAN_NAME, dvh_doses );
+
+  BOOST_REQUIRE_EQUAL( dvh_doses.size(), 3 );
+  BOOST_CHECK_EQUAL( dvh_doses[2], 2.0 );
+
+  std::vector<double> prostate_fractions;
+  plan_file.getDoseVolumeHistogram( PLAN_NAME, "prostate", 
+				    prostate_fractions );
+
+  BOOST_REQUIRE_EQUAL( prostate_fractions.size(), 3 );
+  BOOST_CHECK_EQUAL( prostate_fractions[0], 1.0 );
+  BOOST_CHECK_EQUAL( prostate_fractions[1], 0.5 );
+  BOOST_CHECK_EQUAL( prostate_fractions[2], 0.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that a quantized dose distribution can be written and read
+BOOST_AUTO_TEST_CASE( getQuantizedDoseDistribution )
+{
+  writeMockPlan();
+
+  std::vector<double> dose( 2*3*4 );
+  for( unsigned i = 0; i < dose.size(); ++i )
+    dose[i] = 1234.5*i/7.0;
+
+  std::vector<unsigned> mesh_dimensions( 3 );
+  mesh_dimensions[0] = 2u;
+  mesh_dimensions[1] = 3u;
+  mesh_dimensions[2] = 4u;
+
+  std::vector<unsigned> mesh_offset( 3, 0u );
+
+  {
+    TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME );
+    
+    BOOST_CHECK( !plan_file.quantizedDoseDistributionExists( PLAN_NAME ) );
+    
+    plan_file.setQuantizedDoseDistribution( PLAN_NAME,
+					    dose,
+					    mesh_dimensions,
+					    mesh_offset );
+  }
+
+  TPOR::BrachytherapyPlanFileHandler plan_file( PLAN_TEST_FILE_NAME, true );
+
+  BOOST_CHECK( plan_file.doseDistributionExists( PLAN_NAME ) );
+  BOOST_CHECK( plan_file.quantizedDoseDistributionExists( PLAN_NAME ) );
+
+  std::vector<double> dequantized_dose;
+  plan_file.getQuantizedDoseDistribution( PLAN_NAME, dequantized_dose );
+
+  double error_bound = 
+    plan_file.getQuantizedDoseDistributionErrorBound( PLAN_NAME );
+
+  BOOST_CHECK_CLOSE( error_bound, dose.back()/65535/2, 1e-9 );
+
+  BOOST_REQUIRE_EQUAL( dequantized_dose.size(), dose.size() );
+  for( unsigned i = 0; i < dose.size(); ++i )
+    BOOST_CHECK( fabs( dequantized_dose[i] - dose[i] ) <= error_bound );
+}
+
+//---------------------------------------------------------------------------//
+// end tstBrachytherapyPlanFileHandler.cpp
+//---------------------------------------------------------------------------//
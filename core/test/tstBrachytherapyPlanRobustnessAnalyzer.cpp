@@ -0,0 +1,269 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstBrachytherapyPlanRobustnessAnalyzer.cpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPlanRobustnessAnalyzer class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE BrachytherapyPlanRobustnessAnalyzer
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "BrachytherapyPlanEvaluator.hpp"
+#include "BrachytherapyPlanRobustnessAnalyzer.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "robustness_test_patient.h5"
+#define SEED_TEST_FILE_NAME "robustness_test_seeds.h5"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME );
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Create a patient with a treatment plan (three needles)
+boost::shared_ptr<TPOR::BrachytherapyPatient> createPatientWithPlan()
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     14500.0 ) );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient(
+				   new TPOR::BrachytherapyPatient( geometry ) );
+
+  boost::shared_ptr<TPOR::BrachytherapySeedProxy> seed(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::AMERSHAM_6711_SEED,
+					       0.55 ) );
+
+  unsigned x = patient->getOrganMeshXDim()/2;
+  unsigned y = patient->getOrganMeshYDim()/2;
+  unsigned z = patient->getOrganMeshZDim()/2;
+
+  patient->insertSeed( TPOR::BrachytherapySeedPosition( x-5, y, z-2,
+							1.0, seed ) );
+  patient->insertSeed( TPOR::BrachytherapySeedPosition( x-5, y, z+1,
+							1.0, seed ) );
+  patient->insertSeed( TPOR::BrachytherapySeedPosition( x+5, y, z-1,
+							1.0, seed ) );
+  patient->insertSeed( TPOR::BrachytherapySeedPosition( x+5, y, z+2,
+							1.0, seed ) );
+  patient->insertSeed( TPOR::BrachytherapySeedPosition( x, y+5, z,
+							1.0, seed ) );
+
+  return patient;
+}
+
+// Create a perturbation model
+TPOR::BrachytherapyPerturbationModel createModel(
+	       const TPOR::BrachytherapyPerturbationDistribution distribution,
+	       const double seed_width,
+	       const double needle_width )
+{
+  TPOR::BrachytherapyPerturbationModel model;
+
+  model.distribution = distribution;
+  model.seed_x_width = seed_width;
+  model.seed_y_width = seed_width;
+  model.seed_z_width = 2*seed_width;
+  model.needle_x_width = needle_width;
+  model.needle_y_width = needle_width;
+  model.needle_z_width = 2*needle_width;
+
+  return model;
+}
+
+// Check that two sets of plan metrics are equal
+void checkMetricsEqual( const TPOR::BrachytherapyPlanMetrics &metrics,
+			const TPOR::BrachytherapyPlanMetrics &expected_metrics )
+{
+  BOOST_CHECK_EQUAL( metrics.prostate_v100, expected_metrics.prostate_v100 );
+  BOOST_CHECK_EQUAL( metrics.prostate_d90, expected_metrics.prostate_d90 );
+  BOOST_CHECK_EQUAL( metrics.prostate_d100, expected_metrics.prostate_d100 );
+  BOOST_CHECK_EQUAL( metrics.urethra_d10, expected_metrics.urethra_d10 );
+  BOOST_CHECK_EQUAL( metrics.urethra_d90, expected_metrics.urethra_d90 );
+  BOOST_CHECK_EQUAL( metrics.rectum_d10, expected_metrics.rectum_d10 );
+  BOOST_CHECK_EQUAL( metrics.rectum_d90, expected_metrics.rectum_d90 );
+  BOOST_CHECK_EQUAL( metrics.dnr, expected_metrics.dnr );
+  BOOST_CHECK_EQUAL( metrics.cn, expected_metrics.cn );
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the scenarios only depend on the random number seed
+BOOST_AUTO_TEST_CASE( sampleScenariosReproducible )
+{
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+    createPatientWithPlan();
+
+  TPOR::BrachytherapyPerturbationModel model =
+    createModel( TPOR::NORMAL_PERTURBATION, 0.1, 0.15 );
+
+  TPOR::BrachytherapyPlanRobustnessAnalyzer analyzer( *patient, model );
+  TPOR::BrachytherapyPlanRobustnessAnalyzer thread_analyzer( *patient, model );
+  TPOR::BrachytherapyPlanRobustnessAnalyzer other_analyzer( *patient, model );
+
+  analyzer.sampleScenarios( 20u, 7u, 1u );
+  thread_analyzer.sampleScenarios( 20u, 7u, 3u );
+  other_analyzer.sampleScenarios( 20u, 8u, 1u );
+
+  const std::vector<TPOR::BrachytherapyPlanMetrics> &metrics =
+    analyzer.getScenarioMetrics();
+  const std::vector<TPOR::BrachytherapyPlanMetrics> &thread_metrics =
+    thread_analyzer.getScenarioMetrics();
+  const std::vector<TPOR::BrachytherapyPlanMetrics> &other_metrics =
+    other_analyzer.getScenarioMetrics();
+
+  BOOST_REQUIRE_EQUAL( metrics.size(), 20u );
+  BOOST_REQUIRE_EQUAL( thread_metrics.size(), 20u );
+
+  unsigned number_of_different_scenarios = 0u;
+  unsigned number_of_perturbed_scenarios = 0u;
+
+  for( unsigned i = 0; i < metrics.size(); ++i )
+  {
+    checkMetricsEqual( thread_metrics[i], metrics[i] );
+
+    if( other_metrics[i].prostate_d90 != metrics[i].prostate_d90 )
+      ++number_of_different_scenarios;
+
+    if( metrics[i].prostate_d90 != analyzer.getNominalMetrics().prostate_d90 )
+      ++number_of_perturbed_scenarios;
+  }
+
+  BOOST_CHECK( number_of_different_scenarios > 0u );
+  BOOST_CHECK( number_of_perturbed_scenarios > 0u );
+
+  // Resampling discards the previous scenarios
+  analyzer.sampleScenarios( 5u, 8u, 2u );
+
+  BOOST_REQUIRE_EQUAL( analyzer.getScenarioMetrics().size(), 5u );
+
+  for( unsigned i = 0; i < 5u; ++i )
+    checkMetricsEqual( analyzer.getScenarioMetrics()[i], other_metrics[i] );
+}
+
+//---------------------------------------------------------------------------//
+// Check that every scenario is the nominal plan if the widths are zero
+BOOST_AUTO_TEST_CASE( sampleScenariosZeroWidth )
+{
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+    createPatientWithPlan();
+
+  TPOR::BrachytherapyPerturbationDistribution distributions[2] =
+    { TPOR::NORMAL_PERTURBATION, TPOR::UNIFORM_PERTURBATION };
+
+  for( unsigned d = 0; d < 2u; ++d )
+  {
+    TPOR::BrachytherapyPlanRobustnessAnalyzer analyzer(
+			       *patient,
+			       createModel( distributions[d], 0.0, 0.0 ) );
+
+    analyzer.sampleScenarios( 6u, 3u );
+
+    TPOR::BrachytherapyPlanMetrics patient_metrics;
+    TPOR::BrachytherapyPlanEvaluator( patient->getGeometry() ).
+      evaluateDoseDistribution( patient->getDoseDistribution(),
+				patient_metrics );
+
+    checkMetricsEqual( analyzer.getNominalMetrics(), patient_metrics );
+
+    for( unsigned i = 0; i < analyzer.getScenarioMetrics().size(); ++i )
+    {
+      checkMetricsEqual( analyzer.getScenarioMetrics()[i],
+			 analyzer.getNominalMetrics() );
+    }
+
+    BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 0.05 ),
+		       analyzer.getNominalMetrics().prostate_v100 );
+    BOOST_CHECK_EQUAL( analyzer.getProstateD90Percentile( 0.95 ),
+		       analyzer.getNominalMetrics().prostate_d90 );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the percentiles are the nearest-rank scenario values
+BOOST_AUTO_TEST_CASE( getPercentiles )
+{
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+    createPatientWithPlan();
+
+  TPOR::BrachytherapyPlanRobustnessAnalyzer analyzer(
+		     *patient,
+		     createModel( TPOR::UNIFORM_PERTURBATION, 0.15, 0.1 ) );
+
+  analyzer.sampleScenarios( 21u, 11u );
+
+  std::vector<double> v100_values, d90_values;
+
+  for( unsigned i = 0; i < analyzer.getScenarioMetrics().size(); ++i )
+  {
+    v100_values.push_back( analyzer.getScenarioMetrics()[i].prostate_v100 );
+    d90_values.push_back( analyzer.getScenarioMetrics()[i].prostate_d90 );
+  }
+
+  std::sort( v100_values.begin(), v100_values.end() );
+  std::sort( d90_values.begin(), d90_values.end() );
+
+  // The rank of a percentile p is the nearest integer to p*(N-1)
+  BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 0.0 ),
+		     v100_values.front() );
+  BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 1.0 ),
+		     v100_values.back() );
+  BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 0.05 ),
+		     v100_values[1] );
+  BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 0.5 ),
+		     v100_values[10] );
+  BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 0.95 ),
+		     v100_values[19] );
+  BOOST_CHECK_EQUAL( analyzer.getProstateV100Percentile( 0.12 ),
+		     v100_values[2] );
+
+  BOOST_CHECK_EQUAL( analyzer.getProstateD90Percentile( 0.0 ),
+		     d90_values.front() );
+  BOOST_CHECK_EQUAL( analyzer.getProstateD90Percentile( 0.05 ),
+		     d90_values[1] );
+  BOOST_CHECK_EQUAL( analyzer.getProstateD90Percentile( 0.5 ),
+		     d90_values[10] );
+  BOOST_CHECK_EQUAL( analyzer.getProstateD90Percentile( 0.95 ),
+		     d90_values[19] );
+  BOOST_CHECK_EQUAL( analyzer.getProstateD90Percentile( 1.0 ),
+		     d90_values.back() );
+}
+
+//---------------------------------------------------------------------------//
+// end tstBrachytherapyPlanRobustnessAnalyzer.cpp
+//---------------------------------------------------------------------------//
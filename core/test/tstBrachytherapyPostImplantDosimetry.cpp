@@ -0,0 +1,273 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstBrachytherapyPostImplantDosimetry.cpp
+//! \author Alex Robinson
+//! \brief  BrachytherapyPostImplantDosimetry class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE BrachytherapyPostImplantDosimetry
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPostImplantDosimetry.hpp"
+#include "BrachytherapySeedFactory.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "post_implant_test_patient.h5"
+#define IMPLANT_TEST_FILE_NAME "post_implant_test_seeds.txt"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Write an implanted seed file
+void writeImplantFile( const std::string &contents )
+{
+  std::ofstream implant_file( IMPLANT_TEST_FILE_NAME );
+
+  implant_file << contents;
+}
+
+// Create the patient geometry
+boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> createGeometry()
+{
+  return boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry>(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     14500.0 ) );
+}
+
+// Create a seed at the center of a region of interest mesh element
+TPOR::BrachytherapyImplantedSeed createSeed(
+	     const TPOR::BrachytherapyPatientGeometry &geometry,
+	     const unsigned i,
+	     const unsigned j,
+	     const unsigned k,
+	     const double axis_x,
+	     const double axis_y,
+	     const double axis_z )
+{
+  TPOR::BrachytherapyImplantedSeed seed;
+
+  seed.x = (geometry.getROIXOffset() + i + 0.5)*0.1;
+  seed.y = (geometry.getROIYOffset() + j + 0.5)*0.1;
+  seed.z = (geometry.getROIZOffset() + k + 0.5)*0.5;
+  seed.axis_x = axis_x;
+  seed.axis_y = axis_y;
+  seed.axis_z = axis_z;
+
+  return seed;
+}
+
+// Return the dose of a region of interest mesh element
+double getDose( const TPOR::BrachytherapyPatientGeometry &geometry,
+		const std::vector<double> &dose_distribution,
+		const unsigned i,
+		const unsigned j,
+		const unsigned k )
+{
+  unsigned x_dim = geometry.getOrganMeshXDim();
+  unsigned y_dim = geometry.getOrganMeshYDim();
+
+  return dose_distribution[i + j*x_dim + k*x_dim*y_dim];
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the implanted seeds can be read
+BOOST_AUTO_TEST_CASE( readImplantedSeeds )
+{
+  writeImplantFile( "# x y z (ax ay az)\n"
+		    "1.0 2.0 3.0\n"
+		    "\n"
+		    "  # a comment\n"
+		    "1.5 2.5 3.5 1.0 0.0 1.0\n"
+		    "-0.5 0.25 4.0\n" );
+
+  std::vector<TPOR::BrachytherapyImplantedSeed> seeds;
+
+  TPOR::BrachytherapyPostImplantDosimetry::readImplantedSeeds(
+						     IMPLANT_TEST_FILE_NAME,
+						     seeds );
+
+  BOOST_REQUIRE_EQUAL( seeds.size(), 3u );
+
+  BOOST_CHECK_EQUAL( seeds[0].x, 1.0 );
+  BOOST_CHECK_EQUAL( seeds[0].y, 2.0 );
+  BOOST_CHECK_EQUAL( seeds[0].z, 3.0 );
+  BOOST_CHECK_EQUAL( seeds[0].axis_x, 0.0 );
+  BOOST_CHECK_EQUAL( seeds[0].axis_y, 0.0 );
+  BOOST_CHECK_EQUAL( seeds[0].axis_z, 1.0 );
+
+  BOOST_CHECK_EQUAL( seeds[1].x, 1.5 );
+  BOOST_CHECK_EQUAL( seeds[1].y, 2.5 );
+  BOOST_CHECK_EQUAL( seeds[1].z, 3.5 );
+  BOOST_CHECK_EQUAL( seeds[1].axis_x, 1.0 );
+  BOOST_CHECK_EQUAL( seeds[1].axis_y, 0.0 );
+  BOOST_CHECK_EQUAL( seeds[1].axis_z, 1.0 );
+
+  BOOST_CHECK_EQUAL( seeds[2].x, -0.5 );
+  BOOST_CHECK_EQUAL( seeds[2].y, 0.25 );
+  BOOST_CHECK_EQUAL( seeds[2].z, 4.0 );
+  BOOST_CHECK_EQUAL( seeds[2].axis_z, 1.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that malformed implanted seed files are reported
+BOOST_AUTO_TEST_CASE( readMalformedImplantedSeeds )
+{
+  std::vector<TPOR::BrachytherapyImplantedSeed> seeds;
+
+  const char* malformed_lines[6] = { "1.0 2.0\n",
+				     "1.0 2.0 3.0 1.0\n",
+				     "1.0 2.0 3.0 1.0 0.0\n",
+				     "1.0 2.0 3.0 1.0 0.0 1.0 1.0\n",
+				     "1.0 2.0 3.0 x\n",
+				     "1.0 2.0 3.0 0.0 0.0 0.0\n" };
+
+  for( unsigned i = 0; i < 6u; ++i )
+  {
+    writeImplantFile( std::string( "1.0 2.0 3.0\n" ) + malformed_lines[i] );
+
+    BOOST_CHECK_THROW(
+	   TPOR::BrachytherapyPostImplantDosimetry::readImplantedSeeds(
+						     IMPLANT_TEST_FILE_NAME,
+						     seeds ),
+	   std::runtime_error );
+  }
+
+  BOOST_CHECK_THROW(
+	   TPOR::BrachytherapyPostImplantDosimetry::readImplantedSeeds(
+						     "missing_seed_file.txt",
+						     seeds ),
+	   std::runtime_error );
+}
+
+//---------------------------------------------------------------------------//
+// Check the dose of an implanted seed at known points
+BOOST_AUTO_TEST_CASE( calculateDoseDistribution )
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry =
+    createGeometry();
+
+  TPOR::BrachytherapyPostImplantDosimetry dosimetry( geometry,
+						     TPOR::AMERSHAM_6711_SEED,
+						     0.55 );
+
+  TPOR::BrachytherapySeedFactory::BrachytherapySeedPtr seed =
+    TPOR::BrachytherapySeedFactory::createSeed( TPOR::AMERSHAM_6711_SEED,
+						0.55 );
+
+  std::vector<TPOR::BrachytherapyImplantedSeed> seeds( 1,
+		       createSeed( *geometry, 10u, 10u, 3u, 0.0, 0.0, 1.0 ) );
+
+  std::vector<double> dose_distribution;
+
+  dosimetry.calculateDoseDistribution( seeds, dose_distribution );
+
+  BOOST_CHECK_EQUAL( dose_distribution.size(),
+		     geometry->getOrganMeshXDim()*
+		     geometry->getOrganMeshYDim()*
+		     geometry->getOrganMeshZDim() );
+
+  // Points on the transverse plane and on the seed axis
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 13u, 10u, 3u ),
+		     seed->getTotalDose( 0.3, 0.0, 0.0 ),
+		     1e-9 );
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 10u, 14u, 3u ),
+		     seed->getTotalDose( 0.4, 0.0, 0.0 ),
+		     1e-9 );
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 10u, 10u, 5u ),
+		     seed->getTotalDose( 1e-6, 0.0, 1.0 ),
+		     1e-9 );
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 13u, 14u, 4u ),
+		     seed->getTotalDose( 0.5, 0.0, 0.5 ),
+		     1e-9 );
+
+  // The seed axis is rotated onto the x-axis
+  seeds[0] = createSeed( *geometry, 10u, 10u, 3u, 2.0, 0.0, 0.0 );
+
+  dosimetry.calculateDoseDistribution( seeds, dose_distribution );
+
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 13u, 10u, 3u ),
+		     seed->getTotalDose( 1e-6, 0.0, 0.3 ),
+		     1e-9 );
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 10u, 10u, 4u ),
+		     seed->getTotalDose( 0.5, 0.0, 0.0 ),
+		     1e-9 );
+  BOOST_CHECK_CLOSE( getDose( *geometry, dose_distribution, 6u, 13u, 3u ),
+		     seed->getTotalDose( 0.3, 0.0, -0.4 ),
+		     1e-9 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the dose of several seeds does not depend on the threads
+BOOST_AUTO_TEST_CASE( calculateDoseDistributionWithThreads )
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry =
+    createGeometry();
+
+  TPOR::BrachytherapyPostImplantDosimetry dosimetry( geometry,
+						     TPOR::AMERSHAM_6711_SEED,
+						     0.55 );
+
+  std::vector<TPOR::BrachytherapyImplantedSeed> seeds;
+  seeds.push_back( createSeed( *geometry, 10u, 10u, 3u, 0.0, 0.0, 1.0 ) );
+  seeds.push_back( createSeed( *geometry, 15u, 12u, 4u, 0.0, 1.0, 1.0 ) );
+  seeds.push_back( createSeed( *geometry, 5u, 16u, 2u, 1.0, 0.0, 0.0 ) );
+
+  std::vector<double> dose_distribution, first_seed_dose_distribution;
+  std::vector<double> thread_dose_distribution;
+
+  dosimetry.calculateDoseDistribution( seeds, dose_distribution, 1u );
+  dosimetry.calculateDoseDistribution( seeds, thread_dose_distribution, 3u );
+  dosimetry.calculateDoseDistribution(
+	    std::vector<TPOR::BrachytherapyImplantedSeed>( 1, seeds[0] ),
+	    first_seed_dose_distribution );
+
+  BOOST_REQUIRE_EQUAL( thread_dose_distribution.size(),
+		       dose_distribution.size() );
+
+  for( unsigned i = 0; i < dose_distribution.size(); ++i )
+  {
+    BOOST_CHECK_CLOSE( thread_dose_distribution[i],
+		       dose_distribution[i],
+		       1e-9 );
+    BOOST_CHECK( dose_distribution[i] > first_seed_dose_distribution[i] );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// end tstBrachytherapyPostImplantDosimetry.cpp
+//---------------------------------------------------------------------------//
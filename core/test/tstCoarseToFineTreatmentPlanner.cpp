@@ -0,0 +1,406 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstCoarseToFineTreatmentPlanner.cpp
+//! \author Alex Robinson
+//! \brief  CoarseToFineTreatmentPlanner class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <list>
+#include <algorithm>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE CoarseToFineTreatmentPlanner
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "BrachytherapyTreatmentPlannerFactory.hpp"
+#include "CoarseToFineTreatmentPlanner.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "coarse_to_fine_test_patient.h5"
+#define SEED_TEST_FILE_NAME "coarse_to_fine_test_seeds.h5"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME, 2u );
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// The seed container type
+typedef std::vector<boost::shared_ptr<TPOR::BrachytherapySeedProxy> >
+SeedVector;
+
+// Create the test seeds
+void createSeeds( SeedVector &seeds )
+{
+  seeds.clear();
+
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::AMERSHAM_6711_SEED,
+					       0.55 ) ) );
+}
+
+// Create the patient geometry
+boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> createGeometry()
+{
+  return boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry>(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     14500.0 ) );
+}
+
+// Create a patient
+boost::shared_ptr<TPOR::BrachytherapyPatient> createPatient()
+{
+  return boost::shared_ptr<TPOR::BrachytherapyPatient>(
+				  new TPOR::BrachytherapyPatient(
+						       createGeometry() ) );
+}
+
+// Check that two treatment plans are equal
+void checkPlansEqual( const TPOR::BrachytherapyPatient &patient,
+		      const TPOR::BrachytherapyPatient &expected_patient )
+{
+  const std::list<TPOR::BrachytherapySeedPosition> &plan =
+    patient.getTreatmentPlan();
+  const std::list<TPOR::BrachytherapySeedPosition> &expected_plan =
+    expected_patient.getTreatmentPlan();
+
+  BOOST_REQUIRE_EQUAL( plan.size(), expected_plan.size() );
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed =
+    plan.begin();
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator expected_seed =
+    expected_plan.begin();
+
+  while( seed != plan.end() )
+  {
+    BOOST_CHECK_EQUAL( seed->getXIndex(), expected_seed->getXIndex() );
+    BOOST_CHECK_EQUAL( seed->getYIndex(), expected_seed->getYIndex() );
+    BOOST_CHECK_EQUAL( seed->getZIndex(), expected_seed->getZIndex() );
+
+    ++seed;
+    ++expected_seed;
+  }
+}
+
+// Return the number of template positions that cross the prostate
+unsigned countProstateNeedles( const TPOR::BrachytherapyPatient &patient )
+{
+  const std::vector<bool> &prostate_mask = patient.getProstateMask();
+  const std::vector<bool> &needle_template =
+    patient.getGeometry()->getNeedleTemplate();
+
+  std::vector<bool> prostate_needles( needle_template.size(), false );
+
+  for( unsigned index = 0; index < prostate_mask.size(); ++index )
+  {
+    unsigned needle_index = index % needle_template.size();
+
+    if( prostate_mask[index] && needle_template[needle_index] )
+      prostate_needles[needle_index] = true;
+  }
+
+  return std::count( prostate_needles.begin(), prostate_needles.end(), true );
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that a downsampled geometry samples every n-th fine mesh element
+BOOST_AUTO_TEST_CASE( downsampleGeometry )
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry =
+    createGeometry();
+
+  TPOR::BrachytherapyPatientGeometry coarse_geometry( *geometry, 2u );
+
+  unsigned x_dim = geometry->getOrganMeshXDim();
+  unsigned y_dim = geometry->getOrganMeshYDim();
+  unsigned z_dim = geometry->getOrganMeshZDim();
+  unsigned coarse_x_dim = coarse_geometry.getOrganMeshXDim();
+  unsigned coarse_y_dim = coarse_geometry.getOrganMeshYDim();
+
+  BOOST_CHECK_EQUAL( coarse_geometry.getDownsamplingFactor(), 2u );
+  BOOST_CHECK_EQUAL( coarse_x_dim, (x_dim + 1u)/2u );
+  BOOST_CHECK_EQUAL( coarse_y_dim, (y_dim + 1u)/2u );
+  BOOST_CHECK_EQUAL( coarse_geometry.getOrganMeshZDim(), z_dim );
+  BOOST_CHECK_EQUAL( coarse_geometry.getNumberOfStructures(),
+		     geometry->getNumberOfStructures() );
+
+  // Every structure of the mock patient is thick enough to be sampled
+  unsigned number_of_label_errors = 0u;
+
+  for( unsigned k = 0; k < z_dim; ++k )
+  {
+    for( unsigned j = 0; j < coarse_y_dim; ++j )
+    {
+      for( unsigned i = 0; i < coarse_x_dim; ++i )
+      {
+	if( coarse_geometry.getStructureLabels()[
+		      i + j*coarse_x_dim + k*coarse_x_dim*coarse_y_dim] !=
+	    geometry->getStructureLabels()[2*i + 2*j*x_dim + k*x_dim*y_dim] )
+	  ++number_of_label_errors;
+      }
+    }
+  }
+
+  BOOST_CHECK_EQUAL( number_of_label_errors, 0u );
+
+  for( unsigned s = 0; s < geometry->getNumberOfStructures(); ++s )
+    BOOST_CHECK( coarse_geometry.getStructureSize( s ) > 0u );
+
+  // The sampled prostate volume is close to the prostate volume
+  BOOST_CHECK_CLOSE( coarse_geometry.getProstateVolume(),
+		     geometry->getProstateVolume(),
+		     5.0 );
+
+  // A coarse template position covers the fine template positions
+  unsigned number_of_template_errors = 0u;
+
+  for( unsigned j = 0; j < coarse_y_dim; ++j )
+  {
+    for( unsigned i = 0; i < coarse_x_dim; ++i )
+    {
+      bool fine_needle = false;
+
+      for( unsigned fine_j = 2*j; fine_j < std::min( 2*j+2, y_dim ); ++fine_j)
+      {
+	for( unsigned fine_i = 2*i; fine_i < std::min( 2*i+2, x_dim );
+	     ++fine_i )
+	{
+	  if( geometry->getNeedleTemplate()[fine_i + fine_j*x_dim] )
+	    fine_needle = true;
+	}
+      }
+
+      if( coarse_geometry.getNeedleTemplate()[i + j*coarse_x_dim] !=
+	  fine_needle )
+	++number_of_template_errors;
+    }
+  }
+
+  BOOST_CHECK_EQUAL( number_of_template_errors, 0u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that a downsampled seed samples every n-th fine dose mesh element
+BOOST_AUTO_TEST_CASE( downsampleSeed )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  TPOR::BrachytherapySeedProxy coarse_seed( *seeds[0], 2u );
+
+  BOOST_CHECK_EQUAL( coarse_seed.getSeedType(), seeds[0]->getSeedType() );
+  BOOST_CHECK_EQUAL( coarse_seed.getSeedName(), seeds[0]->getSeedName() );
+  BOOST_CHECK_EQUAL( coarse_seed.getSeedStrength(),
+		     seeds[0]->getSeedStrength() );
+
+  for( int z = -3; z <= 3; ++z )
+  {
+    for( int y = -9; y <= 9; ++y )
+    {
+      for( int x = -9; x <= 9; ++x )
+      {
+	BOOST_CHECK_EQUAL( coarse_seed.getTotalDose( x, y, z ),
+			   seeds[0]->getTotalDose( 2*x, 2*y, z ) );
+      }
+    }
+  }
+
+  // The dose distribution overlap covers the sampled dose mesh
+  TPOR::DoseDistributionOverlap overlap =
+    coarse_seed.getDoseDistributionOverlap( 0, 0, 0, 100u, 100u, 100u );
+
+  BOOST_CHECK_EQUAL( overlap.x_end, 11 );
+  BOOST_CHECK_EQUAL( overlap.y_end, 11 );
+  BOOST_CHECK_EQUAL( overlap.z_end, 5 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the fine plan only uses the template positions around the
+// coarse needles and that the patient candidates are not restricted
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlan )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  // Cache the adjoint data so that every candidate table has the same base
+  // weights (the cached data is rescaled by the seed strength)
+  std::vector<std::vector<double> > adjoint_data;
+
+  createGeometry()->getAdjointData( seeds[0], adjoint_data );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  TPOR::BrachytherapyTreatmentPlannerFactory factory( patient, seeds );
+
+  TPOR::CoarseToFineTreatmentPlanner planner(
+					 patient,
+					 factory,
+					 TPOR::DWDMM_TREATMENT_PLANNER );
+
+  planner.calculateOptimumTreatmentPlan();
+
+  BOOST_CHECK( planner.getNumberOfCoarseNeedles() > 0u );
+  BOOST_CHECK( planner.getNumberOfFineTemplatePositions() > 0u );
+  BOOST_CHECK( planner.getNumberOfFineTemplatePositions() <
+	       countProstateNeedles( *patient ) );
+  BOOST_CHECK( !planner.isFullTemplateUsed() );
+  BOOST_CHECK( patient->getNumInsertedSeeds() > 0u );
+  BOOST_CHECK( patient->getNumInsertedNeedles() <=
+	       planner.getNumberOfFineTemplatePositions() );
+
+  // A planner created after the coarse-to-fine planner uses all candidates
+  patient->resetState();
+
+  factory.createTreatmentPlanner( TPOR::DWDMM_TREATMENT_PLANNER )->
+    calculateOptimumTreatmentPlan();
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> full_patient =
+    createPatient();
+
+  TPOR::BrachytherapyTreatmentPlannerFactory( full_patient, seeds ).
+    createTreatmentPlanner( TPOR::DWDMM_TREATMENT_PLANNER )->
+    calculateOptimumTreatmentPlan();
+
+  checkPlansEqual( *patient, *full_patient );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the full template fallback keeps the plan with the highest
+// prostate coverage
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlanWithFallback )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  std::vector<std::vector<double> > adjoint_data;
+
+  createGeometry()->getAdjointData( seeds[0], adjoint_data );
+
+  // Only the template positions covered by the coarse needles are used
+  boost::shared_ptr<TPOR::BrachytherapyPatient> fine_patient =
+    createPatient();
+
+  TPOR::CoarseToFineTreatmentPlanner fine_planner(
+	      fine_patient,
+	      TPOR::BrachytherapyTreatmentPlannerFactory( fine_patient, seeds ),
+	      TPOR::DWDMM_TREATMENT_PLANNER,
+	      false,
+	      2u,
+	      0u );
+
+  fine_planner.calculateOptimumTreatmentPlan();
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  TPOR::CoarseToFineTreatmentPlanner planner(
+	      patient,
+	      TPOR::BrachytherapyTreatmentPlannerFactory( patient, seeds ),
+	      TPOR::DWDMM_TREATMENT_PLANNER,
+	      true,
+	      2u,
+	      0u );
+
+  planner.calculateOptimumTreatmentPlan();
+
+  // The fine plan fails and the full template plan is kept
+  BOOST_REQUIRE( fine_patient->getProstatePrescribedDoseCoverage() < 0.98 );
+  BOOST_CHECK( !fine_planner.isFullTemplateUsed() );
+  BOOST_CHECK( planner.isFullTemplateUsed() );
+  BOOST_CHECK( patient->getProstatePrescribedDoseCoverage() >=
+	       fine_patient->getProstatePrescribedDoseCoverage() );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> full_patient =
+    createPatient();
+
+  TPOR::BrachytherapyTreatmentPlannerFactory( full_patient, seeds ).
+    createTreatmentPlanner( TPOR::DWDMM_TREATMENT_PLANNER )->
+    calculateOptimumTreatmentPlan();
+
+  checkPlansEqual( *patient, *full_patient );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the fine plan is made with all of the candidates if the coarse
+// plan fails (the needle goals of the IIEM planner are not reached on the
+// mock patient)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlanAfterCoarseFailure )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  std::vector<std::vector<double> > adjoint_data;
+
+  createGeometry()->getAdjointData( seeds[0], adjoint_data );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> coarse_patient =
+    createPatient();
+
+  TPOR::BrachytherapyTreatmentPlannerFactory coarse_factory =
+    TPOR::BrachytherapyTreatmentPlannerFactory( coarse_patient, seeds ).
+    createDownsampledFactory( 2u );
+
+  coarse_factory.createTreatmentPlanner( TPOR::IIEM_TREATMENT_PLANNER )->
+    calculateOptimumTreatmentPlan();
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient = createPatient();
+
+  TPOR::CoarseToFineTreatmentPlanner planner(
+	      patient,
+	      TPOR::BrachytherapyTreatmentPlannerFactory( patient, seeds ),
+	      TPOR::IIEM_TREATMENT_PLANNER );
+
+  planner.calculateOptimumTreatmentPlan();
+
+  // The coarse plan fails and its needles are not used
+  BOOST_REQUIRE( coarse_factory.getPatient()->
+		 getProstatePrescribedDoseCoverage() < 0.98 );
+  BOOST_CHECK_EQUAL( planner.getNumberOfCoarseNeedles(),
+		     coarse_factory.getPatient()->getNumInsertedNeedles() );
+  BOOST_CHECK_EQUAL( planner.getNumberOfFineTemplatePositions(), 0u );
+  BOOST_CHECK( planner.isFullTemplateUsed() );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> full_patient =
+    createPatient();
+
+  TPOR::BrachytherapyTreatmentPlannerFactory( full_patient, seeds ).
+    createTreatmentPlanner( TPOR::IIEM_TREATMENT_PLANNER )->
+    calculateOptimumTreatmentPlan();
+
+  checkPlansEqual( *patient, *full_patient );
+}
+
+//---------------------------------------------------------------------------//
+// end tstCoarseToFineTreatmentPlanner.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,254 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstDWDMMTreatmentPlanner.cpp
+//! \author Alex Robinson
+//! \brief  DWDMMTreatmentPlanner class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <list>
+#include <algorithm>
+#include <math.h>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE DWDMMTreatmentPlanner
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "BrachytherapyCandidateTable.hpp"
+#include "DWDMMTreatmentPlanner.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "dwdmm_test_patient.h5"
+#define SEED_TEST_FILE_NAME "dwdmm_test_seeds.h5"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME, 2u );
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// The seed container type
+typedef std::vector<boost::shared_ptr<TPOR::BrachytherapySeedProxy> >
+SeedVector;
+
+// Create the test seeds
+void createSeeds( SeedVector &seeds )
+{
+  seeds.clear();
+
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::AMERSHAM_6711_SEED,
+					       0.55 ) ) );
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::BEST_2301_SEED,
+					       0.2 ) ) );
+}
+
+// Create a patient
+boost::shared_ptr<TPOR::BrachytherapyPatient> createPatient(
+					       const double prescribed_dose )
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     prescribed_dose ) );
+
+  return boost::shared_ptr<TPOR::BrachytherapyPatient>(
+				   new TPOR::BrachytherapyPatient( geometry ) );
+}
+
+// Update every candidate (the original list based update)
+void updateAllCandidates( TPOR::BrachytherapyPatient &patient,
+			  TPOR::BrachytherapyCandidateTable &candidates,
+			  std::vector<unsigned> &occupied_candidates,
+			  const unsigned inserted_candidate )
+{
+  int x = candidates.getXIndex( inserted_candidate );
+  int y = candidates.getYIndex( inserted_candidate );
+  int z = candidates.getZIndex( inserted_candidate );
+
+  TPOR::DoseDistributionOverlap position_box = { x, x+1, y, y+1, z, z+1 };
+
+  candidates.findAliveCandidatesInBox( position_box, occupied_candidates );
+
+  std::vector<unsigned> skipped_candidates;
+
+  candidates.removeOccupiedCandidates( occupied_candidates,
+				       skipped_candidates );
+
+  for( unsigned c = candidates.getFirstAliveCandidate();
+       c != candidates.getNumberOfCandidates();
+       c = candidates.getNextAliveCandidate( c ) )
+  {
+    if( std::find( skipped_candidates.begin(),
+		   skipped_candidates.end(),
+		   c ) != skipped_candidates.end() )
+      continue;
+
+    unsigned position_index = candidates.getPositionIndex( c );
+
+    double dose = patient.getDoseDistribution()[position_index];
+
+    candidates.setDynamicWeight( c, candidates.getBaseWeight( c )*dose );
+  }
+}
+
+// Insert a candidate seed and update every candidate
+void insertCandidate( TPOR::BrachytherapyPatient &patient,
+		      TPOR::BrachytherapyCandidateTable &candidates,
+		      std::vector<unsigned> &occupied_candidates,
+		      const unsigned candidate )
+{
+  patient.insertSeed( candidates.createSeedPosition( candidate ) );
+  candidates.removeCandidate( candidate );
+  updateAllCandidates( patient, candidates, occupied_candidates, candidate );
+}
+
+// Calculate the reference treatment plan (every candidate is updated after
+// every insertion and the minimum weight is found by a scan)
+void calculateReferencePlan( TPOR::BrachytherapyPatient &patient,
+			     const SeedVector &seeds )
+{
+  TPOR::BrachytherapyCandidateTable candidates( patient.getOrganMeshXDim(),
+						patient.getOrganMeshYDim(),
+						patient.getOrganMeshZDim() );
+
+  patient.getCandidateSeedPositions( seeds, candidates );
+  candidates.buildPositionIndex();
+
+  std::vector<unsigned> occupied_candidates;
+
+  insertCandidate( patient,
+		   candidates,
+		   occupied_candidates,
+		   candidates.findMinimumDynamicWeightCandidate() );
+
+  while( patient.getProstatePrescribedDoseCoverage() < 0.98 &&
+	 candidates.getNumberOfAliveCandidates() > 0 )
+  {
+    unsigned candidate = candidates.findMinimumDynamicWeightCandidate();
+
+    while( true )
+    {
+      if( patient.isSeedOnNeedle( candidates, candidate ) )
+	break;
+
+      unsigned n = patient.getNumInsertedNeedles() + 1;
+
+      candidates.multiplyDynamicWeight( candidate,
+					0.5*sqrt( (900.0 + n*n)/
+						  (900.0 - n*n) ) );
+
+      unsigned test_candidate = candidates.findMinimumDynamicWeightCandidate();
+
+      if( test_candidate == candidate )
+	break;
+      else
+	candidate = test_candidate;
+    }
+
+    insertCandidate( patient, candidates, occupied_candidates, candidate );
+  }
+}
+
+// Check that two treatment plans are equal
+void checkPlansEqual( const TPOR::BrachytherapyPatient &patient,
+		      const TPOR::BrachytherapyPatient &expected_patient )
+{
+  const std::list<TPOR::BrachytherapySeedPosition> &plan =
+    patient.getTreatmentPlan();
+  const std::list<TPOR::BrachytherapySeedPosition> &expected_plan =
+    expected_patient.getTreatmentPlan();
+
+  BOOST_REQUIRE_EQUAL( plan.size(), expected_plan.size() );
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed =
+    plan.begin();
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator expected_seed =
+    expected_plan.begin();
+
+  while( seed != plan.end() )
+  {
+    BOOST_CHECK_EQUAL( seed->getXIndex(), expected_seed->getXIndex() );
+    BOOST_CHECK_EQUAL( seed->getYIndex(), expected_seed->getYIndex() );
+    BOOST_CHECK_EQUAL( seed->getZIndex(), expected_seed->getZIndex() );
+    BOOST_CHECK_EQUAL( seed->getSeedType(), expected_seed->getSeedType() );
+
+    ++seed;
+    ++expected_seed;
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the planner selects the seeds of the reference planner
+// (the needle penalty of a candidate only lasts until the next update)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlan )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  // Cache the adjoint data so that every candidate table has the same base
+  // weights (the cached data is rescaled by the seed strength)
+  std::vector<std::vector<double> > adjoint_data;
+
+  for( unsigned s = 0; s < seeds.size(); ++s )
+    createPatient( 14500.0 )->getGeometry()->getAdjointData( seeds[s],
+							     adjoint_data );
+
+  // Few needles (penalty < 1) and many needles (penalty > 1) are used
+  const double prescribed_doses[2] = { 14500.0, 50000.0 };
+
+  for( unsigned i = 0; i < 2u; ++i )
+  {
+    boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> reference_patient =
+      createPatient( prescribed_doses[i] );
+
+    TPOR::DWDMMTreatmentPlanner planner( patient, seeds );
+
+    planner.calculateOptimumTreatmentPlan();
+
+    calculateReferencePlan( *reference_patient, seeds );
+
+    BOOST_CHECK( patient->getNumInsertedSeeds() > 1u );
+    BOOST_CHECK( i == 0u || patient->getNumInsertedNeedles() > 23u );
+
+    checkPlansEqual( *patient, *reference_patient );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// end tstDWDMMTreatmentPlanner.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,191 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstDoseVolumeHelpers.cpp
+//! \author Alex Robinson
+//! \brief  Dose-volume helper function unit tests.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+
+// Boost Includes
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+// TPOR Includes
+#include "DoseVolumeHelpers.hpp"
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Create a dose distribution (cGy) and an organ mask
+void createDoseDistribution( std::vector<double> &dose_distribution,
+			     std::vector<bool> &organ_mask )
+{
+  dose_distribution.resize( 8 );
+  organ_mask.resize( 8 );
+  
+  for( unsigned i = 0; i < 8; ++i )
+  {
+    dose_distribution[i] = 100.0*(i+1);
+    organ_mask[i] = (i % 2 == 0);
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the organ dose coverage can be calculated
+BOOST_AUTO_TEST_CASE( calculateOrganDoseCoverage )
+{
+  std::vector<double> dose_distribution;
+  std::vector<bool> organ_mask;
+  createDoseDistribution( dose_distribution, organ_mask );
+
+  // Organ doses: 100, 300, 500, 700
+  double coverage = TPOR::calculateOrganDoseCoverage( dose_distribution,
+						      organ_mask,
+						      4u,
+						      300.0 );
+
+  BOOST_CHECK_EQUAL( coverage, 0.5 );
+
+  coverage = TPOR::calculateOrganDoseCoverage( dose_distribution,
+					       organ_mask,
+					       4u,
+					       0.0 );
+  
+  BOOST_CHECK_EQUAL( coverage, 1.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the number of mesh elements covered can be calculated
+BOOST_AUTO_TEST_CASE( calculateNumElementsCovered )
+{
+  std::vector<double> dose_distribution;
+  std::vector<bool> organ_mask;
+  createDoseDistribution( dose_distribution, organ_mask );
+
+  BOOST_CHECK_EQUAL( TPOR::calculateNumElementsCovered( dose_distribution, 
+							 450.0 ),
+		     4u );
+  BOOST_CHECK_EQUAL( TPOR::calculateNumElementsCovered( dose_distribution, 
+							 800.0 ),
+		     0u );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the organ doses can be extracted and sorted
+BOOST_AUTO_TEST_CASE( extractSortedOrganDoses )
+{
+  std::vector<double> dose_distribution;
+  std::vector<bool> organ_mask;
+  createDoseDistribution( dose_distribution, organ_mask );
+
+  std::vector<double> organ_doses;
+  TPOR::extractSortedOrganDoses( dose_distribution,
+				 organ_mask,
+				 4u,
+				 organ_doses );
+
+  BOOST_REQUIRE_EQUAL( organ_doses.size(), 4u );
+  BOOST_CHECK_EQUAL( organ_doses[0], 700.0 );
+  BOOST_CHECK_EQUAL( organ_doses[1], 500.0 );
+  BOOST_CHECK_EQUAL( organ_doses[2], 300.0 );
+  BOOST_CHECK_EQUAL( organ_doses[3], 100.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the doses of every structure can be extracted and sorted
+BOOST_AUTO_TEST_CASE( extractSortedStructureDoses )
+{
+  std::vector<double> dose_distribution;
+  std::vector<bool> organ_mask;
+  createDoseDistribution( dose_distribution, organ_mask );
+
+  // Structure 0: even elements, structure 1: elements 4-7 (overlapping)
+  std::vector<unsigned> structure_labels( dose_distribution.size(), 0u );
+
+  for( unsigned i = 0; i < structure_labels.size(); ++i )
+  {
+    if( organ_mask[i] )
+      structure_labels[i] |= 1u;
+    if( i >= 4 )
+      structure_labels[i] |= 2u;
+  }
+
+  std::vector<std::vector<double> > structure_doses;
+  TPOR::extractSortedStructureDoses( dose_distribution,
+				     structure_labels,
+				     2u,
+				     structure_doses );
+
+  BOOST_REQUIRE_EQUAL( structure_doses.size(), 2u );
+  BOOST_REQUIRE_EQUAL( structure_doses[0].size(), 4u );
+  BOOST_CHECK_EQUAL( structure_doses[0][0], 700.0 );
+  BOOST_CHECK_EQUAL( structure_doses[0][1], 500.0 );
+  BOOST_CHECK_EQUAL( structure_doses[0][2], 300.0 );
+  BOOST_CHECK_EQUAL( structure_doses[0][3], 100.0 );
+  
+  BOOST_REQUIRE_EQUAL( structure_doses[1].size(), 4u );
+  BOOST_CHECK_EQUAL( structure_doses[1][0], 800.0 );
+  BOOST_CHECK_EQUAL( structure_doses[1][1], 700.0 );
+  BOOST_CHECK_EQUAL( structure_doses[1][2], 600.0 );
+  BOOST_CHECK_EQUAL( structure_doses[1][3], 500.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the organ dose coverage can be calculated from sorted doses
+BOOST_AUTO_TEST_CASE( calculateSortedOrganDoseCoverage )
+{
+  std::vector<double> organ_doses( 4 );
+  organ_doses[0] = 700.0;
+  organ_doses[1] = 500.0;
+  organ_doses[2] = 300.0;
+  organ_doses[3] = 100.0;
+
+  BOOST_CHECK_EQUAL( TPOR::calculateSortedOrganDoseCoverage( organ_doses,
+							      300.0 ),
+		     0.5 );
+  BOOST_CHECK_EQUAL( TPOR::calculateSortedOrganDoseCoverage( organ_doses,
+							      0.0 ),
+		     1.0 );
+  BOOST_CHECK_EQUAL( TPOR::calculateSortedOrganDoseCoverage( organ_doses,
+							      700.0 ),
+		     0.0 );
+}
+
+//---------------------------------------------------------------------------//
+// Check that the dose covering a fraction of an organ can be calculated
+BOOST_AUTO_TEST_CASE( calculateDoseCoveringOrgan )
+{
+  std::vector<double> organ_doses( 4 );
+  organ_doses[0] = 700.0;
+  organ_doses[1] = 500.0;
+  organ_doses[2] = 300.0;
+  organ_doses[3] = 100.0;
+
+  // Volume fractions: 0.0, 0.25, 0.5, 0.75
+  BOOST_CHECK_CLOSE( TPOR::calculateDoseCoveringOrgan( organ_doses, 0.0 ),
+		     7.0,
+		     1e-12 );
+  BOOST_CHECK_CLOSE( TPOR::calculateDoseCoveringOrgan( organ_doses, 0.25 ),
+		     5.0,
+		     1e-12 );
+  BOOST_CHECK_CLOSE( TPOR::calculateDoseCoveringOrgan( organ_doses, 0.375 ),
+		     4.0,
+		     1e-12 );
+  BOOST_CHECK_CLOSE( TPOR::calculateDoseCoveringOrgan( organ_doses, 0.9 ),
+		     1.0,
+		     1e-12 );
+  BOOST_CHECK_CLOSE( TPOR::calculateDoseCoveringOrgan( organ_doses, 1.0 ),
+		     1.0,
+		     1e-12 );
+}
+
+//---------------------------------------------------------------------------//
+// end tstDoseVolumeHelpers.cpp
+//---------------------------------------------------------------------------//
@@ -41,7 +41,8 @@ typedef boost::mpl::list<std::vector<unsigned char>,
 			 std::string> 
 array_types;
 
-typedef boost::mpl::list<char, signed char, int, unsigned, double> 
+typedef boost::mpl::list<char, signed char, int, unsigned, unsigned short,
+			 double> 
 native_types;
 			 
 
@@ -444,6 +445,85 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( readValueFromGroupAttribute,
   hdf5_file_handler.closeHDF5File();
 }
 
+//---------------------------------------------------------------------------//
+// Check that the HDF5FileHandler can test if groups and datasets exist and
+// remove groups
+BOOST_AUTO_TEST_CASE( groupAndDataSetExistence )
+{
+  TPOR::HDF5FileHandler hdf5_file_handler;
+
+  hdf5_file_handler.openHDF5FileAndOverwrite( HDF5_TEST_FILE_NAME );
+
+  std::vector<double> data( 10, 1.0 );
+
+  hdf5_file_handler.writeArrayToDataSet( data, TEST_DATASET_NAME );
+
+  BOOST_CHECK( hdf5_file_handler.groupExists( "/data" ) );
+  BOOST_CHECK( hdf5_file_handler.dataSetExists( TEST_DATASET_NAME ) );
+  BOOST_CHECK( !hdf5_file_handler.dataSetExists( "/data/missing_array" ) );
+
+  hdf5_file_handler.removeGroup( "/data" );
+
+  BOOST_CHECK( !hdf5_file_handler.groupExists( "/data" ) );
+
+  hdf5_file_handler.closeHDF5File();
+}
+
+//---------------------------------------------------------------------------//
+// Check that the HDF5FileHandler can write an array to a chunked dataset and
+// read back a hyperslab of it
+BOOST_AUTO_TEST_CASE( writeArrayToChunkedDataSet )
+{
+  TPOR::HDF5FileHandler hdf5_file_handler;
+
+  hdf5_file_handler.openHDF5FileAndOverwrite( HDF5_TEST_FILE_NAME );
+
+  // 4 slices of 3x2 values
+  std::vector<double> original_data( 4*3*2 );
+  for( unsigned i = 0; i < original_data.size(); ++i )
+    original_data[i] = i;
+
+  std::vector<hsize_t> dimensions( 3 );
+  dimensions[0] = 4;
+  dimensions[1] = 3;
+  dimensions[2] = 2;
+
+  std::vector<hsize_t> chunk_dimensions( dimensions );
+  chunk_dimensions[0] = 1;
+
+  hdf5_file_handler.writeArrayToChunkedDataSet( original_data,
+						TEST_DATASET_NAME,
+						dimensions,
+						chunk_dimensions );
+  
+  std::vector<double> copied_data;
+  hdf5_file_handler.readArrayFromDataSet( copied_data, TEST_DATASET_NAME );
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( original_data.begin(), 
+				 original_data.end(),
+				 copied_data.begin(),
+				 copied_data.end() );
+
+  // Read slices 1 and 2
+  std::vector<hsize_t> offset( 3, 0 );
+  offset[0] = 1;
+  
+  std::vector<hsize_t> count( dimensions );
+  count[0] = 2;
+
+  hdf5_file_handler.readArrayHyperslabFromDataSet( copied_data,
+						   TEST_DATASET_NAME,
+						   offset,
+						   count );
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( original_data.begin()+6, 
+				 original_data.begin()+18,
+				 copied_data.begin(),
+				 copied_data.end() );
+
+  hdf5_file_handler.closeHDF5File();
+}
+
 //---------------------------------------------------------------------------//
 // end tstHDF5FileHandler.cpp
 //---------------------------------------------------------------------------//
@@ -0,0 +1,555 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstIIEMTreatmentPlanner.cpp
+//! \author Alex Robinson
+//! \brief  IIEMTreatmentPlanner class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <list>
+#include <math.h>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE IIEMTreatmentPlanner
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "BrachytherapyCandidateTable.hpp"
+#include "IIEMTreatmentPlanner.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "iiem_test_patient.h5"
+#define SEED_TEST_FILE_NAME "iiem_test_seeds.h5"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME, 3u, 1.5 );
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Create the test seed
+boost::shared_ptr<TPOR::BrachytherapySeedProxy> createSeed()
+{
+  return boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::AMERSHAM_6711_SEED,
+					       0.55 ) );
+}
+
+// Create a patient
+boost::shared_ptr<TPOR::BrachytherapyPatient> createPatient(
+					       const double prescribed_dose )
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     prescribed_dose ) );
+
+  return boost::shared_ptr<TPOR::BrachytherapyPatient>(
+				   new TPOR::BrachytherapyPatient( geometry ) );
+}
+
+// Check that two treatment plans are equal
+void checkPlansEqual( const TPOR::BrachytherapyPatient &patient,
+		      const TPOR::BrachytherapyPatient &expected_patient )
+{
+  const std::list<TPOR::BrachytherapySeedPosition> &plan =
+    patient.getTreatmentPlan();
+  const std::list<TPOR::BrachytherapySeedPosition> &expected_plan =
+    expected_patient.getTreatmentPlan();
+
+  BOOST_REQUIRE_EQUAL( plan.size(), expected_plan.size() );
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed =
+    plan.begin();
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator expected_seed =
+    expected_plan.begin();
+
+  while( seed != plan.end() )
+  {
+    BOOST_CHECK_EQUAL( seed->getXIndex(), expected_seed->getXIndex() );
+    BOOST_CHECK_EQUAL( seed->getYIndex(), expected_seed->getYIndex() );
+    BOOST_CHECK_EQUAL( seed->getZIndex(), expected_seed->getZIndex() );
+
+    ++seed;
+    ++expected_seed;
+  }
+}
+
+// Select a seed and remove it from the remaining candidates (return false
+// if it was the last remaining candidate)
+bool selectCandidate( TPOR::BrachytherapyPatient &patient,
+		      TPOR::BrachytherapyCandidateTable &remaining_candidates,
+		      const unsigned candidate )
+{
+  patient.insertSeed( remaining_candidates.createSeedPosition( candidate ) );
+  remaining_candidates.removeCandidate( candidate );
+
+  return remaining_candidates.getNextAliveCandidate( candidate ) !=
+    remaining_candidates.getNumberOfCandidates();
+}
+
+// Conduct the reference needle isodose constant iteration (every remaining
+// candidate is scanned and the candidates off the needles are skipped)
+double conductReferenceNeedleIsodoseConstantIteration(
+	      TPOR::BrachytherapyPatient &patient,
+	      const double start_constant,
+	      const double end_constant,
+	      const double step,
+	      const TPOR::BrachytherapyCandidateTable &remaining_candidates )
+{
+  patient.createCheckpoint( "reference_needle_isodose_constant_iteration" );
+
+  TPOR::BrachytherapyCandidateTable remaining_candidates_copy =
+    remaining_candidates;
+
+  const unsigned end_candidate = remaining_candidates.getNumberOfCandidates();
+
+  double optimum_needle_isodose_constant = 0.0;
+
+  for( double needle_isodose_constant = start_constant;
+       needle_isodose_constant <= end_constant;
+       needle_isodose_constant += step )
+  {
+    while( patient.getProstatePrescribedDoseCoverage() < 0.98 )
+    {
+      double dose_cutoff =
+	patient.getPrescribedDose()*needle_isodose_constant;
+
+      unsigned candidate;
+
+      for( candidate = remaining_candidates_copy.getFirstAliveCandidate();
+	   candidate != end_candidate;
+	   candidate = remaining_candidates_copy.getNextAliveCandidate(
+								candidate ) )
+      {
+	if( patient.getDose( remaining_candidates_copy, candidate ) <
+	    dose_cutoff &&
+	    patient.isSeedOnNeedle( remaining_candidates_copy, candidate ) )
+	  break;
+      }
+
+      if( candidate == end_candidate )
+	break;
+
+      if( !selectCandidate( patient, remaining_candidates_copy, candidate ) )
+	break;
+    }
+
+    if( patient.getProstatePrescribedDoseCoverage() >= 0.98 )
+    {
+      optimum_needle_isodose_constant = needle_isodose_constant;
+      break;
+    }
+    else
+    {
+      patient.restoreCheckpoint(
+			      "reference_needle_isodose_constant_iteration" );
+
+      remaining_candidates_copy = remaining_candidates;
+    }
+  }
+
+  patient.releaseCheckpoint( "reference_needle_isodose_constant_iteration" );
+
+  return optimum_needle_isodose_constant;
+}
+
+// Conduct a reference isodose constant trial (every remaining candidate is
+// scanned and the seeds are selected from scratch)
+bool conductReferenceIsodoseConstantTrial(
+		  TPOR::BrachytherapyPatient &patient,
+		  const TPOR::BrachytherapyCandidateTable &candidates,
+		  const double isodose_constant,
+		  const unsigned needle_goal )
+{
+  TPOR::BrachytherapyCandidateTable remaining_candidates = candidates;
+
+  const unsigned end_candidate = remaining_candidates.getNumberOfCandidates();
+
+  patient.resetState();
+
+  bool candidates_remain =
+    selectCandidate( patient,
+		     remaining_candidates,
+		     remaining_candidates.getFirstAliveCandidate() );
+
+  while( candidates_remain && patient.getNumInsertedNeedles() < needle_goal )
+  {
+    double dose_cutoff = patient.getPrescribedDose()*isodose_constant*
+      patient.getNumInsertedSeeds();
+
+    unsigned candidate;
+
+    for( candidate = remaining_candidates.getFirstAliveCandidate();
+	 candidate != end_candidate;
+	 candidate = remaining_candidates.getNextAliveCandidate( candidate ) )
+    {
+      if( patient.getDose( remaining_candidates, candidate ) < dose_cutoff )
+	break;
+    }
+
+    if( candidate == end_candidate )
+      break;
+
+    candidates_remain =
+      selectCandidate( patient, remaining_candidates, candidate );
+  }
+
+  if( patient.getNumInsertedNeedles() != needle_goal )
+    return false;
+
+  patient.saveState();
+
+  double needle_isodose_constant =
+    conductReferenceNeedleIsodoseConstantIteration( patient,
+						    1.02,
+						    1.08,
+						    0.02,
+						    remaining_candidates );
+
+  if( patient.getProstatePrescribedDoseCoverage() < 0.98 )
+    return false;
+
+  patient.loadSavedState();
+
+  conductReferenceNeedleIsodoseConstantIteration( patient,
+						  needle_isodose_constant-0.019,
+						  needle_isodose_constant,
+						  0.001,
+						  remaining_candidates );
+
+  return true;
+}
+
+// Calculate the reference treatment plan (the needle goals and the isodose
+// constants are scanned in order on a single patient)
+void calculateReferencePlan(
+		  TPOR::BrachytherapyPatient &patient,
+		  const boost::shared_ptr<TPOR::BrachytherapySeedProxy> &seed,
+		  const double min_isodose_constant )
+{
+  TPOR::BrachytherapyCandidateTable candidates( patient.getOrganMeshXDim(),
+						patient.getOrganMeshYDim(),
+						patient.getOrganMeshZDim() );
+
+  patient.getCandidateSeedPositions(
+	  std::vector<boost::shared_ptr<TPOR::BrachytherapySeedProxy> >(
+								    1, seed ),
+	  candidates );
+
+  candidates.sortByBaseWeight();
+  candidates.buildPositionIndex();
+
+  unsigned min_number_of_needles =
+    static_cast<unsigned>(floor(0.24*patient.getProstateVolume() + 11.33));
+
+  for( unsigned needle_goal = min_number_of_needles;
+       needle_goal <= 30;
+       ++needle_goal )
+  {
+    bool success = false;
+
+    for( double isodose_constant = 0.001;
+	 isodose_constant <= min_isodose_constant;
+	 isodose_constant += 0.001 )
+    {
+      success = conductReferenceIsodoseConstantTrial( patient,
+						      candidates,
+						      isodose_constant,
+						      needle_goal );
+
+      if( success )
+	break;
+    }
+
+    if( success )
+      break;
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the planner selects the seeds of the reference planner (the
+// needle isodose constant iteration of the reference planner scans every
+// remaining candidate instead of the candidates on the inserted needles)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlan )
+{
+  boost::shared_ptr<TPOR::BrachytherapySeedProxy> seed = createSeed();
+
+  // Cache the adjoint data so that every planner has the same base weights
+  std::vector<std::vector<double> > adjoint_data;
+
+  createPatient( 14500.0 )->getGeometry()->getAdjointData( seed,
+							   adjoint_data );
+
+  const double prescribed_doses[3] = { 10000.0, 14500.0, 20000.0 };
+
+  for( unsigned i = 0; i < 3u; ++i )
+  {
+    boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> reference_patient =
+      createPatient( prescribed_doses[i] );
+
+    TPOR::IIEMTreatmentPlanner planner( 
+				     patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u );
+
+    planner.calculateOptimumTreatmentPlan();
+
+    calculateReferencePlan( *reference_patient, 
+			    seed,
+			    planner.getMinSeedIsodoseConstant() );
+
+    BOOST_CHECK( patient->getProstatePrescribedDoseCoverage() >= 0.98 );
+
+    checkPlansEqual( *patient, *reference_patient );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the plan and the number of trials do not depend on the number
+// of threads (the needle goal of the second dose is not reached with the
+// first needle goal)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlanWithThreads )
+{
+  boost::shared_ptr<TPOR::BrachytherapySeedProxy> seed = createSeed();
+
+  // Cache the adjoint data so that every planner has the same base weights
+  std::vector<std::vector<double> > adjoint_data;
+
+  createPatient( 14500.0 )->getGeometry()->getAdjointData( seed,
+							   adjoint_data );
+
+  const double prescribed_doses[2] = { 14500.0, 30000.0 };
+
+  for( unsigned i = 0; i < 2u; ++i )
+  {
+    boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> thread_patient =
+      createPatient( prescribed_doses[i] );
+
+    TPOR::IIEMTreatmentPlanner planner( 
+				     patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u );
+    TPOR::IIEMTreatmentPlanner thread_planner( 
+				     thread_patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     3u );
+
+    planner.calculateOptimumTreatmentPlan();
+    thread_planner.calculateOptimumTreatmentPlan();
+
+    BOOST_CHECK( patient->getProstatePrescribedDoseCoverage() >= 0.98 );
+    // Sua's linear fit gives the first needle goal
+    unsigned first_needle_goal = static_cast<unsigned>( 
+			  floor( 0.24*patient->getProstateVolume() + 11.33 ) );
+
+    BOOST_CHECK( i == 0u || 
+		 patient->getNumInsertedNeedles() > first_needle_goal );
+
+    checkPlansEqual( *thread_patient, *patient );
+    BOOST_CHECK_EQUAL( thread_planner.getNumberOfTrials(),
+		       planner.getNumberOfTrials() );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that a search with a verification window that covers every trial
+// gives the plan of the scan (the trial success is not monotone on the 
+// mock patient, so a search without a window can keep a different trial
+// and needle goal)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlanWithSearch )
+{
+  boost::shared_ptr<TPOR::BrachytherapySeedProxy> seed = createSeed();
+
+  // Cache the adjoint data so that every planner has the same base weights
+  std::vector<std::vector<double> > adjoint_data;
+
+  createPatient( 14500.0 )->getGeometry()->getAdjointData( seed,
+							   adjoint_data );
+
+  const double prescribed_doses[2] = { 10000.0, 14500.0 };
+
+  for( unsigned i = 0; i < 2u; ++i )
+  {
+    boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> search_patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> window_patient =
+      createPatient( prescribed_doses[i] );
+
+    TPOR::IIEMTreatmentPlanner planner( 
+				     patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u );
+    TPOR::IIEMTreatmentPlanner search_planner( 
+				     search_patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u,
+				     true );
+    TPOR::IIEMTreatmentPlanner window_planner( 
+				     window_patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u,
+				     true,
+				     1000u );
+
+    planner.calculateOptimumTreatmentPlan();
+    search_planner.calculateOptimumTreatmentPlan();
+    window_planner.calculateOptimumTreatmentPlan();
+
+    // The scan keeps the lowest successful needle goal
+    BOOST_CHECK( search_patient->getProstatePrescribedDoseCoverage() >= 
+		 0.98 );
+    BOOST_CHECK( search_patient->getNumInsertedNeedles() >= 
+		 patient->getNumInsertedNeedles() );
+
+    checkPlansEqual( *window_patient, *patient );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the search and the threaded sweep select the seeds of the
+// reference planner (the reference planner scans the remaining candidates
+// for the first acceptable candidate instead of searching a candidate dose
+// tree)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlanAcceptableCandidates )
+{
+  boost::shared_ptr<TPOR::BrachytherapySeedProxy> seed = createSeed();
+
+  // Cache the adjoint data so that every planner has the same base weights
+  std::vector<std::vector<double> > adjoint_data;
+
+  createPatient( 14500.0 )->getGeometry()->getAdjointData( seed,
+							   adjoint_data );
+
+  const double prescribed_doses[2] = { 10000.0, 20000.0 };
+
+  for( unsigned i = 0; i < 2u; ++i )
+  {
+    boost::shared_ptr<TPOR::BrachytherapyPatient> window_patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> thread_patient =
+      createPatient( prescribed_doses[i] );
+    boost::shared_ptr<TPOR::BrachytherapyPatient> reference_patient =
+      createPatient( prescribed_doses[i] );
+
+    TPOR::IIEMTreatmentPlanner window_planner( 
+				     window_patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u,
+				     true,
+				     1000u );
+    TPOR::IIEMTreatmentPlanner thread_planner( 
+				     thread_patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     3u );
+
+    window_planner.calculateOptimumTreatmentPlan();
+    thread_planner.calculateOptimumTreatmentPlan();
+
+    calculateReferencePlan( *reference_patient, 
+			    seed,
+			    window_planner.getMinSeedIsodoseConstant() );
+
+    checkPlansEqual( *window_patient, *reference_patient );
+    checkPlansEqual( *thread_patient, *reference_patient );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the seed selections that are reused across the needle goals
+// give the plan of the reference planner (the reference planner selects
+// the seeds of every needle goal from scratch) with the scan and with a
+// search (which tries the needle goals out of order)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlanReusedSelections )
+{
+  boost::shared_ptr<TPOR::BrachytherapySeedProxy> seed = createSeed();
+
+  // Cache the adjoint data so that every planner has the same base weights
+  std::vector<std::vector<double> > adjoint_data;
+
+  createPatient( 14500.0 )->getGeometry()->getAdjointData( seed,
+							   adjoint_data );
+
+  // The first needle goal is not reached with this prescribed dose
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+    createPatient( 30000.0 );
+  boost::shared_ptr<TPOR::BrachytherapyPatient> window_patient =
+    createPatient( 30000.0 );
+  boost::shared_ptr<TPOR::BrachytherapyPatient> reference_patient =
+    createPatient( 30000.0 );
+
+  TPOR::IIEMTreatmentPlanner planner( patient,
+				      seed,
+				      TPOR::BrachytherapyDoseMatrixSettings(),
+				      1u );
+  TPOR::IIEMTreatmentPlanner window_planner(
+				     window_patient,
+				     seed,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u,
+				     true,
+				     1000u );
+
+  planner.calculateOptimumTreatmentPlan();
+  window_planner.calculateOptimumTreatmentPlan();
+
+  calculateReferencePlan( *reference_patient,
+			  seed,
+			  planner.getMinSeedIsodoseConstant() );
+
+  unsigned first_needle_goal = static_cast<unsigned>(
+			  floor( 0.24*patient->getProstateVolume() + 11.33 ) );
+
+  BOOST_CHECK( patient->getProstatePrescribedDoseCoverage() >= 0.98 );
+  BOOST_CHECK( patient->getNumInsertedNeedles() > first_needle_goal+1u );
+
+  checkPlansEqual( *patient, *reference_patient );
+  checkPlansEqual( *window_patient, *reference_patient );
+}
+
+//---------------------------------------------------------------------------//
+// end tstIIEMTreatmentPlanner.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,155 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstIndexedMinHeap.cpp
+//! \author Alex Robinson
+//! \brief  Indexed d-ary min heap unit tests.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+// Boost Includes
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "IndexedMinHeap.hpp"
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Create a set of keys with repeated values
+void createKeys( std::vector<double> &keys )
+{
+  keys.resize( 50 );
+
+  for( unsigned i = 0; i < keys.size(); ++i )
+    keys[i] = static_cast<double>( (i*37) % 11 );
+}
+
+// Return the id of the first smallest alive key (linear scan)
+unsigned findMinimum( const std::vector<double> &keys,
+		      const std::vector<bool> &alive )
+{
+  unsigned min_id = keys.size();
+
+  for( unsigned i = 0; i < keys.size(); ++i )
+  {
+    if( alive[i] && (min_id == keys.size() || keys[i] < keys[min_id]) )
+      min_id = i;
+  }
+
+  return min_id;
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that ids are popped in key order (ties broken by id)
+BOOST_AUTO_TEST_CASE( popInKeyOrder )
+{
+  std::vector<double> keys;
+  createKeys( keys );
+
+  std::vector<bool> alive( keys.size(), true );
+
+  TPOR::IndexedMinHeap heap( keys.size(), 3u );
+
+  for( unsigned i = 0; i < keys.size(); ++i )
+    heap.push( i, keys[i] );
+
+  BOOST_CHECK_EQUAL( heap.size(), keys.size() );
+  BOOST_CHECK( heap.isValid() );
+
+  while( !heap.empty() )
+  {
+    unsigned min_id = findMinimum( keys, alive );
+
+    BOOST_CHECK_EQUAL( heap.top(), min_id );
+    BOOST_CHECK_EQUAL( heap.getTopKey(), keys[min_id] );
+
+    heap.pop();
+    alive[min_id] = false;
+
+    BOOST_CHECK( !heap.contains( min_id ) );
+    BOOST_CHECK( heap.isValid() );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the key of a stored id can be decreased and increased
+BOOST_AUTO_TEST_CASE( updateKey )
+{
+  std::vector<double> keys;
+  createKeys( keys );
+
+  std::vector<bool> alive( keys.size(), true );
+
+  TPOR::IndexedMinHeap heap( keys.size() );
+
+  for( unsigned i = 0; i < keys.size(); ++i )
+    heap.push( i, keys[i] );
+
+  for( unsigned i = 0; i < keys.size(); ++i )
+  {
+    unsigned id = (i*13) % keys.size();
+
+    if( i % 2 == 0 )
+      keys[id] *= 0.5;
+    else
+      keys[id] += 3.0;
+
+    heap.update( id, keys[id] );
+
+    BOOST_CHECK_EQUAL( heap.getKey( id ), keys[id] );
+    BOOST_CHECK_EQUAL( heap.top(), findMinimum( keys, alive ) );
+    BOOST_CHECK( heap.isValid() );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that any stored id can be removed
+BOOST_AUTO_TEST_CASE( removeId )
+{
+  std::vector<double> keys;
+  createKeys( keys );
+
+  std::vector<bool> alive( keys.size(), true );
+
+  TPOR::IndexedMinHeap heap( keys.size(), 2u );
+
+  for( unsigned i = 0; i < keys.size(); ++i )
+    heap.push( i, keys[i] );
+
+  for( unsigned i = 0; i < keys.size() - 1u; ++i )
+  {
+    unsigned id = (i*7 + 3) % keys.size();
+
+    heap.remove( id );
+    alive[id] = false;
+
+    BOOST_CHECK( !heap.contains( id ) );
+    BOOST_CHECK_EQUAL( heap.size(), keys.size() - i - 1u );
+    BOOST_CHECK_EQUAL( heap.top(), findMinimum( keys, alive ) );
+    BOOST_CHECK( heap.isValid() );
+  }
+
+  // A removed id can be stored again
+  heap.push( 3u, -1.0 );
+
+  BOOST_CHECK_EQUAL( heap.top(), 3u );
+  BOOST_CHECK( heap.isValid() );
+
+  // All ids are removed by a reset
+  heap.reset( 10u );
+
+  BOOST_CHECK( heap.empty() );
+  BOOST_CHECK_EQUAL( heap.getNumberOfIds(), 10u );
+}
+
+//---------------------------------------------------------------------------//
+// end tstIndexedMinHeap.cpp
+//---------------------------------------------------------------------------//
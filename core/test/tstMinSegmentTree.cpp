@@ -0,0 +1,134 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstMinSegmentTree.cpp
+//! \author Alex Robinson
+//! \brief  Minimum segment tree unit tests.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+// Boost Includes
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "MinSegmentTree.hpp"
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Create a set of values with repeated values
+void createValues( std::vector<double> &values )
+{
+  values.resize( 37 );
+
+  for( unsigned i = 0; i < values.size(); ++i )
+    values[i] = static_cast<double>( (i*29) % 13 );
+}
+
+// Return the first id with a value below a limit (linear scan)
+unsigned findFirstBelow( const std::vector<double> &values,
+			 const double limit )
+{
+  for( unsigned i = 0; i < values.size(); ++i )
+  {
+    if( values[i] < limit )
+      return i;
+  }
+
+  return values.size();
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the first id below a limit matches a linear scan
+BOOST_AUTO_TEST_CASE( findFirstBelowLimit )
+{
+  std::vector<double> values;
+  createValues( values );
+
+  TPOR::MinSegmentTree tree;
+  tree.reset( values );
+
+  BOOST_CHECK_EQUAL( tree.size(), values.size() );
+  BOOST_CHECK_EQUAL( tree.getMinValue(), 0.0 );
+  BOOST_CHECK( tree.isValid() );
+
+  for( unsigned i = 0; i < values.size(); ++i )
+    BOOST_CHECK_EQUAL( tree.getValue( i ), values[i] );
+
+  for( double limit = -1.0; limit <= 14.0; limit += 0.5 )
+  {
+    BOOST_CHECK_EQUAL( tree.findFirstBelow( limit ),
+		       findFirstBelow( values, limit ) );
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check that the values can be changed
+BOOST_AUTO_TEST_CASE( setValue )
+{
+  std::vector<double> values;
+  createValues( values );
+
+  TPOR::MinSegmentTree tree( values.size() );
+
+  BOOST_CHECK_EQUAL( tree.findFirstBelow( 100.0 ), values.size() );
+
+  for( unsigned i = 0; i < values.size(); ++i )
+    tree.setValue( i, values[i] );
+
+  BOOST_CHECK( tree.isValid() );
+
+  for( unsigned i = 0; i < values.size(); ++i )
+  {
+    unsigned id = (i*11) % values.size();
+
+    if( i % 3 == 0 )
+      values[id] = std::numeric_limits<double>::infinity();
+    else if( i % 3 == 1 )
+      values[id] += 5.0;
+    else
+      values[id] -= 2.0;
+
+    tree.setValue( id, values[id] );
+
+    BOOST_CHECK_EQUAL( tree.getValue( id ), values[id] );
+    BOOST_CHECK_EQUAL( tree.getMinValue(),
+		       *std::min_element( values.begin(), values.end() ) );
+    BOOST_CHECK( tree.isValid() );
+
+    for( double limit = 0.0; limit <= 18.0; limit += 3.0 )
+    {
+      BOOST_CHECK_EQUAL( tree.findFirstBelow( limit ),
+			 findFirstBelow( values, limit ) );
+    }
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Check the trees with no ids and one id
+BOOST_AUTO_TEST_CASE( smallTrees )
+{
+  TPOR::MinSegmentTree tree;
+
+  BOOST_CHECK_EQUAL( tree.size(), 0u );
+  BOOST_CHECK_EQUAL( tree.findFirstBelow( 1.0 ), 0u );
+
+  tree.reset( 1u );
+  tree.setValue( 0u, 2.0 );
+
+  BOOST_CHECK_EQUAL( tree.findFirstBelow( 2.0 ), 1u );
+  BOOST_CHECK_EQUAL( tree.findFirstBelow( 2.5 ), 0u );
+  BOOST_CHECK( tree.isValid() );
+}
+
+//---------------------------------------------------------------------------//
+// end tstMinSegmentTree.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,168 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstSCMTreatmentPlanner.cpp
+//! \author Alex Robinson
+//! \brief  SCMTreatmentPlanner class unit tests
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <vector>
+#include <list>
+
+// Boost Includes
+#include <boost/shared_ptr.hpp>
+#define BOOST_TEST_MODULE SCMTreatmentPlanner
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "BrachytherapyPatientGeometry.hpp"
+#include "BrachytherapyPatient.hpp"
+#include "BrachytherapySeedProxy.hpp"
+#include "BrachytherapySeedPosition.hpp"
+#include "SCMTreatmentPlanner.hpp"
+#include "MockBrachytherapyFiles.hpp"
+
+//---------------------------------------------------------------------------//
+// Test File Names.
+//---------------------------------------------------------------------------//
+#define PATIENT_TEST_FILE_NAME "scm_test_patient.h5"
+#define SEED_TEST_FILE_NAME "scm_test_seeds.h5"
+
+//---------------------------------------------------------------------------//
+// Testing Structs.
+//---------------------------------------------------------------------------//
+struct MockFileGenerator{
+  MockFileGenerator()
+  {
+    writeMockPatientFile( PATIENT_TEST_FILE_NAME, 2u );
+    writeMockSeedFile( SEED_TEST_FILE_NAME );
+  }
+
+  ~MockFileGenerator()
+  { /* ... */ }
+};
+
+//---------------------------------------------------------------------------//
+// Global Testing Fixture.
+//---------------------------------------------------------------------------//
+BOOST_GLOBAL_FIXTURE( MockFileGenerator );
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// The seed container type
+typedef std::vector<boost::shared_ptr<TPOR::BrachytherapySeedProxy> >
+SeedVector;
+
+// Create the test seeds
+void createSeeds( SeedVector &seeds )
+{
+  seeds.clear();
+
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::AMERSHAM_6711_SEED,
+					       0.55 ) ) );
+  seeds.push_back( boost::shared_ptr<TPOR::BrachytherapySeedProxy>(
+	     new TPOR::BrachytherapySeedProxy( SEED_TEST_FILE_NAME,
+					       TPOR::BEST_2301_SEED,
+					       0.2 ) ) );
+}
+
+// Create a patient
+boost::shared_ptr<TPOR::BrachytherapyPatient> createPatient(
+					       const double prescribed_dose )
+{
+  boost::shared_ptr<const TPOR::BrachytherapyPatientGeometry> geometry(
+	     new TPOR::BrachytherapyPatientGeometry( PATIENT_TEST_FILE_NAME,
+						     prescribed_dose ) );
+
+  return boost::shared_ptr<TPOR::BrachytherapyPatient>(
+				   new TPOR::BrachytherapyPatient( geometry ) );
+}
+
+// Check that two treatment plans are equal
+void checkPlansEqual( const TPOR::BrachytherapyPatient &patient,
+		      const TPOR::BrachytherapyPatient &expected_patient )
+{
+  const std::list<TPOR::BrachytherapySeedPosition> &plan =
+    patient.getTreatmentPlan();
+  const std::list<TPOR::BrachytherapySeedPosition> &expected_plan =
+    expected_patient.getTreatmentPlan();
+
+  BOOST_REQUIRE_EQUAL( plan.size(), expected_plan.size() );
+
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator seed =
+    plan.begin();
+  std::list<TPOR::BrachytherapySeedPosition>::const_iterator expected_seed =
+    expected_plan.begin();
+
+  while( seed != plan.end() )
+  {
+    BOOST_CHECK_EQUAL( seed->getXIndex(), expected_seed->getXIndex() );
+    BOOST_CHECK_EQUAL( seed->getYIndex(), expected_seed->getYIndex() );
+    BOOST_CHECK_EQUAL( seed->getZIndex(), expected_seed->getZIndex() );
+    BOOST_CHECK_EQUAL( seed->getSeedType(), expected_seed->getSeedType() );
+
+    ++seed;
+    ++expected_seed;
+  }
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the lazy and eager evaluation modes select the same seeds
+// (with any number of threads)
+BOOST_AUTO_TEST_CASE( calculateOptimumTreatmentPlan )
+{
+  SeedVector seeds;
+  createSeeds( seeds );
+
+  // Cache the adjoint data so that every planner has the same base weights
+  std::vector<std::vector<double> > adjoint_data;
+
+  for( unsigned s = 0; s < seeds.size(); ++s )
+    createPatient( 14500.0 )->getGeometry()->getAdjointData( seeds[s],
+							     adjoint_data );
+
+  boost::shared_ptr<TPOR::BrachytherapyPatient> patient =
+    createPatient( 14500.0 );
+  boost::shared_ptr<TPOR::BrachytherapyPatient> thread_patient =
+    createPatient( 14500.0 );
+  boost::shared_ptr<TPOR::BrachytherapyPatient> eager_patient =
+    createPatient( 14500.0 );
+
+  TPOR::SCMTreatmentPlanner planner( patient,
+				     seeds,
+				     true,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u );
+  TPOR::SCMTreatmentPlanner thread_planner( 
+				     thread_patient,
+				     seeds,
+				     true,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     3u );
+  TPOR::SCMTreatmentPlanner eager_planner( 
+				     eager_patient,
+				     seeds,
+				     false,
+				     TPOR::BrachytherapyDoseMatrixSettings(),
+				     1u );
+
+  planner.calculateOptimumTreatmentPlan();
+  thread_planner.calculateOptimumTreatmentPlan();
+  eager_planner.calculateOptimumTreatmentPlan();
+
+  BOOST_CHECK( patient->getNumInsertedSeeds() > 1u );
+
+  checkPlansEqual( *thread_patient, *patient );
+  checkPlansEqual( *eager_patient, *patient );
+}
+
+//---------------------------------------------------------------------------//
+// end tstSCMTreatmentPlanner.cpp
+//---------------------------------------------------------------------------//
@@ -0,0 +1,128 @@
+//---------------------------------------------------------------------------//
+//!
+//! \file   tstVTKStructuredPointsWriter.cpp
+//! \author Alex Robinson
+//! \brief  VTK legacy structured points file writer unit tests.
+//!
+//---------------------------------------------------------------------------//
+
+// Std Lib Includes
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Boost Includes
+#define BOOST_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+
+// TPOR Includes
+#include "VTKStructuredPointsWriter.hpp"
+
+//---------------------------------------------------------------------------//
+// Testing Info.
+//---------------------------------------------------------------------------//
+#define VTK_TEST_FILE "vtk_test_file.vtk"
+
+//---------------------------------------------------------------------------//
+// Testing Functions.
+//---------------------------------------------------------------------------//
+// Read a line of the vtk file
+std::string readLine( std::ifstream &file )
+{
+  std::string line;
+  std::getline( file, line );
+  
+  return line;
+}
+
+// Read a block of raw bytes from the vtk file
+std::vector<unsigned char> readBytes( std::ifstream &file, 
+				      const unsigned num_bytes )
+{
+  std::vector<unsigned char> bytes( num_bytes );
+  file.read( reinterpret_cast<char*>( &bytes[0] ), num_bytes );
+
+  return bytes;
+}
+
+//---------------------------------------------------------------------------//
+// Tests.
+//---------------------------------------------------------------------------//
+// Check that the header and the cell data can be written
+BOOST_AUTO_TEST_CASE( writeCellData )
+{
+  {
+    TPOR::VTKStructuredPointsWriter vtk_file( VTK_TEST_FILE,
+					      "test file",
+					      2u, 1u, 1u,
+					      0.5, 0.0, 1.0,
+					      0.1, 0.1, 0.5 );
+    
+    std::vector<unsigned char> labels( 2 );
+    labels[0] = 1u;
+    labels[1] = 5u;
+    
+    vtk_file.writeCellData( "tissue", labels );
+
+    std::vector<float> dose( 2 );
+    dose[0] = 1.0f;
+    dose[1] = -2.0f;
+  
+    vtk_file.writeCellData( "dose", dose );
+    
+    std::vector<int> plan( 2 );
+    plan[0] = 0;
+    plan[1] = 258;
+
+    vtk_file.writeCellData( "treatment_plan", plan );
+  }
+
+  std::ifstream file( VTK_TEST_FILE, std::ifstream::binary );
+  
+  BOOST_CHECK_EQUAL( readLine( file ), "# vtk DataFile Version 3.0" );
+  BOOST_CHECK_EQUAL( readLine( file ), "test file" );
+  BOOST_CHECK_EQUAL( readLine( file ), "BINARY" );
+  BOOST_CHECK_EQUAL( readLine( file ), "DATASET STRUCTURED_POINTS" );
+  BOOST_CHECK_EQUAL( readLine( file ), "DIMENSIONS 3 2 2" );
+  BOOST_CHECK_EQUAL( readLine( file ), "ORIGIN 0.5 0 1" );
+  BOOST_CHECK_EQUAL( readLine( file ), "SPACING 0.1 0.1 0.5" );
+  BOOST_CHECK_EQUAL( readLine( file ), "CELL_DATA 2" );
+  
+  BOOST_CHECK_EQUAL( readLine( file ), "SCALARS tissue unsigned_char 1" );
+  BOOST_CHECK_EQUAL( readLine( file ), "LOOKUP_TABLE default" );
+  
+  std::vector<unsigned char> bytes = readBytes( file, 3 );
+  BOOST_CHECK_EQUAL( bytes[0], 1u );
+  BOOST_CHECK_EQUAL( bytes[1], 5u );
+  BOOST_CHECK_EQUAL( bytes[2], '\n' );
+
+  BOOST_CHECK_EQUAL( readLine( file ), "SCALARS dose float 1" );
+  BOOST_CHECK_EQUAL( readLine( file ), "LOOKUP_TABLE default" );
+
+  // The values must be big-endian
+  bytes = readBytes( file, 9 );
+  BOOST_CHECK_EQUAL( bytes[0], 0x3Fu );
+  BOOST_CHECK_EQUAL( bytes[1], 0x80u );
+  BOOST_CHECK_EQUAL( bytes[2], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[3], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[4], 0xC0u );
+  BOOST_CHECK_EQUAL( bytes[5], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[6], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[7], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[8], '\n' );
+
+  BOOST_CHECK_EQUAL( readLine( file ), "SCALARS treatment_plan int 1" );
+  BOOST_CHECK_EQUAL( readLine( file ), "LOOKUP_TABLE default" );
+
+  bytes = readBytes( file, 8 );
+  BOOST_CHECK_EQUAL( bytes[3], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[4], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[5], 0x00u );
+  BOOST_CHECK_EQUAL( bytes[6], 0x01u );
+  BOOST_CHECK_EQUAL( bytes[7], 0x02u );
+}
+
+//---------------------------------------------------------------------------//
+// end tstVTKStructuredPointsWriter.cpp
+//---------------------------------------------------------------------------//